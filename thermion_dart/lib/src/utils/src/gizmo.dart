@@ -83,6 +83,9 @@ abstract class BaseGizmo extends Gizmo {
     if (result.entity == x || result.entity == y || result.entity == z) {
       _activeAxis = result.entity;
       _isHovered = true;
+    } else if (result.entity == center) {
+      _activeAxis = null;
+      _isHovered = true;
     } else if (result.entity == 0) {
       _activeAxis = null;
       _isHovered = false;
@@ -35,7 +35,8 @@ class FFIGizmo extends BaseGizmo {
   ///
   /// Used to test whether a Gizmo is at the given viewport coordinates.
   /// Called by `FilamentGestureDetector` on a mouse/finger down event. You probably don't want to call this yourself.
-  /// This is asynchronous and will require 2-3 frames to complete - subscribe to the [gizmoPickResult] stream to receive the results of this method.
+  /// The handles are hit-tested on the CPU, so the highlight is updated immediately and the result is delivered to the [onPick] callback
+  /// without waiting for a frame to be rendered.
   /// [x] and [y] must be in local logical coordinates (i.e. where 0,0 is at top-left of the ThermionWidget).
   ///
   @override
@@ -178,6 +178,42 @@ external void Viewer_pick(
       callback,
 );
 
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TViewer>,
+        ffi.Pointer<TView>,
+        ffi.Int,
+        ffi.Int,
+        ffi.Pointer<
+            ffi.NativeFunction<
+                ffi.Void Function(
+                    EntityId entityId,
+                    ffi.Int x,
+                    ffi.Int y,
+                    ffi.Pointer<TView> tView,
+                    ffi.Float depth,
+                    ffi.Float fragX,
+                    ffi.Float fragY,
+                    ffi.Float fragZ)>>)>(isLeaf: true)
+external void Viewer_hoverPick(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<TView> tView,
+  int x,
+  int y,
+  ffi.Pointer<
+          ffi.NativeFunction<
+              ffi.Void Function(
+                  EntityId entityId,
+                  ffi.Int x,
+                  ffi.Int y,
+                  ffi.Pointer<TView> tView,
+                  ffi.Float depth,
+                  ffi.Float fragX,
+                  ffi.Float fragY,
+                  ffi.Float fragZ)>>
+      callback,
+);
+
 @ffi.Native<ffi.Bool Function(ffi.Pointer<TViewer>, EntityId)>(isLeaf: true)
 external bool Viewer_isNonPickableEntity(
   ffi.Pointer<TViewer> viewer,
@@ -218,6 +254,16 @@ external void set_background_image(
   bool fillHeight,
 );
 
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>, ffi.Bool,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void Viewer_setBackgroundImageAsync(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> path,
+  bool fillHeight,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
 @ffi.Native<
     ffi.Void Function(
         ffi.Pointer<TViewer>, ffi.Float, ffi.Float, ffi.Bool)>(isLeaf: true)
@@ -246,6 +292,33 @@ external void load_skybox(
   ffi.Pointer<ffi.Char> skyboxPath,
 );
 
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void Viewer_loadSkyboxAsync(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> skyboxPath,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<ffi.Bool Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>)>(
+    isLeaf: true)
+external bool Viewer_loadPanoramaMaterial(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> path,
+);
+
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>, ffi.Uint32,
+        ffi.Uint32, ffi.Uint32)>(isLeaf: true)
+external void Viewer_loadTiledPanorama(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> uriTemplate,
+  int tileSize,
+  int numLevels,
+  int cacheFaceSize,
+);
+
 @ffi.Native<
     ffi.Void Function(
         ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>, ffi.Float)>(isLeaf: true)
@@ -255,6 +328,33 @@ external void Viewer_loadIbl(
   double intensity,
 );
 
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>, ffi.Float,
+        ffi.Float, ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void Viewer_loadIblAsync(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> iblPath,
+  double intensity,
+  double crossfadeInSecs,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>, ffi.Int)>(isLeaf: true)
+external void Viewer_prefetchEnvironment(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> uri,
+  int priority,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TViewer>, ffi.Size)>(isLeaf: true)
+external void Viewer_setEnvironmentCacheBudget(
+  ffi.Pointer<TViewer> viewer,
+  int budgetInBytes,
+);
+
 @ffi.Native<
     ffi.Void Function(ffi.Pointer<TViewer>, ffi.Float, ffi.Float, ffi.Float,
         ffi.Float)>(isLeaf: true)
@@ -266,6 +366,17 @@ external void create_ibl(
   double intensity,
 );
 
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>, ffi.Float,
+        ffi.Bool, ffi.Pointer<ffi.Char>)>(isLeaf: true)
+external void Viewer_createIblFromImage(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> imagePath,
+  double intensity,
+  bool createSkybox,
+  ffi.Pointer<ffi.Char> cacheDir,
+);
+
 @ffi.Native<ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Float>)>(
     isLeaf: true)
 external void rotate_ibl(
@@ -560,6 +671,24 @@ external void set_animation_frame(
   int animationFrame,
 );
 
+@ffi.Native<
+    ffi.Bool Function(
+        ffi.Pointer<TSceneManager>, EntityId, ffi.Int, ffi.Float)>(isLeaf: true)
+external bool seek_animation(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int animationIndex,
+  double timeInSecs,
+);
+
+@ffi.Native<ffi.Float Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(
+    isLeaf: true)
+external double get_animation_frame_rate(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int animationIndex,
+);
+
 @ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(
     isLeaf: true)
 external void stop_animation(
@@ -975,6 +1104,26 @@ external void add_collision_component(
   bool affectsCollidingTransform,
 );
 
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        EntityId,
+        ffi.Pointer<
+            ffi.NativeFunction<
+                ffi.Void Function(EntityId entityId1, EntityId entityId2)>>,
+        ffi.Bool,
+        ffi.Int)>(isLeaf: true)
+external void SceneManager_addCollisionComponent(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entityId,
+  ffi.Pointer<
+          ffi.NativeFunction<
+              ffi.Void Function(EntityId entityId1, EntityId entityId2)>>
+      callback,
+  bool affectsCollidingTransform,
+  int shapeType,
+);
+
 @ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId)>(
     isLeaf: true)
 external void remove_collision_component(
@@ -1027,6 +1176,149 @@ external void test_collisions(
   int entity,
 );
 
+@ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Bool)>(
+    isLeaf: true)
+external void SceneManager_setCollisionEventsEnabled(
+  ffi.Pointer<TSceneManager> sceneManager,
+  bool enabled,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Bool)>(
+    isLeaf: true)
+external void SceneManager_setStopAtFirstContact(
+  ffi.Pointer<TSceneManager> sceneManager,
+  bool enabled,
+);
+
+@ffi.Native<
+    ffi.Float Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Float,
+        ffi.Float, ffi.Float, ffi.Pointer<EntityId>)>(isLeaf: true)
+external double SceneManager_timeOfImpact(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  double dx,
+  double dy,
+  double dz,
+  ffi.Pointer<EntityId> hitEntity,
+);
+
+@ffi.Native<
+    ffi.Int Function(ffi.Pointer<TSceneManager>, ffi.Pointer<TCollisionEvent>,
+        ffi.Int)>(isLeaf: true)
+external int SceneManager_getCollisionEvents(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TCollisionEvent> out,
+  int capacity,
+);
+
+@ffi.Native<
+    ffi.Int Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Int,
+        ffi.Pointer<TRaycastHit>,
+        ffi.Int)>(isLeaf: true)
+external int SceneManager_raycast(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double originX,
+  double originY,
+  double originZ,
+  double directionX,
+  double directionY,
+  double directionZ,
+  double maxDistance,
+  int layerMask,
+  ffi.Pointer<TRaycastHit> out,
+  int maxHits,
+);
+
+@ffi.Native<
+    ffi.Int Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Pointer<EntityId>,
+        ffi.Int)>(isLeaf: true)
+external int SceneManager_queryBox(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double minX,
+  double minY,
+  double minZ,
+  double maxX,
+  double maxY,
+  double maxZ,
+  ffi.Pointer<EntityId> out,
+  int capacity,
+);
+
+@ffi.Native<
+    ffi.Int Function(ffi.Pointer<TSceneManager>, ffi.Float, ffi.Float,
+        ffi.Float, ffi.Float, ffi.Pointer<EntityId>, ffi.Int)>(isLeaf: true)
+external int SceneManager_querySphere(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double x,
+  double y,
+  double z,
+  double radius,
+  ffi.Pointer<EntityId> out,
+  int capacity,
+);
+
+@ffi.Native<
+    ffi.Int Function(ffi.Pointer<TSceneManager>, ffi.Pointer<TView>,
+        ffi.Pointer<EntityId>, ffi.Int)>(isLeaf: true)
+external int SceneManager_queryFrustum(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TView> view,
+  ffi.Pointer<EntityId> out,
+  int capacity,
+);
+
+@ffi.Native<
+    ffi.Int Function(ffi.Pointer<TSceneManager>, ffi.Float, ffi.Float,
+        ffi.Float, ffi.Int, ffi.Pointer<EntityId>, ffi.Pointer<ffi.Float>)>(
+    isLeaf: true)
+external int SceneManager_queryNearest(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double x,
+  double y,
+  double z,
+  int k,
+  ffi.Pointer<EntityId> out,
+  ffi.Pointer<ffi.Float> distances,
+);
+
+@ffi.Native<
+    ffi.Int Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Pointer<TView>,
+        ffi.Pointer<ffi.Float>,
+        ffi.Int,
+        ffi.Int,
+        ffi.Pointer<EntityId>,
+        ffi.Pointer<ffi.Int32>,
+        ffi.Int)>(isLeaf: true)
+external int SceneManager_pickRegion(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TView> view,
+  ffi.Pointer<ffi.Float> points,
+  int numPoints,
+  int step,
+  ffi.Pointer<EntityId> outEntities,
+  ffi.Pointer<ffi.Int32> outPixelCounts,
+  int capacity,
+);
+
 @ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(
     isLeaf: true)
 external void set_priority(
@@ -1063,6 +1355,23 @@ external void get_bounding_box_to_out(
   ffi.Pointer<ffi.Float> maxY,
 );
 
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Pointer<TView>,
+        ffi.Pointer<EntityId>,
+        ffi.Int,
+        ffi.Pointer<Aabb2>,
+        ffi.Pointer<ffi.Int32>)>(isLeaf: true)
+external void get_bounding_boxes(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TView> view,
+  ffi.Pointer<EntityId> entities,
+  int count,
+  ffi.Pointer<Aabb2> out,
+  ffi.Pointer<ffi.Int32> inFront,
+);
+
 @ffi.Native<
     ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Float,
         ffi.Float, ffi.Float)>(isLeaf: true)
@@ -1173,67 +1482,249 @@ external void apply_texture_to_material(
   int materialIndex,
 );
 
-@ffi.Native<
-    ffi.Pointer<TMaterialInstance> Function(
-        ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(isLeaf: true)
-external ffi.Pointer<TMaterialInstance> get_material_instance_at(
+@ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Size)>(
+    isLeaf: true)
+external void SceneManager_setTextureStreamingBudget(
   ffi.Pointer<TSceneManager> sceneManager,
-  int entity,
-  int materialIndex,
+  int budgetInBytes,
 );
 
-@ffi.Native<ffi.Void Function(ffi.Pointer<TMaterialInstance>, ffi.Bool)>(
+@ffi.Native<TTextureStreamingStats Function(ffi.Pointer<TSceneManager>)>(
     isLeaf: true)
-external void MaterialInstance_setDepthWrite(
-  ffi.Pointer<TMaterialInstance> materialInstance,
-  bool enabled,
+external TTextureStreamingStats SceneManager_getTextureStreamingStats(
+  ffi.Pointer<TSceneManager> sceneManager,
 );
 
-@ffi.Native<ffi.Void Function(ffi.Pointer<TMaterialInstance>, ffi.Bool)>(
+@ffi.Native<TAnimationStats Function(ffi.Pointer<TSceneManager>)>(
     isLeaf: true)
-external void MaterialInstance_setDepthCulling(
-  ffi.Pointer<TMaterialInstance> materialInstance,
-  bool enabled,
+external TAnimationStats SceneManager_getAnimationStats(
+  ffi.Pointer<TSceneManager> sceneManager,
 );
 
 @ffi.Native<
-    ffi.Void Function(ffi.Pointer<TMaterialInstance>, ffi.Pointer<ffi.Char>,
-        ffi.Double, ffi.Double)>(isLeaf: true)
-external void MaterialInstance_setParameterFloat2(
-  ffi.Pointer<TMaterialInstance> materialInstance,
-  ffi.Pointer<ffi.Char> name,
-  double x,
-  double y,
-);
-
-@ffi.Native<TViewport Function(ffi.Pointer<TView>)>(isLeaf: true)
-external TViewport View_getViewport(
-  ffi.Pointer<TView> view,
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>, ffi.Int, ffi.Float)>(isLeaf: true)
+external void SceneManager_setAnimationClock(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int mode,
+  double timestepInSecs,
 );
 
-@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Uint32, ffi.Uint32)>(
+@ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Float)>(
     isLeaf: true)
-external void View_updateViewport(
-  ffi.Pointer<TView> view,
-  int width,
-  int height,
+external void SceneManager_stepAnimations(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double deltaInSecs,
 );
 
-@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Pointer<TRenderTarget>)>(
-    isLeaf: true)
-external void View_setRenderTarget(
-  ffi.Pointer<TView> view,
-  ffi.Pointer<TRenderTarget> renderTarget,
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Bool, ffi.Float, ffi.Int,
+        ffi.Int)>(isLeaf: true)
+external void SceneManager_setAnimationLod(
+  ffi.Pointer<TSceneManager> sceneManager,
+  bool enabled,
+  double distantScreenSize,
+  int distantInterval,
+  int culledInterval,
 );
 
-@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Bool)>(isLeaf: true)
-external void View_setFrustumCullingEnabled(
-  ffi.Pointer<TView> view,
-  bool enabled,
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Float, ffi.Float,
+        ffi.Float)>(isLeaf: true)
+external void SceneManager_setAnimationCompression(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double translationTolerance,
+  double rotationTolerance,
+  double scaleTolerance,
 );
 
-@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Bool)>(isLeaf: true)
-external void View_setPostProcessing(
+@ffi.Native<
+    ffi.Int Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int, ffi.Float,
+        ffi.Int, ffi.Bool, ffi.Pointer<EntityId>, ffi.Int)>(isLeaf: true)
+external int SceneManager_addAnimationLayer(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int animationIndex,
+  double weight,
+  int mode,
+  bool loop,
+  ffi.Pointer<EntityId> maskEntities,
+  int maskCount,
+);
+
+@ffi.Native<
+    ffi.Bool Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+        ffi.Float)>(isLeaf: true)
+external bool SceneManager_setAnimationLayerWeight(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int layerId,
+  double weight,
+);
+
+@ffi.Native<ffi.Bool Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(
+    isLeaf: true)
+external bool SceneManager_removeAnimationLayer(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int layerId,
+);
+
+@ffi.Native<
+    ffi.Int Function(ffi.Pointer<TSceneManager>, ffi.Pointer<ffi.Uint8>,
+        ffi.Size)>(isLeaf: true)
+external int SceneManager_createAnimationStateMachine(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<ffi.Uint8> data,
+  int length,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Int)>(
+    isLeaf: true)
+external void SceneManager_destroyAnimationStateMachine(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int stateMachine,
+);
+
+@ffi.Native<ffi.Bool Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(
+    isLeaf: true)
+external bool SceneManager_setAnimationStateMachine(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int stateMachine,
+);
+
+@ffi.Native<
+    ffi.Bool Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+        ffi.Float)>(isLeaf: true)
+external bool SceneManager_setAnimationStateMachineParameter(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int parameter,
+  double value,
+);
+
+@ffi.Native<ffi.Int Function(ffi.Pointer<TSceneManager>, EntityId)>(
+    isLeaf: true)
+external int SceneManager_getAnimationStateMachineState(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+);
+
+@ffi.Native<ffi.Bool Function(ffi.Pointer<TSceneManager>, ffi.Pointer<ffi.Char>)>(
+    isLeaf: true)
+external bool SceneManager_loadVertexAnimationMaterial(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<ffi.Char> path,
+);
+
+@ffi.Native<
+    ffi.Int Function(
+        ffi.Pointer<TSceneManager>, EntityId, ffi.Int, ffi.Float)>(isLeaf: true)
+external int SceneManager_bakeVertexAnimation(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int animationIndex,
+  double frameRate,
+);
+
+@ffi.Native<
+    EntityId Function(ffi.Pointer<TSceneManager>, ffi.Int, ffi.Pointer<ffi.Float>,
+        ffi.Pointer<ffi.Float>, ffi.Int)>(isLeaf: true)
+external int SceneManager_createVertexAnimationInstances(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int vertexAnimation,
+  ffi.Pointer<ffi.Float> transforms,
+  ffi.Pointer<ffi.Float> timeOffsets,
+  int count,
+);
+
+@ffi.Native<
+    ffi.Bool Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Pointer<ffi.Float>,
+        ffi.Pointer<ffi.Float>, ffi.Int)>(isLeaf: true)
+external bool SceneManager_setVertexAnimationInstances(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  ffi.Pointer<ffi.Float> transforms,
+  ffi.Pointer<ffi.Float> timeOffsets,
+  int count,
+);
+
+@ffi.Native<ffi.Bool Function(ffi.Pointer<TSceneManager>, EntityId)>(
+    isLeaf: true)
+external bool SceneManager_destroyVertexAnimationInstances(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Int)>(
+    isLeaf: true)
+external void SceneManager_destroyVertexAnimation(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int vertexAnimation,
+);
+
+@ffi.Native<
+    ffi.Pointer<TMaterialInstance> Function(
+        ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(isLeaf: true)
+external ffi.Pointer<TMaterialInstance> get_material_instance_at(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int materialIndex,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TMaterialInstance>, ffi.Bool)>(
+    isLeaf: true)
+external void MaterialInstance_setDepthWrite(
+  ffi.Pointer<TMaterialInstance> materialInstance,
+  bool enabled,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TMaterialInstance>, ffi.Bool)>(
+    isLeaf: true)
+external void MaterialInstance_setDepthCulling(
+  ffi.Pointer<TMaterialInstance> materialInstance,
+  bool enabled,
+);
+
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TMaterialInstance>, ffi.Pointer<ffi.Char>,
+        ffi.Double, ffi.Double)>(isLeaf: true)
+external void MaterialInstance_setParameterFloat2(
+  ffi.Pointer<TMaterialInstance> materialInstance,
+  ffi.Pointer<ffi.Char> name,
+  double x,
+  double y,
+);
+
+@ffi.Native<TViewport Function(ffi.Pointer<TView>)>(isLeaf: true)
+external TViewport View_getViewport(
+  ffi.Pointer<TView> view,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Uint32, ffi.Uint32)>(
+    isLeaf: true)
+external void View_updateViewport(
+  ffi.Pointer<TView> view,
+  int width,
+  int height,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Pointer<TRenderTarget>)>(
+    isLeaf: true)
+external void View_setRenderTarget(
+  ffi.Pointer<TView> view,
+  ffi.Pointer<TRenderTarget> renderTarget,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Bool)>(isLeaf: true)
+external void View_setFrustumCullingEnabled(
+  ffi.Pointer<TView> view,
+  bool enabled,
+);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<TView>, ffi.Bool)>(isLeaf: true)
+external void View_setPostProcessing(
   ffi.Pointer<TView> tView,
   bool enabled,
 );
@@ -1444,11 +1935,69 @@ external void Viewer_requestFrameRenderThread(
 
 @ffi.Native<
     ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>, ffi.Float,
-        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+        ffi.Float, ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
 external void Viewer_loadIblRenderThread(
   ffi.Pointer<TViewer> viewer,
   ffi.Pointer<ffi.Char> iblPath,
   double intensity,
+  double crossfadeInSecs,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(
+            ffi.Pointer<TViewer>,
+            ffi.Pointer<ffi.Char>,
+            ffi.Float,
+            ffi.Bool,
+            ffi.Pointer<ffi.Char>,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void Viewer_createIblFromImageRenderThread(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> imagePath,
+  double intensity,
+  bool createSkybox,
+  ffi.Pointer<ffi.Char> cacheDir,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TViewer>, ffi.Size,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void Viewer_setEnvironmentCacheBudgetRenderThread(
+  ffi.Pointer<TViewer> viewer,
+  int budgetInBytes,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TViewer>, ffi.Pointer<ffi.Char>,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>>)>(
+    isLeaf: true)
+external void Viewer_loadPanoramaMaterialRenderThread(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> path,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(
+            ffi.Pointer<TViewer>,
+            ffi.Pointer<ffi.Char>,
+            ffi.Uint32,
+            ffi.Uint32,
+            ffi.Uint32,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void Viewer_loadTiledPanoramaRenderThread(
+  ffi.Pointer<TViewer> viewer,
+  ffi.Pointer<ffi.Char> uriTemplate,
+  int tileSize,
+  int numLevels,
+  int cacheFaceSize,
   ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
 );
 
@@ -1608,6 +2157,317 @@ external void SceneManager_createUnlitMaterialInstanceRenderThread(
       callback,
 );
 
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Size,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_setTextureStreamingBudgetRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int budgetInBytes,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Pointer<TTextureStreamingStats>,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_getTextureStreamingStatsRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TTextureStreamingStats> out,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Pointer<TAnimationStats>,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_getAnimationStatsRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TAnimationStats> out,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Bool,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_setCollisionEventsEnabledRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  bool enabled,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Pointer<TCollisionEvent>,
+        ffi.Int,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>>)>(isLeaf: true)
+external void SceneManager_getCollisionEventsRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TCollisionEvent> out,
+  int capacity,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>> callback,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Pointer<TView>,
+        ffi.Pointer<ffi.Float>,
+        ffi.Int,
+        ffi.Int,
+        ffi.Pointer<EntityId>,
+        ffi.Pointer<ffi.Int32>,
+        ffi.Int,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>>)>(isLeaf: true)
+external void SceneManager_pickRegionRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<TView> view,
+  ffi.Pointer<ffi.Float> points,
+  int numPoints,
+  int step,
+  ffi.Pointer<EntityId> outEntities,
+  ffi.Pointer<ffi.Int32> outPixelCounts,
+  int capacity,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>> callback,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Int,
+        ffi.Float,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_setAnimationClockRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int mode,
+  double timestepInSecs,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Float,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_stepAnimationsRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double deltaInSecs,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Bool,
+        ffi.Float,
+        ffi.Int,
+        ffi.Int,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_setAnimationLodRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  bool enabled,
+  double distantScreenSize,
+  int distantInterval,
+  int culledInterval,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+    ffi.Void Function(
+        ffi.Pointer<TSceneManager>,
+        ffi.Float,
+        ffi.Float,
+        ffi.Float,
+        ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(isLeaf: true)
+external void SceneManager_setAnimationCompressionRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  double translationTolerance,
+  double rotationTolerance,
+  double scaleTolerance,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(
+            ffi.Pointer<TSceneManager>,
+            EntityId,
+            ffi.Int,
+            ffi.Float,
+            ffi.Int,
+            ffi.Bool,
+            ffi.Pointer<EntityId>,
+            ffi.Int,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>>)>(
+    isLeaf: true)
+external void SceneManager_addAnimationLayerRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int animationIndex,
+  double weight,
+  int mode,
+  bool loop,
+  ffi.Pointer<EntityId> maskEntities,
+  int maskCount,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+            ffi.Float, ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void SceneManager_setAnimationLayerWeightRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int layerId,
+  double weight,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void SceneManager_removeAnimationLayerRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int layerId,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Pointer<ffi.Uint8>,
+            ffi.Size, ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>>)>(
+    isLeaf: true)
+external void SceneManager_createAnimationStateMachineRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<ffi.Uint8> data,
+  int length,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Int,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void SceneManager_destroyAnimationStateMachineRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int stateMachine,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>>)>(
+    isLeaf: true)
+external void SceneManager_setAnimationStateMachineRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int stateMachine,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+            ffi.Float, ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void SceneManager_setAnimationStateMachineParameterRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int parameter,
+  double value,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>>)>(
+    isLeaf: true)
+external void SceneManager_getAnimationStateMachineStateRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Pointer<ffi.Char>,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>>)>(
+    isLeaf: true)
+external void SceneManager_loadVertexAnimationMaterialRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  ffi.Pointer<ffi.Char> path,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+            ffi.Float, ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>>)>(
+    isLeaf: true)
+external void SceneManager_bakeVertexAnimationRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  int animationIndex,
+  double frameRate,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Int)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(
+            ffi.Pointer<TSceneManager>,
+            ffi.Int,
+            ffi.Pointer<ffi.Float>,
+            ffi.Pointer<ffi.Float>,
+            ffi.Int,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function(EntityId)>>)>(
+    isLeaf: true)
+external void SceneManager_createVertexAnimationInstancesRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int vertexAnimation,
+  ffi.Pointer<ffi.Float> transforms,
+  ffi.Pointer<ffi.Float> timeOffsets,
+  int count,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(EntityId)>> callback,
+);
+
+@ffi.Native<
+        ffi.Void Function(
+            ffi.Pointer<TSceneManager>,
+            EntityId,
+            ffi.Pointer<ffi.Float>,
+            ffi.Pointer<ffi.Float>,
+            ffi.Int,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void SceneManager_setVertexAnimationInstancesRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  ffi.Pointer<ffi.Float> transforms,
+  ffi.Pointer<ffi.Float> timeOffsets,
+  int count,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void SceneManager_destroyVertexAnimationInstancesRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int entity,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, ffi.Int,
+            ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>>)>(
+    isLeaf: true)
+external void SceneManager_destroyVertexAnimationRenderThread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int vertexAnimation,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function()>> onComplete,
+);
+
 @ffi.Native<
         ffi.Void Function(
             ffi.Pointer<TSceneManager>,
@@ -1688,6 +2548,18 @@ external void set_animation_frame_render_thread(
   int animationFrame,
 );
 
+@ffi.Native<
+        ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int,
+            ffi.Float, ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>>)>(
+    isLeaf: true)
+external void seek_animation_render_thread(
+  ffi.Pointer<TSceneManager> sceneManager,
+  int asset,
+  int animationIndex,
+  double timeInSecs,
+  ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>> callback,
+);
+
 @ffi.Native<ffi.Void Function(ffi.Pointer<TSceneManager>, EntityId, ffi.Int)>(
     isLeaf: true)
 external void stop_animation_render_thread(
@@ -2245,6 +3117,80 @@ final class Aabb2 extends ffi.Struct {
   external double maxY;
 }
 
+final class TTextureStreamingStats extends ffi.Struct {
+  @ffi.Uint32()
+  external int textureCount;
+
+  @ffi.Uint32()
+  external int satisfiedCount;
+
+  @ffi.Uint32()
+  external int pendingCount;
+
+  @ffi.Uint64()
+  external int residentBytes;
+
+  @ffi.Uint64()
+  external int requiredBytes;
+
+  @ffi.Uint64()
+  external int budgetBytes;
+}
+
+final class TAnimationStats extends ffi.Struct {
+  @ffi.Uint64()
+  external int boneMatrixUpdates;
+
+  @ffi.Uint64()
+  external int jointTransformWrites;
+
+  @ffi.Uint64()
+  external int morphWeightUploads;
+
+  @ffi.Uint64()
+  external int evaluatedComponents;
+
+  @ffi.Uint64()
+  external int skippedEvaluations;
+
+  @ffi.Uint64()
+  external int skippedSkinningUpdates;
+
+  @ffi.Uint64()
+  external int uncompressedClipBytes;
+
+  @ffi.Uint64()
+  external int compressedClipBytes;
+}
+
+final class TCollisionEvent extends ffi.Struct {
+  @ffi.Int32()
+  external int type;
+
+  @EntityId()
+  external int entity1;
+
+  @EntityId()
+  external int entity2;
+}
+
+final class TRaycastHit extends ffi.Struct {
+  @EntityId()
+  external int entity;
+
+  @ffi.Float()
+  external double distance;
+
+  @ffi.Array.multi([3])
+  external ffi.Array<ffi.Float> barycentrics;
+
+  @ffi.Array.multi([2])
+  external ffi.Array<ffi.Float> uv;
+
+  @ffi.Int32()
+  external int triangle;
+}
+
 final class ResourceBuffer extends ffi.Struct {
   external ffi.Pointer<ffi.Void> data;
 
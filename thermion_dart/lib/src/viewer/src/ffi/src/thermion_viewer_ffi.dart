@@ -12,6 +12,7 @@ import '../../thermion_viewer_base.dart';
 import 'package:logging/logging.dart';
 
 import 'callbacks.dart';
+import 'thermion_dart.g.dart' as g;
 import 'ffi_camera.dart';
 import 'ffi_view.dart';
 
@@ -40,6 +41,15 @@ class ThermionViewerFFI extends ThermionViewer {
   final _pickResultController =
       StreamController<FilamentPickResult>.broadcast();
 
+  ///
+  ///
+  ///
+  @override
+  Stream<FilamentPickResult> get hoverPickResult =>
+      _hoverPickResultController.stream;
+  final _hoverPickResultController =
+      StreamController<FilamentPickResult>.broadcast();
+
   ///
   ///
   ///
@@ -85,6 +95,9 @@ class ThermionViewerFFI extends ThermionViewer {
     _onPickResultCallable = NativeCallable<
         Void Function(EntityId entityId, Int x, Int y,
             Pointer<TView> view, Float depth, Float fragX, Float fragY, Float fragZ)>.listener(_onPickResult);
+    _onHoverPickResultCallable = NativeCallable<
+        Void Function(EntityId entityId, Int x, Int y,
+            Pointer<TView> view, Float depth, Float fragX, Float fragY, Float fragZ)>.listener(_onHoverPickResult);
 
     _initialize();
   }
@@ -305,6 +318,7 @@ class ThermionViewerFFI extends ThermionViewer {
     await clearEntities();
     await clearLights();
     await _pickResultController.close();
+    await _hoverPickResultController.close();
     await _gizmoPickResultController.close();
     await _sceneUpdateEventController.close();
     Viewer_destroyOnRenderThread(_viewer!);
@@ -377,6 +391,39 @@ class ThermionViewerFFI extends ThermionViewer {
     allocator.free(pathPtr);
   }
 
+  ///
+  ///
+  ///
+  @override
+  Future loadPanoramaMaterial(String path) async {
+    final pathPtr = path.toNativeUtf8(allocator: allocator).cast<Char>();
+    var success = await withBoolCallback((cb) {
+      Viewer_loadPanoramaMaterialRenderThread(_viewer!, pathPtr, cb);
+    });
+    allocator.free(pathPtr);
+    if (!success) {
+      throw Exception("Failed to load panorama material from $path");
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future loadTiledPanorama(String uriTemplate,
+      {required int numLevels,
+      int tileSize = 512,
+      int cacheFaceSize = 2048}) async {
+    final uriPtr = uriTemplate.toNativeUtf8(allocator: allocator).cast<Char>();
+
+    await withVoidCallback((cb) {
+      Viewer_loadTiledPanoramaRenderThread(
+          _viewer!, uriPtr, tileSize, numLevels, cacheFaceSize, cb);
+    });
+
+    allocator.free(uriPtr);
+  }
+
   ///
   ///
   ///
@@ -389,12 +436,59 @@ class ThermionViewerFFI extends ThermionViewer {
   ///
   ///
   @override
-  Future loadIbl(String lightingPath, {double intensity = 30000}) async {
+  Future loadIbl(String lightingPath,
+      {double intensity = 30000, double crossfade = 0.0}) async {
     final pathPtr =
         lightingPath.toNativeUtf8(allocator: allocator).cast<Char>();
 
     await withVoidCallback((cb) {
-      Viewer_loadIblRenderThread(_viewer!, pathPtr, intensity, cb);
+      Viewer_loadIblRenderThread(_viewer!, pathPtr, intensity, crossfade, cb);
+    });
+
+    allocator.free(pathPtr);
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future createIblFromImage(String imagePath,
+      {double intensity = 30000,
+      bool createSkybox = false,
+      String? cacheDirectory}) async {
+    final pathPtr = imagePath.toNativeUtf8(allocator: allocator).cast<Char>();
+    final cacheDirPtr = cacheDirectory == null
+        ? nullptr
+        : cacheDirectory.toNativeUtf8(allocator: allocator).cast<Char>();
+
+    await withVoidCallback((cb) {
+      Viewer_createIblFromImageRenderThread(
+          _viewer!, pathPtr, intensity, createSkybox, cacheDirPtr, cb);
+    });
+
+    allocator.free(pathPtr);
+    if (cacheDirPtr != nullptr) {
+      allocator.free(cacheDirPtr);
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future prefetchEnvironment(String uri, {int priority = 0}) async {
+    final uriPtr = uri.toNativeUtf8(allocator: allocator).cast<Char>();
+    Viewer_prefetchEnvironment(_viewer!, uriPtr, priority);
+    allocator.free(uriPtr);
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setEnvironmentCacheBudget(int budgetInBytes) async {
+    await withVoidCallback((cb) {
+      Viewer_setEnvironmentCacheBudgetRenderThread(_viewer!, budgetInBytes, cb);
     });
   }
 
@@ -1129,7 +1223,35 @@ class ThermionViewerFFI extends ThermionViewer {
   @override
   Future setAnimationFrame(
       ThermionEntity entity, int index, int animationFrame) async {
-    set_animation_frame(_sceneManager!, entity, index, animationFrame);
+    set_animation_frame_render_thread(
+        _sceneManager!, entity, index, animationFrame);
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future seekAnimation(
+      ThermionEntity entity, int index, double timeInSecs) async {
+    var result = await withBoolCallback((cb) {
+      seek_animation_render_thread(
+          _sceneManager!, entity, index, timeInSecs, cb);
+    });
+    if (!result) {
+      throw Exception("Failed to seek animation $index");
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<double> getAnimationFrameRate(ThermionEntity entity, int index) async {
+    var frameRate = get_animation_frame_rate(_sceneManager!, entity, index);
+    if (frameRate < 0) {
+      throw Exception("Failed to get frame rate for animation $index");
+    }
+    return frameRate;
   }
 
   ///
@@ -1521,6 +1643,19 @@ class ThermionViewerFFI extends ThermionViewer {
           Void Function(EntityId entityId, Int x, Int y, Pointer<TView> view, Float depth, Float fragX, Float fragY, Float fragZ)>
       _onPickResultCallable;
 
+  void _onHoverPickResult(
+      ThermionEntity entityId, int x, int y, Pointer<TView> viewPtr, double depth, double fragX, double fragY, double fragZ) async {
+    final view = FFIView(viewPtr, _viewer!);
+    final viewport = await view.getViewport();
+
+    _hoverPickResultController
+        .add((entity: entityId, x: x, y: (viewport.height - y), depth: depth, fragX: fragX, fragY: viewport.height - fragY, fragZ: fragZ ));
+  }
+
+  late NativeCallable<
+          Void Function(EntityId entityId, Int x, Int y, Pointer<TView> view, Float depth, Float fragX, Float fragY, Float fragZ)>
+      _onHoverPickResultCallable;
+
   ///
   ///
   ///
@@ -1533,6 +1668,18 @@ class ThermionViewerFFI extends ThermionViewer {
         _viewer!, view.view, x, y, _onPickResultCallable.nativeFunction);
   }
 
+  ///
+  ///
+  ///
+  @override
+  Future hoverPick(int x, int y) async {
+    final view = (await getViewAt(0)) as FFIView;
+    var viewport = await view.getViewport();
+    y = viewport.height - y;
+    Viewer_hoverPick(
+        _viewer!, view.view, x, y, _onHoverPickResultCallable.nativeFunction);
+  }
+
   ///
   ///
   ///
@@ -1696,7 +1843,8 @@ class ThermionViewerFFI extends ThermionViewer {
   @override
   Future addCollisionComponent(ThermionEntity entity,
       {void Function(int entityId1, int entityId2)? callback,
-      bool affectsTransform = false}) async {
+      bool affectsTransform = false,
+      CollisionShapeType shape = CollisionShapeType.AABB}) async {
     if (_sceneManager == null) {
       throw Exception("SceneManager must be non-null");
     }
@@ -1706,12 +1854,12 @@ class ThermionViewerFFI extends ThermionViewer {
       var ptr = NativeCallable<
           Void Function(
               EntityId entityId1, EntityId entityId2)>.listener(callback);
-      add_collision_component(
-          _sceneManager!, entity, ptr.nativeFunction, affectsTransform);
+      SceneManager_addCollisionComponent(_sceneManager!, entity,
+          ptr.nativeFunction, affectsTransform, shape.index);
       _collisions[entity] = ptr;
     } else {
-      add_collision_component(
-          _sceneManager!, entity, nullptr, affectsTransform);
+      SceneManager_addCollisionComponent(
+          _sceneManager!, entity, nullptr, affectsTransform, shape.index);
     }
   }
 
@@ -1827,6 +1975,244 @@ class ThermionViewerFFI extends ThermionViewer {
     test_collisions(_sceneManager!, entity);
   }
 
+  ///
+  ///
+  ///
+  @override
+  Future setCollisionEventsEnabled(bool enabled) async {
+    await withVoidCallback((cb) {
+      SceneManager_setCollisionEventsEnabledRenderThread(
+          _sceneManager!, enabled, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setStopAtFirstContact(bool enabled) async {
+    SceneManager_setStopAtFirstContact(_sceneManager!, enabled);
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<SweepHit?> timeOfImpact(
+      ThermionEntity entity, Vector3 displacement) async {
+    final hitEntity = allocator<EntityId>(1);
+    final fraction = SceneManager_timeOfImpact(_sceneManager!, entity,
+        displacement.x, displacement.y, displacement.z, hitEntity);
+    final hit = hitEntity.value;
+    allocator.free(hitEntity);
+    if (fraction < 0) {
+      return null;
+    }
+    return (entity: hit, fraction: fraction);
+  }
+
+  int _collisionEventCapacity = 64;
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<CollisionEvent>> getCollisionEvents() async {
+    while (true) {
+      final capacity = _collisionEventCapacity;
+      final out = allocator<TCollisionEvent>(capacity);
+      final count = await withIntCallback((cb) {
+        SceneManager_getCollisionEventsRenderThread(
+            _sceneManager!, out, capacity, cb);
+      });
+      if (count > capacity) {
+        // nothing was copied, so retry with a buffer large enough for every pending event
+        allocator.free(out);
+        _collisionEventCapacity = count * 2;
+        continue;
+      }
+      final events = List<CollisionEvent>.generate(count, (i) {
+        final event = out[i];
+        return (
+          type: CollisionEventType.values[event.type],
+          entity1: event.entity1,
+          entity2: event.entity2
+        );
+      });
+      allocator.free(out);
+      return events;
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<RaycastHit>> raycast(Vector3 origin, Vector3 direction,
+      {double maxDistance = double.infinity,
+      int layerMask = 0xFF,
+      int maxHits = 1}) async {
+    if (maxHits <= 0) {
+      return [];
+    }
+    final out = allocator<TRaycastHit>(maxHits);
+    final count = SceneManager_raycast(
+        _sceneManager!,
+        origin.x,
+        origin.y,
+        origin.z,
+        direction.x,
+        direction.y,
+        direction.z,
+        maxDistance,
+        layerMask,
+        out,
+        maxHits);
+    final hits = List<RaycastHit>.generate(count, (i) {
+      final hit = out[i];
+      return (
+        entity: hit.entity,
+        distance: hit.distance,
+        barycentrics: Vector3(
+            hit.barycentrics[0], hit.barycentrics[1], hit.barycentrics[2]),
+        uv: Vector2(hit.uv[0], hit.uv[1]),
+        triangle: hit.triangle
+      );
+    });
+    allocator.free(out);
+    return hits;
+  }
+
+  int _spatialQueryCapacity = 256;
+
+  // runs [query] with a buffer of [_spatialQueryCapacity] entities, growing the
+  // buffer and retrying if there are more results than fit
+  List<ThermionEntity> _spatialQuery(
+      int Function(Pointer<EntityId> out, int capacity) query) {
+    while (true) {
+      final capacity = _spatialQueryCapacity;
+      final out = allocator<EntityId>(capacity);
+      final count = query(out, capacity);
+      if (count > capacity) {
+        allocator.free(out);
+        _spatialQueryCapacity = count * 2;
+        continue;
+      }
+      final entities = List<ThermionEntity>.generate(count, (i) => out[i]);
+      allocator.free(out);
+      return entities;
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<ThermionEntity>> queryBox(Aabb3 box) async {
+    return _spatialQuery((out, capacity) => SceneManager_queryBox(
+        _sceneManager!,
+        box.min.x,
+        box.min.y,
+        box.min.z,
+        box.max.x,
+        box.max.y,
+        box.max.z,
+        out,
+        capacity));
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<ThermionEntity>> querySphere(
+      Vector3 center, double radius) async {
+    return _spatialQuery((out, capacity) => SceneManager_querySphere(
+        _sceneManager!, center.x, center.y, center.z, radius, out, capacity));
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<ThermionEntity>> queryFrustum({View? view}) async {
+    final ffiView = (view ?? await getViewAt(0)) as FFIView;
+    return _spatialQuery((out, capacity) => SceneManager_queryFrustum(
+        _sceneManager!, ffiView.view, out, capacity));
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<ThermionEntity>> queryNearest(Vector3 point, int k) async {
+    if (k <= 0) {
+      return [];
+    }
+    final out = allocator<EntityId>(k);
+    final count = SceneManager_queryNearest(
+        _sceneManager!, point.x, point.y, point.z, k, out, nullptr);
+    final entities = List<ThermionEntity>.generate(count, (i) => out[i]);
+    allocator.free(out);
+    return entities;
+  }
+
+  int _pickRegionCapacity = 256;
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<RegionPickResult>> pickRegion(List<Vector2> points,
+      {int step = 1, View? view}) async {
+    if (points.length < 3) {
+      throw Exception("A region must have at least three points");
+    }
+    final ffiView = (view ?? await getViewAt(0)) as FFIView;
+    final pointsPtr = allocator<Float>(points.length * 2);
+    for (int i = 0; i < points.length; i++) {
+      pointsPtr[i * 2] = points[i].x;
+      pointsPtr[i * 2 + 1] = points[i].y;
+    }
+    while (true) {
+      final capacity = _pickRegionCapacity;
+      final outEntities = allocator<EntityId>(capacity);
+      final outPixelCounts = allocator<Int32>(capacity);
+      final count = await withIntCallback((cb) {
+        SceneManager_pickRegionRenderThread(_sceneManager!, ffiView.view,
+            pointsPtr, points.length, step, outEntities, outPixelCounts,
+            capacity, cb);
+      });
+      if (count > capacity) {
+        // only the first [capacity] entities were copied, so retry with a buffer large enough for all of them
+        allocator.free(outEntities);
+        allocator.free(outPixelCounts);
+        _pickRegionCapacity = count * 2;
+        continue;
+      }
+      final results = List<RegionPickResult>.generate(count,
+          (i) => (entity: outEntities[i], pixelCount: outPixelCounts[i]));
+      allocator.free(outEntities);
+      allocator.free(outPixelCounts);
+      allocator.free(pointsPtr);
+      return results;
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<List<RegionPickResult>> pickRect(Vector2 min, Vector2 max,
+      {int step = 1, View? view}) {
+    return pickRegion([
+      Vector2(min.x, min.y),
+      Vector2(max.x, min.y),
+      Vector2(max.x, max.y),
+      Vector2(min.x, max.y)
+    ], step: step, view: view);
+  }
+
   ///
   ///
   ///
@@ -1846,6 +2232,39 @@ class ThermionViewerFFI extends ThermionViewer {
         v64.Vector2(result.maxX, result.maxY));
   }
 
+  ///
+  ///
+  ///
+  @override
+  Future<List<v64.Aabb2?>> getViewportBoundingBoxes(
+      List<ThermionEntity> entities,
+      {View? view}) async {
+    if (entities.isEmpty) {
+      return [];
+    }
+    final ffiView = (view ?? await getViewAt(0)) as FFIView;
+    final entityIds = allocator<EntityId>(entities.length);
+    for (int i = 0; i < entities.length; i++) {
+      entityIds[i] = entities[i];
+    }
+    final out = allocator<g.Aabb2>(entities.length);
+    final inFront = allocator<Int32>(entities.length);
+    get_bounding_boxes(_sceneManager!, ffiView.view, entityIds,
+        entities.length, out, inFront);
+    final boxes = List<v64.Aabb2?>.generate(entities.length, (i) {
+      if (inFront[i] == 0) {
+        return null;
+      }
+      final box = out[i];
+      return v64.Aabb2.minMax(
+          v64.Vector2(box.minX, box.minY), v64.Vector2(box.maxX, box.maxY));
+    });
+    allocator.free(entityIds);
+    allocator.free(out);
+    allocator.free(inFront);
+    return boxes;
+  }
+
   ///
   ///
   ///
@@ -1942,6 +2361,348 @@ class ThermionViewerFFI extends ThermionViewer {
     destroy_texture(_sceneManager!, texture._pointer);
   }
 
+  ///
+  ///
+  ///
+  @override
+  Future setTextureStreamingBudget(int budgetInBytes) async {
+    await withVoidCallback((cb) {
+      SceneManager_setTextureStreamingBudgetRenderThread(
+          _sceneManager!, budgetInBytes, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<TextureStreamingStats> getTextureStreamingStats() async {
+    final out = allocator<TTextureStreamingStats>(1);
+    await withVoidCallback((cb) {
+      SceneManager_getTextureStreamingStatsRenderThread(
+          _sceneManager!, out, cb);
+    });
+    final stats = (
+      textureCount: out.ref.textureCount,
+      satisfiedCount: out.ref.satisfiedCount,
+      pendingCount: out.ref.pendingCount,
+      residentBytes: out.ref.residentBytes,
+      requiredBytes: out.ref.requiredBytes,
+      budgetBytes: out.ref.budgetBytes
+    );
+    allocator.free(out);
+    return stats;
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<AnimationStats> getAnimationStats() async {
+    final out = allocator<TAnimationStats>(1);
+    await withVoidCallback((cb) {
+      SceneManager_getAnimationStatsRenderThread(_sceneManager!, out, cb);
+    });
+    final stats = (
+      boneMatrixUpdates: out.ref.boneMatrixUpdates,
+      jointTransformWrites: out.ref.jointTransformWrites,
+      morphWeightUploads: out.ref.morphWeightUploads,
+      evaluatedComponents: out.ref.evaluatedComponents,
+      skippedEvaluations: out.ref.skippedEvaluations,
+      skippedSkinningUpdates: out.ref.skippedSkinningUpdates,
+      uncompressedClipBytes: out.ref.uncompressedClipBytes,
+      compressedClipBytes: out.ref.compressedClipBytes
+    );
+    allocator.free(out);
+    return stats;
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setAnimationClock(AnimationClockMode mode,
+      {double timestepInSecs = 1 / 60}) async {
+    await withVoidCallback((cb) {
+      SceneManager_setAnimationClockRenderThread(
+          _sceneManager!, mode.index, timestepInSecs, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future stepAnimations(double deltaInSecs) async {
+    await withVoidCallback((cb) {
+      SceneManager_stepAnimationsRenderThread(_sceneManager!, deltaInSecs, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setAnimationLod(
+      {bool enabled = true,
+      double distantScreenSize = 0.1,
+      int distantInterval = 4,
+      int culledInterval = 0}) async {
+    await withVoidCallback((cb) {
+      SceneManager_setAnimationLodRenderThread(_sceneManager!, enabled,
+          distantScreenSize, distantInterval, culledInterval, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setAnimationCompression(
+      {double translationTolerance = 1e-4,
+      double rotationTolerance = 1e-4,
+      double scaleTolerance = 1e-4}) async {
+    await withVoidCallback((cb) {
+      SceneManager_setAnimationCompressionRenderThread(_sceneManager!,
+          translationTolerance, rotationTolerance, scaleTolerance, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<int> addAnimationLayer(ThermionEntity entity, int index,
+      {double weight = 1.0,
+      AnimationBlendMode mode = AnimationBlendMode.OVERRIDE,
+      bool loop = true,
+      List<ThermionEntity>? mask}) async {
+    final maskCount = mask?.length ?? 0;
+    final maskPtr = allocator<Int32>(max(maskCount, 1));
+    for (int i = 0; i < maskCount; i++) {
+      maskPtr[i] = mask![i];
+    }
+    final layerId = await withIntCallback((cb) {
+      SceneManager_addAnimationLayerRenderThread(_sceneManager!, entity, index,
+          weight, mode.index, loop, maskPtr, maskCount, cb);
+    });
+    allocator.free(maskPtr);
+    if (layerId < 0) {
+      throw Exception("Failed to add animation layer");
+    }
+    return layerId;
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setAnimationLayerWeight(
+      ThermionEntity entity, int layerId, double weight) async {
+    await withVoidCallback((cb) {
+      SceneManager_setAnimationLayerWeightRenderThread(
+          _sceneManager!, entity, layerId, weight, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future removeAnimationLayer(ThermionEntity entity, int layerId) async {
+    await withVoidCallback((cb) {
+      SceneManager_removeAnimationLayerRenderThread(
+          _sceneManager!, entity, layerId, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<int> createAnimationStateMachine(
+      AnimationStateMachine stateMachine) async {
+    final data = stateMachine.compile();
+    final dataPtr = allocator<Uint8>(data.length);
+    dataPtr.asTypedList(data.length).setAll(0, data);
+    var id = await withIntCallback((cb) {
+      SceneManager_createAnimationStateMachineRenderThread(
+          _sceneManager!, dataPtr, data.length, cb);
+    });
+    allocator.free(dataPtr);
+    if (id < 0) {
+      throw Exception("Failed to create animation state machine");
+    }
+    return id;
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future destroyAnimationStateMachine(int stateMachine) async {
+    await withVoidCallback((cb) {
+      SceneManager_destroyAnimationStateMachineRenderThread(
+          _sceneManager!, stateMachine, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setAnimationStateMachine(
+      ThermionEntity entity, int? stateMachine) async {
+    var success = await withBoolCallback((cb) {
+      SceneManager_setAnimationStateMachineRenderThread(
+          _sceneManager!, entity, stateMachine ?? -1, cb);
+    });
+    if (!success) {
+      throw Exception("Failed to set animation state machine");
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setAnimationStateMachineParameter(
+      ThermionEntity entity, int parameter, double value) async {
+    await withVoidCallback((cb) {
+      SceneManager_setAnimationStateMachineParameterRenderThread(
+          _sceneManager!, entity, parameter, value, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<int> getAnimationStateMachineState(ThermionEntity entity) async {
+    return withIntCallback((cb) {
+      SceneManager_getAnimationStateMachineStateRenderThread(
+          _sceneManager!, entity, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future loadVertexAnimationMaterial(String path) async {
+    final pathPtr = path.toNativeUtf8(allocator: allocator).cast<Char>();
+    var success = await withBoolCallback((cb) {
+      SceneManager_loadVertexAnimationMaterialRenderThread(
+          _sceneManager!, pathPtr, cb);
+    });
+    allocator.free(pathPtr);
+    if (!success) {
+      throw Exception("Failed to load vertex animation material from $path");
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<int> bakeVertexAnimation(ThermionEntity entity, int animationIndex,
+      {double frameRate = 30.0}) async {
+    var vertexAnimation = await withIntCallback((cb) {
+      SceneManager_bakeVertexAnimationRenderThread(
+          _sceneManager!, entity, animationIndex, frameRate, cb);
+    });
+    if (vertexAnimation < 0) {
+      throw Exception("Failed to bake vertex animation");
+    }
+    return vertexAnimation;
+  }
+
+  (Pointer<Float>, Pointer<Float>) _allocateVertexAnimationInstances(
+      List<Matrix4> transforms, List<double>? timeOffsets) {
+    if (timeOffsets != null && timeOffsets.length != transforms.length) {
+      throw Exception(
+          "Expected ${transforms.length} time offsets, got ${timeOffsets.length}");
+    }
+    final transformsPtr = allocator<Float>(transforms.length * 16);
+    for (int i = 0; i < transforms.length; i++) {
+      for (int j = 0; j < 16; j++) {
+        transformsPtr[(i * 16) + j] = transforms[i].storage[j];
+      }
+    }
+    var timeOffsetsPtr = nullptr.cast<Float>();
+    if (timeOffsets != null) {
+      timeOffsetsPtr = allocator<Float>(timeOffsets.length);
+      for (int i = 0; i < timeOffsets.length; i++) {
+        timeOffsetsPtr[i] = timeOffsets[i];
+      }
+    }
+    return (transformsPtr, timeOffsetsPtr);
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future<ThermionEntity> createVertexAnimationInstances(
+      int vertexAnimation, List<Matrix4> transforms,
+      {List<double>? timeOffsets}) async {
+    final (transformsPtr, timeOffsetsPtr) =
+        _allocateVertexAnimationInstances(transforms, timeOffsets);
+    var entity = await withIntCallback((cb) {
+      SceneManager_createVertexAnimationInstancesRenderThread(_sceneManager!,
+          vertexAnimation, transformsPtr, timeOffsetsPtr, transforms.length, cb);
+    });
+    allocator.free(transformsPtr);
+    if (timeOffsetsPtr != nullptr) {
+      allocator.free(timeOffsetsPtr);
+    }
+    if (entity == 0) {
+      throw Exception("Failed to create vertex animation instances");
+    }
+    return entity;
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future setVertexAnimationInstances(
+      ThermionEntity entity, List<Matrix4> transforms,
+      {List<double>? timeOffsets}) async {
+    final (transformsPtr, timeOffsetsPtr) =
+        _allocateVertexAnimationInstances(transforms, timeOffsets);
+    await withVoidCallback((cb) {
+      SceneManager_setVertexAnimationInstancesRenderThread(_sceneManager!,
+          entity, transformsPtr, timeOffsetsPtr, transforms.length, cb);
+    });
+    allocator.free(transformsPtr);
+    if (timeOffsetsPtr != nullptr) {
+      allocator.free(timeOffsetsPtr);
+    }
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future destroyVertexAnimationInstances(ThermionEntity entity) async {
+    await withVoidCallback((cb) {
+      SceneManager_destroyVertexAnimationInstancesRenderThread(
+          _sceneManager!, entity, cb);
+    });
+  }
+
+  ///
+  ///
+  ///
+  @override
+  Future destroyVertexAnimation(int vertexAnimation) async {
+    await withVoidCallback((cb) {
+      SceneManager_destroyVertexAnimationRenderThread(
+          _sceneManager!, vertexAnimation, cb);
+    });
+  }
+
   Future<MaterialInstance> createUbershaderMaterialInstance(
       {bool doubleSided = false,
       bool unlit = false,
@@ -0,0 +1,40 @@
+///
+/// How the animation clock advances (see [ThermionViewer.setAnimationClock]).
+///
+enum AnimationClockMode {
+  WALL_CLOCK, //!< animations are driven by the wall clock (the default)
+  FIXED_TIMESTEP, //!< the clock advances by a fixed timestep every rendered frame
+  MANUAL //!< the clock only advances when [ThermionViewer.stepAnimations] is called
+}
+
+///
+/// How an animation layer is combined with the layers below it
+/// (see [ThermionViewer.addAnimationLayer]).
+///
+enum AnimationBlendMode {
+  OVERRIDE, //!< the layer's pose is blended towards by the layer weight
+  ADDITIVE //!< the layer's offset from the rest pose is added, scaled by the layer weight
+}
+
+///
+/// Cumulative counters for the work done by the animation system
+/// (see [ThermionViewer.getAnimationStats]).
+/// [boneMatrixUpdates] is the number of times the bone matrices of an instance
+/// were recomputed/uploaded; [morphWeightUploads] is the number of morph weight
+/// uploads (each covering a contiguous range of morph targets).
+/// [skippedEvaluations]/[skippedSkinningUpdates] count the updates skipped by
+/// animation LOD (see [ThermionViewer.setAnimationLod]).
+/// [uncompressedClipBytes]/[compressedClipBytes] are the total size of every
+/// bone/morph animation added, before and after compression
+/// (see [ThermionViewer.setAnimationCompression]).
+///
+typedef AnimationStats = ({
+  int boneMatrixUpdates,
+  int jointTransformWrites,
+  int morphWeightUploads,
+  int evaluatedComponents,
+  int skippedEvaluations,
+  int skippedSkinningUpdates,
+  int uncompressedClipBytes,
+  int compressedClipBytes
+});
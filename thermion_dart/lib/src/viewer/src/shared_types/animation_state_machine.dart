@@ -0,0 +1,192 @@
+import 'dart:typed_data';
+
+///
+/// The type of an [AnimationStateMachine] parameter.
+///
+enum AnimationStateMachineParameterType {
+  FLOAT, //!< compared against a threshold
+  BOOL, //!< set to 0 (false) or 1 (true)
+  TRIGGER //!< a bool that is reset as soon as a transition that tests it is taken
+}
+
+enum AnimationConditionOp { GREATER, LESS, EQUAL, NOT_EQUAL }
+
+///
+/// A condition that must be met before an [AnimationStateMachine] transition
+/// can be taken.
+///
+class AnimationCondition {
+  final String parameter;
+  final AnimationConditionOp op;
+  final double value;
+
+  AnimationCondition(this.parameter, this.op, this.value);
+
+  AnimationCondition.greaterThan(this.parameter, this.value)
+      : op = AnimationConditionOp.GREATER;
+
+  AnimationCondition.lessThan(this.parameter, this.value)
+      : op = AnimationConditionOp.LESS;
+
+  ///
+  /// Met when the bool/trigger [parameter] is set.
+  ///
+  AnimationCondition.isSet(this.parameter)
+      : op = AnimationConditionOp.EQUAL,
+        value = 1.0;
+
+  ///
+  /// Met when the bool [parameter] is not set.
+  ///
+  AnimationCondition.isNotSet(this.parameter)
+      : op = AnimationConditionOp.EQUAL,
+        value = 0.0;
+}
+
+class _AnimationTransition {
+  final String? from;
+  final String to;
+  final double blendDuration;
+  final double? exitTime;
+  final List<AnimationCondition> conditions;
+
+  _AnimationTransition(
+      this.from, this.to, this.blendDuration, this.exitTime, this.conditions);
+}
+
+///
+/// Describes a state machine that selects which glTF animation an entity
+/// plays. Each state plays a single glTF animation; a transition cross-fades
+/// to another state as soon as its conditions are met.
+///
+/// Once compiled (see [ThermionViewer.createAnimationStateMachine]), the state
+/// machine is evaluated natively every frame, so only parameter changes need
+/// to be sent from Dart (see
+/// [ThermionViewer.setAnimationStateMachineParameter]).
+///
+class AnimationStateMachine {
+  static const _kMagic = 0x4d534154;
+  static const _kVersion = 1;
+  static const _kAnyState = -1;
+
+  final _parameters =
+      <String, (AnimationStateMachineParameterType, double)>{};
+  final _states = <String, (int, bool)>{};
+  final _transitions = <_AnimationTransition>[];
+
+  ///
+  /// The state that is entered when the state machine is attached to an
+  /// entity. Defaults to the first state added.
+  ///
+  String? initialState;
+
+  void addParameter(String name, AnimationStateMachineParameterType type,
+      {double defaultValue = 0.0}) {
+    if (_parameters.containsKey(name)) {
+      throw Exception("Parameter $name already exists");
+    }
+    _parameters[name] = (type, defaultValue);
+  }
+
+  ///
+  /// Adds a state that plays the glTF animation at [animationIndex].
+  ///
+  void addState(String name, int animationIndex, {bool loop = true}) {
+    if (_states.containsKey(name)) {
+      throw Exception("State $name already exists");
+    }
+    _states[name] = (animationIndex, loop);
+  }
+
+  ///
+  /// Adds a transition from the state [from] (or from any state, if null) to
+  /// [to]. Transitions are tested in the order they were added, and the first
+  /// transition whose [conditions] are all met is taken. If [exitTime] is
+  /// provided, the transition can only be taken once the current state has
+  /// played for that fraction of its duration (e.g. 1.0 to wait until the
+  /// animation has finished).
+  ///
+  void addTransition(String? from, String to,
+      {double blendDuration = 0.25,
+      double? exitTime,
+      List<AnimationCondition> conditions = const []}) {
+    _transitions.add(
+        _AnimationTransition(from, to, blendDuration, exitTime, conditions));
+  }
+
+  int getParameterIndex(String name) {
+    final index = _parameters.keys.toList().indexOf(name);
+    if (index == -1) {
+      throw Exception("Unknown parameter $name");
+    }
+    return index;
+  }
+
+  int getStateIndex(String name) {
+    final index = _states.keys.toList().indexOf(name);
+    if (index == -1) {
+      throw Exception("Unknown state $name");
+    }
+    return index;
+  }
+
+  String getStateName(int index) {
+    return _states.keys.elementAt(index);
+  }
+
+  ///
+  /// Compiles this state machine into the binary format parsed by the native
+  /// AnimationStateMachine.
+  ///
+  Uint8List compile() {
+    if (_states.isEmpty) {
+      throw Exception("An animation state machine needs at least one state");
+    }
+    final words = <(bool, num)>[];
+    void writeInt(int value) => words.add((true, value));
+    void writeFloat(double value) => words.add((false, value));
+
+    writeInt(_kMagic);
+    writeInt(_kVersion);
+
+    writeInt(_parameters.length);
+    for (final (type, defaultValue) in _parameters.values) {
+      writeInt(type.index);
+      writeFloat(defaultValue);
+    }
+
+    writeInt(_states.length);
+    writeInt(getStateIndex(initialState ?? _states.keys.first));
+    for (final (animationIndex, loop) in _states.values) {
+      writeInt(animationIndex);
+      writeInt(loop ? 1 : 0);
+    }
+
+    writeInt(_transitions.length);
+    for (final transition in _transitions) {
+      writeInt(transition.from == null
+          ? _kAnyState
+          : getStateIndex(transition.from!));
+      writeInt(getStateIndex(transition.to));
+      writeFloat(transition.blendDuration);
+      writeFloat(transition.exitTime ?? -1.0);
+      writeInt(transition.conditions.length);
+      for (final condition in transition.conditions) {
+        writeInt(getParameterIndex(condition.parameter));
+        writeInt(condition.op.index);
+        writeFloat(condition.value);
+      }
+    }
+
+    final data = ByteData(words.length * 4);
+    for (int i = 0; i < words.length; i++) {
+      final (isInt, value) = words[i];
+      if (isInt) {
+        data.setInt32(i * 4, value.toInt(), Endian.little);
+      } else {
+        data.setFloat32(i * 4, value.toDouble(), Endian.little);
+      }
+    }
+    return data.buffer.asUint8List();
+  }
+}
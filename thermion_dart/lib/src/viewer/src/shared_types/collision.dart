@@ -0,0 +1,34 @@
+import 'entities.dart';
+
+///
+/// The shape used to test a collidable entity against others
+/// (see [ThermionViewer.addCollisionComponent]).
+///
+enum CollisionShapeType {
+  AABB, //!< the bounding box of the entity, re-aligned with the world axes as the entity rotates
+  OBB //!< an oriented box that rotates with the entity (fitted to the mesh, if the asset was loaded with keepData)
+}
+
+enum CollisionEventType {
+  BEGIN, //!< the entities started overlapping this frame
+  PERSIST, //!< the entities are still overlapping
+  END //!< the entities stopped overlapping this frame (or one was removed)
+}
+
+///
+/// The first collidable entity touched by a moving entity (see
+/// [ThermionViewer.timeOfImpact]), and the fraction (from 0 to 1) of the
+/// movement at which it is touched.
+///
+typedef SweepHit = ({ThermionEntity entity, double fraction});
+
+///
+/// A change in the overlap between the collision shapes of two collidable
+/// entities, recorded by the per-frame collision pass
+/// (see [ThermionViewer.setCollisionEventsEnabled]).
+///
+typedef CollisionEvent = ({
+  CollisionEventType type,
+  ThermionEntity entity1,
+  ThermionEntity entity2
+});
@@ -1,3 +1,5 @@
+import 'package:vector_math/vector_math_64.dart';
+
 import '../../viewer.dart';
 
 /// The result of a picking operation (see [ThermionViewer.pick] for more details).
@@ -15,3 +17,21 @@ typedef FilamentPickResult = ({
   double fragZ
 });
 typedef PickResult = FilamentPickResult;
+
+/// A ray intersection found by [ThermionViewer.raycast]. [distance] is measured
+/// along the ray from its origin, [barycentrics] are the barycentric coordinates
+/// of the hit point within triangle [triangle] of the entity's mesh and [uv] are
+/// the interpolated texture coordinates (zero if the mesh has none).
+///
+typedef RaycastHit = ({
+  ThermionEntity entity,
+  double distance,
+  Vector3 barycentrics,
+  Vector2 uv,
+  int triangle
+});
+
+/// An entity found by [ThermionViewer.pickRegion], with the (estimated) number
+/// of pixels it covers within the region.
+///
+typedef RegionPickResult = ({ThermionEntity entity, int pixelCount});
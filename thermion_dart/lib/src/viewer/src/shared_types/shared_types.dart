@@ -6,6 +6,9 @@ export 'render_target.dart';
 export 'camera.dart';
 export 'material.dart';
 export 'texture.dart';
+export 'animation.dart';
+export 'animation_state_machine.dart';
+export 'collision.dart';
 export 'entities.dart';
 export 'light.dart';
 export 'shadow.dart';
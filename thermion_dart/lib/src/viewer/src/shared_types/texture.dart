@@ -1,3 +1,18 @@
 abstract class ThermionTexture {
   
-}
\ No newline at end of file
+}
+
+///
+/// A snapshot of the state of the texture streamer (see [ThermionViewer.getTextureStreamingStats]).
+/// [satisfiedCount] is the number of textures whose required mip level is resident;
+/// [requiredBytes] is the (estimated) GPU memory that would be needed to make the required mip level
+/// of every texture resident.
+///
+typedef TextureStreamingStats = ({
+  int textureCount,
+  int satisfiedCount,
+  int pendingCount,
+  int residentBytes,
+  int requiredBytes,
+  int budgetBytes
+});
\ No newline at end of file
@@ -28,6 +28,11 @@ abstract class ThermionViewer {
   ///
   Stream<FilamentPickResult> get pickResult;
 
+  ///
+  /// The result(s) of calling [hoverPick] (see below). As with [pickResult], subscribe before calling [hoverPick].
+  ///
+  Stream<FilamentPickResult> get hoverPickResult;
+
   ///
   /// A Stream containing entities added/removed to/from to the scene.
   ///
@@ -119,6 +124,7 @@ abstract class ThermionViewer {
   /// This will be rendered at the maximum depth (i.e. behind all other objects including the skybox).
   /// If [fillHeight] is false, the image will be rendered at its original size. Note this may cause issues with pixel density so be sure to specify the correct resolution
   /// If [fillHeight] is true, the image will be stretched/compressed to fit the height of the viewport.
+  /// The image is decoded in the background; the current background image remains visible until the returned Future completes.
   ///
   Future setBackgroundImage(String path, {bool fillHeight = false});
 
@@ -140,6 +146,7 @@ abstract class ThermionViewer {
 
   ///
   /// Load a skybox from [skyboxPath] (which must be a .ktx file)
+  /// The skybox is loaded in the background; the current skybox remains visible until the returned Future completes.
   ///
   Future loadSkybox(String skyboxPath);
 
@@ -148,11 +155,51 @@ abstract class ThermionViewer {
   ///
   Future removeSkybox();
 
+  ///
+  /// Loads the compiled panorama material (materials/panorama.mat,
+  /// compiled to panorama.filamat by `make materials`) from [path].
+  /// This must be called before [loadTiledPanorama].
+  ///
+  Future loadPanoramaMaterial(String path);
+
+  ///
+  /// Replaces the skybox with a tiled, multi-resolution cubemap panorama.
+  /// [uriTemplate] is the path to each tile, where the tokens {level}, {face}, {x} and {y} will be substituted
+  /// (e.g. "assets/pano/{level}/{face}_{x}_{y}.jpg"). {face} is one of px, nx, py, ny, pz or nz and {y} is counted from the top of the face.
+  /// Level 0 must contain a single [tileSize]x[tileSize] tile per face; each of the remaining [numLevels] levels doubles the face resolution.
+  /// Only the tiles visible to the active camera are loaded, refining progressively from level 0.
+  /// [cacheFaceSize] bounds the GPU memory of the tile cache (it holds as many tiles as a cubemap with faces of this size);
+  /// it does not limit the resolution, since only the visible tiles of the finest required level are kept resident.
+  /// Call [removeSkybox] to remove the panorama.
+  ///
+  Future loadTiledPanorama(String uriTemplate,
+      {required int numLevels, int tileSize = 512, int cacheFaceSize = 2048});
+
   ///
   /// Creates an indirect light by loading the reflections/irradiance from the KTX file.
   /// Only one indirect light can be active at any given time; if an indirect light has already been loaded, it will be replaced.
+  /// The IBL is loaded in the background; the current indirect light remains active until it is ready.
+  /// If [crossfade] (in seconds) is greater than zero, the intensity of the current indirect light is faded out and
+  /// the new indirect light faded in over this duration. The returned Future completes once the fade has finished.
   ///
-  Future loadIbl(String lightingPath, {double intensity = 30000});
+  Future loadIbl(String lightingPath,
+      {double intensity = 30000, double crossfade = 0.0});
+
+  ///
+  /// Loads the skybox/IBL (.ktx) at [uri] in the background so that a
+  /// subsequent call to [loadSkybox]/[loadIbl] with the same [uri] can swap
+  /// immediately, without loading or decoding anything on the render thread.
+  /// Use this to prefetch neighbouring scenes (e.g. in a 360 tour).
+  /// Requests with a higher [priority] are loaded first.
+  /// Prefetched environments are retained until evicted (least recently used
+  /// first) to stay within the budget set by [setEnvironmentCacheBudget].
+  ///
+  Future prefetchEnvironment(String uri, {int priority = 0});
+
+  ///
+  /// Sets the maximum memory (in bytes) used by prefetched environments (256MB by default).
+  ///
+  Future setEnvironmentCacheBudget(int budgetInBytes);
 
   ///
   /// Creates a indirect light with the given color.
@@ -160,6 +207,20 @@ abstract class ThermionViewer {
   ///
   Future createIbl(double r, double g, double b, double intensity);
 
+  ///
+  /// Creates an indirect light by prefiltering the equirectangular image at
+  /// [imagePath] (.hdr, .png or .jpg) at runtime.
+  /// If [createSkybox] is true, the image will also replace the current skybox.
+  /// If [cacheDirectory] is provided, the prefiltered result is cached in this
+  /// directory (keyed by the image contents) so subsequent calls with the
+  /// same image can skip the prefilter step.
+  /// Only one indirect light can be active at any given time; if an indirect light has already been loaded, it will be replaced.
+  ///
+  Future createIblFromImage(String imagePath,
+      {double intensity = 30000,
+      bool createSkybox = false,
+      String? cacheDirectory});
+
   ///
   /// Rotates the IBL & skybox.
   ///
@@ -340,6 +401,171 @@ abstract class ThermionViewer {
       double fadeOutInSecs = 0.0,
       double maxDelta = 1.0});
 
+  ///
+  /// Returns the number of bone matrix updates, joint transform writes and
+  /// morph weight uploads performed by the animation system so far.
+  ///
+  Future<AnimationStats> getAnimationStats();
+
+  ///
+  /// Sets how the clock that drives all animations advances.
+  /// By default, animations are driven by the wall clock. When rendering
+  /// offline (or replaying), use [AnimationClockMode.FIXED_TIMESTEP] to advance
+  /// animations by exactly [timestepInSecs] every rendered frame, or
+  /// [AnimationClockMode.MANUAL] to advance them only via [stepAnimations].
+  /// Either way, the output no longer depends on how long each frame takes to render.
+  ///
+  Future setAnimationClock(AnimationClockMode mode,
+      {double timestepInSecs = 1 / 60});
+
+  ///
+  /// Advances the animation clock by [deltaInSecs] (only when the clock mode
+  /// is not [AnimationClockMode.WALL_CLOCK]). The new time is applied the next
+  /// time a frame is rendered.
+  ///
+  Future stepAnimations(double deltaInSecs);
+
+  ///
+  /// Enables/disables animation LOD. When enabled, animated entities that
+  /// aren't visible in any rendered view are updated every [culledInterval]
+  /// frames (or not at all if [culledInterval] is 0) and their bone matrices
+  /// aren't updated; entities that occupy less than [distantScreenSize] of the
+  /// viewport height are updated every [distantInterval] frames.
+  /// Skipped updates are reported by [getAnimationStats].
+  ///
+  Future setAnimationLod(
+      {bool enabled = true,
+      double distantScreenSize = 0.1,
+      int distantInterval = 4,
+      int culledInterval = 0});
+
+  ///
+  /// Sets the tolerances used to compress animations subsequently added via
+  /// [addBoneAnimation]. Keyframes are removed where the remaining keyframes
+  /// can reconstruct them within [translationTolerance] (world units),
+  /// [rotationTolerance] (radians) and [scaleTolerance]; the remaining values
+  /// are quantized to 16 bits. Pass zero to keep every keyframe.
+  /// Morph animation weights are quantized (but every frame is kept).
+  /// See [getAnimationStats] for the resulting compression ratio.
+  ///
+  Future setAnimationCompression(
+      {double translationTolerance = 1e-4,
+      double rotationTolerance = 1e-4,
+      double scaleTolerance = 1e-4});
+
+  ///
+  /// Adds a blend layer that plays the glTF animation at [index] on [entity]
+  /// and returns its ID. Layers are applied in the order they were added,
+  /// on top of any animation started with [playAnimation], each blended in
+  /// by [weight] according to [mode]. If [mask] is provided, the layer only
+  /// affects those entities (and their descendants), e.g. the upper body
+  /// of a character.
+  ///
+  Future<int> addAnimationLayer(ThermionEntity entity, int index,
+      {double weight = 1.0,
+      AnimationBlendMode mode = AnimationBlendMode.OVERRIDE,
+      bool loop = true,
+      List<ThermionEntity>? mask});
+
+  ///
+  /// Sets the weight of the animation layer [layerId] (see [addAnimationLayer]).
+  ///
+  Future setAnimationLayerWeight(
+      ThermionEntity entity, int layerId, double weight);
+
+  ///
+  /// Removes the animation layer [layerId] (see [addAnimationLayer]).
+  ///
+  Future removeAnimationLayer(ThermionEntity entity, int layerId);
+
+  ///
+  /// Compiles [stateMachine] and uploads it to the native animation system,
+  /// returning an ID that can be attached to any number of entities with
+  /// [setAnimationStateMachine].
+  ///
+  Future<int> createAnimationStateMachine(AnimationStateMachine stateMachine);
+
+  ///
+  /// Destroys the state machine [stateMachine] (see [createAnimationStateMachine]).
+  /// Entities it is attached to will continue to use it until detached.
+  ///
+  Future destroyAnimationStateMachine(int stateMachine);
+
+  ///
+  /// Attaches the state machine [stateMachine] to [entity] and enters its
+  /// initial state, or detaches the current state machine if [stateMachine]
+  /// is null. While attached, the state machine replaces any animation
+  /// started with [playAnimation].
+  ///
+  Future setAnimationStateMachine(ThermionEntity entity, int? stateMachine);
+
+  ///
+  /// Sets the value of [parameter] (see
+  /// [AnimationStateMachine.getParameterIndex]) for the state machine attached
+  /// to [entity]. Use 0/1 for bool and trigger parameters. Any transition
+  /// this enables is taken when the next frame is rendered.
+  ///
+  Future setAnimationStateMachineParameter(
+      ThermionEntity entity, int parameter, double value);
+
+  ///
+  /// Returns the index of the current state of the state machine attached to
+  /// [entity] (see [AnimationStateMachine.getStateName]), or -1 if none is
+  /// attached.
+  ///
+  Future<int> getAnimationStateMachineState(ThermionEntity entity);
+
+  ///
+  /// Loads the compiled vertex animation material (materials/vat.mat,
+  /// compiled to vat.filamat by `make materials`) from [path].
+  /// This must be called before [createVertexAnimationInstances].
+  ///
+  Future loadVertexAnimationMaterial(String path);
+
+  ///
+  /// Bakes the glTF animation at [animationIndex] for [entity] into a vertex
+  /// animation texture sampled at [frameRate] frames per second, and returns
+  /// an ID for [createVertexAnimationInstances]. [entity] must have been
+  /// loaded with `keepData: true`.
+  ///
+  /// Baked animations are played entirely on the GPU, so large crowds cost
+  /// about as much CPU time as static geometry. The baked mesh is rendered
+  /// unlit with the base color factor of each primitive (textures are not
+  /// baked).
+  ///
+  Future<int> bakeVertexAnimation(ThermionEntity entity, int animationIndex,
+      {double frameRate = 30.0});
+
+  ///
+  /// Creates an entity that draws one instance of the baked animation
+  /// [vertexAnimation] (see [bakeVertexAnimation]) at each of [transforms],
+  /// with a single draw call. Each instance's animation is offset by the
+  /// corresponding entry in [timeOffsets] (in seconds).
+  /// Animations advance with the animation clock (see [setAnimationClock]).
+  ///
+  Future<ThermionEntity> createVertexAnimationInstances(
+      int vertexAnimation, List<Matrix4> transforms,
+      {List<double>? timeOffsets});
+
+  ///
+  /// Updates the transforms/time offsets of every instance drawn by [entity]
+  /// (see [createVertexAnimationInstances]). The number of instances can't
+  /// be changed.
+  ///
+  Future setVertexAnimationInstances(
+      ThermionEntity entity, List<Matrix4> transforms,
+      {List<double>? timeOffsets});
+
+  ///
+  /// Removes and destroys an entity created by [createVertexAnimationInstances].
+  ///
+  Future destroyVertexAnimationInstances(ThermionEntity entity);
+
+  ///
+  /// Destroys the baked animation [vertexAnimation] (and any instances created from it).
+  ///
+  Future destroyVertexAnimation(int vertexAnimation);
+
   ///
   /// Gets the entity representing the bone at [boneIndex]/[skinIndex].
   /// The returned entity is only intended for use with [getWorldTransform].
@@ -425,9 +651,30 @@ abstract class ThermionViewer {
       bool replaceActive = true,
       double crossfade = 0.0});
 
+  ///
+  /// Applies the glTF animation at [index] in [entity] at [animationFrame].
+  /// Frames are counted at the frame rate of the animation (see
+  /// [getAnimationFrameRate]).
+  ///
   Future setAnimationFrame(
       ThermionEntity entity, int index, int animationFrame);
 
+  ///
+  /// Applies the glTF animation at [index] in [entity] at [timeInSecs]
+  /// (e.g. to scrub through an animation timeline).
+  ///
+  /// Seeking is cheapest when the playhead moves in small steps, and when
+  /// [entity] was loaded with keepData (the keyframes for each channel are
+  /// then cached natively).
+  ///
+  Future seekAnimation(ThermionEntity entity, int index, double timeInSecs);
+
+  ///
+  /// Returns the frame rate of the glTF animation at [index] in [entity],
+  /// estimated from the interval between its keyframes.
+  ///
+  Future<double> getAnimationFrameRate(ThermionEntity entity, int index);
+
   Future stopAnimation(ThermionEntity entity, int animationIndex);
   Future stopAnimationByName(ThermionEntity entity, String name);
 
@@ -697,6 +944,14 @@ abstract class ThermionViewer {
   ///
   Future pick(int x, int y);
 
+  ///
+  /// Picks the entity under the given viewport coordinates for hover feedback (e.g. on every pointer move).
+  /// Unlike [pick], requests are coalesced: only the latest coordinate is kept, at most one pick is in flight at any time
+  /// and at most one result is emitted (on [hoverPickResult]) per rendered frame, so results may be skipped but never queue up.
+  /// [x] and [y] must be in local logical coordinates (i.e. where 0,0 is at top-left of the ThermionWidget).
+  ///
+  Future hoverPick(int x, int y);
+
   ///
   /// Retrieves the name assigned to the given ThermionEntity (usually corresponds to the glTF mesh name).
   ///
@@ -736,10 +991,14 @@ abstract class ThermionViewer {
   /// Makes [entity] collidable.
   /// This allows you to call [testCollisions] with any other entity ("entity B") to see if [entity] has collided with entity B. The callback will be invoked if so.
   /// Alternatively, if [affectsTransform] is true and this entity collides with another entity, any queued position updates to the latter entity will be ignored.
+  /// [shape] determines how [entity] is tested once its bounding box overlaps another; [CollisionShapeType.OBB] avoids the false positives
+  /// caused by the bounding box of a rotated entity growing to contain its corners. For assets loaded with keepData, the box is fitted to
+  /// the vertices of the mesh in the background.
   ///
   Future addCollisionComponent(ThermionEntity entity,
       {void Function(int entityId1, int entityId2)? callback,
-      bool affectsTransform = false});
+      bool affectsTransform = false,
+      CollisionShapeType shape = CollisionShapeType.AABB});
 
   ///
   /// Removes the collision component from [entity], meaning this will no longer be tested when [testCollisions] or [queuePositionUpdate] is called with another entity.
@@ -775,6 +1034,108 @@ abstract class ThermionViewer {
   ///
   Future testCollisions(ThermionEntity entity);
 
+  ///
+  /// Enables/disables the per-frame collision pass. When enabled, every pair
+  /// of collidable entities (see [addCollisionComponent]) whose collision shapes
+  /// overlap is found once per frame, and a [CollisionEvent] is recorded for
+  /// each pair that starts overlapping, is still overlapping or stops
+  /// overlapping. Collision callbacks are not invoked by this pass; use
+  /// [getCollisionEvents] to read the events instead.
+  ///
+  Future setCollisionEventsEnabled(bool enabled);
+
+  ///
+  /// Returns the collision events recorded since the last call. BEGIN/END
+  /// events are accumulated until read; PERSIST events only describe the most
+  /// recent frame.
+  ///
+  Future<List<CollisionEvent>> getCollisionEvents();
+
+  ///
+  /// Queued transform updates (see [queueTransformUpdates]) are swept from
+  /// the entity's current position to its new one, so collision callbacks
+  /// are invoked for every entity it passes through, however fast it moves.
+  /// If [enabled] is true, the movement also stops just before the first
+  /// entity whose collision component was added with `affectsTransform`;
+  /// entities that already overlap at the start of a movement never stop it.
+  ///
+  Future setStopAtFirstContact(bool enabled);
+
+  ///
+  /// Sweeps the bounding box of [entity] by [displacement] against every
+  /// other collidable entity and returns the first one it would touch (or
+  /// null if there is none). An entity that already overlaps [entity] is
+  /// touched at fraction 0.
+  ///
+  Future<SweepHit?> timeOfImpact(ThermionEntity entity, Vector3 displacement);
+
+  ///
+  /// Casts a ray from [origin] along [direction] against the triangles of
+  /// every renderable whose visibility layer is included in [layerMask], and
+  /// returns the (at most [maxHits]) closest hits in order of increasing
+  /// distance, one per renderable.
+  ///
+  /// Only glTF assets loaded with keepData and geometry created with
+  /// [createGeometry] (with triangle primitives) can be hit. The
+  /// acceleration structure for each mesh is built in the background when the
+  /// asset is loaded; a mesh cannot be hit until it is ready.
+  ///
+  /// This runs on the calling thread (not the render thread), so it is cheap
+  /// enough to call for every pointer event.
+  ///
+  Future<List<RaycastHit>> raycast(Vector3 origin, Vector3 direction,
+      {double maxDistance = double.infinity,
+      int layerMask = 0xFF,
+      int maxHits = 1});
+
+  ///
+  /// Returns every renderable entity whose world-space bounding box overlaps
+  /// [box]. These queries use a spatial index over the bounding boxes of all
+  /// renderables in the scene, which is kept up to date as entities are
+  /// added, removed and transformed.
+  ///
+  Future<List<ThermionEntity>> queryBox(Aabb3 box);
+
+  ///
+  /// Returns every renderable entity whose world-space bounding box
+  /// intersects the sphere at [center] with [radius].
+  ///
+  Future<List<ThermionEntity>> querySphere(Vector3 center, double radius);
+
+  ///
+  /// Returns every renderable entity whose world-space bounding box
+  /// (conservatively) intersects the frustum of the camera for [view] (the
+  /// first view if not specified).
+  ///
+  Future<List<ThermionEntity>> queryFrustum({View? view});
+
+  ///
+  /// Returns (at most) the [k] renderable entities whose world-space bounding
+  /// boxes are closest to [point], closest first.
+  ///
+  Future<List<ThermionEntity>> queryNearest(Vector3 point, int k);
+
+  ///
+  /// Finds the entities visible within the polygon [points] (in viewport
+  /// coordinates, with the origin at the top-left, as for [pick]), e.g. for
+  /// marquee or lasso selection. Results are ordered by decreasing coverage.
+  ///
+  /// Every [step]th pixel in the region is sampled by casting a ray through it,
+  /// so (as with [raycast]) only glTF assets loaded with keepData and custom
+  /// geometry can be found, and only those can occlude each other. Pixel
+  /// counts are estimates when [step] is greater than 1 (or when the region is
+  /// so large that the step is increased automatically).
+  ///
+  Future<List<RegionPickResult>> pickRegion(List<Vector2> points,
+      {int step = 1, View? view});
+
+  ///
+  /// Finds the entities visible within the rectangle from [min] to [max] (see
+  /// [pickRegion]).
+  ///
+  Future<List<RegionPickResult>> pickRect(Vector2 min, Vector2 max,
+      {int step = 1, View? view});
+
   ///
   /// Sets the draw priority for the given entity. See RenderableManager.h for more details.
   ///
@@ -795,6 +1156,15 @@ abstract class ThermionViewer {
   ///
   Future<Aabb2> getViewportBoundingBox(ThermionEntity entity);
 
+  ///
+  /// Gets the 2D bounding box (in viewport coordinates) for each of the given
+  /// entities in a single call, which is much cheaper than calling
+  /// [getViewportBoundingBox] for each entity. The result for an entity is null
+  /// if its bounding box is entirely behind the camera.
+  ///
+  Future<List<Aabb2?>> getViewportBoundingBoxes(List<ThermionEntity> entities,
+      {View? view});
+
   ///
   /// Toggles the visibility of the respective layer.
   ///
@@ -829,9 +1199,22 @@ abstract class ThermionViewer {
 
   ///
   /// Decodes the specified image data and creates a texture.
+  /// Only the lowest mip levels are uploaded initially; finer levels are streamed in (and out)
+  /// depending on how large the entities the texture is applied to appear on screen,
+  /// subject to the budget set by [setTextureStreamingBudget].
   ///
   Future<ThermionTexture> createTexture(Uint8List data);
 
+  ///
+  /// Sets the (estimated) GPU memory budget for textures created with [createTexture].
+  ///
+  Future setTextureStreamingBudget(int budgetInBytes);
+
+  ///
+  /// Returns the current residency statistics for textures created with [createTexture].
+  ///
+  Future<TextureStreamingStats> getTextureStreamingStats();
+
   ///
   ///
   ///
@@ -31,7 +31,8 @@ class ThermionViewerStub extends ThermionViewer {
   @override
   Future addCollisionComponent(ThermionEntity entity,
       {void Function(int entityId1, int entityId2)? callback,
-      bool affectsTransform = false}) {
+      bool affectsTransform = false,
+      CollisionShapeType shape = CollisionShapeType.AABB}) {
     // TODO: implement addCollisionComponent
     throw UnimplementedError();
   }
@@ -252,7 +253,8 @@ class ThermionViewerStub extends ThermionViewer {
   Future<bool> get initialized => throw UnimplementedError();
 
   @override
-  Future loadIbl(String lightingPath, {double intensity = 30000}) {
+  Future loadIbl(String lightingPath,
+      {double intensity = 30000, double crossfade = 0.0}) {
     // TODO: implement loadIbl
     throw UnimplementedError();
   }
@@ -301,6 +303,16 @@ class ThermionViewerStub extends ThermionViewer {
   // TODO: implement pickResult
   Stream<FilamentPickResult> get pickResult => throw UnimplementedError();
 
+  @override
+  Future hoverPick(int x, int y) {
+    // TODO: implement hoverPick
+    throw UnimplementedError();
+  }
+
+  @override
+  // TODO: implement hoverPickResult
+  Stream<FilamentPickResult> get hoverPickResult => throw UnimplementedError();
+
   @override
   Future playAnimation(ThermionEntity entity, int index,
       {bool loop = false,
@@ -381,6 +393,40 @@ class ThermionViewerStub extends ThermionViewer {
     throw UnimplementedError();
   }
 
+  @override
+  Future createIblFromImage(String imagePath,
+      {double intensity = 30000,
+      bool createSkybox = false,
+      String? cacheDirectory}) {
+    // TODO: implement createIblFromImage
+    throw UnimplementedError();
+  }
+
+  @override
+  Future prefetchEnvironment(String uri, {int priority = 0}) {
+    // TODO: implement prefetchEnvironment
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setEnvironmentCacheBudget(int budgetInBytes) {
+    // TODO: implement setEnvironmentCacheBudget
+    throw UnimplementedError();
+  }
+
+  @override
+  Future loadPanoramaMaterial(String path) {
+    // TODO: implement loadPanoramaMaterial
+    throw UnimplementedError();
+  }
+
+  @override
+  Future loadTiledPanorama(String uriTemplate,
+      {required int numLevels, int tileSize = 512, int cacheFaceSize = 2048}) {
+    // TODO: implement loadTiledPanorama
+    throw UnimplementedError();
+  }
+
  
   @override
   // TODO: implement rendering
@@ -429,6 +475,89 @@ class ThermionViewerStub extends ThermionViewer {
     throw UnimplementedError();
   }
 
+  @override
+  Future setCollisionEventsEnabled(bool enabled) {
+    // TODO: implement setCollisionEventsEnabled
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<CollisionEvent>> getCollisionEvents() {
+    // TODO: implement getCollisionEvents
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setStopAtFirstContact(bool enabled) {
+    // TODO: implement setStopAtFirstContact
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<SweepHit?> timeOfImpact(ThermionEntity entity, Vector3 displacement) {
+    // TODO: implement timeOfImpact
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<RaycastHit>> raycast(Vector3 origin, Vector3 direction,
+      {double maxDistance = double.infinity,
+      int layerMask = 0xFF,
+      int maxHits = 1}) {
+    // TODO: implement raycast
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<ThermionEntity>> queryBox(Aabb3 box) {
+    // TODO: implement queryBox
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<ThermionEntity>> querySphere(Vector3 center, double radius) {
+    // TODO: implement querySphere
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<ThermionEntity>> queryFrustum({View? view}) {
+    // TODO: implement queryFrustum
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<ThermionEntity>> queryNearest(Vector3 point, int k) {
+    // TODO: implement queryNearest
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<RegionPickResult>> pickRegion(List<Vector2> points,
+      {int step = 1, View? view}) {
+    // TODO: implement pickRegion
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<RegionPickResult>> pickRect(Vector2 min, Vector2 max,
+      {int step = 1, View? view}) {
+    // TODO: implement pickRect
+    throw UnimplementedError();
+  }
+
+  @override
+  Future seekAnimation(ThermionEntity entity, int index, double timeInSecs) {
+    // TODO: implement seekAnimation
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<double> getAnimationFrameRate(ThermionEntity entity, int index) {
+    // TODO: implement getAnimationFrameRate
+    throw UnimplementedError();
+  }
+
   @override
   Future setAntiAliasing(bool msaa, bool fxaa, bool taa) {
     // TODO: implement setAntiAliasing
@@ -808,6 +937,13 @@ class ThermionViewerStub extends ThermionViewer {
     // TODO: implement getViewportBoundingBox
     throw UnimplementedError();
   }
+
+  @override
+  Future<List<Aabb2?>> getViewportBoundingBoxes(List<ThermionEntity> entities,
+      {View? view}) {
+    // TODO: implement getViewportBoundingBoxes
+    throw UnimplementedError();
+  }
   
   
   @override
@@ -1076,4 +1212,149 @@ class ThermionViewerStub extends ThermionViewer {
   }
 
   
+
+  @override
+  Future setTextureStreamingBudget(int budgetInBytes) {
+    // TODO: implement setTextureStreamingBudget
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<TextureStreamingStats> getTextureStreamingStats() {
+    // TODO: implement getTextureStreamingStats
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<AnimationStats> getAnimationStats() {
+    // TODO: implement getAnimationStats
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setAnimationClock(AnimationClockMode mode,
+      {double timestepInSecs = 1 / 60}) {
+    // TODO: implement setAnimationClock
+    throw UnimplementedError();
+  }
+
+  @override
+  Future stepAnimations(double deltaInSecs) {
+    // TODO: implement stepAnimations
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setAnimationLod(
+      {bool enabled = true,
+      double distantScreenSize = 0.1,
+      int distantInterval = 4,
+      int culledInterval = 0}) {
+    // TODO: implement setAnimationLod
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setAnimationCompression(
+      {double translationTolerance = 1e-4,
+      double rotationTolerance = 1e-4,
+      double scaleTolerance = 1e-4}) {
+    // TODO: implement setAnimationCompression
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<int> addAnimationLayer(ThermionEntity entity, int index,
+      {double weight = 1.0,
+      AnimationBlendMode mode = AnimationBlendMode.OVERRIDE,
+      bool loop = true,
+      List<ThermionEntity>? mask}) {
+    // TODO: implement addAnimationLayer
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setAnimationLayerWeight(
+      ThermionEntity entity, int layerId, double weight) {
+    // TODO: implement setAnimationLayerWeight
+    throw UnimplementedError();
+  }
+
+  @override
+  Future removeAnimationLayer(ThermionEntity entity, int layerId) {
+    // TODO: implement removeAnimationLayer
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<int> createAnimationStateMachine(AnimationStateMachine stateMachine) {
+    // TODO: implement createAnimationStateMachine
+    throw UnimplementedError();
+  }
+
+  @override
+  Future destroyAnimationStateMachine(int stateMachine) {
+    // TODO: implement destroyAnimationStateMachine
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setAnimationStateMachine(ThermionEntity entity, int? stateMachine) {
+    // TODO: implement setAnimationStateMachine
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setAnimationStateMachineParameter(
+      ThermionEntity entity, int parameter, double value) {
+    // TODO: implement setAnimationStateMachineParameter
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<int> getAnimationStateMachineState(ThermionEntity entity) {
+    // TODO: implement getAnimationStateMachineState
+    throw UnimplementedError();
+  }
+
+  @override
+  Future loadVertexAnimationMaterial(String path) {
+    // TODO: implement loadVertexAnimationMaterial
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<int> bakeVertexAnimation(ThermionEntity entity, int animationIndex,
+      {double frameRate = 30.0}) {
+    // TODO: implement bakeVertexAnimation
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<ThermionEntity> createVertexAnimationInstances(
+      int vertexAnimation, List<Matrix4> transforms,
+      {List<double>? timeOffsets}) {
+    // TODO: implement createVertexAnimationInstances
+    throw UnimplementedError();
+  }
+
+  @override
+  Future setVertexAnimationInstances(
+      ThermionEntity entity, List<Matrix4> transforms,
+      {List<double>? timeOffsets}) {
+    // TODO: implement setVertexAnimationInstances
+    throw UnimplementedError();
+  }
+
+  @override
+  Future destroyVertexAnimationInstances(ThermionEntity entity) {
+    // TODO: implement destroyVertexAnimationInstances
+    throw UnimplementedError();
+  }
+
+  @override
+  Future destroyVertexAnimation(int vertexAnimation) {
+    // TODO: implement destroyVertexAnimation
+    throw UnimplementedError();
+  }
 }
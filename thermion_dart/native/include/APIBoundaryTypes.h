@@ -105,6 +105,49 @@ extern "C"
 
     typedef struct Aabb2 Aabb2;
 
+    struct TTextureStreamingStats {
+        uint32_t textureCount;
+        uint32_t satisfiedCount;
+        uint32_t pendingCount;
+        uint64_t residentBytes;
+        uint64_t requiredBytes;
+        uint64_t budgetBytes;
+    };
+
+    typedef struct TTextureStreamingStats TTextureStreamingStats;
+
+    struct TAnimationStats {
+        uint64_t boneMatrixUpdates;
+        uint64_t jointTransformWrites;
+        uint64_t morphWeightUploads;
+        uint64_t evaluatedComponents;
+        uint64_t skippedEvaluations;
+        uint64_t skippedSkinningUpdates;
+        uint64_t uncompressedClipBytes;
+        uint64_t compressedClipBytes;
+    };
+
+    typedef struct TAnimationStats TAnimationStats;
+
+    // type is 0 (begin), 1 (persist) or 2 (end)
+    struct TCollisionEvent {
+        int32_t type;
+        EntityId entity1;
+        EntityId entity2;
+    };
+
+    typedef struct TCollisionEvent TCollisionEvent;
+
+    struct TRaycastHit {
+        EntityId entity;
+        float distance;
+        float barycentrics[3];
+        float uv[2];
+        int32_t triangle;
+    };
+
+    typedef struct TRaycastHit TRaycastHit;
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
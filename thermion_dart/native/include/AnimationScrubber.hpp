@@ -0,0 +1,133 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <filament/Engine.h>
+
+#include <gltfio/FilamentAsset.h>
+#include <gltfio/FilamentInstance.h>
+
+#include <math/quat.h>
+#include <math/vec3.h>
+#include <utils/Entity.h>
+
+#include "components/LocalPose.hpp"
+
+struct cgltf_data;
+
+namespace thermion
+{
+
+    using namespace filament;
+    using namespace filament::gltfio;
+
+    ///
+    /// Random-access evaluation of the glTF animations of a single instance (e.g. for scrubbing a timeline).
+    ///
+    /// gltfio's Animator searches the keyframes of every channel from scratch each time an animation is applied.
+    /// A scrubber instead keeps a cursor (the index of the last keyframe found) for each channel, so a playhead
+    /// that moves monotonically (forwards or backwards) only needs to step to the adjacent keyframe (O(1) amortized),
+    /// falling back to a binary search (O(log n)) for larger jumps.
+    ///
+    /// The keyframes of each animation are copied from the glTF source data the first time that animation is
+    /// seeked, so the asset must be loaded with keepData.
+    ///
+    /// All methods must be called from the render thread.
+    ///
+    class AnimationScrubber
+    {
+    public:
+        // the frame rate assumed for animations with fewer than two keyframes
+        static constexpr float kDefaultFrameRate = 30.0f;
+        // the number of keyframes a cursor will step over before falling back to a binary search
+        static constexpr size_t kMaxLinearSteps = 4;
+
+        ///
+        /// Returns the frame rate of each animation in [data], estimated from the shortest interval between keyframes
+        /// (glTF doesn't store the frame rate an animation was authored at).
+        ///
+        static std::vector<float> computeFrameRates(const cgltf_data *data);
+
+        ///
+        /// Creates a scrubber for [instance], or returns nullptr if the source data for [asset] has been released.
+        ///
+        static AnimationScrubber *create(Engine *engine, const FilamentAsset *asset, FilamentInstance *instance);
+
+        ///
+        /// Applies the glTF animation at [animationIndex] at [timeInSecs] (clamped to the duration of the animation)
+        /// to the local transforms/morph weights of the instance. Bone matrices are not updated.
+        /// Returns false if [animationIndex] is out of range.
+        ///
+        bool seek(int animationIndex, float timeInSecs);
+
+        ///
+        /// Samples the node transforms of the glTF animation at [animationIndex] at [timeInSecs] (clamped as above) into [pose],
+        /// which must have a slot for every entity of the instance (in the order of FilamentInstance::getEntities()).
+        /// Only the paths that the animation targets are written, and neither the TransformManager nor any morph weights are touched.
+        /// Returns false if [animationIndex] is out of range.
+        ///
+        bool sample(int animationIndex, float timeInSecs, LocalPose &pose);
+
+    private:
+        enum class Path
+        {
+            TRANSLATION,
+            ROTATION,
+            SCALE,
+            WEIGHTS
+        };
+
+        enum class Interpolation
+        {
+            STEP,
+            LINEAR,
+            CUBIC_SPLINE
+        };
+
+        struct Channel
+        {
+            int node = -1;
+            Path path = Path::TRANSLATION;
+            Interpolation interpolation = Interpolation::LINEAR;
+            // the number of floats in each value (3 for translation/scale, 4 for rotation, or the number of morph targets)
+            uint32_t components = 0;
+            std::vector<float> times;
+            // for cubic spline channels, each keyframe stores an in-tangent, a value and an out-tangent
+            std::vector<float> values;
+            size_t cursor = 0;
+        };
+
+        struct Clip
+        {
+            std::vector<Channel> channels;
+            // the nodes whose local transform is animated by this clip
+            std::vector<int> nodes;
+            // the nodes whose morph weights are animated by this clip
+            std::vector<int> morphNodes;
+            float duration = 0.0f;
+        };
+
+        struct Node
+        {
+            utils::Entity entity;
+            // the index of [entity] in FilamentInstance::getEntities(), or -1
+            int poseIndex = -1;
+            math::float3 translation = math::float3(0.0f);
+            math::quatf rotation = math::quatf(1.0f, 0.0f, 0.0f, 0.0f);
+            math::float3 scale = math::float3(1.0f);
+            std::vector<float> weights;
+        };
+
+        AnimationScrubber(Engine *engine, const cgltf_data *data) : _engine(engine), _data(data) {}
+
+        Clip *getClip(int animationIndex);
+        size_t findKeyframe(Channel &channel, float timeInSecs) const;
+        void evaluate(const Channel &channel, size_t keyframe, float timeInSecs, float *out) const;
+
+        Engine *_engine = nullptr;
+        const cgltf_data *_data = nullptr;
+        std::vector<Node> _nodes;
+        std::vector<std::unique_ptr<Clip>> _clips;
+    };
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <filament/Engine.h>
+#include <filament/Texture.h>
+
+#include <image/Ktx1Bundle.h>
+#include <math/vec3.h>
+
+#include "ResourceBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "tsl/robin_map.h"
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    ///
+    /// A cache of (KTX) environment textures (skyboxes/IBLs) that can be
+    /// prefetched ahead of time so that switching to a new environment
+    /// doesn't stall the render thread.
+    ///
+    /// Prefetched environments are fetched and parsed on a worker thread,
+    /// uploaded on the render thread (in [update], at most one per frame) and
+    /// then kept resident until evicted. When the total size of all cached
+    /// environments would exceed the memory budget, the least recently used
+    /// environments that are not currently in use are evicted.
+    ///
+    /// All methods are thread-safe, but [update], [acquire] and [release]
+    /// must be called from the render thread.
+    ///
+    class EnvironmentCache
+    {
+    public:
+        struct Environment
+        {
+            Texture *texture = nullptr;
+            math::float3 harmonics[9];
+            bool hasHarmonics = false;
+        };
+
+        ///
+        /// Environments are fetched and parsed on [pool] (shared with the SceneManager), or on the calling thread if [pool] is null.
+        ///
+        EnvironmentCache(Engine *engine, const ResourceLoaderWrapperImpl *const resourceLoaderWrapper, ThreadPool *pool, size_t budgetInBytes = 256 * 1024 * 1024);
+        ~EnvironmentCache();
+
+        ///
+        /// Queues the environment at [uri] to be loaded in the background.
+        /// Requests with a higher [priority] are fetched first.
+        /// This is a no-op if [uri] is already cached or queued (other than updating its priority).
+        ///
+        void prefetch(const char *uri, int priority);
+
+        ///
+        /// Sets the memory budget, evicting environments if necessary.
+        ///
+        void setBudget(size_t budgetInBytes);
+
+        ///
+        /// Returns true (and populates [out]) if the environment at [uri] is resident.
+        /// The returned texture is owned by the cache and will not be evicted until [release] is called.
+        ///
+        bool acquire(const char *uri, Environment &out);
+
+        ///
+        /// Returns true if the environment at [uri] is resident, or is queued/loading.
+        ///
+        bool contains(const char *uri);
+
+        ///
+        /// Returns true if the environment at [uri] has been uploaded and can be acquired.
+        ///
+        bool isResident(const char *uri);
+
+        ///
+        /// Marks [texture] (previously returned by [acquire]) as no longer in use.
+        /// Returns false if [texture] is not owned by this cache.
+        ///
+        bool release(Texture *texture);
+
+        ///
+        /// Dispatches pending fetches and uploads any environments that have finished loading.
+        ///
+        void update();
+
+        ///
+        /// Returns true if any environment is queued, loading or waiting to be uploaded in [update].
+        ///
+        bool hasPendingLoads();
+
+        size_t getResidentBytes() const
+        {
+            return _residentBytes;
+        }
+
+    private:
+        enum class State : uint8_t
+        {
+            QUEUED,
+            LOADING,
+            LOADED,
+            RESIDENT
+        };
+
+        struct Entry
+        {
+            State state = State::QUEUED;
+            int priority = 0;
+            size_t sizeInBytes = 0;
+            uint64_t lastUsed = 0;
+            int useCount = 0;
+            image::Ktx1Bundle *bundle = nullptr;
+            Environment environment;
+        };
+
+        void load(std::string uri);
+        void evict(size_t requiredBytes);
+        void destroyEntry(Entry &entry);
+
+        Engine *_engine = nullptr;
+        const ResourceLoaderWrapperImpl *const _resourceLoaderWrapper;
+        size_t _budgetInBytes = 0;
+        std::atomic<size_t> _residentBytes{0};
+        uint64_t _clock = 0;
+        int _loading = 0;
+
+        TaskGroup _loads;
+        std::atomic<bool> _stopped{false};
+        std::mutex _mutex;
+        tsl::robin_map<std::string, Entry> _entries;
+    };
+}
@@ -27,6 +27,9 @@
 #include <math/mat3.h>
 #include <math/norm.h>
 
+#include <image/LinearImage.h>
+
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -35,6 +38,8 @@
 #include "ResourceBuffer.hpp"
 #include "SceneManager.hpp"
 #include "ThreadPool.hpp"
+#include "PanoramaStreamer.hpp"
+#include "EnvironmentCache.hpp"
 
 namespace thermion
 {
@@ -60,17 +65,69 @@ namespace thermion
         void loadSkybox(const char *const skyboxUri);
         void removeSkybox();
 
+        ///
+        /// Loads the skybox at [skyboxUri] on a worker thread and swaps it in once it has been uploaded.
+        /// The current skybox remains visible until then. [onComplete] (if non-null) is invoked on the render thread
+        /// once the new skybox is visible (or the load has failed/been superseded by another call).
+        ///
+        void loadSkyboxAsync(const char *const skyboxUri, void (*onComplete)());
+
+        ///
+        /// Loads the (compiled) panorama material (materials/panorama.mat) used to render tiled panoramas.
+        ///
+        bool loadPanoramaMaterial(const char *const uri);
+
+        ///
+        /// Replaces the skybox with a tiled, multi-resolution cubemap panorama (see PanoramaStreamer).
+        /// Tiles are streamed in as the camera moves; call [removeSkybox] to remove.
+        /// [cacheFaceSize] bounds the GPU memory used for the tile cache (not the resolution of the panorama).
+        /// The panorama material must have been loaded first (see [loadPanoramaMaterial]).
+        ///
+        void loadTiledPanorama(const char *const uriTemplate, uint32_t tileSize, uint32_t numLevels, uint32_t cacheFaceSize);
+
+        ///
+        /// Loads the (KTX) skybox/IBL at [uri] in the background so that a subsequent call to
+        /// [loadSkybox]/[loadIbl] with the same URI is effectively free.
+        ///
+        void prefetchEnvironment(const char *const uri, int priority);
+        void setEnvironmentCacheBudget(size_t budgetInBytes);
+
         void loadIbl(const char *const iblUri, float intensity);
+
+        ///
+        /// Loads the IBL at [iblUri] on a worker thread and swaps it in once it has been uploaded (see [loadSkyboxAsync]).
+        /// If [crossfadeInSecs] is greater than zero, the intensity of the current IBL is faded out and the new IBL faded in
+        /// over this duration; [onComplete] is invoked once the fade has finished.
+        ///
+        void loadIblAsync(const char *const iblUri, float intensity, float crossfadeInSecs, void (*onComplete)());
         void removeIbl();
         void rotateIbl(const math::mat3f &matrix);
         void createIbl(float r, float g, float b, float intensity);
 
+        ///
+        /// Creates an indirect light (and optionally a skybox) from the equirectangular HDR/LDR image at [path] (see IblGenerator).
+        /// If [cacheDir] is non-null, the prefiltered result is cached on disk.
+        ///
+        void createIblFromImage(const char *const path, float intensity, bool createSkybox, const char *const cacheDir);
+
         void removeEntity(EntityId asset);
         void clearEntities();
 
         void render(
             uint64_t frameTimeInNanos
         );
+
+        ///
+        /// Uploads/swaps in any skyboxes, IBLs or background images that have finished loading in the background.
+        /// This is called at the start of every [render], but should also be called from the render thread
+        /// when no frames are being rendered (while [hasPendingAsyncLoads] is true) so that asynchronous loads still complete.
+        ///
+        void processAsyncLoads();
+
+        ///
+        /// Returns true if [processAsyncLoads] has work to do now, or will have once a background load completes.
+        ///
+        bool hasPendingAsyncLoads();
         void setFrameInterval(float interval);
 
         void setMainCamera(View *view);
@@ -95,6 +152,13 @@ namespace thermion
 
         void setBackgroundColor(const float r, const float g, const float b, const float a);
         void setBackgroundImage(const char *resourcePath, bool fillHeight, uint32_t width, uint32_t height);
+
+        ///
+        /// Decodes the image at [resourcePath] on a worker thread, then uploads it and sets it as the background image on the render thread.
+        /// The current background image remains visible until then. If another call is made before this one completes,
+        /// this image is discarded. [onComplete] (if non-null) is invoked on the render thread once the image has been set (or discarded).
+        ///
+        void setBackgroundImageAsync(const char *resourcePath, bool fillHeight, uint32_t width, uint32_t height, void (*onComplete)());
         void clearBackgroundImage();
         void setBackgroundImagePosition(float x, float y, bool clamp, uint32_t width, uint32_t height);
         
@@ -106,6 +170,14 @@ namespace thermion
         bool isNonPickableEntity(EntityId entityId);
 
         void pick(View *view, uint32_t x, uint32_t y, PickCallback callback);
+
+        ///
+        /// Requests a pick at [x], [y] in [view] for hover feedback. Unlike [pick], requests for each view are coalesced:
+        /// only the latest coordinate is kept, and a pick is only issued (when the view is next rendered) once the previous
+        /// hover pick for the view has resolved. [callback] is therefore invoked at most once per frame, with the result for
+        /// the most recently requested coordinate at the time the pick was issued.
+        ///
+        void hoverPick(View *view, uint32_t x, uint32_t y, PickCallback callback);
         
         Engine* getEngine() { 
             return _engine;
@@ -156,7 +228,8 @@ namespace thermion
         void* _context = nullptr;
         Scene *_scene = nullptr;
         Engine *_engine = nullptr;
-        thermion::ThreadPool *_tp = nullptr;
+        // background image decodes, on the SceneManager's thread pool
+        thermion::TaskGroup *_imageDecodes = nullptr;
         Renderer *_renderer = nullptr;
         SceneManager *_sceneManager = nullptr;
         std::vector<RenderTarget*> _renderTargets;
@@ -168,9 +241,52 @@ namespace thermion
         std::vector<utils::Entity> _lights;
         Texture *_skyboxTexture = nullptr;
         Skybox *_skybox = nullptr;
+        PanoramaStreamer *_panoramaStreamer = nullptr;
+        Material *_panoramaMaterial = nullptr;
+        EnvironmentCache *_environmentCache = nullptr;
         Texture *_iblTexture = nullptr;
         IndirectLight *_indirectLight = nullptr;
 
+        // asynchronous skybox/IBL loads
+        enum class PendingEnvironmentStage
+        {
+            LOADING,
+            FADING_OUT,
+            FADING_IN
+        };
+
+        struct PendingEnvironment
+        {
+            std::string uri;
+            bool ibl = false;
+            float intensity = 0.0f;
+            float crossfadeInSecs = 0.0f;
+            void (*onComplete)() = nullptr;
+            PendingEnvironmentStage stage = PendingEnvironmentStage::LOADING;
+            float fromIntensity = 0.0f;
+            float fadeDuration = 0.0f;
+            time_point_t fadeStart;
+        };
+        std::vector<PendingEnvironment> _pendingEnvironments;
+        void queueEnvironment(PendingEnvironment pending);
+        bool updatePendingEnvironment(PendingEnvironment &pending);
+
+        // the latest hover pick requested for each view
+        struct HoverPick
+        {
+            View *view = nullptr;
+            PickCallback callback = nullptr;
+            uint32_t x = 0;
+            uint32_t y = 0;
+            // true if [x], [y] haven't been picked yet
+            bool pending = false;
+            // true while a pick for this view is awaiting its result
+            bool inFlight = false;
+        };
+        std::mutex _hoverPickMutex;
+        std::vector<HoverPick> _hoverPicks;
+        void issueHoverPicks(const std::vector<View *> &views);
+
         float _frameInterval = 1000.0 / 60.0;
 
         // Camera properties
@@ -187,10 +303,30 @@ namespace thermion
         IndexBuffer *_imageIb = nullptr;
         Material *_imageMaterial = nullptr;
         TextureSampler _imageSampler;
-        void loadKtx2Texture(std::string path, ResourceBuffer data);
-        void loadKtxTexture(std::string path, ResourceBuffer data);
-        void loadPngTexture(std::string path, ResourceBuffer data);
-        void loadTextureFromPath(std::string path);
+
+        // a background image that has been decoded (but not uploaded); exactly one of [image]/[bundle]/[ktx2] is set on success
+        struct DecodedImage
+        {
+            image::LinearImage *image = nullptr;
+            image::Ktx1Bundle *bundle = nullptr;
+            // the encoded KTX2 file (this can only be transcoded once the texture has been created on the render thread)
+            std::vector<uint8_t> *ktx2 = nullptr;
+            bool fillHeight = false;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint64_t generation = 0;
+            void (*onComplete)() = nullptr;
+        };
+        std::mutex _decodedImagesMutex;
+        std::vector<DecodedImage> _decodedImages;
+        std::atomic<int> _imageDecodesInFlight{0};
+        std::atomic<uint64_t> _backgroundImageGeneration{0};
+
+        // safe to call from any thread
+        void decodeImage(std::string path, DecodedImage &out);
+        // must be called on the render thread; consumes [decoded]
+        Texture *uploadImage(DecodedImage &decoded, uint32_t &width, uint32_t &height);
+        void applyBackgroundImage(Texture *texture, uint32_t imageWidth, uint32_t imageHeight, bool fillHeight, uint32_t width, uint32_t height);
         void savePng(void *data, size_t size, int frameNumber);
         void createBackgroundImage();
 
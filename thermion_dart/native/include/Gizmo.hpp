@@ -53,47 +53,42 @@ class Gizmo {
             return _isActive;
         }
 
+        ///
+        /// Tests the handles of the gizmo against the ray through the given viewport coordinates (with the origin at the bottom-left, as
+        /// for View::pick), highlights the handle that was hit (if any) and invokes [callback] with that handle (or zero if nothing was hit).
+        /// The callback is invoked synchronously.
+        ///
         void pick(uint32_t x, uint32_t y, PickCallback callback);
+
+        ///
+        /// Returns the handle (an axis or the center cube) hit by the ray through the given viewport coordinates, or a null entity if no
+        /// handle was hit. Handles are intersected analytically in the space of the gizmo (the shaft of each axis as a cylinder, the arrow as
+        /// a cone and the center as a box), so this doesn't wait for the GPU and doesn't allocate.
+        ///
+        Entity hitTest(uint32_t x, uint32_t y);
+
         bool isGizmoEntity(Entity entity);
         void setVisibility(bool visible);
 
     private:
 
-        class PickCallbackHandler {
-            public: 
-                PickCallbackHandler(Gizmo* gizmo, PickCallback callback) : _gizmo(gizmo), _callback(callback) {};
-                void handle(filament::View::PickingQueryResult const &result) { 
-                    auto x = static_cast<int32_t>(result.fragCoords.x);
-                    auto y= static_cast<int32_t>(result.fragCoords.y);
-                    for(int i = 0; i < 7; i++) {
-                        if(_gizmo->_entities[i] == result.renderable) {
-                            if(i < 4) {
-                                return;    
-                            }
-                            _gizmo->highlight(_gizmo->_entities[i - 4]);
-                            _callback(Entity::smuggle(_gizmo->_entities[i - 4]), x, y, _gizmo->_view);
-                            return;
-                        }
-                    }
-                    _gizmo->unhighlight();
-                    _callback(0, x, y, _gizmo->_view);
-                    delete(this);
-                }
-
-            private:
-                Gizmo* _gizmo;
-                PickCallback _callback;
+        // the dimensions of the handles in model space, before the material scales them to a constant size in screen-space
+        static constexpr float kCenterCubeSize = 0.01f;
+        static constexpr float kLineLength = 0.6f;
+        static constexpr float kLineWidth = 0.004f;
+        static constexpr float kArrowLength = 0.06f;
+        static constexpr float kArrowWidth = 0.02f;
+        // the handles are too thin to hit precisely, so they are fattened by this much when hit-testing
+        static constexpr float kPickTolerance = 0.03f;
 
-        };
-        void createTransparentRectangles();
         void highlight(Entity entity);
         void unhighlight();
         Engine *_engine;
         Scene *_scene;
         View *_view;
-        utils::Entity _entities[7] = { utils::Entity(), utils::Entity(), utils::Entity(), utils::Entity(), utils::Entity(), utils::Entity(), utils::Entity() };
+        utils::Entity _entities[4] = { utils::Entity(), utils::Entity(), utils::Entity(), utils::Entity() };
         Material* _material;
-        MaterialInstance* _materialInstances[7];
+        MaterialInstance* _materialInstances[4];
         math::float4 inactiveColors[3] {
             math::float4 { 1.0f, 0.0f, 0.0f, 0.5f },
             math::float4 { 0.0f, 1.0f, 0.0f, 0.5f },
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+
+#include <filament/Engine.h>
+#include <filament/Renderer.h>
+#include <filament/Texture.h>
+
+#include <math/vec3.h>
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    ///
+    /// Generates an image-based light (a prefiltered specular cubemap and
+    /// irradiance spherical harmonics) from an equirectangular HDR/LDR image.
+    ///
+    /// The specular cubemap is prefiltered on the GPU with IBLPrefilterContext;
+    /// the spherical harmonics are computed on the CPU from a downsampled copy
+    /// of the image.
+    ///
+    /// If a cache directory is provided, the result is written to
+    /// <cacheDir>/<content hash>.ibl and subsequent calls with the same image
+    /// will be loaded from disk, skipping the decode/prefilter entirely
+    /// (unless a skybox is also requested, in which case the image is still
+    /// decoded to create the environment cubemap).
+    ///
+    /// Must be called from the render thread.
+    ///
+    class IblGenerator
+    {
+    public:
+        struct Ibl
+        {
+            Texture *reflections = nullptr;
+            // only populated if createSkybox was true
+            Texture *skybox = nullptr;
+            math::float3 harmonics[9];
+        };
+
+        IblGenerator(Engine *engine, Renderer *renderer) : _engine(engine), _renderer(renderer) {}
+
+        bool generate(
+            const char *name,
+            const uint8_t *data,
+            size_t length,
+            const char *cacheDir,
+            bool createSkybox,
+            Ibl &out);
+
+    private:
+        bool readFromCache(const std::string &path, Ibl &out);
+        bool writeToCache(const std::string &path, const Ibl &ibl);
+
+        Engine *_engine = nullptr;
+        Renderer *_renderer = nullptr;
+    };
+}
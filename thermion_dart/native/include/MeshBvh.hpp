@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <filament/Box.h>
+#include <math/vec2.h>
+#include <math/vec3.h>
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    ///
+    /// A bounding volume hierarchy over the triangles of a single mesh (in object space), for CPU ray casting.
+    ///
+    /// The hierarchy is built once (with a binned surface area heuristic) and is immutable afterwards, so it can be
+    /// built on a worker thread and shared between every instance of the mesh.
+    ///
+    class MeshBvh
+    {
+    public:
+        // the maximum number of triangles in each leaf
+        static constexpr uint32_t kMaxLeafSize = 4;
+
+        struct Hit
+        {
+            // the ray parameter (the distance along the ray, if the ray direction is normalized)
+            float distance = 0.0f;
+            // the barycentric coordinates of the hit point relative to the three vertices of the triangle
+            math::float3 barycentrics;
+            // the interpolated texture coordinates (zero if the mesh has no texture coordinates)
+            math::float2 uv;
+            uint32_t triangle = 0;
+        };
+
+        ///
+        /// Builds a BVH over the triangle list [indices] (three per triangle). [uvs] may be empty, otherwise it
+        /// must contain one element for each element of [positions]. Returns nullptr if there are no triangles.
+        ///
+        static std::shared_ptr<const MeshBvh> build(std::vector<math::float3> &&positions, std::vector<math::float2> &&uvs, std::vector<uint32_t> &&indices);
+
+        ///
+        /// Finds the closest intersection with the ray [origin] + t * [direction] for t in [0, maxDistance].
+        /// Back faces are hit as well as front faces. Returns false if there is no intersection.
+        ///
+        bool raycast(const math::float3 &origin, const math::float3 &direction, float maxDistance, Hit &hit) const;
+
+        const Aabb &getBounds() const
+        {
+            return _nodes[0].box;
+        }
+
+        size_t getTriangleCount() const
+        {
+            return _indices.size() / 3;
+        }
+
+        const std::vector<math::float3> &getPositions() const
+        {
+            return _positions;
+        }
+
+    private:
+        struct Node
+        {
+            Aabb box;
+            // for leaves, the first triangle (in _triangles); otherwise the index of the right child (the left child immediately follows its parent)
+            uint32_t offset = 0;
+            // the number of triangles in a leaf, or zero for interior nodes
+            uint32_t count = 0;
+        };
+
+        uint32_t buildRecursive(uint32_t first, uint32_t count, const std::vector<Aabb> &triangleBoxes, const std::vector<math::float3> &centroids);
+
+        std::vector<math::float3> _positions;
+        std::vector<math::float2> _uvs;
+        std::vector<uint32_t> _indices;
+        // triangle indices, reordered so that the triangles in each leaf are contiguous
+        std::vector<uint32_t> _triangles;
+        std::vector<Node> _nodes;
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include <filament/Box.h>
+#include <math/mat3.h>
+#include <math/mat4.h>
+#include <math/vec3.h>
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    ///
+    /// A box with arbitrary orientation, used as a tighter collision shape than an axis-aligned box once an entity rotates.
+    ///
+    struct OrientedBox
+    {
+        math::float3 center;
+        // the (unit, mutually orthogonal) directions of the edges of the box
+        math::float3 axes[3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+        // the half-length of the box along each of [axes]
+        math::float3 halfExtents;
+
+        static OrientedBox fromAabb(const Aabb &box)
+        {
+            OrientedBox result;
+            result.center = box.center();
+            result.halfExtents = box.extent();
+            return result;
+        }
+
+        ///
+        /// Fits a box to [points] by principal component analysis, i.e. with its axes along the eigenvectors of the covariance of the points.
+        /// A box aligned with the coordinate axes is also considered, and the one with the smaller volume is returned, so the result is never
+        /// looser than the axis-aligned bounding box of the points. Returns an empty box (centered at the origin) if [count] is zero.
+        ///
+        static OrientedBox fit(const math::float3 *points, size_t count);
+
+        ///
+        /// The box that bounds this one after it is transformed by [transform]. This is exact for transforms made of a rotation, a
+        /// translation and a (uniform or non-uniform along the axes of the box) scale; if the transform skews the box, the axes are
+        /// orthonormalized and the result is conservative.
+        ///
+        OrientedBox transform(const math::mat4f &transform) const
+        {
+            const math::mat3f upper = transform.upperLeft();
+            const math::float3 edges[3] = {upper * (axes[0] * halfExtents.x), upper * (axes[1] * halfExtents.y), upper * (axes[2] * halfExtents.z)};
+
+            OrientedBox result;
+            result.center = (transform * math::float4(center, 1.0f)).xyz;
+
+            // Gram-Schmidt, starting with the longest edge so a flat box keeps its orientation
+            int order[3] = {0, 1, 2};
+            for (int i = 0; i < 2; i++)
+            {
+                for (int j = i + 1; j < 3; j++)
+                {
+                    if (dot(edges[order[j]], edges[order[j]]) > dot(edges[order[i]], edges[order[i]]))
+                    {
+                        std::swap(order[i], order[j]);
+                    }
+                }
+            }
+            math::float3 first = edges[order[0]];
+            if (!(dot(first, first) > 0.0f))
+            {
+                first = upper * axes[order[0]];
+            }
+            result.axes[0] = normalize(first);
+            math::float3 second = edges[order[1]] - dot(edges[order[1]], result.axes[0]) * result.axes[0];
+            if (!(dot(second, second) > 1e-12f * dot(first, first)))
+            {
+                // the box is (nearly) a line; any perpendicular direction will do
+                second = std::abs(result.axes[0].x) < 0.9f ? cross(result.axes[0], math::float3{1.0f, 0.0f, 0.0f}) : cross(result.axes[0], math::float3{0.0f, 1.0f, 0.0f});
+            }
+            result.axes[1] = normalize(second);
+            result.axes[2] = cross(result.axes[0], result.axes[1]);
+
+            for (int i = 0; i < 3; i++)
+            {
+                result.halfExtents[i] = std::abs(dot(edges[0], result.axes[i])) + std::abs(dot(edges[1], result.axes[i])) + std::abs(dot(edges[2], result.axes[i]));
+            }
+            return result;
+        }
+
+        ///
+        /// The axis-aligned box that bounds this box.
+        ///
+        Aabb getBounds() const
+        {
+            const math::float3 extent = abs(axes[0]) * halfExtents.x + abs(axes[1]) * halfExtents.y + abs(axes[2]) * halfExtents.z;
+            return {center - extent, center + extent};
+        }
+
+        float getVolume() const
+        {
+            return 8.0f * halfExtents.x * halfExtents.y * halfExtents.z;
+        }
+    };
+}
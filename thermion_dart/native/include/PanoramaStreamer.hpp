@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <filament/Engine.h>
+#include <filament/Frustum.h>
+#include <filament/IndexBuffer.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
+#include <filament/Scene.h>
+#include <filament/Texture.h>
+#include <filament/TextureSampler.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+#include <utils/Entity.h>
+
+#include "ResourceBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "tsl/robin_map.h"
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    ///
+    /// Streams a multi-resolution tiled cubemap panorama into a fixed-size
+    /// atlas of tile slots, drawn behind the scene with the panorama material
+    /// (materials/panorama.mat).
+    ///
+    /// Tiles are addressed by (level, face, x, y). Level 0 contains a single
+    /// [tileSize] x [tileSize] tile per face; every subsequent level doubles the
+    /// face resolution (so level L has 2^L x 2^L tiles per face). The URI for
+    /// each tile is produced by substituting the tokens {level}, {face}, {x} and
+    /// {y} in the template passed to the constructor, where {face} is one of
+    /// px, nx, py, ny, pz, nz (in Filament cubemap face order) and {y} is
+    /// counted from the top of the face.
+    ///
+    /// Every resident tile occupies one slot of the atlas at its native size
+    /// (plus a one texel border). An indirection texture holds one texel per
+    /// tile of the finest level of each face, pointing to the finest resident
+    /// tile that covers it, so the shader samples the best available level for
+    /// every pixel. The resolution is therefore only limited by the number of
+    /// levels; the size of the atlas only limits how many tiles are resident at
+    /// once. When the atlas is full, the least recently visible tile is evicted
+    /// (the six level 0 tiles are never evicted, so every direction is always
+    /// covered once they have been uploaded).
+    ///
+    /// The six level 0 tiles are always requested first and the panorama is
+    /// shown as soon as they are uploaded. After that, only tiles that
+    /// intersect the camera frustum are requested, and only down to the level
+    /// whose resolution matches the current viewport/field of view. A tile is
+    /// only requested once its parent has been uploaded, so the panorama
+    /// refines progressively from coarse to fine.
+    ///
+    /// Fetching (via the ResourceLoader) and decoding happen on worker threads;
+    /// uploads are budgeted per frame and happen on the render thread in
+    /// [update].
+    ///
+    class PanoramaStreamer
+    {
+    public:
+        ///
+        /// [material] must have been built from materials/panorama.mat (and must outlive the streamer).
+        /// Tiles are fetched and decoded on [pool] (shared with the SceneManager), or on the render thread if [pool] is null.
+        /// The atlas holds as many tiles as a cubemap with faces of [cacheFaceSize] (but never fewer than
+        /// the level 0 tiles plus one level of refinement around them).
+        ///
+        PanoramaStreamer(
+            Engine *engine,
+            Scene *scene,
+            Material *material,
+            ThreadPool *pool,
+            const ResourceLoaderWrapperImpl *const resourceLoaderWrapper,
+            const char *uriTemplate,
+            uint32_t tileSize,
+            uint32_t numLevels,
+            uint32_t cacheFaceSize);
+        ~PanoramaStreamer();
+
+        ///
+        /// Uploads any decoded tiles (up to the per-frame budget) and requests
+        /// new tiles for the camera attached to [view].
+        /// Must be called from the render thread.
+        ///
+        void update(View *view);
+
+        ///
+        /// The number of tiles that can be resident at once.
+        ///
+        uint32_t getSlotCount() const
+        {
+            return _numSlots;
+        }
+
+        uint32_t getUploadedTileCount() const
+        {
+            return _uploadedTileCount;
+        }
+
+        uint32_t getPendingTileCount() const
+        {
+            return _inFlight;
+        }
+
+        ///
+        /// The (background) renderable that draws the panorama.
+        ///
+        utils::Entity getEntity() const
+        {
+            return _entity;
+        }
+
+    private:
+        enum class TileState : uint8_t
+        {
+            REQUESTED,
+            UPLOADED,
+            FAILED
+        };
+
+        struct Tile
+        {
+            TileState state = TileState::REQUESTED;
+            uint32_t level = 0;
+            uint32_t face = 0;
+            uint32_t x = 0;
+            uint32_t y = 0;
+            // the atlas slot holding the tile (once uploaded)
+            int32_t slot = -1;
+            // the last frame in which the tile was visible
+            uint64_t lastVisible = 0;
+        };
+
+        struct DecodedTile
+        {
+            uint64_t key;
+            uint32_t level;
+            uint32_t face;
+            uint32_t x;
+            uint32_t y;
+            // RGB8 pixels covering a whole slot (the tile plus its border); nullptr if the tile could not be loaded
+            uint8_t *pixels = nullptr;
+        };
+
+        struct TileRequest
+        {
+            uint32_t level;
+            uint32_t face;
+            uint32_t x;
+            uint32_t y;
+            float angle;
+        };
+
+        static uint64_t makeKey(uint32_t level, uint32_t face, uint32_t x, uint32_t y)
+        {
+            return (uint64_t(level) << 56) | (uint64_t(face) << 48) | (uint64_t(y) << 24) | uint64_t(x);
+        }
+
+        std::string getTileUri(uint32_t level, uint32_t face, uint32_t x, uint32_t y) const;
+        void decodeTile(uint32_t level, uint32_t face, uint32_t x, uint32_t y);
+        void uploadTile(DecodedTile &tile);
+        int32_t allocateSlot();
+        void evict(int32_t slot);
+        void setIndirection(const Tile &region, const Tile &target);
+        void collectRequests(
+            const filament::Frustum &frustum,
+            const math::float3 &cameraPosition,
+            const math::float3 &cameraForward,
+            float sphereScale,
+            uint32_t requiredLevel,
+            uint32_t level,
+            uint32_t face,
+            uint32_t x,
+            uint32_t y,
+            std::vector<TileRequest> &requests);
+
+        Engine *_engine = nullptr;
+        Scene *_scene = nullptr;
+        const ResourceLoaderWrapperImpl *const _resourceLoaderWrapper;
+        std::string _uriTemplate;
+        uint32_t _tileSize = 0;
+        uint32_t _numLevels = 0;
+        // the size of a slot in the atlas (a tile plus a one texel border on every side)
+        uint32_t _slotSize = 0;
+        uint32_t _slotsPerSide = 0;
+        uint32_t _numSlots = 0;
+        uint32_t _atlasSize = 0;
+        // the number of tiles along each side of a face at the finest level
+        uint32_t _finestTilesPerSide = 0;
+
+        Texture *_atlasTexture = nullptr;
+        Texture *_indirectionTexture = nullptr;
+        MaterialInstance *_materialInstance = nullptr;
+        VertexBuffer *_vertexBuffer = nullptr;
+        IndexBuffer *_indexBuffer = nullptr;
+        utils::Entity _entity;
+        uint32_t _rootsUploaded = 0;
+
+        TaskGroup _decodes;
+        std::atomic<bool> _stopped{false};
+        std::mutex _decodedMutex;
+        std::deque<DecodedTile> _decoded;
+
+        // only accessed from the render thread
+        tsl::robin_map<uint64_t, Tile> _tiles;
+        // the key of the tile in each slot (for eviction), and the slots that are unused
+        std::vector<uint64_t> _slotKeys;
+        std::vector<int32_t> _freeSlots;
+        // RGBA8 texels (slot x, slot y, level, valid) for each tile of the finest level, faces side by side
+        std::vector<uint8_t> _indirection;
+        bool _indirectionDirty = false;
+        uint64_t _frame = 0;
+        uint32_t _inFlight = 0;
+        uint32_t _uploadedTileCount = 0;
+    };
+}
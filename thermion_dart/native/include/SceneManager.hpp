@@ -24,8 +24,13 @@
 #include "APIBoundaryTypes.h"
 #include "GridOverlay.hpp"
 #include "ResourceBuffer.hpp"
+#include "TextureStreamer.hpp"
+#include "VertexAnimationTexture.hpp"
+#include "AnimationScrubber.hpp"
 #include "components/CollisionComponentManager.hpp"
 #include "components/AnimationComponentManager.hpp"
+#include "components/RaycastComponentManager.hpp"
+#include "components/SpatialIndexComponentManager.hpp"
 
 #include "tsl/robin_map.h"
 
@@ -117,9 +122,73 @@ namespace thermion
         const utils::Entity *getLightEntities(EntityId e) noexcept;
         size_t getLightEntityCount(EntityId e) noexcept;
 
-        void updateAnimations();
+        ///
+        /// Advances all animations. [views] are the views that will be rendered this frame (used for animation LOD).
+        ///
+        void updateAnimations(const std::vector<View *> &views);
         void updateTransforms();
         void testCollisions(EntityId entity);
+
+        ///
+        /// Runs the per-frame collision pass (see CollisionComponentManager::update), if enabled.
+        ///
+        void updateCollisions();
+
+        ///
+        /// If [enabled], queued transform updates (see queueTransformUpdates) stop just before the first collidable entity that affects
+        /// transforms, rather than moving through it. Movements are swept either way, so collision callbacks are invoked for every
+        /// entity touched on the way.
+        ///
+        void setStopAtFirstContact(bool enabled);
+
+        ///
+        /// Sweeps the bounding box of [entity] by ([dx], [dy], [dz]) against every other collidable entity, and returns the fraction (in [0, 1])
+        /// of the movement at which it first touches one (written to [hitEntity]), or a negative value if it doesn't touch anything.
+        ///
+        float timeOfImpact(EntityId entity, float dx, float dy, float dz, EntityId *hitEntity);
+        void setCollisionEventsEnabled(bool enabled);
+
+        ///
+        /// Copies the collision events recorded since the last call to [out] (if there are no more than [capacity]).
+        /// Returns the number of pending events.
+        ///
+        int getCollisionEvents(TCollisionEvent *out, int capacity);
+
+        ///
+        /// Casts a ray against the triangles of every raycastable renderable (glTF assets loaded with keepData and
+        /// custom triangle geometry) whose layer mask intersects [layerMask]. Writes the (at most [maxHits]) closest
+        /// hits to [out], one per renderable, in order of increasing distance. Returns the number of hits.
+        ///
+        int raycast(const math::float3 &origin, const math::float3 &direction, float maxDistance, uint8_t layerMask, TRaycastHit *out, int maxHits);
+
+        ///
+        /// Spatial queries over the world-space bounding boxes of every renderable in the scene (see SpatialIndexComponentManager).
+        /// The first three write the renderable entities whose boxes intersect the region to [out] (up to [capacity]) and return
+        /// the number of intersecting entities, which may exceed [capacity].
+        ///
+        int queryBox(const Aabb &box, EntityId *out, int capacity);
+        int querySphere(const math::float3 &center, float radius, EntityId *out, int capacity);
+        int queryFrustum(View *view, EntityId *out, int capacity);
+
+        ///
+        /// Writes (at most) the [k] renderable entities whose world-space bounding boxes are closest to [point] to [out], in order
+        /// of increasing distance. If [distances] is not null, the distance to each box is written to the same index. Returns the
+        /// number of entities written.
+        ///
+        int queryNearest(const math::float3 &point, int k, EntityId *out, float *distances);
+
+        ///
+        /// Finds the entities visible in the polygon [points] ([numPoints] x/y pairs in viewport coordinates, with the origin at
+        /// the top-left) of [view], by casting a ray through the center of every [step]th pixel in the region against
+        /// raycastable renderables (see [raycast]) in the view's scene and visible layers. This is a CPU equivalent of reading
+        /// back the region from an entity-ID render pass; the sampling step is increased as needed to keep the number of rays
+        /// below kMaxRegionSamples.
+        ///
+        /// Writes the distinct entities (up to [capacity]) to [outEntities] in order of decreasing coverage and, if
+        /// [outPixelCounts] is not null, the (estimated) number of pixels covered by each entity. Returns the number of
+        /// distinct entities, which may exceed [capacity].
+        ///
+        int pickRegion(View *view, const float *points, int numPoints, int step, EntityId *outEntities, int32_t *outPixelCounts, int capacity);
         bool setMaterialColor(EntityId e, const char *meshName, int materialInstance, const float r, const float g, const float b, const float a);
 
         bool setMorphAnimationBuffer(
@@ -177,13 +246,92 @@ namespace thermion
         bool updateBoneMatrices(EntityId entityId);
         void playAnimation(EntityId e, int index, bool loop, bool reverse, bool replaceActive, float crossfade = 0.3f, float startOffset = 0.0f);
         void stopAnimation(EntityId e, int index);
+
+        ///
+        /// Adds a blend layer playing the glTF animation at [animationIndex] (see AnimationComponentManager::addLayer).
+        /// If [maskCount] > 0, the layer only affects [maskEntities] and their descendants.
+        /// Returns the layer ID, or -1 if the layer could not be added.
+        ///
+        int addAnimationLayer(EntityId e, int animationIndex, float weight, int mode, bool loop, const EntityId *maskEntities, int maskCount);
+        bool setAnimationLayerWeight(EntityId e, int layerId, float weight);
+        bool removeAnimationLayer(EntityId e, int layerId);
+
+        ///
+        /// Parses a compiled animation state machine (see AnimationStateMachine::parse) and returns an ID
+        /// that can be attached to any number of entities with [setAnimationStateMachine], or -1 if [data] is invalid.
+        ///
+        int createAnimationStateMachine(const uint8_t *data, size_t length);
+        void destroyAnimationStateMachine(int stateMachine);
+
+        ///
+        /// Attaches [stateMachine] to [entity] (or detaches the current state machine if [stateMachine] is -1).
+        ///
+        bool setAnimationStateMachine(EntityId e, int stateMachine);
+        bool setAnimationStateMachineParameter(EntityId e, int parameter, float value);
+        int getAnimationStateMachineState(EntityId e);
         void setMorphTargetWeights(const char *const entityName, float *weights, int count);
         
+        ///
+        /// Creates a streamed texture (see TextureStreamer); only the lowest mip levels are uploaded
+        /// until the texture is bound to a renderable that is large enough on screen to need more.
+        ///
         Texture* createTexture(const uint8_t* data, size_t length, const char* name);
         bool applyTexture(EntityId entityId, Texture *texture, const char* slotName, int materialIndex);
         void destroyTexture(Texture* texture);
+
+        TextureStreamer* getTextureStreamer() {
+            return _textureStreamer;
+        }
+
+        AnimationComponentManager* getAnimationComponentManager() {
+            return _animationComponentManager;
+        }
+
+        ///
+        /// The worker threads shared by everything that loads or evaluates asynchronously (may be null, e.g. on web).
+        ///
+        ThreadPool* getThreadPool() {
+            return _threadPool;
+        }
+
+        ///
+        /// Loads the (compiled) vertex animation material (materials/vat.mat) used to render baked vertex animations.
+        ///
+        bool loadVertexAnimationMaterial(const char* uri);
+
+        ///
+        /// Bakes the glTF animation at [animationIndex] for [entity] into a vertex animation texture (see VertexAnimationTexture).
+        /// Returns an ID for the baked animation, or -1 if the animation could not be baked.
+        ///
+        int bakeVertexAnimation(EntityId entity, int animationIndex, float frameRate);
+
+        ///
+        /// Adds a renderable to the scene that draws [count] instances of the baked animation [vertexAnimation].
+        /// [transforms] is an array of [count] column-major 4x4 matrices; [timeOffsets] may be null.
+        ///
+        EntityId createVertexAnimationInstances(int vertexAnimation, const float* transforms, const float* timeOffsets, int count);
+        bool setVertexAnimationInstances(EntityId entity, const float* transforms, const float* timeOffsets, int count);
+        bool destroyVertexAnimationInstances(EntityId entity);
+        void destroyVertexAnimation(int vertexAnimation);
         
+        ///
+        /// Applies the glTF animation at [animationIndex] to [entity] at [animationFrame], using the
+        /// frame rate of the animation (see [getAnimationFrameRate]).
+        ///
         void setAnimationFrame(EntityId entity, int animationIndex, int animationFrame);
+
+        ///
+        /// Applies the glTF animation at [animationIndex] to [entity] at [timeInSecs]. If the asset was
+        /// loaded with keepData, keyframes are found with cached per-channel cursors (see AnimationScrubber),
+        /// which makes scrubbing back and forth through long animations much cheaper.
+        ///
+        bool seekAnimation(EntityId entity, int animationIndex, float timeInSecs);
+
+        ///
+        /// Returns the frame rate of the glTF animation at [animationIndex], estimated from its keyframes
+        /// when the asset was loaded, or -1 if [entity] or [animationIndex] are invalid.
+        ///
+        float getAnimationFrameRate(EntityId entity, int animationIndex);
         bool hide(EntityId entity, const char *meshName);
         bool reveal(EntityId entity, const char *meshName);
         const char *getNameForEntity(EntityId entityId);
@@ -193,7 +341,13 @@ namespace thermion
         int getEntityCount(EntityId entity, bool renderableOnly);
         void getEntities(EntityId entity, bool renderableOnly, EntityId *out);
         const char *getEntityNameAt(EntityId entity, int index, bool renderableOnly);
-        void addCollisionComponent(EntityId entity, void (*onCollisionCallback)(const EntityId entityId1, const EntityId entityId2), bool affectsCollidingTransform);
+        ///
+        /// Makes [entity] collidable, with [shapeType] as its collision shape. If [shapeType] is OBB and the asset was loaded with keepData,
+        /// a box is fitted to the vertices of its meshes on a worker thread; until then (or if there is no mesh data), the oriented
+        /// bounding box of the entity is used.
+        ///
+        void addCollisionComponent(EntityId entity, void (*onCollisionCallback)(const EntityId entityId1, const EntityId entityId2), bool affectsCollidingTransform,
+                                   CollisionShapeType shapeType = CollisionShapeType::AABB);
         void removeCollisionComponent(EntityId entityId);
         EntityId getParent(EntityId child);
         EntityId getAncestor(EntityId child);
@@ -231,6 +385,13 @@ namespace thermion
         ///
         Aabb2 getBoundingBox(View* view, EntityId entity);
 
+        ///
+        /// Writes the 2D viewport bounding box of each of the [count] entities in [entities] to the same index in [out] (see
+        /// [getBoundingBox]). If [inFront] is not null, it receives 1 for each entity with at least one corner of its bounding
+        /// box in front of the camera and 0 otherwise (in which case the box in [out] is empty, with min > max).
+        ///
+        void getBoundingBoxes(View* view, const EntityId* entities, int count, Aabb2* out, int32_t* inFront);
+
         ///
         /// Creates an entity with the specified geometry/material/normals and adds to the scene.
         /// If [keepData] is true, stores 
@@ -331,11 +492,44 @@ namespace thermion
         tsl::robin_map<EntityId, unique_ptr<CustomGeometry>> _geometry;
         tsl::robin_map<EntityId, unique_ptr<HighlightOverlay>> _highlighted;        
         tsl::robin_map<EntityId, math::mat4> _transformUpdates;
+        bool _stopAtFirstContact = false;
         std::set<Texture*> _textures;
+        TextureStreamer* _textureStreamer = nullptr;
         std::vector<Camera*> _cameras;
 
+        tsl::robin_map<int, std::shared_ptr<const AnimationStateMachine>> _animationStateMachines;
+        int _nextAnimationStateMachineId = 0;
+
+        Material* _vertexAnimationMaterial = nullptr;
+        tsl::robin_map<int, unique_ptr<VertexAnimationTexture>> _vertexAnimations;
+        int _nextVertexAnimationId = 0;
+        // vertex animations are played from this time (on the animation clock)
+        time_point_t _vertexAnimationEpoch;
+        void destroyVertexAnimations();
+
+        // the frame rate of each glTF animation, by asset
+        tsl::robin_map<const gltfio::FilamentAsset *, std::vector<float>> _animationFrameRates;
+        tsl::robin_map<const gltfio::FilamentInstance *, unique_ptr<AnimationScrubber>> _animationScrubbers;
+        AnimationScrubber *getAnimationScrubber(gltfio::FilamentInstance *instance);
+
+        // the maximum number of worker threads shared by animation evaluation, BVH building/collision fitting,
+        // texture streaming and asynchronous loading (see getThreadPool)
+        static constexpr int kMaxWorkerThreads = 4;
+        // null if worker threads aren't available, in which case that work is done on the calling thread
+        ThreadPool *_threadPool = nullptr;
+
         AnimationComponentManager *_animationComponentManager = nullptr;
         CollisionComponentManager *_collisionComponentManager = nullptr;
+        RaycastComponentManager *_raycastComponentManager = nullptr;
+        SpatialIndexComponentManager *_spatialIndexComponentManager = nullptr;
+        void addToSpatialIndex(const utils::Entity *entities, size_t count);
+
+        // the maximum number of rays cast by pickRegion
+        static constexpr int kMaxRegionSamples = 1 << 18;
+
+        // the triangle BVH of each mesh (by cgltf mesh index) of each asset loaded with keepData
+        tsl::robin_map<const gltfio::FilamentAsset *, std::vector<MeshBvhFuture>> _meshBvhs;
+        void addRaycastComponents(gltfio::FilamentAsset *asset, gltfio::FilamentInstance *instance);
 
         utils::Entity findEntityByName(
             const gltfio::FilamentInstance *instance,
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define THERMION_SCREEN_SPACE_BOUNDS_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define THERMION_SCREEN_SPACE_BOUNDS_NEON 1
+#endif
+
+#include <filament/Box.h>
+#include <math/mat4.h>
+#include <math/vec4.h>
+
+#include "APIBoundaryTypes.h"
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    ///
+    /// Projects the eight corners of [box] with [clipFromLocal] (i.e. projection * view * world) and writes the 2D bounds of the
+    /// projected corners, in viewport coordinates (origin at the top-left), to [out]. NDC coordinates are clamped to [-1, 1], and
+    /// corners behind the camera are ignored. Returns false (and writes an empty box, with min > max) if every corner is behind
+    /// the camera.
+    ///
+    /// The clip-space position of each corner is the position of the min corner plus some combination of the three (projected)
+    /// box edges, so only four matrix/vector products are needed; the corners are then divided, clamped and reduced four at a time.
+    ///
+    inline bool projectBox(const math::mat4f &clipFromLocal, const Aabb &box, float viewportWidth, float viewportHeight, Aabb2 &out)
+    {
+        const math::float3 extent = box.max - box.min;
+        const math::float4 base = clipFromLocal * math::float4(box.min, 1.0f);
+        const math::float4 edgeX = clipFromLocal[0] * extent.x;
+        const math::float4 edgeY = clipFromLocal[1] * extent.y;
+        const math::float4 edgeZ = clipFromLocal[2] * extent.z;
+
+#if defined(THERMION_SCREEN_SPACE_BOUNDS_SSE)
+        // lanes are the corners (0, 0), (1, 0), (0, 1), (1, 1) in the x/y edges
+        const __m128 maskX = _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f);
+        const __m128 maskY = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 width = _mm_set1_ps(viewportWidth);
+        const __m128 height = _mm_set1_ps(viewportHeight);
+        const __m128 largest = _mm_set1_ps(FLT_MAX);
+        const __m128 lowest = _mm_set1_ps(-FLT_MAX);
+
+        __m128 minX = largest, minY = largest, maxX = lowest, maxY = lowest;
+        __m128 inFront = zero;
+
+        for (int z = 0; z < 2; z++)
+        {
+            const math::float4 origin = z ? base + edgeZ : base;
+            const __m128 x = _mm_add_ps(_mm_set1_ps(origin.x), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeX.x), maskX), _mm_mul_ps(_mm_set1_ps(edgeY.x), maskY)));
+            const __m128 y = _mm_add_ps(_mm_set1_ps(origin.y), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeX.y), maskX), _mm_mul_ps(_mm_set1_ps(edgeY.y), maskY)));
+            const __m128 w = _mm_add_ps(_mm_set1_ps(origin.w), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeX.w), maskX), _mm_mul_ps(_mm_set1_ps(edgeY.w), maskY)));
+
+            const __m128 valid = _mm_cmpgt_ps(w, zero);
+            inFront = _mm_or_ps(inFront, valid);
+
+            const __m128 inverseW = _mm_div_ps(one, w);
+            const __m128 ndcX = _mm_max_ps(_mm_sub_ps(zero, one), _mm_min_ps(one, _mm_mul_ps(x, inverseW)));
+            const __m128 ndcY = _mm_max_ps(_mm_sub_ps(zero, one), _mm_min_ps(one, _mm_mul_ps(y, inverseW)));
+            const __m128 viewportX = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndcX, half), half), width);
+            const __m128 viewportY = _mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(ndcY, half)), height);
+
+            // corners behind the camera are replaced with values that can't affect the min/max
+            minX = _mm_min_ps(minX, _mm_or_ps(_mm_and_ps(valid, viewportX), _mm_andnot_ps(valid, largest)));
+            minY = _mm_min_ps(minY, _mm_or_ps(_mm_and_ps(valid, viewportY), _mm_andnot_ps(valid, largest)));
+            maxX = _mm_max_ps(maxX, _mm_or_ps(_mm_and_ps(valid, viewportX), _mm_andnot_ps(valid, lowest)));
+            maxY = _mm_max_ps(maxY, _mm_or_ps(_mm_and_ps(valid, viewportY), _mm_andnot_ps(valid, lowest)));
+        }
+
+        // reduce the four lanes
+        minX = _mm_min_ps(minX, _mm_shuffle_ps(minX, minX, _MM_SHUFFLE(1, 0, 3, 2)));
+        minX = _mm_min_ps(minX, _mm_shuffle_ps(minX, minX, _MM_SHUFFLE(2, 3, 0, 1)));
+        minY = _mm_min_ps(minY, _mm_shuffle_ps(minY, minY, _MM_SHUFFLE(1, 0, 3, 2)));
+        minY = _mm_min_ps(minY, _mm_shuffle_ps(minY, minY, _MM_SHUFFLE(2, 3, 0, 1)));
+        maxX = _mm_max_ps(maxX, _mm_shuffle_ps(maxX, maxX, _MM_SHUFFLE(1, 0, 3, 2)));
+        maxX = _mm_max_ps(maxX, _mm_shuffle_ps(maxX, maxX, _MM_SHUFFLE(2, 3, 0, 1)));
+        maxY = _mm_max_ps(maxY, _mm_shuffle_ps(maxY, maxY, _MM_SHUFFLE(1, 0, 3, 2)));
+        maxY = _mm_max_ps(maxY, _mm_shuffle_ps(maxY, maxY, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        out = {_mm_cvtss_f32(minX), _mm_cvtss_f32(minY), _mm_cvtss_f32(maxX), _mm_cvtss_f32(maxY)};
+        return _mm_movemask_ps(inFront) != 0;
+#elif defined(THERMION_SCREEN_SPACE_BOUNDS_NEON)
+        static const float kMaskX[4] = {0.0f, 1.0f, 0.0f, 1.0f};
+        static const float kMaskY[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+        const float32x4_t maskX = vld1q_f32(kMaskX);
+        const float32x4_t maskY = vld1q_f32(kMaskY);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        const float32x4_t largest = vdupq_n_f32(FLT_MAX);
+        const float32x4_t lowest = vdupq_n_f32(-FLT_MAX);
+
+        float32x4_t minX = largest, minY = largest, maxX = lowest, maxY = lowest;
+        uint32x4_t inFront = vdupq_n_u32(0);
+
+        for (int z = 0; z < 2; z++)
+        {
+            const math::float4 origin = z ? base + edgeZ : base;
+            const float32x4_t x = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(origin.x), maskX, edgeX.x), maskY, edgeY.x);
+            const float32x4_t y = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(origin.y), maskX, edgeX.y), maskY, edgeY.y);
+            const float32x4_t w = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(origin.w), maskX, edgeX.w), maskY, edgeY.w);
+
+            const uint32x4_t valid = vcgtq_f32(w, zero);
+            inFront = vorrq_u32(inFront, valid);
+
+#if defined(__aarch64__)
+            const float32x4_t inverseW = vdivq_f32(one, w);
+#else
+            // refine the reciprocal estimate with two Newton-Raphson steps
+            float32x4_t inverseW = vrecpeq_f32(w);
+            inverseW = vmulq_f32(vrecpsq_f32(w, inverseW), inverseW);
+            inverseW = vmulq_f32(vrecpsq_f32(w, inverseW), inverseW);
+#endif
+            const float32x4_t ndcX = vmaxq_f32(vnegq_f32(one), vminq_f32(one, vmulq_f32(x, inverseW)));
+            const float32x4_t ndcY = vmaxq_f32(vnegq_f32(one), vminq_f32(one, vmulq_f32(y, inverseW)));
+            const float32x4_t viewportX = vmulq_n_f32(vmlaq_f32(half, ndcX, half), viewportWidth);
+            const float32x4_t viewportY = vmulq_n_f32(vmlsq_f32(half, ndcY, half), viewportHeight);
+
+            // corners behind the camera are replaced with values that can't affect the min/max
+            minX = vminq_f32(minX, vbslq_f32(valid, viewportX, largest));
+            minY = vminq_f32(minY, vbslq_f32(valid, viewportY, largest));
+            maxX = vmaxq_f32(maxX, vbslq_f32(valid, viewportX, lowest));
+            maxY = vmaxq_f32(maxY, vbslq_f32(valid, viewportY, lowest));
+        }
+
+        // reduce the four lanes
+        float32x2_t minX2 = vpmin_f32(vget_low_f32(minX), vget_high_f32(minX));
+        float32x2_t minY2 = vpmin_f32(vget_low_f32(minY), vget_high_f32(minY));
+        float32x2_t maxX2 = vpmax_f32(vget_low_f32(maxX), vget_high_f32(maxX));
+        float32x2_t maxY2 = vpmax_f32(vget_low_f32(maxY), vget_high_f32(maxY));
+        minX2 = vpmin_f32(minX2, minX2);
+        minY2 = vpmin_f32(minY2, minY2);
+        maxX2 = vpmax_f32(maxX2, maxX2);
+        maxY2 = vpmax_f32(maxY2, maxY2);
+
+        out = {vget_lane_f32(minX2, 0), vget_lane_f32(minY2, 0), vget_lane_f32(maxX2, 0), vget_lane_f32(maxY2, 0)};
+        const uint32x2_t inFront2 = vorr_u32(vget_low_u32(inFront), vget_high_u32(inFront));
+        return (vget_lane_u32(inFront2, 0) | vget_lane_u32(inFront2, 1)) != 0;
+#else
+        out = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+        bool inFront = false;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            math::float4 clip = base;
+            if (corner & 1)
+            {
+                clip += edgeX;
+            }
+            if (corner & 2)
+            {
+                clip += edgeY;
+            }
+            if (corner & 4)
+            {
+                clip += edgeZ;
+            }
+            if (clip.w <= 0.0f)
+            {
+                continue;
+            }
+            inFront = true;
+            const float ndcX = std::max(-1.0f, std::min(1.0f, clip.x / clip.w));
+            const float ndcY = std::max(-1.0f, std::min(1.0f, clip.y / clip.w));
+            const float viewportX = (ndcX * 0.5f + 0.5f) * viewportWidth;
+            const float viewportY = (0.5f - ndcY * 0.5f) * viewportHeight;
+            out.minX = std::min(out.minX, viewportX);
+            out.minY = std::min(out.minY, viewportY);
+            out.maxX = std::max(out.maxX, viewportX);
+            out.maxY = std::max(out.maxY, viewportY);
+        }
+        return inFront;
+#endif
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <filament/Engine.h>
+#include <filament/MaterialInstance.h>
+#include <filament/Texture.h>
+#include <filament/TextureSampler.h>
+#include <filament/View.h>
+
+#include <image/LinearImage.h>
+#include <utils/Entity.h>
+
+#include "ThreadPool.hpp"
+#include "tsl/robin_map.h"
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    ///
+    /// Streams the mip levels of (image) textures in and out of GPU memory
+    /// based on how large they appear on screen.
+    ///
+    /// [create] decodes the image once and uploads only the tail of the mip
+    /// chain (the largest level no bigger than kBaseSize). The returned
+    /// "base" texture is used as the handle for the lifetime of the streamed
+    /// texture and is always resident, so there is always something to
+    /// sample. Only the encoded image is kept in CPU memory.
+    ///
+    /// Every frame, [update] projects the bounding box of each renderable
+    /// that a streamed texture is bound to into every View, and derives the
+    /// finest mip level needed from the projected screen area. When a finer
+    /// level is needed than is resident, the image is decoded and
+    /// downsampled on a worker thread, uploaded as a new texture on the
+    /// render thread (at most kMaxUploadsPerFrame per frame) and swapped in
+    /// for every binding.
+    ///
+    /// When a promotion would exceed the memory budget, textures that are
+    /// resident at a finer level than they currently need are evicted
+    /// (least recently visible first) back to their base texture. If that
+    /// doesn't free enough memory, the promotion is clamped to the finest
+    /// level that fits.
+    ///
+    /// All methods must be called from the render thread.
+    ///
+    class TextureStreamer
+    {
+    public:
+        struct Stats
+        {
+            // the number of streamed textures
+            uint32_t textureCount = 0;
+            // the number of streamed textures whose finest required level is resident
+            uint32_t satisfiedCount = 0;
+            // the number of textures currently being decoded/awaiting upload
+            uint32_t pendingCount = 0;
+            // the (estimated) GPU memory used by all streamed textures
+            size_t residentBytes = 0;
+            // the (estimated) GPU memory that would be needed to make every required level resident
+            size_t requiredBytes = 0;
+            size_t budgetBytes = 0;
+        };
+
+        ///
+        /// Images are decoded on [pool] (shared with the SceneManager), or on the render thread if [pool] is null.
+        ///
+        TextureStreamer(Engine *engine, ThreadPool *pool, size_t budgetInBytes = 256 * 1024 * 1024);
+        ~TextureStreamer();
+
+        ///
+        /// Decodes [data] and uploads the lowest mip levels. Returns the base texture
+        /// (which acts as the handle for [bind]/[destroy]), or nullptr if the image could not be decoded.
+        ///
+        Texture *create(const uint8_t *data, size_t length, const char *name);
+
+        bool isStreamed(Texture *handle) const;
+
+        ///
+        /// Binds the streamed texture [handle] to [parameterName] on the [materialIndex]-th
+        /// material instance of [entity]. The binding is updated whenever a different mip range is swapped in.
+        ///
+        bool bind(Texture *handle, utils::Entity entity, int materialIndex, const char *parameterName);
+
+        ///
+        /// Destroys the streamed texture [handle] (and any finer texture that has been swapped in).
+        /// Returns false if [handle] is not a streamed texture.
+        ///
+        bool destroy(Texture *handle);
+
+        ///
+        /// Destroys all streamed textures.
+        ///
+        void clear();
+
+        void setBudget(size_t budgetInBytes);
+
+        ///
+        /// Recomputes the required mip level for every streamed texture from [views],
+        /// uploads decoded levels and dispatches new decodes.
+        ///
+        void update(const std::vector<View *> &views);
+
+        Stats getStats() const;
+
+    private:
+        struct Binding
+        {
+            utils::Entity entity;
+            int materialIndex = 0;
+            MaterialInstance *materialInstance = nullptr;
+            std::string parameterName;
+        };
+
+        struct StreamedTexture
+        {
+            // distinguishes this texture from a later texture that happens to reuse the same handle
+            uint64_t id = 0;
+            std::string name;
+            // the encoded image, shared with any in-flight decode
+            std::shared_ptr<std::vector<uint8_t>> source;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t channels = 0;
+            uint32_t numLevels = 0;
+
+            Texture *base = nullptr;
+            uint32_t baseLevel = 0;
+
+            // the texture swapped in for a finer level than [baseLevel] (if any)
+            Texture *resident = nullptr;
+            uint32_t residentLevel = 0;
+
+            uint32_t requiredLevel = 0;
+            uint32_t pendingLevel = 0;
+            bool pending = false;
+
+            uint64_t lastVisibleFrame = 0;
+            std::vector<Binding> bindings;
+        };
+
+        struct DecodedLevels
+        {
+            Texture *handle = nullptr;
+            uint64_t id = 0;
+            uint32_t level = 0;
+            // mip chain starting at [level]
+            std::vector<image::LinearImage> mips;
+        };
+
+        static std::vector<image::LinearImage> createLevels(const image::LinearImage &image, uint32_t level);
+        static std::vector<image::LinearImage> decodeLevels(const std::vector<uint8_t> &source, const std::string &name, uint32_t level);
+
+        size_t getSizeInBytes(const StreamedTexture &texture, uint32_t level) const;
+        Texture *upload(const StreamedTexture &texture, std::vector<image::LinearImage> &mips);
+        void swap(StreamedTexture &texture, Texture *resident, uint32_t level);
+        uint32_t computeRequiredLevel(StreamedTexture &texture, const std::vector<View *> &views);
+        bool makeRoom(size_t requiredBytes, Texture *exclude);
+        void destroyTexture(StreamedTexture &texture);
+
+        Engine *_engine = nullptr;
+        size_t _budgetInBytes = 0;
+        size_t _residentBytes = 0;
+        uint64_t _frame = 0;
+        uint64_t _nextId = 0;
+        TextureSampler _sampler;
+
+        TaskGroup _decodes;
+        std::mutex _decodedMutex;
+        std::vector<DecodedLevels> _decoded;
+        tsl::robin_map<Texture *, StreamedTexture> _textures;
+    };
+}
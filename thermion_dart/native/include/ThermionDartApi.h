@@ -86,6 +86,7 @@ extern "C"
 	EMSCRIPTEN_KEEPALIVE TSwapChain* Viewer_getSwapChainAt(TViewer *tViewer, int index);
 	EMSCRIPTEN_KEEPALIVE void Viewer_setViewRenderable(TViewer *viewer, TSwapChain *swapChain, TView* view, bool renderable);	
 	EMSCRIPTEN_KEEPALIVE void Viewer_pick(TViewer *viewer, TView* tView, int x, int y, void (*callback)(EntityId entityId, int x, int y, TView *tView, float depth, float fragX, float fragY, float fragZ));
+	EMSCRIPTEN_KEEPALIVE void Viewer_hoverPick(TViewer *viewer, TView* tView, int x, int y, void (*callback)(EntityId entityId, int x, int y, TView *tView, float depth, float fragX, float fragY, float fragZ));
 	EMSCRIPTEN_KEEPALIVE bool Viewer_isNonPickableEntity(TViewer *viewer, EntityId entityId);
 	
 	// Engine
@@ -95,13 +96,21 @@ extern "C"
 	
 	EMSCRIPTEN_KEEPALIVE void clear_background_image(TViewer *viewer);
 	EMSCRIPTEN_KEEPALIVE void set_background_image(TViewer *viewer, const char *path, bool fillHeight);
+	EMSCRIPTEN_KEEPALIVE void Viewer_setBackgroundImageAsync(TViewer *viewer, const char *path, bool fillHeight, void (*onComplete)());
 	EMSCRIPTEN_KEEPALIVE void set_background_image_position(TViewer *viewer, float x, float y, bool clamp);
 	EMSCRIPTEN_KEEPALIVE void set_background_color(TViewer *viewer, const float r, const float g, const float b, const float a);
 	
 	
 	EMSCRIPTEN_KEEPALIVE void load_skybox(TViewer *viewer, const char *skyboxPath);
+	EMSCRIPTEN_KEEPALIVE void Viewer_loadSkyboxAsync(TViewer *viewer, const char *skyboxPath, void (*onComplete)());
+	EMSCRIPTEN_KEEPALIVE bool Viewer_loadPanoramaMaterial(TViewer *viewer, const char *path);
+	EMSCRIPTEN_KEEPALIVE void Viewer_loadTiledPanorama(TViewer *viewer, const char *uriTemplate, uint32_t tileSize, uint32_t numLevels, uint32_t cacheFaceSize);
 	EMSCRIPTEN_KEEPALIVE void Viewer_loadIbl(TViewer *viewer, const char *iblPath, float intensity);
+	EMSCRIPTEN_KEEPALIVE void Viewer_loadIblAsync(TViewer *viewer, const char *iblPath, float intensity, float crossfadeInSecs, void (*onComplete)());
+	EMSCRIPTEN_KEEPALIVE void Viewer_prefetchEnvironment(TViewer *viewer, const char *uri, int priority);
+	EMSCRIPTEN_KEEPALIVE void Viewer_setEnvironmentCacheBudget(TViewer *viewer, size_t budgetInBytes);
 	EMSCRIPTEN_KEEPALIVE void create_ibl(TViewer *viewer, float r, float g, float b, float intensity);
+	EMSCRIPTEN_KEEPALIVE void Viewer_createIblFromImage(TViewer *viewer, const char *imagePath, float intensity, bool createSkybox, const char *cacheDir);
 	EMSCRIPTEN_KEEPALIVE void rotate_ibl(TViewer *viewer, float *rotationMatrix);
 	EMSCRIPTEN_KEEPALIVE void remove_skybox(TViewer *viewer);
 	EMSCRIPTEN_KEEPALIVE void remove_ibl(TViewer *viewer);
@@ -187,6 +196,8 @@ extern "C"
 		const float *const transform);
 	EMSCRIPTEN_KEEPALIVE void play_animation(TSceneManager *sceneManager, EntityId entity, int index, bool loop, bool reverse, bool replaceActive, float crossfade, float startOffset);
 	EMSCRIPTEN_KEEPALIVE void set_animation_frame(TSceneManager *sceneManager, EntityId entity, int animationIndex, int animationFrame);
+	EMSCRIPTEN_KEEPALIVE bool seek_animation(TSceneManager *sceneManager, EntityId entity, int animationIndex, float timeInSecs);
+	EMSCRIPTEN_KEEPALIVE float get_animation_frame_rate(TSceneManager *sceneManager, EntityId entity, int animationIndex);
 	EMSCRIPTEN_KEEPALIVE void stop_animation(TSceneManager *sceneManager, EntityId entity, int index);
 	EMSCRIPTEN_KEEPALIVE int get_animation_count(TSceneManager *sceneManager, EntityId asset);
 	EMSCRIPTEN_KEEPALIVE void get_animation_name(TSceneManager *sceneManager, EntityId entity, char *const outPtr, int index);
@@ -265,6 +276,7 @@ extern "C"
 	EMSCRIPTEN_KEEPALIVE void ios_dummy();
 	EMSCRIPTEN_KEEPALIVE void thermion_flutter_free(void *ptr);
 	EMSCRIPTEN_KEEPALIVE void add_collision_component(TSceneManager *sceneManager, EntityId entityId, void (*callback)(const EntityId entityId1, const EntityId entityId2), bool affectsCollidingTransform);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_addCollisionComponent(TSceneManager *sceneManager, EntityId entityId, void (*callback)(const EntityId entityId1, const EntityId entityId2), bool affectsCollidingTransform, int shapeType);
 	EMSCRIPTEN_KEEPALIVE void remove_collision_component(TSceneManager *sceneManager, EntityId entityId);
 	EMSCRIPTEN_KEEPALIVE bool add_animation_component(TSceneManager *sceneManager, EntityId entityId);
 	EMSCRIPTEN_KEEPALIVE void remove_animation_component(TSceneManager *sceneManager, EntityId entityId);
@@ -273,10 +285,21 @@ extern "C"
 	EMSCRIPTEN_KEEPALIVE EntityId get_ancestor(TSceneManager *sceneManager, EntityId child);
 	EMSCRIPTEN_KEEPALIVE void set_parent(TSceneManager *sceneManager, EntityId child, EntityId parent, bool preserveScaling);
 	EMSCRIPTEN_KEEPALIVE void test_collisions(TSceneManager *sceneManager, EntityId entity);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_setCollisionEventsEnabled(TSceneManager *sceneManager, bool enabled);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_setStopAtFirstContact(TSceneManager *sceneManager, bool enabled);
+	EMSCRIPTEN_KEEPALIVE float SceneManager_timeOfImpact(TSceneManager *sceneManager, EntityId entity, float dx, float dy, float dz, EntityId *hitEntity);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_getCollisionEvents(TSceneManager *sceneManager, TCollisionEvent *out, int capacity);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_raycast(TSceneManager *sceneManager, float originX, float originY, float originZ, float directionX, float directionY, float directionZ, float maxDistance, int layerMask, TRaycastHit *out, int maxHits);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_queryBox(TSceneManager *sceneManager, float minX, float minY, float minZ, float maxX, float maxY, float maxZ, EntityId *out, int capacity);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_querySphere(TSceneManager *sceneManager, float x, float y, float z, float radius, EntityId *out, int capacity);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_queryFrustum(TSceneManager *sceneManager, TView *view, EntityId *out, int capacity);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_queryNearest(TSceneManager *sceneManager, float x, float y, float z, int k, EntityId *out, float *distances);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_pickRegion(TSceneManager *sceneManager, TView *view, const float *points, int numPoints, int step, EntityId *outEntities, int32_t *outPixelCounts, int capacity);
 	EMSCRIPTEN_KEEPALIVE void set_priority(TSceneManager *sceneManager, EntityId entityId, int priority);
 	
 	EMSCRIPTEN_KEEPALIVE Aabb2 get_bounding_box(TSceneManager *sceneManager, TView *view, EntityId entity);
 	EMSCRIPTEN_KEEPALIVE void get_bounding_box_to_out(TSceneManager *sceneManager, TView *view, EntityId entity, float *minX, float *minY, float *maxX, float *maxY);
+	EMSCRIPTEN_KEEPALIVE void get_bounding_boxes(TSceneManager *sceneManager, TView *view, const EntityId *entities, int count, Aabb2 *out, int32_t *inFront);
 	
 	
 	EMSCRIPTEN_KEEPALIVE void set_stencil_highlight(TSceneManager *sceneManager, EntityId entity, float r, float g, float b);
@@ -289,6 +312,27 @@ extern "C"
 	EMSCRIPTEN_KEEPALIVE void *const create_texture(TSceneManager *sceneManager, uint8_t *data, size_t length);
 	EMSCRIPTEN_KEEPALIVE void destroy_texture(TSceneManager *sceneManager, void *const texture);
 	EMSCRIPTEN_KEEPALIVE void apply_texture_to_material(TSceneManager *sceneManager, EntityId entity, void *const texture, const char *parameterName, int materialIndex);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_setTextureStreamingBudget(TSceneManager *sceneManager, size_t budgetInBytes);
+	EMSCRIPTEN_KEEPALIVE TTextureStreamingStats SceneManager_getTextureStreamingStats(TSceneManager *sceneManager);
+	EMSCRIPTEN_KEEPALIVE TAnimationStats SceneManager_getAnimationStats(TSceneManager *sceneManager);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationClock(TSceneManager *sceneManager, int mode, float timestepInSecs);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_stepAnimations(TSceneManager *sceneManager, float deltaInSecs);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationLod(TSceneManager *sceneManager, bool enabled, float distantScreenSize, int distantInterval, int culledInterval);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationCompression(TSceneManager *sceneManager, float translationTolerance, float rotationTolerance, float scaleTolerance);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_addAnimationLayer(TSceneManager *sceneManager, EntityId entity, int animationIndex, float weight, int mode, bool loop, const EntityId *maskEntities, int maskCount);
+	EMSCRIPTEN_KEEPALIVE bool SceneManager_setAnimationLayerWeight(TSceneManager *sceneManager, EntityId entity, int layerId, float weight);
+	EMSCRIPTEN_KEEPALIVE bool SceneManager_removeAnimationLayer(TSceneManager *sceneManager, EntityId entity, int layerId);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_createAnimationStateMachine(TSceneManager *sceneManager, const uint8_t *data, size_t length);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_destroyAnimationStateMachine(TSceneManager *sceneManager, int stateMachine);
+	EMSCRIPTEN_KEEPALIVE bool SceneManager_setAnimationStateMachine(TSceneManager *sceneManager, EntityId entity, int stateMachine);
+	EMSCRIPTEN_KEEPALIVE bool SceneManager_setAnimationStateMachineParameter(TSceneManager *sceneManager, EntityId entity, int parameter, float value);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_getAnimationStateMachineState(TSceneManager *sceneManager, EntityId entity);
+	EMSCRIPTEN_KEEPALIVE bool SceneManager_loadVertexAnimationMaterial(TSceneManager *sceneManager, const char *path);
+	EMSCRIPTEN_KEEPALIVE int SceneManager_bakeVertexAnimation(TSceneManager *sceneManager, EntityId entity, int animationIndex, float frameRate);
+	EMSCRIPTEN_KEEPALIVE EntityId SceneManager_createVertexAnimationInstances(TSceneManager *sceneManager, int vertexAnimation, const float *transforms, const float *timeOffsets, int count);
+	EMSCRIPTEN_KEEPALIVE bool SceneManager_setVertexAnimationInstances(TSceneManager *sceneManager, EntityId entity, const float *transforms, const float *timeOffsets, int count);
+	EMSCRIPTEN_KEEPALIVE bool SceneManager_destroyVertexAnimationInstances(TSceneManager *sceneManager, EntityId entity);
+	EMSCRIPTEN_KEEPALIVE void SceneManager_destroyVertexAnimation(TSceneManager *sceneManager, int vertexAnimation);
 
 	EMSCRIPTEN_KEEPALIVE TMaterialInstance* get_material_instance_at(TSceneManager *sceneManager, EntityId entity, int materialIndex);
 	
@@ -35,7 +35,11 @@ extern "C"
     EMSCRIPTEN_KEEPALIVE void Viewer_captureRenderThread(TViewer *viewer, TView* view,  TSwapChain* swapChain, uint8_t* out, void (*onComplete)());
     EMSCRIPTEN_KEEPALIVE void Viewer_captureRenderTargetRenderThread(TViewer *viewer, TView* view,  TSwapChain* swapChain, TRenderTarget* renderTarget, uint8_t* out, void (*onComplete)());
     EMSCRIPTEN_KEEPALIVE void Viewer_requestFrameRenderThread(TViewer *viewer, void(*onComplete)());
-    EMSCRIPTEN_KEEPALIVE void Viewer_loadIblRenderThread(TViewer *viewer, const char *iblPath, float intensity, void(*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void Viewer_loadIblRenderThread(TViewer *viewer, const char *iblPath, float intensity, float crossfadeInSecs, void(*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void Viewer_createIblFromImageRenderThread(TViewer *viewer, const char *imagePath, float intensity, bool createSkybox, const char *cacheDir, void(*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void Viewer_setEnvironmentCacheBudgetRenderThread(TViewer *viewer, size_t budgetInBytes, void(*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void Viewer_loadPanoramaMaterialRenderThread(TViewer *viewer, const char *path, void (*callback)(bool));
+    EMSCRIPTEN_KEEPALIVE void Viewer_loadTiledPanoramaRenderThread(TViewer *viewer, const char *uriTemplate, uint32_t tileSize, uint32_t numLevels, uint32_t cacheFaceSize, void(*onComplete)());
     
     EMSCRIPTEN_KEEPALIVE void View_setToneMappingRenderThread(TView *tView, TEngine *tEngine, thermion::ToneMapping toneMapping);
     EMSCRIPTEN_KEEPALIVE void View_setBloomRenderThread(TView *tView, double bloom);
@@ -67,6 +71,30 @@ extern "C"
         void (*callback)(EntityId));
     EMSCRIPTEN_KEEPALIVE void SceneManager_loadGlbFromBufferRenderThread(TSceneManager *sceneManager, const uint8_t *const data, size_t length, int numInstances, bool keepData, int priority, int layer, bool loadResourcesAsync, void (*callback)(EntityId));
     EMSCRIPTEN_KEEPALIVE void SceneManager_createUnlitMaterialInstanceRenderThread(TSceneManager *sceneManager, void (*callback)(TMaterialInstance*));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setTextureStreamingBudgetRenderThread(TSceneManager *sceneManager, size_t budgetInBytes, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_getTextureStreamingStatsRenderThread(TSceneManager *sceneManager, TTextureStreamingStats *out, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_getAnimationStatsRenderThread(TSceneManager *sceneManager, TAnimationStats *out, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationClockRenderThread(TSceneManager *sceneManager, int mode, float timestepInSecs, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setCollisionEventsEnabledRenderThread(TSceneManager *sceneManager, bool enabled, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_getCollisionEventsRenderThread(TSceneManager *sceneManager, TCollisionEvent *out, int capacity, void (*callback)(int));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_pickRegionRenderThread(TSceneManager *sceneManager, TView *view, const float *points, int numPoints, int step, EntityId *outEntities, int32_t *outPixelCounts, int capacity, void (*callback)(int));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_stepAnimationsRenderThread(TSceneManager *sceneManager, float deltaInSecs, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationLodRenderThread(TSceneManager *sceneManager, bool enabled, float distantScreenSize, int distantInterval, int culledInterval, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationCompressionRenderThread(TSceneManager *sceneManager, float translationTolerance, float rotationTolerance, float scaleTolerance, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_addAnimationLayerRenderThread(TSceneManager *sceneManager, EntityId entity, int animationIndex, float weight, int mode, bool loop, const EntityId *maskEntities, int maskCount, void (*callback)(int));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationLayerWeightRenderThread(TSceneManager *sceneManager, EntityId entity, int layerId, float weight, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_removeAnimationLayerRenderThread(TSceneManager *sceneManager, EntityId entity, int layerId, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_createAnimationStateMachineRenderThread(TSceneManager *sceneManager, const uint8_t *data, size_t length, void (*callback)(int));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_destroyAnimationStateMachineRenderThread(TSceneManager *sceneManager, int stateMachine, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationStateMachineRenderThread(TSceneManager *sceneManager, EntityId entity, int stateMachine, void (*callback)(bool));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationStateMachineParameterRenderThread(TSceneManager *sceneManager, EntityId entity, int parameter, float value, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_getAnimationStateMachineStateRenderThread(TSceneManager *sceneManager, EntityId entity, void (*callback)(int));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_loadVertexAnimationMaterialRenderThread(TSceneManager *sceneManager, const char *path, void (*callback)(bool));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_bakeVertexAnimationRenderThread(TSceneManager *sceneManager, EntityId entity, int animationIndex, float frameRate, void (*callback)(int));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_createVertexAnimationInstancesRenderThread(TSceneManager *sceneManager, int vertexAnimation, const float *transforms, const float *timeOffsets, int count, void (*callback)(EntityId));
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setVertexAnimationInstancesRenderThread(TSceneManager *sceneManager, EntityId entity, const float *transforms, const float *timeOffsets, int count, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_destroyVertexAnimationInstancesRenderThread(TSceneManager *sceneManager, EntityId entity, void (*onComplete)());
+    EMSCRIPTEN_KEEPALIVE void SceneManager_destroyVertexAnimationRenderThread(TSceneManager *sceneManager, int vertexAnimation, void (*onComplete)());
     EMSCRIPTEN_KEEPALIVE void load_glb_render_thread(TSceneManager *sceneManager, const char *assetPath, int numInstances, bool keepData, void (*callback)(EntityId));
     EMSCRIPTEN_KEEPALIVE void load_gltf_render_thread(TSceneManager *sceneManager, const char *assetPath, const char *relativePath, bool keepData, void (*callback)(EntityId));
     EMSCRIPTEN_KEEPALIVE void create_instance_render_thread(TSceneManager *sceneManager, EntityId entityId, void (*callback)(EntityId));
@@ -80,6 +108,7 @@ extern "C"
         float *const weights,
         int count);
     EMSCRIPTEN_KEEPALIVE void set_animation_frame_render_thread(TSceneManager *sceneManager, EntityId asset, int animationIndex, int animationFrame);
+    EMSCRIPTEN_KEEPALIVE void seek_animation_render_thread(TSceneManager *sceneManager, EntityId asset, int animationIndex, float timeInSecs, void (*callback)(bool));
     EMSCRIPTEN_KEEPALIVE void stop_animation_render_thread(TSceneManager *sceneManager, EntityId asset, int index);
     EMSCRIPTEN_KEEPALIVE void get_animation_count_render_thread(TSceneManager *sceneManager, EntityId asset, void (*callback)(int));
     EMSCRIPTEN_KEEPALIVE void get_animation_name_render_thread(TSceneManager *sceneManager, EntityId asset, char *const outPtr, int index, void (*callback)());
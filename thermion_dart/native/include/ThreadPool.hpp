@@ -3,7 +3,10 @@
  * distribution in the file COPYING.
  */
 
+#include <condition_variable>
+#include <algorithm>
 #include <future>
+#include <mutex>
 #include <thread>
 #include <deque>
 #include <vector>
@@ -32,7 +35,11 @@ public:
 		}
 	}
 	~ThreadPool() {
-		stop = true;
+		{
+			std::unique_lock<std::mutex> lock(access);
+			stop = true;
+		}
+		cond.notify_all();
 		for(std::thread &t : pool) {
 			t.join();
 		}
@@ -51,16 +58,21 @@ public:
 		return ret;
 	}
 
+	int size() const {
+		return int(pool.size());
+	}
+
 private:
 	void add_worker() {
 		std::thread t([this]() {
-			while(!stop || tasks.size() > 0) {
+			while(true) {
 				std::function<void()> task;
 				{
+					// idle workers block until a task is added (rather than polling), since the pool is shared
 					std::unique_lock<std::mutex> lock(access);
+					cond.wait(lock, [this] { return stop || !tasks.empty(); });
 					if(tasks.empty()) {
-						cond.wait_for(lock, std::chrono::duration<int, std::milli>(5));
-						continue;
+						return;
 					}
 					task = std::move(tasks.front());
 					tasks.pop_front();
@@ -72,6 +84,51 @@ private:
 	}
 };
 
+//
+// The tasks that a single owner has added to a (shared) ThreadPool, so the owner can wait for
+// its own tasks (e.g. before it is destroyed) without waiting for everything else in the pool.
+// If the pool is null (e.g. on web), tasks are run immediately on the calling thread.
+//
+class TaskGroup {
+	ThreadPool *pool;
+
+	std::mutex access;
+	std::vector<std::future<void>> futures;
+
+public:
+	explicit TaskGroup(ThreadPool *pool) : pool(pool) {}
+	~TaskGroup() {
+		wait();
+	}
+
+	void add(std::function<void()> task) {
+		if(!pool) {
+			task();
+			return;
+		}
+		std::packaged_task<void()> pt(std::move(task));
+		auto future = pool->add_task(pt);
+
+		std::unique_lock<std::mutex> lock(access);
+		// forget the tasks that have already completed
+		futures.erase(std::remove_if(futures.begin(), futures.end(), [](const std::future<void> &f) {
+			return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}), futures.end());
+		futures.push_back(std::move(future));
+	}
+
+	void wait() {
+		std::vector<std::future<void>> pending;
+		{
+			std::unique_lock<std::mutex> lock(access);
+			pending.swap(futures);
+		}
+		for(auto &f : pending) {
+			f.wait();
+		}
+	}
+};
+
 }
 
 #endif//_THREADPOOL_HPP
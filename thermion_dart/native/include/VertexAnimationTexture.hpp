@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+
+#include <filament/Box.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
+#include <filament/Texture.h>
+#include <filament/VertexBuffer.h>
+
+#include <gltfio/FilamentAsset.h>
+#include <gltfio/FilamentInstance.h>
+
+#include <math/mat4.h>
+#include <utils/Entity.h>
+
+namespace thermion
+{
+
+    using namespace filament;
+    using namespace filament::gltfio;
+
+    ///
+    /// A glTF animation baked into a vertex animation texture (VAT), for rendering large
+    /// numbers of animated instances at (roughly) the CPU cost of static geometry.
+    ///
+    /// [bake] applies the animation with the instance's Animator at a fixed frame rate and
+    /// skins every vertex on the CPU, storing the object-space position/normal of each vertex
+    /// for each frame in a pair of float textures. The mesh itself is flattened into a single
+    /// vertex/index buffer (with the base color factor of each primitive baked into the vertex colors).
+    ///
+    /// [createInstances] then creates a single renderable that draws every instance with one
+    /// (instanced) draw call, using the vertex animation material (materials/vat.mat). The
+    /// transform and time offset of each instance are stored in a small texture that is read
+    /// in the vertex shader, so animating the whole crowd only requires setting the "time"
+    /// parameter once per frame (see [setTime]).
+    ///
+    /// All methods must be called from the render thread.
+    ///
+    class VertexAnimationTexture
+    {
+    public:
+        // the width of every texture (the data for each vertex/instance wraps onto the next row)
+        static constexpr uint32_t kTextureWidth = 1024;
+        // the maximum number of instances that can be drawn by a single renderable
+        static constexpr int kMaxInstances = 32767;
+
+        ///
+        /// Bakes the glTF animation at [animationIndex] for [instance] at [frameRate] frames per second.
+        /// The source data of [asset] must not have been released (i.e. the asset must be loaded with keepData).
+        /// Returns nullptr if the animation could not be baked.
+        ///
+        static VertexAnimationTexture *bake(Engine *engine, const FilamentAsset *asset, FilamentInstance *instance, int animationIndex, float frameRate);
+
+        ~VertexAnimationTexture();
+
+        ///
+        /// Creates a renderable that draws [count] instances of the baked animation with [material].
+        /// [transforms] are relative to the renderable; [timeOffsets] (if not null) offsets the animation
+        /// time of each instance so the crowd doesn't move in lockstep.
+        /// The renderable is not added to the scene.
+        ///
+        utils::Entity createInstances(Material *material, const math::mat4f *transforms, const float *timeOffsets, int count);
+
+        ///
+        /// Updates the transforms/time offsets of the instances drawn by [entity] (created with [createInstances]).
+        ///
+        bool setInstances(utils::Entity entity, const math::mat4f *transforms, const float *timeOffsets, int count);
+
+        ///
+        /// Destroys the renderable [entity] (created with [createInstances]). Returns false if [entity] was not created by this VAT.
+        ///
+        bool destroyInstances(utils::Entity entity);
+
+        bool hasInstances(utils::Entity entity) const;
+
+        std::vector<utils::Entity> getInstanceEntities() const;
+
+        ///
+        /// Sets the animation time (in seconds) for every set of instances.
+        ///
+        void setTime(float timeInSecs);
+
+        uint32_t getVertexCount() const
+        {
+            return _vertexCount;
+        }
+
+        uint32_t getFrameCount() const
+        {
+            return _frameCount;
+        }
+
+        ///
+        /// Returns the GPU memory used by the baked textures.
+        ///
+        size_t getSizeInBytes() const;
+
+    private:
+        struct Instances
+        {
+            utils::Entity entity;
+            MaterialInstance *materialInstance = nullptr;
+            Texture *data = nullptr;
+            int count = 0;
+        };
+
+        VertexAnimationTexture(Engine *engine) : _engine(engine) {}
+
+        Texture *createInstanceData(const math::mat4f *transforms, const float *timeOffsets, int count) const;
+        Box computeBounds(const math::mat4f *transforms, int count) const;
+
+        Engine *_engine = nullptr;
+        VertexBuffer *_vertexBuffer = nullptr;
+        IndexBuffer *_indexBuffer = nullptr;
+        Texture *_positions = nullptr;
+        Texture *_normals = nullptr;
+        uint32_t _vertexCount = 0;
+        uint32_t _indexCount = 0;
+        uint32_t _frameCount = 0;
+        float _frameRate = 30.0f;
+        // the bounds of every baked frame
+        Box _bounds;
+        std::vector<Instances> _instances;
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define THERMION_AABB_BATCH_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define THERMION_AABB_BATCH_NEON 1
+#endif
+
+#include "filament/Box.h"
+
+namespace thermion
+{
+
+    //
+    // Four boxes in structure-of-arrays layout, so one box can be tested against all four with a few SIMD
+    // comparisons (see overlapMask). Unused lanes are left empty and never overlap anything.
+    //
+    struct alignas(16) AabbBatch
+    {
+        static constexpr int kWidth = 4;
+
+        float minX[kWidth];
+        float minY[kWidth];
+        float minZ[kWidth];
+        float maxX[kWidth];
+        float maxY[kWidth];
+        float maxZ[kWidth];
+
+        AabbBatch()
+        {
+            for (int lane = 0; lane < kWidth; lane++)
+            {
+                set(lane, filament::Aabb());
+            }
+        }
+
+        void set(int lane, const filament::Aabb &box)
+        {
+            minX[lane] = box.min.x;
+            minY[lane] = box.min.y;
+            minZ[lane] = box.min.z;
+            maxX[lane] = box.max.x;
+            maxY[lane] = box.max.y;
+            maxZ[lane] = box.max.z;
+        }
+    };
+
+    ///
+    /// Returns a bitmask of the lanes in [batch] that overlap [box] (boxes that only touch are considered overlapping).
+    ///
+    inline uint32_t overlapMask(const filament::Aabb &box, const AabbBatch &batch)
+    {
+#if defined(THERMION_AABB_BATCH_SSE)
+        __m128 result = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(batch.minX), _mm_set1_ps(box.max.x)),
+                                   _mm_cmpge_ps(_mm_load_ps(batch.maxX), _mm_set1_ps(box.min.x)));
+        result = _mm_and_ps(result, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(batch.minY), _mm_set1_ps(box.max.y)),
+                                               _mm_cmpge_ps(_mm_load_ps(batch.maxY), _mm_set1_ps(box.min.y))));
+        result = _mm_and_ps(result, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(batch.minZ), _mm_set1_ps(box.max.z)),
+                                               _mm_cmpge_ps(_mm_load_ps(batch.maxZ), _mm_set1_ps(box.min.z))));
+        return uint32_t(_mm_movemask_ps(result));
+#elif defined(THERMION_AABB_BATCH_NEON)
+        uint32x4_t result = vandq_u32(vcleq_f32(vld1q_f32(batch.minX), vdupq_n_f32(box.max.x)),
+                                      vcgeq_f32(vld1q_f32(batch.maxX), vdupq_n_f32(box.min.x)));
+        result = vandq_u32(result, vandq_u32(vcleq_f32(vld1q_f32(batch.minY), vdupq_n_f32(box.max.y)),
+                                             vcgeq_f32(vld1q_f32(batch.maxY), vdupq_n_f32(box.min.y))));
+        result = vandq_u32(result, vandq_u32(vcleq_f32(vld1q_f32(batch.minZ), vdupq_n_f32(box.max.z)),
+                                             vcgeq_f32(vld1q_f32(batch.maxZ), vdupq_n_f32(box.min.z))));
+        // every lane is either all ones or all zeros, so keep one bit per lane
+        static const uint32_t kLaneBits[4] = {1, 2, 4, 8};
+        const uint32x4_t bits = vandq_u32(result, vld1q_u32(kLaneBits));
+        return vgetq_lane_u32(bits, 0) | vgetq_lane_u32(bits, 1) | vgetq_lane_u32(bits, 2) | vgetq_lane_u32(bits, 3);
+#else
+        uint32_t mask = 0;
+        for (int lane = 0; lane < AabbBatch::kWidth; lane++)
+        {
+            if (batch.minX[lane] <= box.max.x && batch.maxX[lane] >= box.min.x &&
+                batch.minY[lane] <= box.max.y && batch.maxY[lane] >= box.min.y &&
+                batch.minZ[lane] <= box.max.z && batch.maxZ[lane] >= box.min.z)
+            {
+                mask |= 1u << lane;
+            }
+        }
+        return mask;
+#endif
+    }
+}
@@ -0,0 +1,563 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "filament/Box.h"
+#include "utils/Entity.h"
+
+namespace thermion
+{
+
+    //
+    // A dynamic AABB tree (a binary bounding volume hierarchy that is updated incrementally as boxes are
+    // added, moved and removed), used as the broadphase for collision queries.
+    //
+    // Each leaf (proxy) stores a "fat" box that is slightly larger than the box it was created/moved with,
+    // so small movements don't require the tree to be restructured. Leaves are inserted where they increase
+    // the surface area of the tree the least, and the tree is kept balanced with AVL-style rotations, so
+    // queries are O(log N) (plus the number of results).
+    //
+    class AabbTree
+    {
+    public:
+        static constexpr int32_t kNull = -1;
+        // boxes are enlarged by this fraction of their extent (in every direction) when inserted
+        static constexpr float kFatFraction = 0.1f;
+
+        int32_t createProxy(const filament::Aabb &box, utils::Entity entity)
+        {
+            const int32_t proxy = allocateNode();
+            _nodes[proxy].box = fatten(box);
+            _nodes[proxy].entity = entity;
+            _nodes[proxy].height = 0;
+            insertLeaf(proxy);
+            _proxyCount++;
+            return proxy;
+        }
+
+        void destroyProxy(int32_t proxy)
+        {
+            removeLeaf(proxy);
+            freeNode(proxy);
+            _proxyCount--;
+        }
+
+        ///
+        /// Updates the box of [proxy]. The tree is only restructured if [box] is no longer contained by the
+        /// fat box of the proxy; returns true if so.
+        ///
+        bool moveProxy(int32_t proxy, const filament::Aabb &box)
+        {
+            const auto &fatBox = _nodes[proxy].box;
+            if (all(lessThanEqual(fatBox.min, box.min)) && all(greaterThanEqual(fatBox.max, box.max)))
+            {
+                return false;
+            }
+            removeLeaf(proxy);
+            _nodes[proxy].box = fatten(box);
+            insertLeaf(proxy);
+            return true;
+        }
+
+        const filament::Aabb &getFatBox(int32_t proxy) const
+        {
+            return _nodes[proxy].box;
+        }
+
+        utils::Entity getEntity(int32_t proxy) const
+        {
+            return _nodes[proxy].entity;
+        }
+
+        size_t getProxyCount() const
+        {
+            return _proxyCount;
+        }
+
+        int32_t getHeight() const
+        {
+            return _root == kNull ? 0 : _nodes[_root].height;
+        }
+
+        ///
+        /// Invokes [callback] with every proxy whose fat box overlaps [box]. Traversal stops early if [callback] returns false.
+        ///
+        template <typename Callback>
+        void query(const filament::Aabb &box, Callback &&callback) const
+        {
+            queryIf([&](const filament::Aabb &nodeBox)
+                    { return overlaps(nodeBox, box); }, callback);
+        }
+
+        ///
+        /// Invokes [callback] with every proxy whose fat box satisfies [predicate], which must also be satisfied by the box of any
+        /// node that contains such a proxy (i.e. [predicate] tests for intersection with some region). Traversal stops early if
+        /// [callback] returns false.
+        ///
+        template <typename Predicate, typename Callback>
+        void queryIf(Predicate &&predicate, Callback &&callback) const
+        {
+            if (_root == kNull)
+            {
+                return;
+            }
+            int32_t stack[kMaxStackSize];
+            std::vector<int32_t> overflow;
+            int32_t count = 0;
+            stack[count++] = _root;
+
+            while (count > 0 || !overflow.empty())
+            {
+                int32_t index;
+                if (!overflow.empty())
+                {
+                    index = overflow.back();
+                    overflow.pop_back();
+                }
+                else
+                {
+                    index = stack[--count];
+                }
+                const Node &node = _nodes[index];
+                if (!predicate(node.box))
+                {
+                    continue;
+                }
+                if (node.isLeaf())
+                {
+                    if (!callback(index))
+                    {
+                        return;
+                    }
+                    continue;
+                }
+                for (int32_t child : {node.left, node.right})
+                {
+                    if (count < kMaxStackSize)
+                    {
+                        stack[count++] = child;
+                    }
+                    else
+                    {
+                        overflow.push_back(child);
+                    }
+                }
+            }
+        }
+
+        ///
+        /// Invokes [callback] with every proxy whose fat box is hit by the ray [origin] + t * [direction] for t in [0, maxDistance].
+        /// [callback] returns the new maximum distance, so the traversal can be clipped once a hit has been found.
+        ///
+        template <typename Callback>
+        void raycast(const filament::math::float3 &origin, const filament::math::float3 &direction, float maxDistance, Callback &&callback) const
+        {
+            if (_root == kNull)
+            {
+                return;
+            }
+            const filament::math::float3 inverseDirection = 1.0f / direction;
+            int32_t stack[kMaxStackSize];
+            std::vector<int32_t> overflow;
+            int32_t count = 0;
+            stack[count++] = _root;
+
+            while (count > 0 || !overflow.empty())
+            {
+                int32_t index;
+                if (!overflow.empty())
+                {
+                    index = overflow.back();
+                    overflow.pop_back();
+                }
+                else
+                {
+                    index = stack[--count];
+                }
+                const Node &node = _nodes[index];
+
+                const auto t0 = (node.box.min - origin) * inverseDirection;
+                const auto t1 = (node.box.max - origin) * inverseDirection;
+                const auto tmin = min(t0, t1);
+                const auto tmax = max(t0, t1);
+                const float enter = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+                const float exit = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, maxDistance));
+                if (enter > exit)
+                {
+                    continue;
+                }
+                if (node.isLeaf())
+                {
+                    maxDistance = callback(index);
+                    continue;
+                }
+                for (int32_t child : {node.left, node.right})
+                {
+                    if (count < kMaxStackSize)
+                    {
+                        stack[count++] = child;
+                    }
+                    else
+                    {
+                        overflow.push_back(child);
+                    }
+                }
+            }
+        }
+
+        ///
+        /// Finds the (at most) [k] proxies closest to [point], as (squared distance, proxy) pairs sorted by distance. [distance]
+        /// returns the squared distance from [point] to a proxy (or infinity to skip it), which must be no less than the
+        /// squared distance to its fat box. Nodes are visited closest first, so only the nodes that could contain one of the
+        /// [k] closest proxies are visited.
+        ///
+        template <typename Distance>
+        void nearest(const filament::math::float3 &point, size_t k, Distance &&distance, std::vector<std::pair<float, int32_t>> &out) const
+        {
+            out.clear();
+            if (_root == kNull || k == 0)
+            {
+                return;
+            }
+            // a min-heap of (squared distance to the node box, node)
+            std::vector<std::pair<float, int32_t>> heap;
+            const auto closer = [](const std::pair<float, int32_t> &a, const std::pair<float, int32_t> &b)
+            { return a.first > b.first; };
+            heap.emplace_back(distanceSquared(_nodes[_root].box, point), _root);
+
+            while (!heap.empty())
+            {
+                std::pop_heap(heap.begin(), heap.end(), closer);
+                const auto [nodeDistance, index] = heap.back();
+                heap.pop_back();
+                if (out.size() == k && nodeDistance >= out.back().first)
+                {
+                    break;
+                }
+                const Node &node = _nodes[index];
+                if (node.isLeaf())
+                {
+                    const float proxyDistance = distance(index);
+                    if (proxyDistance == std::numeric_limits<float>::infinity() || (out.size() == k && proxyDistance >= out.back().first))
+                    {
+                        continue;
+                    }
+                    const std::pair<float, int32_t> result(proxyDistance, index);
+                    out.insert(std::upper_bound(out.begin(), out.end(), result), result);
+                    if (out.size() > k)
+                    {
+                        out.pop_back();
+                    }
+                    continue;
+                }
+                for (int32_t child : {node.left, node.right})
+                {
+                    const float childDistance = distanceSquared(_nodes[child].box, point);
+                    if (out.size() < k || childDistance < out.back().first)
+                    {
+                        heap.emplace_back(childDistance, child);
+                        std::push_heap(heap.begin(), heap.end(), closer);
+                    }
+                }
+            }
+        }
+
+        ///
+        /// The squared distance from [point] to the closest point in [box] (zero if [box] contains [point]).
+        ///
+        static float distanceSquared(const filament::Aabb &box, const filament::math::float3 &point)
+        {
+            const auto d = max(max(box.min - point, point - box.max), filament::math::float3(0.0f));
+            return dot(d, d);
+        }
+
+        static bool overlaps(const filament::Aabb &a, const filament::Aabb &b)
+        {
+            return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+                   a.min.y <= b.max.y && a.max.y >= b.min.y &&
+                   a.min.z <= b.max.z && a.max.z >= b.min.z;
+        }
+
+    private:
+        static constexpr int32_t kMaxStackSize = 256;
+
+        struct Node
+        {
+            filament::Aabb box;
+            utils::Entity entity;
+            // the parent of a node in the tree, or the next free node in the free list
+            int32_t parent = kNull;
+            int32_t left = kNull;
+            int32_t right = kNull;
+            // 0 for leaves, -1 for free nodes
+            int32_t height = -1;
+
+            bool isLeaf() const
+            {
+                return left == kNull;
+            }
+        };
+
+        static filament::Aabb merge(const filament::Aabb &a, const filament::Aabb &b)
+        {
+            return {min(a.min, b.min), max(a.max, b.max)};
+        }
+
+        static float surfaceArea(const filament::Aabb &box)
+        {
+            const auto d = box.max - box.min;
+            return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+        }
+
+        static filament::Aabb fatten(const filament::Aabb &box)
+        {
+            const auto margin = (box.max - box.min) * kFatFraction;
+            return {box.min - margin, box.max + margin};
+        }
+
+        int32_t allocateNode()
+        {
+            if (_freeList == kNull)
+            {
+                _nodes.emplace_back();
+                return int32_t(_nodes.size() - 1);
+            }
+            const int32_t index = _freeList;
+            _freeList = _nodes[index].parent;
+            _nodes[index] = Node();
+            return index;
+        }
+
+        void freeNode(int32_t index)
+        {
+            _nodes[index].parent = _freeList;
+            _nodes[index].height = -1;
+            _freeList = index;
+        }
+
+        void insertLeaf(int32_t leaf)
+        {
+            if (_root == kNull)
+            {
+                _root = leaf;
+                _nodes[leaf].parent = kNull;
+                return;
+            }
+
+            // descend to the sibling that minimizes the increase in surface area
+            const filament::Aabb leafBox = _nodes[leaf].box;
+            int32_t index = _root;
+            while (!_nodes[index].isLeaf())
+            {
+                const Node &node = _nodes[index];
+                const float area = surfaceArea(node.box);
+                const float combinedArea = surfaceArea(merge(node.box, leafBox));
+                // the cost of creating a new parent for this node and the new leaf
+                const float cost = 2.0f * combinedArea;
+                // the minimum cost of pushing the leaf further down the tree
+                const float inheritanceCost = 2.0f * (combinedArea - area);
+
+                auto descendCost = [&](int32_t child)
+                {
+                    const Node &c = _nodes[child];
+                    const float merged = surfaceArea(merge(leafBox, c.box));
+                    return (c.isLeaf() ? merged : merged - surfaceArea(c.box)) + inheritanceCost;
+                };
+                const float leftCost = descendCost(node.left);
+                const float rightCost = descendCost(node.right);
+
+                if (cost < leftCost && cost < rightCost)
+                {
+                    break;
+                }
+                index = leftCost < rightCost ? node.left : node.right;
+            }
+
+            const int32_t sibling = index;
+            const int32_t oldParent = _nodes[sibling].parent;
+            const int32_t newParent = allocateNode();
+            _nodes[newParent].parent = oldParent;
+            _nodes[newParent].box = merge(leafBox, _nodes[sibling].box);
+            _nodes[newParent].height = _nodes[sibling].height + 1;
+            _nodes[newParent].left = sibling;
+            _nodes[newParent].right = leaf;
+            _nodes[sibling].parent = newParent;
+            _nodes[leaf].parent = newParent;
+
+            if (oldParent == kNull)
+            {
+                _root = newParent;
+            }
+            else if (_nodes[oldParent].left == sibling)
+            {
+                _nodes[oldParent].left = newParent;
+            }
+            else
+            {
+                _nodes[oldParent].right = newParent;
+            }
+
+            refitAncestors(newParent);
+        }
+
+        void removeLeaf(int32_t leaf)
+        {
+            if (leaf == _root)
+            {
+                _root = kNull;
+                return;
+            }
+
+            const int32_t parent = _nodes[leaf].parent;
+            const int32_t grandParent = _nodes[parent].parent;
+            const int32_t sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+            if (grandParent == kNull)
+            {
+                _root = sibling;
+                _nodes[sibling].parent = kNull;
+                freeNode(parent);
+                return;
+            }
+
+            if (_nodes[grandParent].left == parent)
+            {
+                _nodes[grandParent].left = sibling;
+            }
+            else
+            {
+                _nodes[grandParent].right = sibling;
+            }
+            _nodes[sibling].parent = grandParent;
+            freeNode(parent);
+
+            refitAncestors(grandParent);
+        }
+
+        // rebalances and recomputes the box/height of [index] and each of its ancestors
+        void refitAncestors(int32_t index)
+        {
+            while (index != kNull)
+            {
+                index = balance(index);
+                Node &node = _nodes[index];
+                node.height = 1 + std::max(_nodes[node.left].height, _nodes[node.right].height);
+                node.box = merge(_nodes[node.left].box, _nodes[node.right].box);
+                index = node.parent;
+            }
+        }
+
+        void replaceChild(int32_t parent, int32_t oldChild, int32_t newChild)
+        {
+            if (parent == kNull)
+            {
+                _root = newChild;
+            }
+            else if (_nodes[parent].left == oldChild)
+            {
+                _nodes[parent].left = newChild;
+            }
+            else
+            {
+                _nodes[parent].right = newChild;
+            }
+        }
+
+        // if the subtrees of [a] differ in height by more than one, rotates the taller child up and returns it
+        int32_t balance(int32_t a)
+        {
+            Node &A = _nodes[a];
+            if (A.isLeaf() || A.height < 2)
+            {
+                return a;
+            }
+
+            const int32_t b = A.left;
+            const int32_t c = A.right;
+            Node &B = _nodes[b];
+            Node &C = _nodes[c];
+            const int32_t difference = C.height - B.height;
+
+            if (difference > 1)
+            {
+                const int32_t f = C.left;
+                const int32_t g = C.right;
+                Node &F = _nodes[f];
+                Node &G = _nodes[g];
+
+                C.left = a;
+                C.parent = A.parent;
+                A.parent = c;
+                replaceChild(C.parent, a, c);
+
+                if (F.height > G.height)
+                {
+                    C.right = f;
+                    A.right = g;
+                    G.parent = a;
+                    A.box = merge(B.box, G.box);
+                    C.box = merge(A.box, F.box);
+                    A.height = 1 + std::max(B.height, G.height);
+                    C.height = 1 + std::max(A.height, F.height);
+                }
+                else
+                {
+                    C.right = g;
+                    A.right = f;
+                    F.parent = a;
+                    A.box = merge(B.box, F.box);
+                    C.box = merge(A.box, G.box);
+                    A.height = 1 + std::max(B.height, F.height);
+                    C.height = 1 + std::max(A.height, G.height);
+                }
+                return c;
+            }
+
+            if (difference < -1)
+            {
+                const int32_t d = B.left;
+                const int32_t e = B.right;
+                Node &D = _nodes[d];
+                Node &E = _nodes[e];
+
+                B.left = a;
+                B.parent = A.parent;
+                A.parent = b;
+                replaceChild(B.parent, a, b);
+
+                if (D.height > E.height)
+                {
+                    B.right = d;
+                    A.left = e;
+                    E.parent = a;
+                    A.box = merge(C.box, E.box);
+                    B.box = merge(A.box, D.box);
+                    A.height = 1 + std::max(C.height, E.height);
+                    B.height = 1 + std::max(A.height, D.height);
+                }
+                else
+                {
+                    B.right = e;
+                    A.left = d;
+                    D.parent = a;
+                    A.box = merge(C.box, D.box);
+                    B.box = merge(A.box, E.box);
+                    A.height = 1 + std::max(C.height, D.height);
+                    B.height = 1 + std::max(A.height, E.height);
+                }
+                return b;
+            }
+
+            return a;
+        }
+
+        std::vector<Node> _nodes;
+        int32_t _root = kNull;
+        int32_t _freeList = kNull;
+        size_t _proxyCount = 0;
+    };
+}
@@ -2,15 +2,24 @@
 
 #include "Log.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <variant>
 
+#include <filament/Box.h>
+#include <filament/Camera.h>
 #include <filament/Engine.h>
+#include <filament/Frustum.h>
 #include <filament/RenderableManager.h>
 #include <filament/Renderer.h>
 #include <filament/Scene.h>
 #include <filament/Texture.h>
 #include <filament/TransformManager.h>
+#include <filament/View.h>
 
 #include <math/vec3.h>
 #include <math/vec4.h>
@@ -23,6 +32,12 @@
 #include <gltfio/math.h>
 #include <utils/NameComponentManager.h>
 
+#include "ThreadPool.hpp"
+#include "AnimationStateMachine.hpp"
+#include "AnimationTrack.hpp"
+#include "AnimationScrubber.hpp"
+#include "LocalPose.hpp"
+
 template class std::vector<float>;
 namespace thermion
 {
@@ -58,6 +73,33 @@ namespace thermion
         int index = -1;
     };
 
+    enum class AnimationBlendMode : uint8_t
+    {
+        // the layer's pose replaces the pose of the layers below it (in proportion to its weight)
+        OVERRIDE,
+        // the difference between the layer's pose and the reference pose is added to the layers below it
+        ADDITIVE
+    };
+
+    //
+    // A glTF animation that is blended with the other layers of the same instance, rather than overwriting them.
+    // Layers are blended in the order they were added.
+    //
+    struct AnimationLayer : AnimationStatus
+    {
+        int id = -1;
+        int index = -1;
+        float weight = 1.0f;
+        AnimationBlendMode mode = AnimationBlendMode::OVERRIDE;
+        // the weight of each node of the instance (in the order of FilamentInstance::getEntities()), or empty if the layer affects every node
+        std::vector<float> mask;
+        // the time at which the animation is sampled this frame (written during evaluation)
+        float elapsedInSecs = 0.0f;
+        // the pose sampled from the animation, and the weight of each node (the layer weight multiplied by its mask)
+        LocalPose pose;
+        std::vector<float> nodeWeights;
+    };
+
     //
     // The status of a morph target animation created dynamically at runtime (not glTF embedded).
     //
@@ -66,7 +108,7 @@ namespace thermion
         utils::Entity meshTarget;
         int numFrames = -1;
         float frameLengthInMs = 0;
-        std::vector<float> frameData;
+        MorphTrack frameData;
         std::vector<int> morphIndices;
         int lengthInFrames;
     };
@@ -80,7 +122,7 @@ namespace thermion
         size_t skinIndex = 0;
         int lengthInFrames;
         float frameLengthInMs = 0;
-        std::vector<math::mat4f> frameData;
+        TransformTrack frameData;
         float fadeOutInSecs = 0;
         float fadeInInSecs = 0;
         float maxDelta = 1.0f;
@@ -98,6 +140,42 @@ namespace thermion
         int fadeGltfAnimationIndex = -1;
         float fadeDuration = 0.0f;
         float fadeOutAnimationStart = 0.0f;
+
+        std::vector<AnimationLayer> layers;
+        int nextLayerId = 0;
+        // the pose captured when the first layer was added; nodes that a layer's animation doesn't target take this pose
+        LocalPose referencePose;
+        // samples the layers directly from the glTF keyframes, or null if the source data of the asset has been released
+        // (owned by the SceneManager)
+        AnimationScrubber *layerSampler = nullptr;
+        // scratch buffers used when blending layers
+        LocalPose blendedPose;
+        std::vector<PoseLayer> poseLayers;
+
+        // selects the glTF animation to play (if a state machine has been attached, see AnimationComponentManager::setStateMachine)
+        AnimationStateMachineInstance stateMachine;
+
+        //
+        // The result of evaluating a bone animation for the current frame.
+        //
+        struct BoneSample
+        {
+            bool finished = false;
+            Entity joint;
+            math::float3 translation;
+            math::quatf rotation;
+            math::float3 scale;
+            float fadeDelta = 0.0f;
+        };
+
+        // per-frame scratch state, written when the component is evaluated (possibly on a worker thread)
+        // and consumed when the results are committed on the render thread.
+        // each entry corresponds to the animation at the same index; a negative value means the animation has finished.
+        std::vector<float> gltfElapsedInSecs;
+        std::vector<BoneSample> boneSamples;
+        std::vector<int> morphFrames;
+        // set when the component isn't visible in any view, in which case bone matrices aren't updated
+        bool skipSkinning = false;
     };
 
     class AnimationComponentManager : public utils::SingleInstanceComponentManager<AnimationComponent>
@@ -106,11 +184,151 @@ namespace thermion
         filament::TransformManager &_transformManager;
         filament::RenderableManager &_renderableManager;
 
+        // below this number of components per job, evaluating on worker threads isn't worth the dispatch overhead
+        static constexpr size_t kMinComponentsPerJob = 8;
+
+        // shared with the SceneManager (may be null, in which case everything is evaluated on the calling thread)
+        ThreadPool *_pool = nullptr;
+        std::vector<AnimationComponent *> _components;
+
+        //
+        // The morph weights accumulated for a single renderable during commit.
+        //
+        struct MorphWeights
+        {
+            Entity target;
+            std::vector<float> weights;
+            std::vector<uint8_t> dirty;
+        };
+        std::vector<MorphWeights> _morphWeights;
+
     public:
+        enum class ClockMode
+        {
+            // animations are driven by the wall clock (the default)
+            WALL_CLOCK,
+            // the animation clock advances by a fixed timestep every time [update] is called
+            FIXED_TIMESTEP,
+            // the animation clock only advances when [step] is called
+            MANUAL
+        };
+
+        struct Stats
+        {
+            // the number of times the bone matrices of an instance were recomputed/uploaded
+            uint64_t boneMatrixUpdates = 0;
+            // the number of joint transforms written by bone animations
+            uint64_t jointTransformWrites = 0;
+            // the number of setMorphWeights calls
+            uint64_t morphWeightUploads = 0;
+            // the number of times an animated component was evaluated/skipped due to its LOD
+            uint64_t evaluatedComponents = 0;
+            uint64_t skippedEvaluations = 0;
+            // the number of bone matrix updates skipped because the component wasn't visible
+            uint64_t skippedSkinningUpdates = 0;
+            // the total size of every bone/morph animation clip added, before and after compression
+            uint64_t uncompressedClipBytes = 0;
+            uint64_t compressedClipBytes = 0;
+        };
+
+        //
+        // Controls how often animated components are updated based on how they appear in the rendered views.
+        // Since animations are sampled from the animation clock, a component that is updated less often
+        // is still posed correctly whenever it is updated.
+        //
+        struct LodSettings
+        {
+            bool enabled = false;
+            // components that occupy less than this fraction of the viewport height (in every view) are updated every [distantInterval] frames
+            float distantScreenSize = 0.1f;
+            int distantInterval = 4;
+            // components that aren't visible in any view are updated every [culledInterval] frames (0 pauses them until they become visible)
+            int culledInterval = 0;
+        };
+
         AnimationComponentManager(
             filament::TransformManager &transformManager,
-            filament::RenderableManager &renderableManager) : _transformManager(transformManager),
-                                                              _renderableManager(renderableManager){};
+            filament::RenderableManager &renderableManager,
+            ThreadPool *pool) : _transformManager(transformManager),
+                                _renderableManager(renderableManager),
+                                _pool(pool)
+        {
+        };
+
+        ///
+        /// Sets how the animation clock advances. Switching modes doesn't cause a discontinuity;
+        /// the clock continues from its current time.
+        /// [timestepInSecs] is only used for [ClockMode::FIXED_TIMESTEP].
+        ///
+        void setClock(ClockMode mode, float timestepInSecs)
+        {
+            _time = getTime();
+            _clockMode = mode;
+            _timestep = toDuration(timestepInSecs);
+            if (mode == ClockMode::WALL_CLOCK)
+            {
+                _wallClockOffset = _time - high_resolution_clock::now();
+            }
+        }
+
+        ///
+        /// Advances the animation clock by [deltaInSecs]. The new time will be used the next time [update] is called.
+        /// This has no effect when the clock is driven by the wall clock.
+        ///
+        void step(float deltaInSecs)
+        {
+            if (_clockMode != ClockMode::WALL_CLOCK)
+            {
+                _time += toDuration(deltaInSecs);
+            }
+        }
+
+        ///
+        /// The current time of the animation clock. Animations should use this (not the wall clock) as their start time.
+        ///
+        time_point_t getTime() const
+        {
+            if (_clockMode == ClockMode::WALL_CLOCK)
+            {
+                return high_resolution_clock::now() + _wallClockOffset;
+            }
+            return _time;
+        }
+
+        void setLodSettings(const LodSettings &settings)
+        {
+            _lodSettings = settings;
+        }
+
+        ///
+        /// Sets the tolerances used to compress bone animation clips added from now on.
+        ///
+        void setCompressionSettings(const TrackCompressionSettings &settings)
+        {
+            _compressionSettings = settings;
+        }
+
+        const TrackCompressionSettings &getCompressionSettings() const
+        {
+            return _compressionSettings;
+        }
+
+        ///
+        /// Records the size of a newly added clip (see [Stats]).
+        ///
+        void addClipStats(size_t uncompressedBytes, size_t compressedBytes)
+        {
+            _stats.uncompressedClipBytes += uncompressedBytes;
+            _stats.compressedClipBytes += compressedBytes;
+        }
+
+        ///
+        /// Returns the number of skinning/morph weight uploads since this manager was created.
+        ///
+        Stats getStats() const
+        {
+            return _stats;
+        }
 
         void addAnimationComponent(std::variant<FilamentInstance *, Entity> target)
         {
@@ -137,6 +355,156 @@ namespace thermion
         }
 
 
+        ///
+        /// Adds a layer that blends the glTF animation at [animationIndex] into the pose of [instance] with [weight].
+        /// If [maskRoots] is not empty, the layer only affects those nodes and their descendants.
+        /// Layers are sampled with [sampler] (which must outlive the animation component), or by applying the animation
+        /// with the instance's Animator and reading the pose back if it is null.
+        /// Returns the ID of the layer, or -1 if [instance] has no animation component.
+        ///
+        int addLayer(FilamentInstance *instance, int animationIndex, float weight, AnimationBlendMode mode, bool loop, const std::vector<Entity> &maskRoots, AnimationScrubber *sampler)
+        {
+            if (!hasComponent(instance->getRoot()))
+            {
+                return -1;
+            }
+            auto &animationComponent = elementAt<0>(getInstance(instance->getRoot()));
+            const auto *entities = instance->getEntities();
+            const size_t numNodes = instance->getEntityCount();
+
+            if (animationComponent.layers.empty())
+            {
+                animationComponent.referencePose.read(_transformManager, entities, numNodes, {});
+            }
+            animationComponent.layerSampler = sampler;
+
+            AnimationLayer layer;
+            layer.id = animationComponent.nextLayerId++;
+            layer.index = animationIndex;
+            layer.weight = weight;
+            layer.mode = mode;
+            layer.loop = loop;
+            layer.start = getTime();
+            layer.startOffset = 0.0f;
+            layer.durationInSecs = instance->getAnimator()->getAnimationDuration(animationIndex);
+            // the channels a layer's animation doesn't target are never sampled, so they keep the reference pose
+            layer.pose.copyFrom(animationComponent.referencePose);
+
+            if (!maskRoots.empty())
+            {
+                layer.mask.assign(numNodes, 0.0f);
+                for (size_t i = 0; i < numNodes; i++)
+                {
+                    // a node is masked in if it (or any of its ancestors) is one of the mask roots
+                    for (Entity node = entities[i]; !node.isNull(); node = _transformManager.getParent(_transformManager.getInstance(node)))
+                    {
+                        if (std::find(maskRoots.begin(), maskRoots.end(), node) != maskRoots.end())
+                        {
+                            layer.mask[i] = 1.0f;
+                            break;
+                        }
+                    }
+                }
+            }
+            animationComponent.layers.push_back(std::move(layer));
+            return animationComponent.layers.back().id;
+        }
+
+        bool setLayerWeight(FilamentInstance *instance, int layerId, float weight)
+        {
+            auto *layer = getLayer(instance, layerId);
+            if (!layer)
+            {
+                return false;
+            }
+            layer->weight = weight;
+            return true;
+        }
+
+        bool removeLayer(FilamentInstance *instance, int layerId)
+        {
+            if (!getLayer(instance, layerId))
+            {
+                return false;
+            }
+            auto &layers = elementAt<0>(getInstance(instance->getRoot())).layers;
+            layers.erase(std::remove_if(layers.begin(), layers.end(), [=](const AnimationLayer &layer)
+                                        { return layer.id == layerId; }),
+                         layers.end());
+            return true;
+        }
+
+        ///
+        /// Attaches [stateMachine] to [instance] (replacing any existing state machine) and enters its initial state.
+        /// From then on, the state machine is evaluated every time [update] is called and cross-fades between
+        /// the glTF animations of its states whenever a transition is taken, so a parameter change made before
+        /// a frame is rendered takes effect in that frame. Pass nullptr to detach the current state machine.
+        /// Returns false if [instance] has no animation component, or a state refers to an invalid animation.
+        ///
+        bool setStateMachine(FilamentInstance *instance, std::shared_ptr<const AnimationStateMachine> stateMachine)
+        {
+            if (!hasComponent(instance->getRoot()))
+            {
+                return false;
+            }
+            auto &animationComponent = elementAt<0>(getInstance(instance->getRoot()));
+            animationComponent.stateMachine = AnimationStateMachineInstance();
+            if (!stateMachine)
+            {
+                return true;
+            }
+
+            auto animator = instance->getAnimator();
+            AnimationStateMachineInstance stateMachineInstance;
+            for (const auto &state : stateMachine->states)
+            {
+                if (state.animationIndex < 0 || size_t(state.animationIndex) >= animator->getAnimationCount())
+                {
+                    Log("ERROR: animation state machine refers to glTF animation %d, but the instance only has %zu animations", state.animationIndex, animator->getAnimationCount());
+                    return false;
+                }
+                stateMachineInstance.stateDurations.push_back(animator->getAnimationDuration(state.animationIndex));
+            }
+            for (const auto &parameter : stateMachine->parameters)
+            {
+                stateMachineInstance.parameterValues.push_back(parameter.defaultValue);
+            }
+            stateMachineInstance.definition = stateMachine;
+            animationComponent.stateMachine = std::move(stateMachineInstance);
+            enterState(animationComponent, stateMachine->initialState, 0.0f, getTime());
+            return true;
+        }
+
+        ///
+        /// Sets the value of [parameter] for the state machine attached to [instance] (use 0/1 for bools/triggers).
+        ///
+        bool setStateMachineParameter(FilamentInstance *instance, int parameter, float value)
+        {
+            if (!hasComponent(instance->getRoot()))
+            {
+                return false;
+            }
+            auto &stateMachine = elementAt<0>(getInstance(instance->getRoot())).stateMachine;
+            if (!stateMachine.definition || parameter < 0 || size_t(parameter) >= stateMachine.parameterValues.size())
+            {
+                return false;
+            }
+            stateMachine.parameterValues[parameter] = value;
+            return true;
+        }
+
+        ///
+        /// Returns the current state of the state machine attached to [instance], or -1 if there is none.
+        ///
+        int getStateMachineState(FilamentInstance *instance)
+        {
+            if (!hasComponent(instance->getRoot()))
+            {
+                return -1;
+            }
+            return elementAt<0>(getInstance(instance->getRoot())).stateMachine.state;
+        }
+
         void removeAnimationComponent(std::variant<FilamentInstance *, Entity> target)
         {
             AnimationComponent animationComponent;
@@ -156,208 +524,683 @@ namespace thermion
             }
         }
 
-        void update()
+        ///
+        /// Advances all animations.
+        ///
+        /// This happens in two phases:
+        /// - evaluation, where each component's animations are sampled independently (split across worker threads when there
+        ///   are enough components). This only reads/writes the component itself, so components can be evaluated in any order.
+        /// - commit, where the results are written to the transform/renderable managers (and glTF animations are applied via gltfio,
+        ///   neither of which are thread-safe) on the calling thread, always in component order.
+        ///
+        /// If LOD is enabled, [views] (the views that will be rendered this frame) determine which components are evaluated.
+        ///
+        void update(const std::vector<View *> &views = {})
         {
+            if (_clockMode == ClockMode::FIXED_TIMESTEP)
+            {
+                _time += _timestep;
+            }
+
+            // all animations are sampled at the same point in time
+            const auto now = getTime();
+
+            _frame++;
 
+            const bool useLod = _lodSettings.enabled && !views.empty();
+
+            _components.clear();
             for (auto it = begin(); it < end(); it++)
             {
                 const auto &entity = getEntity(it);
+                auto &animationComponent = elementAt<0>(getInstance(entity));
+                if (animationComponent.gltfAnimations.empty() && animationComponent.boneAnimations.empty() && animationComponent.morphAnimations.empty() &&
+                    animationComponent.layers.empty() && !animationComponent.stateMachine.definition)
+                {
+                    continue;
+                }
 
-                auto componentInstance = getInstance(entity);
-                auto &animationComponent = elementAt<0>(componentInstance);
-
-                auto &morphAnimations = animationComponent.morphAnimations;
-
-                if (std::holds_alternative<FilamentInstance *>(animationComponent.target))
+                animationComponent.skipSkinning = false;
+                if (useLod)
                 {
+                    bool visible = false;
+                    const float screenSize = computeScreenSize(animationComponent, views, visible);
+                    const int interval = !visible ? _lodSettings.culledInterval : screenSize < _lodSettings.distantScreenSize ? _lodSettings.distantInterval
+                                                                                                                                : 1;
+                    animationComponent.skipSkinning = !visible;
+                    // stagger the updates so components with the same interval don't all update on the same frame
+                    if (interval <= 0 || (_frame + entity.getId()) % interval != 0)
+                    {
+                        _stats.skippedEvaluations++;
+                        continue;
+                    }
+                }
+                _stats.evaluatedComponents++;
+                _components.push_back(&animationComponent);
+            }
 
-                    auto target = std::get<FilamentInstance *>(animationComponent.target);
-                    auto animator = target->getAnimator();
-                    auto &gltfAnimations = animationComponent.gltfAnimations;
-                    auto &boneAnimations = animationComponent.boneAnimations;
+            const size_t numJobs = _pool ? std::min(size_t(_pool->size() + 1), _components.size() / kMinComponentsPerJob) : 0;
 
-                    if(gltfAnimations.size() > 0) {
-                        for (int i = ((int)gltfAnimations.size()) - 1; i >= 0; i--)
+            if (numJobs > 1)
+            {
+                // the pool is shared with (potentially slow) loading tasks, so rather than waiting for each worker to
+                // evaluate a fixed range, this thread and the workers claim batches of components until none are left.
+                // This thread then only waits for batches that are already being evaluated, and a job that only starts
+                // after that finds nothing left to do (so it never touches _components after this returns).
+                struct Batches
+                {
+                    std::atomic<size_t> next{0};
+                    std::atomic<size_t> done{0};
+                    std::mutex mutex;
+                    std::condition_variable finished;
+                };
+                auto batches = std::make_shared<Batches>();
+                const size_t count = _components.size();
+                const size_t batchSize = (count + numJobs - 1) / numJobs;
+                auto evaluateBatches = [this, batches, count, batchSize, now]
+                {
+                    size_t first;
+                    while ((first = batches->next.fetch_add(batchSize)) < count)
+                    {
+                        const size_t last = std::min(first + batchSize, count);
+                        for (size_t i = first; i < last; i++)
                         {
-                            auto now = high_resolution_clock::now();
-
-                            auto animationStatus = animationComponent.gltfAnimations[i];
-
-                            auto elapsedInSecs = animationStatus.startOffset + float(std::chrono::duration_cast<std::chrono::milliseconds>(now - animationStatus.start).count()) / 1000.0f;
-
-                            if (!animationStatus.loop && elapsedInSecs >= animationStatus.durationInSecs)
-                            {
-                                animator->applyAnimation(animationStatus.index, animationStatus.durationInSecs - 0.001);
-                                animator->updateBoneMatrices();
-                                gltfAnimations.erase(gltfAnimations.begin() + i);
-                                animationComponent.fadeGltfAnimationIndex = -1;
-                                continue;
-                            }
-                            animator->applyAnimation(animationStatus.index, elapsedInSecs);
-
-                            if (animationComponent.fadeGltfAnimationIndex != -1 && elapsedInSecs < animationComponent.fadeDuration)
-                            {
-                                // cross-fade
-                                auto fadeFromTime = animationComponent.fadeOutAnimationStart + elapsedInSecs;
-                                auto alpha = elapsedInSecs / animationComponent.fadeDuration;
-                                animator->applyCrossFade(animationComponent.fadeGltfAnimationIndex, fadeFromTime, alpha);
-                            }
+                            evaluate(*_components[i], now);
+                        }
+                        if (batches->done.fetch_add(last - first) + (last - first) == count)
+                        {
+                            std::lock_guard lock(batches->mutex);
+                            batches->finished.notify_all();
                         }
-
-                        animator->updateBoneMatrices();
                     }
+                };
+                for (size_t job = 0; job < numJobs - 1; job++)
+                {
+                    std::packaged_task<void()> task(evaluateBatches);
+                    _pool->add_task(task);
+                }
+                evaluateBatches();
+                std::unique_lock lock(batches->mutex);
+                batches->finished.wait(lock, [&]
+                                       { return batches->done == count; });
+            }
+            else
+            {
+                for (auto *component : _components)
+                {
+                    evaluate(*component, now);
+                }
+            }
+
+            for (auto *component : _components)
+            {
+                commit(*component);
+            }
+        }
+
+    private:
+        ///
+        /// Replaces the glTF animations of [animationComponent] with the animation for [state], cross-fading
+        /// from the animation of the current state over [blendDuration] seconds.
+        ///
+        void enterState(AnimationComponent &animationComponent, int32_t state, float blendDuration, const time_point_t &now)
+        {
+            auto &stateMachine = animationComponent.stateMachine;
+            const auto &states = stateMachine.definition->states;
 
-                    ///
-                    /// When fading in/out, interpolate between the "current" transform (which has possibly been set by the glTF animation loop above)
-                    /// and the first (for fading in) or last (for fading out) frame. 
-                    ///                    
-                    for (int i = (int)boneAnimations.size() - 1; i >= 0; i--)
+            if (stateMachine.state >= 0 && blendDuration > 0.0f)
+            {
+                const auto &previous = states[stateMachine.state];
+                auto elapsedInSecs = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - stateMachine.stateStart).count()) / 1000.0f;
+                if (!previous.loop)
+                {
+                    elapsedInSecs = std::min(elapsedInSecs, stateMachine.stateDurations[stateMachine.state] - 0.001f);
+                }
+                animationComponent.fadeGltfAnimationIndex = previous.animationIndex;
+                animationComponent.fadeDuration = blendDuration;
+                animationComponent.fadeOutAnimationStart = elapsedInSecs;
+            }
+            else
+            {
+                animationComponent.fadeGltfAnimationIndex = -1;
+                animationComponent.fadeDuration = 0.0f;
+            }
+
+            GltfAnimation animation;
+            animation.index = states[state].animationIndex;
+            animation.start = now;
+            animation.startOffset = 0.0f;
+            animation.loop = states[state].loop;
+            animation.durationInSecs = stateMachine.stateDurations[state];
+            animationComponent.gltfAnimations.clear();
+            animationComponent.gltfAnimations.push_back(std::move(animation));
+
+            stateMachine.state = state;
+            stateMachine.stateStart = now;
+        }
+
+        ///
+        /// Takes (at most) one transition of the state machine attached to [animationComponent].
+        ///
+        void advanceStateMachine(AnimationComponent &animationComponent, const time_point_t &now)
+        {
+            auto &stateMachine = animationComponent.stateMachine;
+            if (!stateMachine.definition)
+            {
+                return;
+            }
+            const auto &definition = *stateMachine.definition;
+
+            const float duration = stateMachine.stateDurations[stateMachine.state];
+            const float elapsedInSecs = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - stateMachine.stateStart).count()) / 1000.0f;
+            const float normalizedTime = duration > 0.0f ? elapsedInSecs / duration : 1.0f;
+
+            const int transitionIndex = definition.findTransition(stateMachine.state, normalizedTime, stateMachine.parameterValues);
+            if (transitionIndex < 0)
+            {
+                return;
+            }
+            const auto &transition = definition.transitions[transitionIndex];
+            for (const auto &condition : transition.conditions)
+            {
+                if (definition.parameters[condition.parameter].type == AnimationStateMachine::ParameterType::TRIGGER)
+                {
+                    stateMachine.parameterValues[condition.parameter] = 0.0f;
+                }
+            }
+            enterState(animationComponent, transition.to, transition.blendDuration, now);
+        }
+
+        AnimationLayer *getLayer(FilamentInstance *instance, int layerId)
+        {
+            if (!hasComponent(instance->getRoot()))
+            {
+                return nullptr;
+            }
+            auto &layers = elementAt<0>(getInstance(instance->getRoot())).layers;
+            for (auto &layer : layers)
+            {
+                if (layer.id == layerId)
+                {
+                    return &layer;
+                }
+            }
+            return nullptr;
+        }
+
+        ///
+        /// Samples each layer of [animationComponent] into its own local pose buffer, blends every layer in a single
+        /// (vectorized) pass over the nodes and then writes the blended pose to each node once.
+        /// Layers are sampled from the glTF keyframes if the source data has been retained; otherwise gltfio can only sample
+        /// an animation by applying it, so each layer's animation is applied to the (masked) nodes and the result read back.
+        ///
+        void blendLayers(AnimationComponent &animationComponent, FilamentInstance *target, bool startFromCurrentPose)
+        {
+            auto animator = target->getAnimator();
+            const auto *entities = target->getEntities();
+            const size_t numNodes = target->getEntityCount();
+
+            const auto &reference = animationComponent.referencePose;
+            auto &blended = animationComponent.blendedPose;
+            auto *sampler = animationComponent.layerSampler;
+
+            if (startFromCurrentPose)
+            {
+                // the pose set by the (non-layered) glTF animations applied this frame
+                blended.read(_transformManager, entities, numNodes, {});
+            }
+            else
+            {
+                blended.copyFrom(reference);
+            }
+
+            auto &poseLayers = animationComponent.poseLayers;
+            poseLayers.clear();
+            for (auto &layer : animationComponent.layers)
+            {
+                if (layer.weight <= 0.0f)
+                {
+                    continue;
+                }
+
+                if (sampler)
+                {
+                    // the Animator wraps looping animations, but the sampler clamps
+                    const float timeInSecs = layer.loop && layer.durationInSecs > 0.0f ? std::fmod(layer.elapsedInSecs, layer.durationInSecs) : layer.elapsedInSecs;
+                    sampler->sample(layer.index, timeInSecs, layer.pose);
+                }
+                else
+                {
+                    // nodes that this animation doesn't target take the reference pose
+                    reference.write(_transformManager, entities, numNodes, layer.mask);
+                    animator->applyAnimation(layer.index, layer.elapsedInSecs);
+                    layer.pose.read(_transformManager, entities, numNodes, layer.mask);
+                }
+
+                layer.nodeWeights.assign(LocalPose::padded(numNodes), 0.0f);
+                for (size_t i = 0; i < numNodes; i++)
+                {
+                    layer.nodeWeights[i] = layer.weight * (layer.mask.empty() ? 1.0f : layer.mask[i]);
+                }
+                poseLayers.push_back({&layer.pose, layer.nodeWeights.data(), layer.mode == AnimationBlendMode::ADDITIVE});
+            }
+
+            blendPoses(blended, reference, poseLayers.data(), poseLayers.size());
+
+            blended.write(_transformManager, entities, numNodes, {});
+            _stats.jointTransformWrites += numNodes;
+        }
+
+        ///
+        /// Returns the largest fraction of the viewport height that the bounds of [animationComponent] occupy in any of [views]
+        /// (or 1 if the camera is inside the bounds). [visible] is set if the bounds intersect the frustum of any view.
+        ///
+        float computeScreenSize(const AnimationComponent &animationComponent, const std::vector<View *> &views, bool &visible)
+        {
+            Aabb aabb;
+            Entity root;
+            if (std::holds_alternative<FilamentInstance *>(animationComponent.target))
+            {
+                auto instance = std::get<FilamentInstance *>(animationComponent.target);
+                aabb = instance->getBoundingBox();
+                root = instance->getRoot();
+            }
+            else
+            {
+                root = std::get<Entity>(animationComponent.target);
+                auto renderable = _renderableManager.getInstance(root);
+                if (!renderable.isValid())
+                {
+                    // no bounds to test, so always treat it as visible
+                    visible = true;
+                    return 1.0f;
+                }
+                const auto box = _renderableManager.getAxisAlignedBoundingBox(renderable);
+                aabb = Aabb{box.getMin(), box.getMax()};
+            }
+
+            const math::mat4f worldTransform = _transformManager.getWorldTransform(_transformManager.getInstance(root));
+            const auto worldAabb = aabb.transform(worldTransform);
+            Box worldBox;
+            worldBox.set(worldAabb.min, worldAabb.max);
+            const math::float3 corners[8] = {
+                {worldAabb.min.x, worldAabb.min.y, worldAabb.min.z},
+                {worldAabb.max.x, worldAabb.min.y, worldAabb.min.z},
+                {worldAabb.min.x, worldAabb.max.y, worldAabb.min.z},
+                {worldAabb.max.x, worldAabb.max.y, worldAabb.min.z},
+                {worldAabb.min.x, worldAabb.min.y, worldAabb.max.z},
+                {worldAabb.max.x, worldAabb.min.y, worldAabb.max.z},
+                {worldAabb.min.x, worldAabb.max.y, worldAabb.max.z},
+                {worldAabb.max.x, worldAabb.max.y, worldAabb.max.z}};
+
+            visible = false;
+            float screenSize = 0.0f;
+            for (auto view : views)
+            {
+                const auto &camera = view->getCamera();
+                if (!camera.getFrustum().intersects(worldBox))
+                {
+                    continue;
+                }
+                visible = true;
+
+                const math::mat4 vp = camera.getProjectionMatrix() * camera.getViewMatrix();
+                float minY = 1.0f, maxY = -1.0f;
+                for (const auto &corner : corners)
+                {
+                    const math::float4 clip = math::float4(vp * math::double4(corner, 1.0));
+                    if (clip.w <= 0.0f)
                     {
-                        auto animationStatus = boneAnimations[i];
+                        return 1.0f;
+                    }
+                    const float y = std::clamp(clip.y / clip.w, -1.0f, 1.0f);
+                    minY = std::min(minY, y);
+                    maxY = std::max(maxY, y);
+                }
+                screenSize = std::max(screenSize, (maxY - minY) / 2.0f);
+            }
+            return screenSize;
+        }
 
-                        auto now = high_resolution_clock::now();
+        ///
+        /// Advances the state machine of [animationComponent] (if any), computes the elapsed time/frame for every animation
+        /// and samples its bone animations.
+        ///
+        void evaluate(AnimationComponent &animationComponent, const time_point_t &now)
+        {
+            // this may replace the glTF animations, so must come first
+            advanceStateMachine(animationComponent, now);
 
-                        auto elapsedInMillis = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - animationStatus.start).count());
-                        auto elapsedInSecs = elapsedInMillis / 1000.0f;
+            auto &gltfAnimations = animationComponent.gltfAnimations;
+            animationComponent.gltfElapsedInSecs.resize(gltfAnimations.size());
+            for (size_t i = 0; i < gltfAnimations.size(); i++)
+            {
+                const auto &animationStatus = gltfAnimations[i];
+                auto elapsedInSecs = animationStatus.startOffset + float(std::chrono::duration_cast<std::chrono::milliseconds>(now - animationStatus.start).count()) / 1000.0f;
+                if (!animationStatus.loop && elapsedInSecs >= animationStatus.durationInSecs)
+                {
+                    elapsedInSecs = -1.0f;
+                }
+                animationComponent.gltfElapsedInSecs[i] = elapsedInSecs;
+            }
 
-                        // if we're not looping and the amount of time elapsed is greater than the animation duration plus the fade-in/out buffer,
-                        // then the animation is completed and we can delete it
-                        if (elapsedInSecs >= (animationStatus.durationInSecs + animationStatus.fadeInInSecs + animationStatus.fadeOutInSecs))
-                        {
-                            if(!animationStatus.loop) {
-                                Log("Bone animation %d finished", i);
-                                boneAnimations.erase(boneAnimations.begin() + i);
-                                continue;
-                            }
-                        }
+            for (auto &layer : animationComponent.layers)
+            {
+                auto elapsedInSecs = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - layer.start).count()) / 1000.0f;
+                // non-looping layers hold their last frame until they are removed
+                if (!layer.loop)
+                {
+                    elapsedInSecs = std::min(elapsedInSecs, layer.durationInSecs - 0.001f);
+                }
+                layer.elapsedInSecs = std::max(elapsedInSecs, 0.0f);
+            }
+
+            auto &boneAnimations = animationComponent.boneAnimations;
+            animationComponent.boneSamples.resize(boneAnimations.size());
+
+            if (std::holds_alternative<FilamentInstance *>(animationComponent.target))
+            {
+                auto target = std::get<FilamentInstance *>(animationComponent.target);
+
+                for (size_t i = 0; i < boneAnimations.size(); i++)
+                {
+                    auto &animationStatus = boneAnimations[i];
+                    auto &sample = animationComponent.boneSamples[i];
+
+                    auto elapsedInMillis = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - animationStatus.start).count());
+                    auto elapsedInSecs = elapsedInMillis / 1000.0f;
+
+                    // if we're not looping and the amount of time elapsed is greater than the animation duration plus the fade-in/out buffer,
+                    // then the animation is completed and we can delete it
+                    sample.finished = !animationStatus.loop && elapsedInSecs >= (animationStatus.durationInSecs + animationStatus.fadeInInSecs + animationStatus.fadeOutInSecs);
+                    if (sample.finished)
+                    {
+                        continue;
+                    }
 
-                        // if we're fading in, treat elapsedFrames is zero (and fading out, treat elapsedFrames as lengthInFrames)
-                        float elapsedInFrames = (elapsedInMillis - (1000 * animationStatus.fadeInInSecs)) / animationStatus.frameLengthInMs;
-                        int currFrame = std::floor(elapsedInFrames);
-                        int nextFrame = currFrame;
+                    // if we're fading in, treat elapsedFrames is zero (and fading out, treat elapsedFrames as lengthInFrames)
+                    float elapsedInFrames = (elapsedInMillis - (1000 * animationStatus.fadeInInSecs)) / animationStatus.frameLengthInMs;
+                    int currFrame = std::floor(elapsedInFrames);
+                    int nextFrame = currFrame;
 
-                        // offset from the end if reverse
-                        if (animationStatus.reverse)
+                    // offset from the end if reverse
+                    if (animationStatus.reverse)
+                    {
+                        currFrame = animationStatus.lengthInFrames - currFrame;
+                        if (currFrame > 0)
                         {
-                            currFrame = animationStatus.lengthInFrames - currFrame;
-                            if (currFrame > 0)
-                            {
-                                nextFrame = currFrame - 1;
-                            }
-                            else
-                            {
-                                nextFrame = 0;
-                            }
+                            nextFrame = currFrame - 1;
                         }
                         else
                         {
-                            if (currFrame < animationStatus.lengthInFrames - 1)
-                            {
-                                nextFrame = currFrame + 1;
-                            }
-                            else
-                            {
-                                nextFrame = currFrame;
-                            }
+                            nextFrame = 0;
+                        }
+                    }
+                    else
+                    {
+                        if (currFrame < animationStatus.lengthInFrames - 1)
+                        {
+                            nextFrame = currFrame + 1;
                         }
-                        currFrame = std::clamp(currFrame, 0, animationStatus.lengthInFrames - 1);
-                        nextFrame = std::clamp(nextFrame, 0, animationStatus.lengthInFrames - 1);
-
-                        float frameDelta = elapsedInFrames - currFrame;
-
-                        // linearly interpolate this animation between its last/current frames 
-                        // this is to avoid jerky animations when the animation framerate is slower than our tick rate                        
-
-                        math::float3 currScale, newScale;
-                        math::quatf currRotation, newRotation;
-                        math::float3 currTranslation, newTranslation;
-                        math::mat4f curr = animationStatus.frameData[currFrame];
-                        decomposeMatrix(curr, &currTranslation, &currRotation, &currScale);
-                        
-                        if(frameDelta > 0) {
-                            math::mat4f next = animationStatus.frameData[nextFrame];
-                            decomposeMatrix(next, &newTranslation, &newRotation, &newScale);                            
-                            newScale = mix(currScale, newScale, frameDelta);
-                            newRotation = slerp(currRotation, newRotation, frameDelta);
-                            newTranslation = mix(currTranslation, newTranslation, frameDelta);
-                        } else { 
-                            newScale = currScale;
-                            newRotation = currRotation;
-                            newTranslation = currTranslation;
+                        else
+                        {
+                            nextFrame = currFrame;
                         }
+                    }
+                    currFrame = std::clamp(currFrame, 0, animationStatus.lengthInFrames - 1);
+                    nextFrame = std::clamp(nextFrame, 0, animationStatus.lengthInFrames - 1);
 
-                        const Entity joint = target->getJointsAt(animationStatus.skinIndex)[animationStatus.boneIndex];
+                    float frameDelta = elapsedInFrames - currFrame;
 
-                        // now calculate the fade out/in delta
-                        // if we're fading in, this will be 0.0 at the start of the fade and 1.0 at the end
-                        auto fadeDelta = elapsedInSecs / animationStatus.fadeInInSecs;
-                        
-                        // // if we're fading out, this will be 1.0 at the start of the fade and 0.0 at the end
-                        if(fadeDelta > 1.0f) {
-                            fadeDelta = 1 - ((elapsedInSecs - animationStatus.durationInSecs - animationStatus.fadeInInSecs) / animationStatus.fadeOutInSecs);
-                        }
+                    // linearly interpolate this animation between its last/current frames 
+                    // this is to avoid jerky animations when the animation framerate is slower than our tick rate                        
+                    animationStatus.frameData.sample(currFrame, nextFrame, frameDelta, sample.translation, sample.rotation, sample.scale);
 
-                        fadeDelta = std::clamp(fadeDelta, 0.0f, animationStatus.maxDelta);
-
-                        auto jointTransform = _transformManager.getInstance(joint);
-
-                        // linearly interpolate this animation between its current (interpolated) frame and the current transform (i.e. as set by the gltf frame)
-                        // // if we are fading in or out, apply a delta
-                        if (fadeDelta >= 0.0f && fadeDelta <= 1.0f) {
-                            math::float3 fadeScale;
-                            math::quatf fadeRotation;
-                            math::float3 fadeTranslation;
-                            auto currentTransform = _transformManager.getTransform(jointTransform);
-                            decomposeMatrix(currentTransform, &fadeTranslation, &fadeRotation, &fadeScale);
-                            newScale = mix(fadeScale, newScale, fadeDelta);
-                            newRotation = slerp(fadeRotation, newRotation, fadeDelta);
-                            newTranslation = mix(fadeTranslation, newTranslation, fadeDelta);
-                        }
+                    sample.joint = target->getJointsAt(animationStatus.skinIndex)[animationStatus.boneIndex];
+
+                    // now calculate the fade out/in delta
+                    // if we're fading in, this will be 0.0 at the start of the fade and 1.0 at the end
+                    auto fadeDelta = elapsedInSecs / animationStatus.fadeInInSecs;
+                    
+                    // // if we're fading out, this will be 1.0 at the start of the fade and 0.0 at the end
+                    if(fadeDelta > 1.0f) {
+                        fadeDelta = 1 - ((elapsedInSecs - animationStatus.durationInSecs - animationStatus.fadeInInSecs) / animationStatus.fadeOutInSecs);
+                    }
+
+                    sample.fadeDelta = std::clamp(fadeDelta, 0.0f, animationStatus.maxDelta);
+
+                    if (animationStatus.loop && elapsedInSecs >= (animationStatus.durationInSecs + animationStatus.fadeInInSecs + animationStatus.fadeOutInSecs))
+                    {
+                        animationStatus.start = now;
+                    }
+                }
+            }
+
+            auto &morphAnimations = animationComponent.morphAnimations;
+            animationComponent.morphFrames.resize(morphAnimations.size());
+            for (size_t i = 0; i < morphAnimations.size(); i++)
+            {
+                const auto &animationStatus = morphAnimations[i];
+
+                auto elapsedInSecs = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - animationStatus.start).count()) / 1000.0f;
+
+                if (!animationStatus.loop && elapsedInSecs >= animationStatus.durationInSecs)
+                {
+                    animationComponent.morphFrames[i] = -1;
+                    continue;
+                }
+
+                int frameNumber = static_cast<int>(elapsedInSecs * 1000.0f / animationStatus.frameLengthInMs) % animationStatus.lengthInFrames;
+                // offset from the end if reverse
+                if (animationStatus.reverse)
+                {
+                    frameNumber = animationStatus.lengthInFrames - frameNumber;
+                }
+                animationComponent.morphFrames[i] = std::min(frameNumber, animationStatus.lengthInFrames - 1);
+            }
+        }
 
-                        _transformManager.setTransform(jointTransform, composeMatrix(newTranslation, newRotation, newScale));
+        ///
+        /// Applies the results of [evaluate] and removes any finished animations.
+        ///
+        void commit(AnimationComponent &animationComponent)
+        {
+            auto &morphAnimations = animationComponent.morphAnimations;
+
+            if (std::holds_alternative<FilamentInstance *>(animationComponent.target))
+            {
 
-                        animator->updateBoneMatrices();
+                auto target = std::get<FilamentInstance *>(animationComponent.target);
+                auto animator = target->getAnimator();
+                auto &gltfAnimations = animationComponent.gltfAnimations;
+                auto &boneAnimations = animationComponent.boneAnimations;
 
-                        if (animationStatus.loop && elapsedInSecs >= (animationStatus.durationInSecs + animationStatus.fadeInInSecs + animationStatus.fadeOutInSecs))
+                // the bone matrices are recomputed once, after every joint transform for this instance has been written
+                bool updateBones = false;
+
+                const bool hasLayers = !animationComponent.layers.empty();
+                if (hasLayers)
+                {
+                    // the intermediate poses written while blending only need local transforms,
+                    // so world transforms are only recomputed once all layers have been blended
+                    _transformManager.openLocalTransformTransaction();
+                    if (gltfAnimations.size() > 0)
+                    {
+                        // start from the reference pose so nodes not targeted by these animations don't keep last frame's blended pose
+                        animationComponent.referencePose.write(_transformManager, target->getEntities(), target->getEntityCount(), {});
+                    }
+                }
+
+                if(gltfAnimations.size() > 0) {
+                    for (int i = ((int)gltfAnimations.size()) - 1; i >= 0; i--)
+                    {
+                        const auto &animationStatus = gltfAnimations[i];
+
+                        auto elapsedInSecs = animationComponent.gltfElapsedInSecs[i];
+
+                        if (elapsedInSecs < 0.0f)
+                        {
+                            animator->applyAnimation(animationStatus.index, animationStatus.durationInSecs - 0.001);
+                            gltfAnimations.erase(gltfAnimations.begin() + i);
+                            animationComponent.fadeGltfAnimationIndex = -1;
+                            continue;
+                        }
+                        animator->applyAnimation(animationStatus.index, elapsedInSecs);
+
+                        if (animationComponent.fadeGltfAnimationIndex != -1 && elapsedInSecs < animationComponent.fadeDuration)
                         {
-                            animationStatus.start = now;
+                            // cross-fade
+                            auto fadeFromTime = animationComponent.fadeOutAnimationStart + elapsedInSecs;
+                            auto alpha = elapsedInSecs / animationComponent.fadeDuration;
+                            animator->applyCrossFade(animationComponent.fadeGltfAnimationIndex, fadeFromTime, alpha);
                         }
                     }
+
+                    updateBones = true;
                 }
-                for (int i = (int)morphAnimations.size() - 1; i >= 0; i--)
+
+                if (hasLayers)
                 {
+                    blendLayers(animationComponent, target, gltfAnimations.size() > 0);
+                    _transformManager.commitLocalTransformTransaction();
+                    updateBones = true;
+                }
 
-                    auto now = high_resolution_clock::now();
+                ///
+                /// When fading in/out, interpolate between the "current" transform (which has possibly been set by the glTF animation loop above)
+                /// and the first (for fading in) or last (for fading out) frame. 
+                ///                    
+                for (int i = (int)boneAnimations.size() - 1; i >= 0; i--)
+                {
+                    const auto &sample = animationComponent.boneSamples[i];
+
+                    if (sample.finished)
+                    {
+                        Log("Bone animation %d finished", i);
+                        boneAnimations.erase(boneAnimations.begin() + i);
+                        continue;
+                    }
 
-                    auto animationStatus = morphAnimations[i];
+                    auto newScale = sample.scale;
+                    auto newRotation = sample.rotation;
+                    auto newTranslation = sample.translation;
 
-                    auto elapsedInSecs = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - animationStatus.start).count()) / 1000.0f;
+                    auto jointTransform = _transformManager.getInstance(sample.joint);
 
-                    if (!animationStatus.loop && elapsedInSecs >= animationStatus.durationInSecs)
+                    // linearly interpolate this animation between its current (interpolated) frame and the current transform (i.e. as set by the gltf frame)
+                    // if we are fading in or out, apply a delta
+                    // (at full weight the current transform doesn't contribute, so there's no need to decompose it)
+                    if (sample.fadeDelta < 1.0f) {
+                        math::float3 fadeScale;
+                        math::quatf fadeRotation;
+                        math::float3 fadeTranslation;
+                        auto currentTransform = _transformManager.getTransform(jointTransform);
+                        decomposeMatrix(currentTransform, &fadeTranslation, &fadeRotation, &fadeScale);
+                        newScale = mix(fadeScale, newScale, sample.fadeDelta);
+                        newRotation = nlerp(fadeRotation, newRotation, sample.fadeDelta);
+                        newTranslation = mix(fadeTranslation, newTranslation, sample.fadeDelta);
+                    }
+
+                    _transformManager.setTransform(jointTransform, composeMatrix(newTranslation, newRotation, newScale));
+                    _stats.jointTransformWrites++;
+                    updateBones = true;
+                }
+
+                if (updateBones && animationComponent.skipSkinning)
+                {
+                    _stats.skippedSkinningUpdates++;
+                }
+                else if (updateBones)
+                {
+                    animator->updateBoneMatrices();
+                    _stats.boneMatrixUpdates++;
+                }
+            }
+            // accumulate the weights of every morph animation for each renderable so each contiguous range of weights is
+            // uploaded with a single call (animations are applied last to first, so the earliest animation takes precedence, as before)
+            size_t numMorphTargets = 0;
+            for (int i = (int)morphAnimations.size() - 1; i >= 0; i--)
+            {
+                const auto &animationStatus = morphAnimations[i];
+
+                int frameNumber = animationComponent.morphFrames[i];
+
+                if (frameNumber < 0)
+                {
+                    morphAnimations.erase(morphAnimations.begin() + i);
+                    continue;
+                }
+
+                size_t target = 0;
+                while (target < numMorphTargets && _morphWeights[target].target != animationStatus.meshTarget)
+                {
+                    target++;
+                }
+                if (target == numMorphTargets)
+                {
+                    if (numMorphTargets == _morphWeights.size())
+                    {
+                        _morphWeights.emplace_back();
+                    }
+                    auto &morphWeights = _morphWeights[numMorphTargets++];
+                    const auto count = _renderableManager.getMorphTargetCount(_renderableManager.getInstance(animationStatus.meshTarget));
+                    morphWeights.target = animationStatus.meshTarget;
+                    morphWeights.weights.resize(count);
+                    morphWeights.dirty.assign(count, 0);
+                }
+                auto &morphWeights = _morphWeights[target];
+
+                for (size_t j = 0; j < animationStatus.morphIndices.size(); j++)
+                {
+                    auto morphIndex = animationStatus.morphIndices[j];
+                    if (morphIndex < 0 || size_t(morphIndex) >= morphWeights.weights.size())
                     {
-                        morphAnimations.erase(morphAnimations.begin() + i);
                         continue;
                     }
+                    morphWeights.weights[morphIndex] = animationStatus.frameData.weight(frameNumber, int(j));
+                    morphWeights.dirty[morphIndex] = 1;
+                }
+            }
 
-                    int frameNumber = static_cast<int>(elapsedInSecs * 1000.0f / animationStatus.frameLengthInMs) % animationStatus.lengthInFrames;
-                    // offset from the end if reverse
-                    if (animationStatus.reverse)
+            for (size_t target = 0; target < numMorphTargets; target++)
+            {
+                const auto &morphWeights = _morphWeights[target];
+                auto renderableInstance = _renderableManager.getInstance(morphWeights.target);
+                size_t offset = 0;
+                while (offset < morphWeights.dirty.size())
+                {
+                    if (!morphWeights.dirty[offset])
                     {
-                        frameNumber = animationStatus.lengthInFrames - frameNumber;
+                        offset++;
+                        continue;
                     }
-                    auto baseOffset = frameNumber * animationStatus.morphIndices.size();
-                    for (int i = 0; i < animationStatus.morphIndices.size(); i++)
+                    size_t count = 1;
+                    while (offset + count < morphWeights.dirty.size() && morphWeights.dirty[offset + count])
                     {
-                        auto morphIndex = animationStatus.morphIndices[i];
-                        // set the weights appropriately
-                        _renderableManager.setMorphWeights(
-                            _renderableManager.getInstance(animationStatus.meshTarget),
-                            animationStatus.frameData.data() + baseOffset + i,
-                            1,
-                            morphIndex);
+                        count++;
                     }
+                    _renderableManager.setMorphWeights(renderableInstance, morphWeights.weights.data() + offset, count, offset);
+                    _stats.morphWeightUploads++;
+                    offset += count;
                 }
             }
         }
+
+        // converted to integer ticks so the clock advances by exactly the same amount every step
+        static high_resolution_clock::duration toDuration(float secs)
+        {
+            return std::chrono::duration_cast<high_resolution_clock::duration>(std::chrono::duration<double>(secs));
+        }
+
+        LodSettings _lodSettings;
+        TrackCompressionSettings _compressionSettings;
+        uint64_t _frame = 0;
+
+        ClockMode _clockMode = ClockMode::WALL_CLOCK;
+        time_point_t _time = high_resolution_clock::now();
+        high_resolution_clock::duration _timestep = toDuration(1.0f / 60.0f);
+        high_resolution_clock::duration _wallClockOffset = high_resolution_clock::duration::zero();
+
+        Stats _stats;
     };
 }
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Log.hpp"
+
+namespace thermion
+{
+
+    //
+    // A state machine that selects which glTF animation an instance plays, evaluated natively every frame
+    // (see AnimationComponentManager::setStateMachine). Each state plays a single glTF animation; a
+    // transition cross-fades to another state once all of its conditions are met (and, optionally,
+    // once the current state has played for a given fraction of its duration).
+    //
+    // State machines are compiled to a compact binary format on the Dart side and parsed once by [parse];
+    // the result is immutable and can be shared by any number of instances. At runtime, only parameter
+    // values cross the FFI boundary.
+    //
+    struct AnimationStateMachine
+    {
+        static constexpr int32_t kMagic = 0x4d534154; // "TASM"
+        static constexpr int32_t kVersion = 1;
+        // a transition with this source state can be taken from any state (other than its target)
+        static constexpr int32_t kAnyState = -1;
+
+        enum class ParameterType : int32_t
+        {
+            FLOAT,
+            BOOL,
+            // a bool that is reset as soon as a transition that tests it is taken
+            TRIGGER
+        };
+
+        enum class ConditionOp : int32_t
+        {
+            GREATER,
+            LESS,
+            EQUAL,
+            NOT_EQUAL
+        };
+
+        struct Parameter
+        {
+            ParameterType type = ParameterType::FLOAT;
+            float defaultValue = 0.0f;
+        };
+
+        struct State
+        {
+            int32_t animationIndex = 0;
+            bool loop = true;
+        };
+
+        struct Condition
+        {
+            int32_t parameter = 0;
+            ConditionOp op = ConditionOp::GREATER;
+            float value = 0.0f;
+        };
+
+        struct Transition
+        {
+            int32_t from = kAnyState;
+            int32_t to = 0;
+            float blendDuration = 0.0f;
+            // the normalized time (elapsed / duration) of the current state after which this transition can be taken,
+            // or negative if the transition can be taken at any time
+            float exitTime = -1.0f;
+            std::vector<Condition> conditions;
+        };
+
+        std::vector<Parameter> parameters;
+        std::vector<State> states;
+        std::vector<Transition> transitions;
+        int32_t initialState = 0;
+
+        ///
+        /// Parses a state machine compiled by the Dart AnimationStateMachine class:
+        ///
+        ///   magic, version,
+        ///   parameterCount, { type, defaultValue }...
+        ///   stateCount, initialState, { animationIndex, loop }...
+        ///   transitionCount, { from, to, blendDuration, exitTime, conditionCount, { parameter, op, value }... }...
+        ///
+        /// where every field is a little-endian int32 or float32.
+        /// Returns nullptr if [data] is malformed or refers to an invalid state/parameter.
+        ///
+        static std::shared_ptr<const AnimationStateMachine> parse(const uint8_t *data, size_t length)
+        {
+            Reader reader{data, length};
+            auto stateMachine = std::make_shared<AnimationStateMachine>();
+
+            if (reader.readInt() != kMagic || reader.readInt() != kVersion)
+            {
+                Log("ERROR: not a compiled animation state machine (or an unsupported version)");
+                return nullptr;
+            }
+
+            const int32_t parameterCount = reader.readInt();
+            for (int32_t i = 0; reader.ok && i < parameterCount; i++)
+            {
+                Parameter parameter;
+                parameter.type = ParameterType(reader.readInt());
+                parameter.defaultValue = reader.readFloat();
+                stateMachine->parameters.push_back(parameter);
+            }
+
+            const int32_t stateCount = reader.readInt();
+            stateMachine->initialState = reader.readInt();
+            for (int32_t i = 0; reader.ok && i < stateCount; i++)
+            {
+                State state;
+                state.animationIndex = reader.readInt();
+                state.loop = reader.readInt() != 0;
+                stateMachine->states.push_back(state);
+            }
+
+            const int32_t transitionCount = reader.readInt();
+            for (int32_t i = 0; reader.ok && i < transitionCount; i++)
+            {
+                Transition transition;
+                transition.from = reader.readInt();
+                transition.to = reader.readInt();
+                transition.blendDuration = reader.readFloat();
+                transition.exitTime = reader.readFloat();
+                const int32_t conditionCount = reader.readInt();
+                for (int32_t j = 0; reader.ok && j < conditionCount; j++)
+                {
+                    Condition condition;
+                    condition.parameter = reader.readInt();
+                    condition.op = ConditionOp(reader.readInt());
+                    condition.value = reader.readFloat();
+                    transition.conditions.push_back(condition);
+                }
+                stateMachine->transitions.push_back(std::move(transition));
+            }
+
+            if (!reader.ok || reader.offset != length)
+            {
+                Log("ERROR: malformed animation state machine (%zu bytes)", length);
+                return nullptr;
+            }
+            if (!stateMachine->validate())
+            {
+                return nullptr;
+            }
+            return stateMachine;
+        }
+
+        ///
+        /// Returns the index of the first transition (in the order they were defined) that can be taken from [state],
+        /// or -1 if none can be taken.
+        ///
+        int findTransition(int32_t state, float normalizedTime, const std::vector<float> &parameterValues) const
+        {
+            for (size_t i = 0; i < transitions.size(); i++)
+            {
+                const auto &transition = transitions[i];
+                if (transition.from != state && !(transition.from == kAnyState && transition.to != state))
+                {
+                    continue;
+                }
+                if (transition.exitTime >= 0.0f && normalizedTime < transition.exitTime)
+                {
+                    continue;
+                }
+                bool satisfied = true;
+                for (const auto &condition : transition.conditions)
+                {
+                    if (!test(condition, parameterValues[condition.parameter]))
+                    {
+                        satisfied = false;
+                        break;
+                    }
+                }
+                if (satisfied)
+                {
+                    return int(i);
+                }
+            }
+            return -1;
+        }
+
+    private:
+        struct Reader
+        {
+            const uint8_t *data;
+            size_t length;
+            size_t offset = 0;
+            bool ok = true;
+
+            int32_t readInt()
+            {
+                int32_t value = 0;
+                read(&value);
+                return value;
+            }
+
+            float readFloat()
+            {
+                float value = 0.0f;
+                read(&value);
+                return value;
+            }
+
+            template <typename T>
+            void read(T *value)
+            {
+                if (!ok || offset + sizeof(T) > length)
+                {
+                    ok = false;
+                    return;
+                }
+                std::memcpy(value, data + offset, sizeof(T));
+                offset += sizeof(T);
+            }
+        };
+
+        bool test(const Condition &condition, float value) const
+        {
+            if (parameters[condition.parameter].type != ParameterType::FLOAT)
+            {
+                // bools/triggers can only be compared for (in)equality; any other operator tests whether the value is set
+                const bool set = value != 0.0f;
+                const bool expected = condition.value != 0.0f;
+                switch (condition.op)
+                {
+                case ConditionOp::EQUAL:
+                    return set == expected;
+                case ConditionOp::NOT_EQUAL:
+                    return set != expected;
+                default:
+                    return set;
+                }
+            }
+            switch (condition.op)
+            {
+            case ConditionOp::GREATER:
+                return value > condition.value;
+            case ConditionOp::LESS:
+                return value < condition.value;
+            case ConditionOp::EQUAL:
+                return value == condition.value;
+            case ConditionOp::NOT_EQUAL:
+                return value != condition.value;
+            }
+            return false;
+        }
+
+        bool validate() const
+        {
+            const int32_t stateCount = int32_t(states.size());
+            const int32_t parameterCount = int32_t(parameters.size());
+            if (stateCount == 0 || initialState < 0 || initialState >= stateCount)
+            {
+                Log("ERROR: animation state machine has no states, or an invalid initial state");
+                return false;
+            }
+            for (const auto &parameter : parameters)
+            {
+                if (parameter.type < ParameterType::FLOAT || parameter.type > ParameterType::TRIGGER)
+                {
+                    Log("ERROR: invalid animation state machine parameter type");
+                    return false;
+                }
+            }
+            for (const auto &transition : transitions)
+            {
+                if ((transition.from != kAnyState && (transition.from < 0 || transition.from >= stateCount)) ||
+                    transition.to < 0 || transition.to >= stateCount)
+                {
+                    Log("ERROR: animation state machine transition refers to an invalid state");
+                    return false;
+                }
+                for (const auto &condition : transition.conditions)
+                {
+                    if (condition.parameter < 0 || condition.parameter >= parameterCount ||
+                        condition.op < ConditionOp::GREATER || condition.op > ConditionOp::NOT_EQUAL)
+                    {
+                        Log("ERROR: animation state machine condition refers to an invalid parameter or operator");
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+
+    //
+    // The runtime state of an AnimationStateMachine attached to an animation component.
+    //
+    struct AnimationStateMachineInstance
+    {
+        std::shared_ptr<const AnimationStateMachine> definition;
+        std::vector<float> parameterValues;
+        // the duration of the animation played by each state
+        std::vector<float> stateDurations;
+        int32_t state = -1;
+        std::chrono::time_point<std::chrono::high_resolution_clock> stateStart;
+    };
+}
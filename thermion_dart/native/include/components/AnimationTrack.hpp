@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <math/mat4.h>
+#include <math/quat.h>
+#include <math/vec3.h>
+
+#include <gltfio/math.h>
+
+namespace thermion
+{
+    using namespace filament;
+
+    //
+    // The maximum error permitted when removing keyframes from a clip.
+    // A keyframe is only removed if every frame it covers can be reconstructed (by interpolating the remaining keyframes)
+    // within these tolerances. A tolerance of zero keeps every keyframe.
+    //
+    struct TrackCompressionSettings
+    {
+        // in world units
+        float translationTolerance = 1e-4f;
+        // in radians
+        float rotationTolerance = 1e-4f;
+        float scaleTolerance = 1e-4f;
+    };
+
+    namespace track
+    {
+        // the maximum number of frames between two keyframes (this bounds the cost of compression, which is quadratic in the segment length)
+        static constexpr size_t kMaxSegmentLength = 256;
+
+        ///
+        /// Greedily selects the keyframes needed to reconstruct [numFrames] frames, where [exceeds(first, last, frame)] returns true
+        /// if interpolating between keyframes [first] and [last] doesn't reconstruct [frame] within tolerance.
+        ///
+        template <typename ExceedsTolerance>
+        std::vector<uint32_t> reduceKeyframes(size_t numFrames, ExceedsTolerance exceeds)
+        {
+            std::vector<uint32_t> keys;
+            if (numFrames == 0)
+            {
+                return keys;
+            }
+            keys.push_back(0);
+            size_t start = 0;
+            while (start + 1 < numFrames)
+            {
+                size_t end = start + 1;
+                // extend the segment while every frame it skips can be reconstructed within tolerance
+                while (end + 1 < numFrames && end + 1 - start <= kMaxSegmentLength)
+                {
+                    bool fits = true;
+                    for (size_t frame = start + 1; frame <= end; frame++)
+                    {
+                        if (exceeds(start, end + 1, frame))
+                        {
+                            fits = false;
+                            break;
+                        }
+                    }
+                    if (!fits)
+                    {
+                        break;
+                    }
+                    end++;
+                }
+                keys.push_back(uint32_t(end));
+                start = end;
+            }
+            return keys;
+        }
+
+        ///
+        /// Returns the index of the keyframe at or before [frame] (clamped so there's always a following keyframe),
+        /// and sets [t] to the interpolation weight between the two.
+        ///
+        inline size_t findSegment(const std::vector<uint32_t> &keys, float frame, float &t)
+        {
+            auto it = std::upper_bound(keys.begin(), keys.end(), frame, [](float f, uint32_t key)
+                                       { return f < float(key); });
+            size_t key = it == keys.begin() ? 0 : size_t(it - keys.begin()) - 1;
+            key = std::min(key, keys.size() - 2);
+            t = std::clamp((frame - float(keys[key])) / float(keys[key + 1] - keys[key]), 0.0f, 1.0f);
+            return key;
+        }
+
+        //
+        // A float3 channel, with each component quantized to 16 bits over the range of the channel.
+        //
+        struct Vec3Channel
+        {
+            std::vector<uint32_t> keys;
+            math::float3 min;
+            math::float3 extent;
+            std::vector<uint16_t> values;
+
+            math::float3 decode(size_t key) const
+            {
+                const uint16_t *value = values.data() + key * 3;
+                return min + extent * math::float3(value[0], value[1], value[2]) * (1.0f / 65535.0f);
+            }
+
+            math::float3 evaluate(float frame) const
+            {
+                if (keys.empty())
+                {
+                    return {};
+                }
+                if (keys.size() == 1)
+                {
+                    return decode(0);
+                }
+                float t;
+                const size_t key = findSegment(keys, frame, t);
+                return mix(decode(key), decode(key + 1), t);
+            }
+
+            size_t getSizeInBytes() const
+            {
+                return sizeof(Vec3Channel) + keys.size() * sizeof(uint32_t) + values.size() * sizeof(uint16_t);
+            }
+
+            static Vec3Channel compress(const std::vector<math::float3> &frames, float tolerance)
+            {
+                Vec3Channel channel;
+                if (frames.empty())
+                {
+                    return channel;
+                }
+                math::float3 max(std::numeric_limits<float>::lowest());
+                channel.min = math::float3(std::numeric_limits<float>::max());
+                for (const auto &frame : frames)
+                {
+                    for (int i = 0; i < 3; i++)
+                    {
+                        channel.min[i] = std::min(channel.min[i], frame[i]);
+                        max[i] = std::max(max[i], frame[i]);
+                    }
+                }
+                channel.extent = max - channel.min;
+
+                // keyframes are selected by the error of the *quantized* values, so the tolerance also accounts for quantization
+                std::vector<uint16_t> quantized(frames.size() * 3);
+                for (size_t frame = 0; frame < frames.size(); frame++)
+                {
+                    for (int i = 0; i < 3; i++)
+                    {
+                        const float normalized = channel.extent[i] > 0.0f ? (frames[frame][i] - channel.min[i]) / channel.extent[i] : 0.0f;
+                        quantized[frame * 3 + i] = uint16_t(std::lround(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+                    }
+                }
+                auto decode = [&](size_t frame)
+                {
+                    const uint16_t *value = quantized.data() + frame * 3;
+                    return channel.min + channel.extent * math::float3(value[0], value[1], value[2]) * (1.0f / 65535.0f);
+                };
+
+                bool constant = true;
+                for (size_t frame = 1; frame < frames.size() && constant; frame++)
+                {
+                    constant = length(frames[frame] - decode(0)) <= tolerance;
+                }
+
+                if (constant)
+                {
+                    channel.keys = {0};
+                }
+                else
+                {
+                    channel.keys = reduceKeyframes(frames.size(), [&](size_t first, size_t last, size_t frame)
+                                                   {
+                        const float t = float(frame - first) / float(last - first);
+                        return length(mix(decode(first), decode(last), t) - frames[frame]) > tolerance; });
+                }
+
+                channel.values.reserve(channel.keys.size() * 3);
+                for (auto key : channel.keys)
+                {
+                    channel.values.insert(channel.values.end(), quantized.begin() + key * 3, quantized.begin() + key * 3 + 3);
+                }
+                return channel;
+            }
+        };
+
+        //
+        // A rotation channel, with each component of the quaternion quantized to a signed 16 bit value.
+        //
+        struct RotationChannel
+        {
+            std::vector<uint32_t> keys;
+            std::vector<int16_t> values;
+
+            math::quatf decode(size_t key) const
+            {
+                const int16_t *value = values.data() + key * 4;
+                return math::quatf(value[3], value[0], value[1], value[2]) * (1.0f / 32767.0f);
+            }
+
+            math::quatf evaluate(float frame) const
+            {
+                if (keys.empty())
+                {
+                    return {};
+                }
+                if (keys.size() == 1)
+                {
+                    return normalize(decode(0));
+                }
+                float t;
+                const size_t key = findSegment(keys, frame, t);
+                // consecutive rotations are in the same hemisphere, so this doesn't need to check the sign
+                return normalize(lerp(decode(key), decode(key + 1), t));
+            }
+
+            size_t getSizeInBytes() const
+            {
+                return sizeof(RotationChannel) + keys.size() * sizeof(uint32_t) + values.size() * sizeof(int16_t);
+            }
+
+            static float angleBetween(const math::quatf &a, const math::quatf &b)
+            {
+                // acos(dot) can't resolve angles below ~7e-4 (the dot product rounds to 1), so this uses the relative rotation instead
+                const math::quatf relative = a * conj(b);
+                return 2.0f * std::atan2(length(relative.xyz), std::abs(relative.w));
+            }
+
+            static RotationChannel compress(const std::vector<math::quatf> &frames, float tolerance)
+            {
+                RotationChannel channel;
+                if (frames.empty())
+                {
+                    return channel;
+                }
+
+                std::vector<int16_t> quantized(frames.size() * 4);
+                for (size_t frame = 0; frame < frames.size(); frame++)
+                {
+                    for (int i = 0; i < 4; i++)
+                    {
+                        quantized[frame * 4 + i] = int16_t(std::lround(std::clamp(frames[frame].xyzw[i], -1.0f, 1.0f) * 32767.0f));
+                    }
+                }
+                auto decode = [&](size_t frame)
+                {
+                    const int16_t *value = quantized.data() + frame * 4;
+                    return math::quatf(value[3], value[0], value[1], value[2]) * (1.0f / 32767.0f);
+                };
+
+                bool constant = true;
+                for (size_t frame = 1; frame < frames.size() && constant; frame++)
+                {
+                    constant = angleBetween(frames[frame], normalize(decode(0))) <= tolerance;
+                }
+
+                if (constant)
+                {
+                    channel.keys = {0};
+                }
+                else
+                {
+                    channel.keys = reduceKeyframes(frames.size(), [&](size_t first, size_t last, size_t frame)
+                                                   {
+                        const float t = float(frame - first) / float(last - first);
+                        return angleBetween(normalize(lerp(decode(first), decode(last), t)), frames[frame]) > tolerance; });
+                }
+
+                channel.values.reserve(channel.keys.size() * 4);
+                for (auto key : channel.keys)
+                {
+                    channel.values.insert(channel.values.end(), quantized.begin() + key * 4, quantized.begin() + key * 4 + 4);
+                }
+                return channel;
+            }
+        };
+    }
+
+    //
+    // The keyframes of a joint transform, decomposed into separate (structure-of-arrays) translation/rotation/scale channels
+    // when the animation is added.
+    //
+    // Each channel is compressed independently: keyframes that can be reconstructed by interpolating their neighbours are
+    // removed, and the remaining values are quantized to 16 bits. Sampling a frame is a binary search over the remaining
+    // keyframes, then a lerp/nlerp between the two adjacent keyframes.
+    //
+    class TransformTrack
+    {
+    public:
+        static TransformTrack compress(const std::vector<math::mat4f> &frames, const TrackCompressionSettings &settings)
+        {
+            std::vector<math::float3> translations(frames.size());
+            std::vector<math::quatf> rotations(frames.size());
+            std::vector<math::float3> scales(frames.size());
+
+            for (size_t i = 0; i < frames.size(); i++)
+            {
+                gltfio::decomposeMatrix(frames[i], &translations[i], &rotations[i], &scales[i]);
+                // keep consecutive rotations in the same hemisphere so sampling never needs to flip the sign
+                if (i > 0 && dot(rotations[i - 1], rotations[i]) < 0.0f)
+                {
+                    rotations[i] = -rotations[i];
+                }
+            }
+
+            TransformTrack track;
+            track._numFrames = frames.size();
+            track._translations = track::Vec3Channel::compress(translations, settings.translationTolerance);
+            track._rotations = track::RotationChannel::compress(rotations, settings.rotationTolerance);
+            track._scales = track::Vec3Channel::compress(scales, settings.scaleTolerance);
+            return track;
+        }
+
+        size_t size() const
+        {
+            return _numFrames;
+        }
+
+        size_t getSizeInBytes() const
+        {
+            return _translations.getSizeInBytes() + _rotations.getSizeInBytes() + _scales.getSizeInBytes();
+        }
+
+        void sample(int currFrame, int nextFrame, float frameDelta, math::float3 &translation, math::quatf &rotation, math::float3 &scale) const
+        {
+            const float frame = frameDelta <= 0.0f ? float(currFrame) : float(currFrame) + float(nextFrame - currFrame) * frameDelta;
+            translation = _translations.evaluate(frame);
+            rotation = _rotations.evaluate(frame);
+            scale = _scales.evaluate(frame);
+        }
+
+    private:
+        size_t _numFrames = 0;
+        track::Vec3Channel _translations;
+        track::RotationChannel _rotations;
+        track::Vec3Channel _scales;
+    };
+
+    //
+    // Morph target weights for every frame of a morph animation, quantized to 16 bits over the range of each morph target.
+    //
+    class MorphTrack
+    {
+    public:
+        static MorphTrack compress(const float *const weights, int numFrames, int numMorphTargets)
+        {
+            MorphTrack track;
+            track._numMorphTargets = numMorphTargets;
+            track._min.assign(numMorphTargets, std::numeric_limits<float>::max());
+            track._extent.assign(numMorphTargets, 0.0f);
+            for (int target = 0; target < numMorphTargets; target++)
+            {
+                float max = std::numeric_limits<float>::lowest();
+                for (int frame = 0; frame < numFrames; frame++)
+                {
+                    const float weight = weights[frame * numMorphTargets + target];
+                    track._min[target] = std::min(track._min[target], weight);
+                    max = std::max(max, weight);
+                }
+                track._extent[target] = numFrames > 0 ? max - track._min[target] : 0.0f;
+            }
+            track._weights.resize(size_t(numFrames) * numMorphTargets);
+            for (size_t i = 0; i < track._weights.size(); i++)
+            {
+                const int target = int(i % numMorphTargets);
+                const float normalized = track._extent[target] > 0.0f ? (weights[i] - track._min[target]) / track._extent[target] : 0.0f;
+                track._weights[i] = uint16_t(std::lround(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+            }
+            return track;
+        }
+
+        float weight(int frame, int morphTarget) const
+        {
+            return _min[morphTarget] + _extent[morphTarget] * float(_weights[size_t(frame) * _numMorphTargets + morphTarget]) * (1.0f / 65535.0f);
+        }
+
+        size_t getSizeInBytes() const
+        {
+            return (_min.size() + _extent.size()) * sizeof(float) + _weights.size() * sizeof(uint16_t);
+        }
+
+    private:
+        int _numMorphTargets = 0;
+        std::vector<float> _min;
+        std::vector<float> _extent;
+        std::vector<uint16_t> _weights;
+    };
+}
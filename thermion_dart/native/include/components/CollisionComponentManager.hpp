@@ -1,5 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <utility>
+#include <vector>
+
 #include "utils/Entity.h"
 #include "utils/EntityInstance.h"
 #include "utils/SingleInstanceComponentManager.h"
@@ -7,94 +15,434 @@
 #include "gltfio/FilamentAsset.h"
 #include "gltfio/FilamentInstance.h"
 #include "Log.hpp"
+#include "OrientedBox.hpp"
+#include "components/AabbBatch.hpp"
+#include "components/AabbTree.hpp"
+#include "components/ObbBatch.hpp"
 
 namespace thermion
 {
 
 typedef void(*CollisionCallback)(int32_t entityId1, int32_t entityId2) ;
-class CollisionComponentManager : public utils::SingleInstanceComponentManager<filament::Aabb, CollisionCallback, bool> {
+
+enum class CollisionEventType : int32_t {
+    BEGIN,
+    PERSIST,
+    END
+};
+
+struct CollisionEvent {
+    CollisionEventType type;
+    int32_t entity1;
+    int32_t entity2;
+};
+
+enum class CollisionShapeType : int32_t {
+    // the bounding box of the entity, re-aligned with the world axes whenever the entity rotates
+    AABB,
+    // an oriented box, which rotates with the entity; initially the bounding box of the entity, then (if the mesh data is available)
+    // a box fitted to the vertices of the mesh
+    OBB
+};
+
+struct CollisionShape {
+    CollisionShapeType type = CollisionShapeType::AABB;
+    // the shape in the space of the entity
+    OrientedBox local;
+    // a tighter shape that is still being fitted (on a worker thread), if any; it replaces [local] once it's ready
+    std::shared_future<OrientedBox> fitted;
+    // [local] transformed by the world transform the proxy was last refit with (only used for OBBs)
+    OrientedBox world;
+};
+
+//
+// Elements: the (local) bounding box, the collision callback, whether collisions affect the transform,
+// the proxy in the broadphase tree, the world transform the proxy was last refit with, the world-space
+// bounding box for that transform and the collision shape.
+//
+// The broadphase only ever tests world-space bounding boxes; pairs whose boxes overlap are then tested with
+// their collision shapes if either is an OBB, so a rotated entity doesn't collide with everything near the
+// corners of its inflated bounding box.
+//
+class CollisionComponentManager : public utils::SingleInstanceComponentManager<filament::Aabb, CollisionCallback, bool, int32_t, filament::math::mat4f, filament::Aabb, CollisionShape> {
 
     const filament::TransformManager& _transformManager;
+    AabbTree _tree;
+    // scratch space for broadphase candidates
+    std::vector<Instance> _candidates;
+    // scratch space for the entities touched by a sweep, and the fraction of the movement at which each is touched
+    std::vector<std::pair<Instance, float>> _contacts;
+
+    // the (sorted) overlapping pairs found by the previous/current collision pass
+    std::vector<uint64_t> _previousPairs;
+    std::vector<uint64_t> _pairs;
+    std::vector<CollisionEvent> _events;
+    bool _eventsEnabled = false;
+
     public:
         CollisionComponentManager(const filament::TransformManager& transformManager) : _transformManager(transformManager) {}
-    
-        std::vector<filament::math::float3> collides(utils::Entity transformingEntity, filament::Aabb sourceBox) { 
-            auto sourceCorners = sourceBox.getCorners();
-            std::vector<filament::math::float3> collisionAxes;
+
+        ///
+        /// Makes [entity] collidable, with [shapeType] as its collision shape. For OBBs, [fitted] may be a (pending) box fitted to the
+        /// mesh of the entity; until it's ready (or if it's invalid), the oriented bounding box of the entity is used.
+        ///
+        Instance addComponent(utils::Entity entity, const filament::Aabb& boundingBox, CollisionCallback callback, bool affectsTransform,
+                CollisionShapeType shapeType = CollisionShapeType::AABB, std::shared_future<OrientedBox> fitted = {}) {
+            if(hasComponent(entity)) {
+                removeComponent(entity);
+            }
+            auto instance = SingleInstanceComponentManager::addComponent(entity);
+            auto worldTransform = _transformManager.getWorldTransform(_transformManager.getInstance(entity));
+            auto& shape = elementAt<6>(instance);
+            shape.type = shapeType;
+            shape.local = OrientedBox::fromAabb(boundingBox);
+            shape.fitted = std::move(fitted);
+            elementAt<0>(instance) = boundingBox;
+            elementAt<1>(instance) = callback;
+            elementAt<2>(instance) = affectsTransform;
+            elementAt<4>(instance) = worldTransform;
+            elementAt<5>(instance) = getWorldBoundingBox(instance, worldTransform);
+            elementAt<3>(instance) = _tree.createProxy(elementAt<5>(instance), entity);
+            return instance;
+        }
+
+        void removeComponent(utils::Entity entity) {
+            auto instance = getInstance(entity);
+            if(!instance) {
+                return;
+            }
+            _tree.destroyProxy(elementAt<3>(instance));
+            SingleInstanceComponentManager::removeComponent(entity);
+        }
+
+        ///
+        /// Moves the broadphase proxy of every collidable entity whose world transform has changed since the last refit.
+        /// Proxies are only reinserted into the tree when an entity moves outside its (fattened) box, so this is cheap
+        /// when few entities have moved. Call once before a batch of [collides] queries.
+        ///
+        void refit() {
             for(auto it = begin(); it < end(); it++) {
-                auto entity = getEntity(it);
+                auto worldTransform = _transformManager.getWorldTransform(_transformManager.getInstance(getEntity(it)));
+                auto& lastTransform = elementAt<4>(it);
+                auto& shape = elementAt<6>(it);
+                bool shapeChanged = false;
+                if(shape.fitted.valid() && shape.fitted.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    shape.local = shape.fitted.get();
+                    shape.fitted = {};
+                    shapeChanged = true;
+                }
+                if(!shapeChanged && memcmp(&worldTransform, &lastTransform, sizeof(worldTransform)) == 0) {
+                    continue;
+                }
+                lastTransform = worldTransform;
+                elementAt<5>(it) = getWorldBoundingBox(it, worldTransform);
+                _tree.moveProxy(elementAt<3>(it), elementAt<5>(it));
+            }
+        }
 
-                if(entity == transformingEntity) {
+        ///
+        /// Writes the collision shape of [entity] under [worldTransform] to [out] and returns true, or returns false if [entity]
+        /// doesn't collide as an OBB.
+        ///
+        bool getShape(utils::Entity entity, const filament::math::mat4f& worldTransform, OrientedBox& out) const {
+            auto instance = getInstance(entity);
+            if(!instance || elementAt<6>(instance).type != CollisionShapeType::OBB) {
+                return false;
+            }
+            out = elementAt<6>(instance).local.transform(worldTransform);
+            return true;
+        }
+
+        size_t getTreeHeight() const {
+            return _tree.getHeight();
+        }
+
+        ///
+        /// Tests [sourceBox] (the world-space bounding box of [transformingEntity]) against every other collidable entity,
+        /// invoking the collision callback of each entity it overlaps. If [sourceShape] isn't null, it's the (world-space)
+        /// oriented box of [transformingEntity], and is used instead of [sourceBox] once the bounding boxes overlap.
+        /// Returns the collision axis for each overlapping entity that affects transforms.
+        ///
+        std::vector<filament::math::float3> collides(utils::Entity transformingEntity, filament::Aabb sourceBox, const OrientedBox* sourceShape = nullptr) {
+            std::vector<filament::math::float3> collisionAxes;
+
+            // only the entities whose (fat) broadphase box overlaps the source box need to be tested
+            _candidates.clear();
+            _tree.query(sourceBox, [&](int32_t proxy) {
+                auto entity = _tree.getEntity(proxy);
+                if(entity != transformingEntity) {
+                    _candidates.push_back(getInstance(entity));
+                }
+                return true;
+            });
+
+            forEachOverlap(sourceBox, sourceShape, _candidates, [&](Instance it) {
+                if(elementAt<2>(it)) {
+                    collisionAxes.push_back(getCollisionAxis(sourceBox, elementAt<5>(it)));
+                }
+                auto callback = elementAt<1>(it);
+                if(callback) {
+                    callback(utils::Entity::smuggle(getEntity(it)), utils::Entity::smuggle(transformingEntity));
+                }
+            });
+
+            return collisionAxes;
+        }
+
+        ///
+        /// Sweeps the bounding box of [movingEntity] linearly from [startBox] to [endBox] (both in world space) and invokes the
+        /// collision callback of every entity it touches on the way. If [stopAtFirstContact] is true, the movement stops just before
+        /// the first entity that affects transforms; entities that are touched beyond that point aren't reported, and entities that
+        /// the box already overlaps at the start never stop it (so an entity can always be moved out of an overlap).
+        /// Returns the fraction of the movement that can be made (1 if nothing stops it).
+        ///
+        /// Rotation and scale are accounted for conservatively by sweeping a box as large as the larger of [startBox] and [endBox].
+        ///
+        float moveAndCollide(utils::Entity movingEntity, const filament::Aabb& startBox, const filament::Aabb& endBox, bool stopAtFirstContact) {
+            const float distance = length(endBox.center() - startBox.center());
+            float stop = 1.0f;
+            _contacts.clear();
+            sweep(movingEntity, startBox, endBox, [&](Instance other, float time) {
+                _contacts.emplace_back(other, time);
+                if(stopAtFirstContact && elementAt<2>(other) && time >= 0.0f) {
+                    stop = std::min(stop, time);
+                }
+            });
+            for(const auto& [other, time] : _contacts) {
+                if(time > stop) {
                     continue;
                 }
-                auto targetXformInstance = _transformManager.getInstance(entity);
-                auto targetXform = _transformManager.getWorldTransform(targetXformInstance);
-                auto targetBox = elementAt<0>(it).transform(targetXform);
-                auto targetCorners = targetBox.getCorners();
-
-                // Log("Checking collision for entity %d with aabb extent %f %f %f against source entity %d with aabb extent %f %f %f", entity, targetBox.extent().x, targetBox.extent().y, targetBox.extent().z, transformingEntityId, sourceBox.extent().x, sourceBox.extent().y, sourceBox.extent().z);
-
-                bool collided = false;
-
-                // iterate over every vertex in the source/target AABB
-                for(int i = 0; i < 8; i++) {
-                    auto intersecting = sourceCorners.vertices[i];
-                    auto min = targetBox.min;
-                    auto max = targetBox.max;
-                    
-                    // if the vertex has insersected with the target/source AABB
-                    if(targetBox.contains(sourceCorners.vertices[i]) <= 0) {
-                        collided = true;
-                        // Log("targetBox %f %f %f contains source vertex %f %f %f", targetBox.extent().x, targetBox.extent().y, targetBox.extent().z, sourceCorners.vertices[i].x, sourceCorners.vertices[i].y, sourceCorners.vertices[i].z);
-                    } else if(sourceBox.contains(targetCorners.vertices[i]) <= 0) {
-                        // Log("sourceBox %f %f %f contains target vertex %f %f %f", sourceBox.extent().x, sourceBox.extent().y, sourceBox.extent().z, targetCorners.vertices[i].x, targetCorners.vertices[i].y, targetCorners.vertices[i].z);
-                        collided = true;
-                        intersecting = targetCorners.vertices[i];
-                        min = sourceBox.min;
-                        max = sourceBox.max;
-                    } else { 
+                auto callback = elementAt<1>(other);
+                if(callback) {
+                    callback(utils::Entity::smuggle(getEntity(other)), utils::Entity::smuggle(movingEntity));
+                }
+            }
+            if(stop < 1.0f && distance > 0.0f) {
+                // back off slightly so the boxes don't end up touching (which counts as overlapping)
+                stop = std::max(0.0f, stop - kContactOffset / distance);
+            }
+            return stop;
+        }
+
+        ///
+        /// The fraction (in [0, 1]) of the linear movement of [startBox] to [endBox] at which the box of [movingEntity] first touches another
+        /// collidable entity (zero if it already overlaps one), or a negative value if it doesn't touch anything. The entity that is touched
+        /// first is written to [hit].
+        ///
+        float timeOfImpact(utils::Entity movingEntity, const filament::Aabb& startBox, const filament::Aabb& endBox, utils::Entity& hit) {
+            float first = std::numeric_limits<float>::infinity();
+            sweep(movingEntity, startBox, endBox, [&](Instance other, float time) {
+                time = std::max(time, 0.0f);
+                if(time < first) {
+                    first = time;
+                    hit = getEntity(other);
+                }
+            });
+            return first == std::numeric_limits<float>::infinity() ? -1.0f : first;
+        }
+
+        ///
+        /// Enables/disables the per-frame collision pass (see [update]).
+        ///
+        void setEventsEnabled(bool enabled) {
+            _eventsEnabled = enabled;
+            if(!enabled) {
+                _previousPairs.clear();
+                _events.clear();
+            }
+        }
+
+        bool isEventsEnabled() const {
+            return _eventsEnabled;
+        }
+
+        ///
+        /// Finds every pair of overlapping collidable entities and records a BEGIN/PERSIST/END event for each pair that
+        /// started overlapping/is still overlapping/stopped overlapping since the previous pass. Collision callbacks
+        /// are not invoked; events are instead accumulated until read with [drainEvents].
+        ///
+        void update() {
+            if(!_eventsEnabled) {
+                return;
+            }
+            refit();
+
+            _pairs.clear();
+            for(auto it = begin(); it < end(); it++) {
+                const auto entity = getEntity(it);
+                const auto& box = elementAt<5>(it);
+
+                // each pair is only reported by the entity with the lower ID
+                _candidates.clear();
+                _tree.query(box, [&](int32_t proxy) {
+                    auto other = _tree.getEntity(proxy);
+                    if(other.getId() > entity.getId()) {
+                        _candidates.push_back(getInstance(other));
+                    }
+                    return true;
+                });
+                const auto& shape = elementAt<6>(it);
+                forEachOverlap(box, shape.type == CollisionShapeType::OBB ? &shape.world : nullptr, _candidates, [&](Instance other) {
+                    _pairs.push_back(uint64_t(entity.getId()) << 32 | getEntity(other).getId());
+                });
+            }
+            std::sort(_pairs.begin(), _pairs.end());
+
+            // PERSIST events only describe the latest pass, but BEGIN/END events are kept until they have been read
+            _events.erase(std::remove_if(_events.begin(), _events.end(), [](const CollisionEvent& event) {
+                return event.type == CollisionEventType::PERSIST;
+            }), _events.end());
+
+            size_t i = 0, j = 0;
+            while(i < _previousPairs.size() || j < _pairs.size()) {
+                if(j == _pairs.size() || (i < _previousPairs.size() && _previousPairs[i] < _pairs[j])) {
+                    pushEvent(CollisionEventType::END, _previousPairs[i++]);
+                } else if(i == _previousPairs.size() || _pairs[j] < _previousPairs[i]) {
+                    pushEvent(CollisionEventType::BEGIN, _pairs[j++]);
+                } else {
+                    pushEvent(CollisionEventType::PERSIST, _pairs[j]);
+                    i++;
+                    j++;
+                }
+            }
+            std::swap(_previousPairs, _pairs);
+        }
+
+        size_t getEventCount() const {
+            return _events.size();
+        }
+
+        ///
+        /// Copies the pending collision events to [out] and clears them, unless there are more than [capacity] events
+        /// (in which case nothing is copied). Returns the number of pending events.
+        ///
+        size_t drainEvents(CollisionEvent* out, size_t capacity) {
+            const size_t count = _events.size();
+            if(count > capacity) {
+                return count;
+            }
+            std::copy(_events.begin(), _events.end(), out);
+            _events.clear();
+            return count;
+        }
+
+    private:
+        // the distance (in world units) kept between entities when a movement is stopped at the first contact
+        static constexpr float kContactOffset = 1e-4f;
+
+        // invokes [callback] with each collidable entity (other than [movingEntity]) touched by the box swept linearly from [startBox] to
+        // [endBox], and the fraction of the movement at which it's first touched (negative if the boxes overlap at the start)
+        template<typename Callback>
+        void sweep(utils::Entity movingEntity, const filament::Aabb& startBox, const filament::Aabb& endBox, Callback&& callback) {
+            const auto halfExtent = max(startBox.extent(), endBox.extent());
+            const auto start = startBox.center();
+            const auto displacement = endBox.center() - start;
+
+            // the broadphase is queried with the bounds of the whole sweep, then each candidate is tested as a ray (the center of the
+            // moving box) against the candidate's box grown by the half-extent of the moving box
+            const filament::Aabb bounds = { min(start, start + displacement) - halfExtent, max(start, start + displacement) + halfExtent };
+            _candidates.clear();
+            _tree.query(bounds, [&](int32_t proxy) {
+                auto entity = _tree.getEntity(proxy);
+                if(entity != movingEntity) {
+                    _candidates.push_back(getInstance(entity));
+                }
+                return true;
+            });
+
+            for(auto candidate : _candidates) {
+                const auto& box = elementAt<5>(candidate);
+                const auto lower = box.min - halfExtent;
+                const auto upper = box.max + halfExtent;
+                float enter = -std::numeric_limits<float>::infinity();
+                float exit = std::numeric_limits<float>::infinity();
+                for(int axis = 0; axis < 3; axis++) {
+                    if(displacement[axis] == 0.0f) {
+                        if(start[axis] < lower[axis] || start[axis] > upper[axis]) {
+                            enter = std::numeric_limits<float>::infinity();
+                            break;
+                        }
                         continue;
                     }
-                    auto affectsTransform = elementAt<2>(it);
-                    if(affectsTransform) {
-                        float xmin = min.x - intersecting.x;
-                        float ymin = min.y - intersecting.y;
-                        float zmin = min.z - intersecting.z;
-                        float xmax = intersecting.x - max.x;
-                        float ymax = intersecting.y - max.y;
-                        float zmax = intersecting.z - max.z;
-
-                        auto maxD = std::max(xmin,std::max(ymin,std::max(zmin,std::max(xmax,std::max(ymax,zmax)))));
-                        filament::math::float3 axis;
-                        if(maxD == xmin) {
-                            axis = {-1.0f,0.0f, 0.0f};
-                        } else if(maxD == ymin) {
-                            axis = {0.0f,-1.0f, 0.0f};
-                        } else if(maxD == zmin) {
-                            axis = {0.0f,0.0f, -1.0f};
-                        } else if(maxD == xmax) {
-                            axis = {1.0f,0.0f, 0.0f};
-                        } else if(maxD == ymax) {
-                        axis = {0.0f,1.0f, 0.0f};  
-                        } else { 
-                        axis = { 0.0f, 0.0f, 1.0f};
+                    float t0 = (lower[axis] - start[axis]) / displacement[axis];
+                    float t1 = (upper[axis] - start[axis]) / displacement[axis];
+                    if(t0 > t1) {
+                        std::swap(t0, t1);
+                    }
+                    enter = std::max(enter, t0);
+                    exit = std::min(exit, t1);
+                }
+                if(enter <= exit && enter <= 1.0f && exit >= 0.0f) {
+                    callback(candidate, enter);
+                }
+            }
+        }
+
+        void pushEvent(CollisionEventType type, uint64_t pair) {
+            _events.push_back({ type, int32_t(uint32_t(pair >> 32)), int32_t(uint32_t(pair)) });
+        }
+
+        // the world-space bounding box of [instance] (whose shape must be up to date) under [worldTransform], updating its
+        // world-space shape if it's an OBB
+        filament::Aabb getWorldBoundingBox(Instance instance, const filament::math::mat4f& worldTransform) {
+            auto& shape = elementAt<6>(instance);
+            if(shape.type != CollisionShapeType::OBB) {
+                return elementAt<0>(instance).transform(worldTransform);
+            }
+            shape.world = shape.local.transform(worldTransform);
+            return shape.world.getBounds();
+        }
+
+        // invokes [callback] with each of [candidates] that overlaps [box] (or [shape], if not null), testing four candidates at a time;
+        // the bounding boxes are tested first, then the oriented boxes of the candidates whose bounding boxes overlap, if either is an OBB
+        template<typename Callback>
+        void forEachOverlap(const filament::Aabb& box, const OrientedBox* shape, const std::vector<Instance>& candidates, Callback&& callback) {
+            for(size_t first = 0; first < candidates.size(); first += AabbBatch::kWidth) {
+                const size_t count = std::min<size_t>(AabbBatch::kWidth, candidates.size() - first);
+                AabbBatch batch;
+                for(size_t lane = 0; lane < count; lane++) {
+                    batch.set(int(lane), elementAt<5>(candidates[first + lane]));
+                }
+                uint32_t mask = overlapMask(box, batch);
+
+                bool needsShapes = shape != nullptr;
+                for(size_t lane = 0; lane < count && !needsShapes; lane++) {
+                    needsShapes = (mask >> lane & 1) && elementAt<6>(candidates[first + lane]).type == CollisionShapeType::OBB;
+                }
+                if(needsShapes) {
+                    ObbBatch shapes;
+                    for(size_t lane = 0; lane < count; lane++) {
+                        if(mask >> lane & 1) {
+                            const auto& candidate = elementAt<6>(candidates[first + lane]);
+                            shapes.set(int(lane), candidate.type == CollisionShapeType::OBB ? candidate.world : OrientedBox::fromAabb(elementAt<5>(candidates[first + lane])));
                         }
-                        collisionAxes.push_back(axis);                      
                     }
-                    break;
+                    mask &= overlapMask(shape ? *shape : OrientedBox::fromAabb(box), shapes);
                 }
-                if(collided) {
-                    auto callback = elementAt<1>(it);
-                    if(callback) {
-                        callback(utils::Entity::smuggle(entity), utils::Entity::smuggle(transformingEntity));
+
+                for(size_t lane = 0; mask; lane++, mask >>= 1) {
+                    if(mask & 1) {
+                        callback(candidates[first + lane]);
                     }
                 }
             }
-            
-            return collisionAxes;
+        }
+
+        // the axis along which [source] penetrates [target] the least, pointing from [target] towards [source]
+        static filament::math::float3 getCollisionAxis(const filament::Aabb& source, const filament::Aabb& target) {
+            const auto overlap = min(source.max, target.max) - max(source.min, target.min);
+            const auto direction = source.center() - target.center();
+            int axis = 0;
+            if(overlap.y < overlap[axis]) {
+                axis = 1;
+            }
+            if(overlap.z < overlap[axis]) {
+                axis = 2;
+            }
+            filament::math::float3 result = { 0.0f, 0.0f, 0.0f };
+            result[axis] = direction[axis] < 0.0f ? -1.0f : 1.0f;
+            return result;
         }
 };
 
 }
-
-
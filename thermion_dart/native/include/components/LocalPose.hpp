@@ -0,0 +1,346 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define THERMION_LOCAL_POSE_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define THERMION_LOCAL_POSE_NEON 1
+#endif
+
+#include <filament/TransformManager.h>
+#include <gltfio/math.h>
+#include <math/quat.h>
+#include <math/vec3.h>
+#include <utils/Entity.h>
+
+namespace thermion
+{
+
+    using namespace filament;
+
+    //
+    // The local transforms of every node of an instance (in the order of FilamentInstance::getEntities()), with each
+    // component of the translation/rotation/scale stored in its own array so poses can be blended four nodes at a time
+    // (see blendPoses). The arrays are padded to a multiple of kWidth with the identity transform.
+    //
+    struct LocalPose
+    {
+        static constexpr size_t kWidth = 4;
+
+        enum Component
+        {
+            TX,
+            TY,
+            TZ,
+            RX,
+            RY,
+            RZ,
+            RW,
+            SX,
+            SY,
+            SZ,
+            kNumComponents
+        };
+
+        size_t numNodes = 0;
+        std::vector<float> components[kNumComponents];
+
+        static size_t padded(size_t numNodes)
+        {
+            return (numNodes + kWidth - 1) / kWidth * kWidth;
+        }
+
+        void resize(size_t count)
+        {
+            numNodes = count;
+            for (int c = 0; c < kNumComponents; c++)
+            {
+                components[c].resize(padded(count), c == RW || c >= SX ? 1.0f : 0.0f);
+            }
+        }
+
+        void copyFrom(const LocalPose &other)
+        {
+            numNodes = other.numNodes;
+            for (int c = 0; c < kNumComponents; c++)
+            {
+                components[c].assign(other.components[c].begin(), other.components[c].end());
+            }
+        }
+
+        math::float3 getTranslation(size_t i) const { return {components[TX][i], components[TY][i], components[TZ][i]}; }
+        math::quatf getRotation(size_t i) const { return math::quatf(components[RW][i], components[RX][i], components[RY][i], components[RZ][i]); }
+        math::float3 getScale(size_t i) const { return {components[SX][i], components[SY][i], components[SZ][i]}; }
+
+        void setTranslation(size_t i, const math::float3 &t)
+        {
+            components[TX][i] = t.x;
+            components[TY][i] = t.y;
+            components[TZ][i] = t.z;
+        }
+
+        void setRotation(size_t i, const math::quatf &r)
+        {
+            components[RX][i] = r.x;
+            components[RY][i] = r.y;
+            components[RZ][i] = r.z;
+            components[RW][i] = r.w;
+        }
+
+        void setScale(size_t i, const math::float3 &s)
+        {
+            components[SX][i] = s.x;
+            components[SY][i] = s.y;
+            components[SZ][i] = s.z;
+        }
+
+        ///
+        /// Reads the local transform of each node in [entities] (or only the nodes with a non-zero weight in [mask], if not empty).
+        ///
+        void read(const TransformManager &tm, const utils::Entity *entities, size_t count, const std::vector<float> &mask)
+        {
+            if (numNodes != count)
+            {
+                resize(count);
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!mask.empty() && mask[i] <= 0.0f)
+                {
+                    continue;
+                }
+                math::float3 translation, scale;
+                math::quatf rotation;
+                gltfio::decomposeMatrix(tm.getTransform(tm.getInstance(entities[i])), &translation, &rotation, &scale);
+                setTranslation(i, translation);
+                setRotation(i, rotation);
+                setScale(i, scale);
+            }
+        }
+
+        ///
+        /// Sets the local transform of each node in [entities] (or only the nodes with a non-zero weight in [mask], if not empty).
+        ///
+        void write(TransformManager &tm, const utils::Entity *entities, size_t count, const std::vector<float> &mask) const
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!mask.empty() && mask[i] <= 0.0f)
+                {
+                    continue;
+                }
+                tm.setTransform(tm.getInstance(entities[i]), gltfio::composeMatrix(getTranslation(i), getRotation(i), getScale(i)));
+            }
+        }
+    };
+
+    //
+    // A pose blended by blendPoses, with the weight of each node (padded like the pose).
+    //
+    struct PoseLayer
+    {
+        const LocalPose *pose = nullptr;
+        const float *weights = nullptr;
+        // if true, the difference between [pose] and the reference pose is added, otherwise [pose] replaces the blended pose
+        bool additive = false;
+    };
+
+    namespace pose
+    {
+        // a minimal four-wide float vector, so the blend below is only written once for every instruction set
+#if defined(THERMION_LOCAL_POSE_SSE)
+        struct Lanes
+        {
+            __m128 v;
+        };
+        inline Lanes load(const float *p) { return {_mm_loadu_ps(p)}; }
+        inline void store(float *p, Lanes a) { _mm_storeu_ps(p, a.v); }
+        inline Lanes splat(float f) { return {_mm_set1_ps(f)}; }
+        inline Lanes operator+(Lanes a, Lanes b) { return {_mm_add_ps(a.v, b.v)}; }
+        inline Lanes operator-(Lanes a, Lanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+        inline Lanes operator*(Lanes a, Lanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+        inline Lanes operator/(Lanes a, Lanes b) { return {_mm_div_ps(a.v, b.v)}; }
+        inline Lanes rsqrt(Lanes a) { return {_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a.v))}; }
+        // -1 in the lanes where a < 0, otherwise 1
+        inline Lanes sign(Lanes a) { return {_mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(a.v, _mm_set1_ps(-0.0f)))}; }
+        // a in the lanes where condition != 0, otherwise b
+        inline Lanes selectNonZero(Lanes condition, Lanes a, Lanes b)
+        {
+            const __m128 mask = _mm_cmpneq_ps(condition.v, _mm_setzero_ps());
+            return {_mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v))};
+        }
+#elif defined(THERMION_LOCAL_POSE_NEON)
+        struct Lanes
+        {
+            float32x4_t v;
+        };
+        inline Lanes load(const float *p) { return {vld1q_f32(p)}; }
+        inline void store(float *p, Lanes a) { vst1q_f32(p, a.v); }
+        inline Lanes splat(float f) { return {vdupq_n_f32(f)}; }
+        inline Lanes operator+(Lanes a, Lanes b) { return {vaddq_f32(a.v, b.v)}; }
+        inline Lanes operator-(Lanes a, Lanes b) { return {vsubq_f32(a.v, b.v)}; }
+        inline Lanes operator*(Lanes a, Lanes b) { return {vmulq_f32(a.v, b.v)}; }
+        // 32-bit NEON has no division or square root, so both are refined from the hardware estimates
+        inline Lanes operator/(Lanes a, Lanes b)
+        {
+            float32x4_t reciprocal = vrecpeq_f32(b.v);
+            reciprocal = vmulq_f32(reciprocal, vrecpsq_f32(b.v, reciprocal));
+            reciprocal = vmulq_f32(reciprocal, vrecpsq_f32(b.v, reciprocal));
+            return {vmulq_f32(a.v, reciprocal)};
+        }
+        inline Lanes rsqrt(Lanes a)
+        {
+            float32x4_t estimate = vrsqrteq_f32(a.v);
+            estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+            estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+            return {estimate};
+        }
+        inline Lanes sign(Lanes a)
+        {
+            const uint32x4_t signBit = vandq_u32(vreinterpretq_u32_f32(a.v), vdupq_n_u32(0x80000000u));
+            return {vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(1.0f)), signBit))};
+        }
+        inline Lanes selectNonZero(Lanes condition, Lanes a, Lanes b)
+        {
+            const uint32x4_t mask = vmvnq_u32(vceqq_f32(condition.v, vdupq_n_f32(0.0f)));
+            return {vbslq_f32(mask, a.v, b.v)};
+        }
+#else
+        struct Lanes
+        {
+            float v[LocalPose::kWidth];
+        };
+        inline Lanes load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+        inline void store(float *p, Lanes a) { std::copy(a.v, a.v + LocalPose::kWidth, p); }
+        inline Lanes splat(float f) { return {{f, f, f, f}}; }
+        template <typename Op>
+        inline Lanes apply(Lanes a, Lanes b, Op op) { return {{op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3])}}; }
+        inline Lanes operator+(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+        inline Lanes operator-(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+        inline Lanes operator*(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+        inline Lanes operator/(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+        inline Lanes rsqrt(Lanes a) { return apply(a, a, [](float x, float) { return 1.0f / std::sqrt(x); }); }
+        inline Lanes sign(Lanes a) { return apply(a, a, [](float x, float) { return std::signbit(x) ? -1.0f : 1.0f; }); }
+        inline Lanes selectNonZero(Lanes condition, Lanes a, Lanes b)
+        {
+            Lanes result;
+            for (size_t i = 0; i < LocalPose::kWidth; i++)
+            {
+                result.v[i] = condition.v[i] != 0.0f ? a.v[i] : b.v[i];
+            }
+            return result;
+        }
+#endif
+
+        struct Quaternions
+        {
+            Lanes x, y, z, w;
+        };
+
+        inline Quaternions multiply(const Quaternions &a, const Quaternions &b)
+        {
+            return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+        }
+
+        inline Quaternions normalize(const Quaternions &q)
+        {
+            const Lanes scale = rsqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+            return {q.x * scale, q.y * scale, q.z * scale, q.w * scale};
+        }
+
+        // normalized linear interpolation from [a] to [b] (or -b, whichever is closer to [a])
+        inline Quaternions nlerp(const Quaternions &a, const Quaternions &b, Lanes t)
+        {
+            const Lanes bt = sign(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) * t;
+            const Lanes at = splat(1.0f) - t;
+            return normalize({a.x * at + b.x * bt, a.y * at + b.y * bt, a.z * at + b.z * bt, a.w * at + b.w * bt});
+        }
+    }
+
+    ///
+    /// Blends [layers] (in order) into [blended] in a single pass over the nodes, four nodes at a time. An override layer moves each
+    /// node towards its pose by its weight; an additive layer adds the difference between its pose and [reference], scaled by its weight.
+    /// Every pose must have the same number of nodes as [blended].
+    ///
+    inline void blendPoses(LocalPose &blended, const LocalPose &reference, const PoseLayer *layers, size_t numLayers)
+    {
+        using namespace pose;
+        using C = LocalPose::Component;
+
+        const Lanes one = splat(1.0f);
+        const size_t count = LocalPose::padded(blended.numNodes);
+        for (size_t i = 0; i < count; i += LocalPose::kWidth)
+        {
+            auto loadPose = [i](const LocalPose &p, Lanes *t, Quaternions &r, Lanes *s)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    t[c] = load(p.components[C::TX + c].data() + i);
+                    s[c] = load(p.components[C::SX + c].data() + i);
+                }
+                r = {load(p.components[C::RX].data() + i), load(p.components[C::RY].data() + i),
+                     load(p.components[C::RZ].data() + i), load(p.components[C::RW].data() + i)};
+            };
+
+            Lanes translation[3], scale[3];
+            Quaternions rotation;
+            loadPose(blended, translation, rotation, scale);
+
+            for (size_t l = 0; l < numLayers; l++)
+            {
+                const auto &layer = layers[l];
+                const Lanes weight = load(layer.weights + i);
+                Lanes layerTranslation[3], layerScale[3];
+                Quaternions layerRotation;
+                loadPose(*layer.pose, layerTranslation, layerRotation, layerScale);
+
+                if (!layer.additive)
+                {
+                    for (int c = 0; c < 3; c++)
+                    {
+                        translation[c] = translation[c] + (layerTranslation[c] - translation[c]) * weight;
+                        scale[c] = scale[c] + (layerScale[c] - scale[c]) * weight;
+                    }
+                    rotation = nlerp(rotation, layerRotation, weight);
+                    continue;
+                }
+
+                Lanes referenceTranslation[3], referenceScale[3];
+                Quaternions referenceRotation;
+                loadPose(reference, referenceTranslation, referenceRotation, referenceScale);
+                for (int c = 0; c < 3; c++)
+                {
+                    translation[c] = translation[c] + (layerTranslation[c] - referenceTranslation[c]) * weight;
+                    // a zero reference scale can't be divided out, so that component is left unchanged
+                    const Lanes ratio = selectNonZero(referenceScale[c], layerScale[c] / referenceScale[c], one);
+                    scale[c] = scale[c] * (one + (ratio - one) * weight);
+                }
+                // the reference rotation is a unit quaternion, so its inverse is its conjugate
+                const Quaternions inverseReference = {splat(0.0f) - referenceRotation.x, splat(0.0f) - referenceRotation.y,
+                                                      splat(0.0f) - referenceRotation.z, referenceRotation.w};
+                const Quaternions delta = multiply(layerRotation, inverseReference);
+                const Quaternions identity = {splat(0.0f), splat(0.0f), splat(0.0f), one};
+                rotation = normalize(multiply(nlerp(identity, delta, weight), rotation));
+            }
+
+            for (int c = 0; c < 3; c++)
+            {
+                store(blended.components[C::TX + c].data() + i, translation[c]);
+                store(blended.components[C::SX + c].data() + i, scale[c]);
+            }
+            store(blended.components[C::RX].data() + i, rotation.x);
+            store(blended.components[C::RY].data() + i, rotation.y);
+            store(blended.components[C::RZ].data() + i, rotation.z);
+            store(blended.components[C::RW].data() + i, rotation.w);
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define THERMION_OBB_BATCH_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define THERMION_OBB_BATCH_NEON 1
+#endif
+
+#include "OrientedBox.hpp"
+
+namespace thermion
+{
+
+    //
+    // Four oriented boxes in structure-of-arrays layout, so one box can be tested against all four with the separating axis
+    // test in a single pass (see overlapMask). Only the lanes that have been set can overlap anything.
+    //
+    struct alignas(16) ObbBatch
+    {
+        static constexpr int kWidth = 4;
+
+        float centerX[kWidth];
+        float centerY[kWidth];
+        float centerZ[kWidth];
+        // axes[3 * i + c] holds component c of axis i
+        float axes[9][kWidth];
+        float halfExtentX[kWidth];
+        float halfExtentY[kWidth];
+        float halfExtentZ[kWidth];
+        uint32_t lanes = 0;
+
+        ObbBatch()
+        {
+            for (int lane = 0; lane < kWidth; lane++)
+            {
+                set(lane, OrientedBox::fromAabb({math::float3(0.0f), math::float3(0.0f)}));
+            }
+            lanes = 0;
+        }
+
+        void set(int lane, const OrientedBox &box)
+        {
+            centerX[lane] = box.center.x;
+            centerY[lane] = box.center.y;
+            centerZ[lane] = box.center.z;
+            for (int i = 0; i < 3; i++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    axes[3 * i + c][lane] = box.axes[i][c];
+                }
+            }
+            halfExtentX[lane] = box.halfExtents.x;
+            halfExtentY[lane] = box.halfExtents.y;
+            halfExtentZ[lane] = box.halfExtents.z;
+            lanes |= 1u << lane;
+        }
+    };
+
+    namespace obb
+    {
+        // a minimal four-wide float vector, so the separating axis test below is only written once for every instruction set
+#if defined(THERMION_OBB_BATCH_SSE)
+        struct Lanes
+        {
+            __m128 v;
+        };
+        inline Lanes load(const float *p) { return {_mm_load_ps(p)}; }
+        inline Lanes splat(float f) { return {_mm_set1_ps(f)}; }
+        inline Lanes operator+(Lanes a, Lanes b) { return {_mm_add_ps(a.v, b.v)}; }
+        inline Lanes operator-(Lanes a, Lanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+        inline Lanes operator*(Lanes a, Lanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+        inline Lanes abs(Lanes a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+        // all ones in the lanes where a > b
+        inline Lanes greater(Lanes a, Lanes b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+        inline Lanes either(Lanes a, Lanes b) { return {_mm_or_ps(a.v, b.v)}; }
+        inline uint32_t bits(Lanes a) { return uint32_t(_mm_movemask_ps(a.v)); }
+#elif defined(THERMION_OBB_BATCH_NEON)
+        struct Lanes
+        {
+            float32x4_t v;
+        };
+        inline Lanes load(const float *p) { return {vld1q_f32(p)}; }
+        inline Lanes splat(float f) { return {vdupq_n_f32(f)}; }
+        inline Lanes operator+(Lanes a, Lanes b) { return {vaddq_f32(a.v, b.v)}; }
+        inline Lanes operator-(Lanes a, Lanes b) { return {vsubq_f32(a.v, b.v)}; }
+        inline Lanes operator*(Lanes a, Lanes b) { return {vmulq_f32(a.v, b.v)}; }
+        inline Lanes abs(Lanes a) { return {vabsq_f32(a.v)}; }
+        inline Lanes greater(Lanes a, Lanes b) { return {vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))}; }
+        inline Lanes either(Lanes a, Lanes b) { return {vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))}; }
+        inline uint32_t bits(Lanes a)
+        {
+            // every lane is either all ones or all zeros, so keep one bit per lane
+            static const uint32_t kLaneBits[4] = {1, 2, 4, 8};
+            const uint32x4_t masked = vandq_u32(vreinterpretq_u32_f32(a.v), vld1q_u32(kLaneBits));
+            return vgetq_lane_u32(masked, 0) | vgetq_lane_u32(masked, 1) | vgetq_lane_u32(masked, 2) | vgetq_lane_u32(masked, 3);
+        }
+#else
+        struct Lanes
+        {
+            float v[ObbBatch::kWidth];
+        };
+        inline Lanes load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+        inline Lanes splat(float f) { return {{f, f, f, f}}; }
+        template <typename Op>
+        inline Lanes apply(Lanes a, Lanes b, Op op) { return {{op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3])}}; }
+        inline Lanes operator+(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+        inline Lanes operator-(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+        inline Lanes operator*(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+        inline Lanes abs(Lanes a) { return {{std::abs(a.v[0]), std::abs(a.v[1]), std::abs(a.v[2]), std::abs(a.v[3])}}; }
+        inline Lanes greater(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x > y ? 1.0f : 0.0f; }); }
+        inline Lanes either(Lanes a, Lanes b) { return apply(a, b, [](float x, float y) { return x != 0.0f || y != 0.0f ? 1.0f : 0.0f; }); }
+        inline uint32_t bits(Lanes a) { return (a.v[0] != 0.0f ? 1u : 0u) | (a.v[1] != 0.0f ? 2u : 0u) | (a.v[2] != 0.0f ? 4u : 0u) | (a.v[3] != 0.0f ? 8u : 0u); }
+#endif
+    }
+
+    ///
+    /// Returns a bitmask of the lanes in [batch] that overlap [box] (boxes that only touch are considered overlapping), by testing the
+    /// fifteen potential separating axes (the three face normals of each box and the cross products of their edges) for all four lanes at once.
+    ///
+    inline uint32_t overlapMask(const OrientedBox &box, const ObbBatch &batch)
+    {
+        using namespace obb;
+
+        // a small tolerance added to the rotation terms, so that (nearly) parallel edges, whose cross product is (nearly) zero, can't
+        // produce a spurious separating axis
+        const Lanes epsilon = splat(1e-6f);
+
+        // the rotation of each lane relative to [box]: r[i][j] = dot(box.axes[i], lane axis j)
+        Lanes r[3][3], absR[3][3];
+        for (int i = 0; i < 3; i++)
+        {
+            const Lanes ax = splat(box.axes[i].x), ay = splat(box.axes[i].y), az = splat(box.axes[i].z);
+            for (int j = 0; j < 3; j++)
+            {
+                r[i][j] = ax * load(batch.axes[3 * j]) + ay * load(batch.axes[3 * j + 1]) + az * load(batch.axes[3 * j + 2]);
+                absR[i][j] = abs(r[i][j]) + epsilon;
+            }
+        }
+
+        // the offset of each lane from [box], in the frame of [box]
+        const Lanes dx = load(batch.centerX) - splat(box.center.x);
+        const Lanes dy = load(batch.centerY) - splat(box.center.y);
+        const Lanes dz = load(batch.centerZ) - splat(box.center.z);
+        Lanes t[3];
+        for (int i = 0; i < 3; i++)
+        {
+            t[i] = splat(box.axes[i].x) * dx + splat(box.axes[i].y) * dy + splat(box.axes[i].z) * dz;
+        }
+
+        const Lanes a[3] = {splat(box.halfExtents.x), splat(box.halfExtents.y), splat(box.halfExtents.z)};
+        const Lanes b[3] = {load(batch.halfExtentX), load(batch.halfExtentY), load(batch.halfExtentZ)};
+
+        Lanes separated = greater(splat(0.0f), splat(1.0f));
+
+        // the face normals of [box]
+        for (int i = 0; i < 3; i++)
+        {
+            separated = either(separated, greater(abs(t[i]), a[i] + b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2]));
+        }
+
+        // the face normals of each lane
+        for (int j = 0; j < 3; j++)
+        {
+            const Lanes distance = abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]);
+            separated = either(separated, greater(distance, a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j] + b[j]));
+        }
+
+        // the cross products of the edges of [box] and the edges of each lane
+        for (int i = 0; i < 3; i++)
+        {
+            const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            for (int j = 0; j < 3; j++)
+            {
+                const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                const Lanes distance = abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]);
+                const Lanes radiusA = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+                const Lanes radiusB = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+                separated = either(separated, greater(distance, radiusA + radiusB));
+            }
+        }
+
+        return ~bits(separated) & batch.lanes;
+    }
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "utils/Entity.h"
+#include "utils/EntityInstance.h"
+#include "utils/SingleInstanceComponentManager.h"
+#include "filament/RenderableManager.h"
+#include "filament/TransformManager.h"
+#include "math/mat4.h"
+#include "Log.hpp"
+#include "MeshBvh.hpp"
+#include "ThreadPool.hpp"
+#include "components/AabbTree.hpp"
+
+namespace thermion
+{
+
+using MeshBvhFuture = std::shared_future<std::shared_ptr<const MeshBvh>>;
+
+struct RaycastHit {
+    utils::Entity entity;
+    MeshBvh::Hit hit;
+};
+
+//
+// Elements: the (possibly still building) triangle BVH of the renderable, its bounding box in object space, the proxy
+// in the top-level tree, the world transform the proxy was last refit with and the inverse of that transform.
+//
+// BVHs are immutable and shared between every instance of the same mesh; they are built on worker threads (where
+// available) so registering a large mesh doesn't stall the caller. A renderable is not hit by rays until its BVH is ready.
+//
+class RaycastComponentManager : public utils::SingleInstanceComponentManager<MeshBvhFuture, filament::Aabb, int32_t, filament::math::mat4f, filament::math::mat4f> {
+
+    const filament::TransformManager& _transformManager;
+    const filament::RenderableManager& _renderableManager;
+    AabbTree _tree;
+    ThreadPool* _pool = nullptr;
+    // scratch space for the hits found by the current raycast, sorted by distance
+    std::vector<RaycastHit> _hits;
+
+    public:
+        ///
+        /// BVHs are built on [pool] if it isn't null (the pool must outlive this manager), otherwise on the calling thread.
+        ///
+        RaycastComponentManager(const filament::TransformManager& transformManager, const filament::RenderableManager& renderableManager, ThreadPool* pool) :
+            _transformManager(transformManager), _renderableManager(renderableManager), _pool(pool) {}
+
+        ///
+        /// Starts building a BVH over the given triangles (see MeshBvh::build), on a worker thread if one is available.
+        ///
+        MeshBvhFuture buildBvh(std::vector<filament::math::float3>&& positions, std::vector<filament::math::float2>&& uvs, std::vector<uint32_t>&& indices) {
+            std::packaged_task<std::shared_ptr<const MeshBvh>()> task([positions = std::move(positions), uvs = std::move(uvs), indices = std::move(indices)]() mutable {
+                return MeshBvh::build(std::move(positions), std::move(uvs), std::move(indices));
+            });
+            if(_pool) {
+                return _pool->add_task(task).share();
+            }
+            auto future = task.get_future();
+            task();
+            return future.share();
+        }
+
+        ///
+        /// Makes [entity] (which must be a renderable) hit by rays, using the triangles in [bvh]. [localBounds] is the
+        /// bounding box of the mesh in object space.
+        ///
+        Instance addComponent(utils::Entity entity, MeshBvhFuture bvh, const filament::Aabb& localBounds) {
+            if(hasComponent(entity)) {
+                removeComponent(entity);
+            }
+            auto instance = SingleInstanceComponentManager::addComponent(entity);
+            auto worldTransform = _transformManager.getWorldTransform(_transformManager.getInstance(entity));
+            elementAt<0>(instance) = std::move(bvh);
+            elementAt<1>(instance) = localBounds;
+            elementAt<2>(instance) = _tree.createProxy(localBounds.transform(worldTransform), entity);
+            elementAt<3>(instance) = worldTransform;
+            elementAt<4>(instance) = inverse(worldTransform);
+            return instance;
+        }
+
+        ///
+        /// The (possibly still building) BVH of [entity], or an invalid future if [entity] has no raycast component.
+        ///
+        MeshBvhFuture getBvh(utils::Entity entity) const {
+            auto instance = getInstance(entity);
+            return instance ? elementAt<0>(instance) : MeshBvhFuture();
+        }
+
+        void removeComponent(utils::Entity entity) {
+            auto instance = getInstance(entity);
+            if(!instance) {
+                return;
+            }
+            _tree.destroyProxy(elementAt<2>(instance));
+            SingleInstanceComponentManager::removeComponent(entity);
+        }
+
+        void clear() {
+            while(getComponentCount() > 0) {
+                removeComponent(getEntity(begin()));
+            }
+        }
+
+        ///
+        /// Moves the proxy of every entity whose world transform has changed since the last refit.
+        ///
+        void refit() {
+            for(auto it = begin(); it < end(); it++) {
+                auto worldTransform = _transformManager.getWorldTransform(_transformManager.getInstance(getEntity(it)));
+                auto& lastTransform = elementAt<3>(it);
+                if(memcmp(&worldTransform, &lastTransform, sizeof(worldTransform)) == 0) {
+                    continue;
+                }
+                lastTransform = worldTransform;
+                elementAt<4>(it) = inverse(worldTransform);
+                _tree.moveProxy(elementAt<2>(it), elementAt<1>(it).transform(worldTransform));
+            }
+        }
+
+        ///
+        /// Finds the (at most [maxHits]) closest renderables hit by the ray [origin] + t * [direction] for t in [0, maxDistance],
+        /// ignoring any renderable whose layer mask doesn't intersect [layerMask]. Each renderable is reported at most once,
+        /// with its closest hit. Hits are written to [out] in order of increasing distance; returns the number of hits.
+        /// Call [refit] first if any transforms may have changed since the last raycast.
+        ///
+        size_t raycast(const filament::math::float3& origin, const filament::math::float3& direction, float maxDistance, uint8_t layerMask, RaycastHit* out, size_t maxHits) {
+            return raycast(origin, direction, maxDistance, layerMask, out, maxHits, [](utils::Entity) { return true; });
+        }
+
+        ///
+        /// As above, but also ignores any renderable for which [filter] returns false.
+        ///
+        template<typename Filter>
+        size_t raycast(const filament::math::float3& origin, const filament::math::float3& direction, float maxDistance, uint8_t layerMask, RaycastHit* out, size_t maxHits, Filter&& filter) {
+            const float length = std::sqrt(dot(direction, direction));
+            if(maxHits == 0 || !(length > 0.0f)) {
+                return 0;
+            }
+            const auto normalizedDirection = direction / length;
+
+            _hits.clear();
+            _tree.raycast(origin, normalizedDirection, maxDistance, [&](int32_t proxy) {
+                auto entity = _tree.getEntity(proxy);
+                auto instance = getInstance(entity);
+                const float cutoff = _hits.size() == maxHits ? _hits.back().hit.distance : maxDistance;
+
+                auto renderableInstance = _renderableManager.getInstance(entity);
+                if(!renderableInstance.isValid() || (_renderableManager.getLayerMask(renderableInstance) & layerMask) == 0 || !filter(entity)) {
+                    return cutoff;
+                }
+                const auto& future = elementAt<0>(instance);
+                if(!future.valid() || future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    return cutoff;
+                }
+                const auto& bvh = future.get();
+                if(!bvh) {
+                    return cutoff;
+                }
+
+                // the direction isn't renormalized, so the ray parameter in object space is still the world-space distance
+                const auto& inverseWorld = elementAt<4>(instance);
+                const auto localOrigin = (inverseWorld * filament::math::float4(origin, 1.0f)).xyz;
+                const auto localDirection = (inverseWorld * filament::math::float4(normalizedDirection, 0.0f)).xyz;
+                MeshBvh::Hit hit;
+                if(!bvh->raycast(localOrigin, localDirection, cutoff, hit)) {
+                    return cutoff;
+                }
+
+                auto position = std::upper_bound(_hits.begin(), _hits.end(), hit.distance, [](float distance, const RaycastHit& other) {
+                    return distance < other.hit.distance;
+                });
+                _hits.insert(position, { entity, hit });
+                if(_hits.size() > maxHits) {
+                    _hits.pop_back();
+                }
+                return _hits.size() == maxHits ? _hits.back().hit.distance : maxDistance;
+            });
+
+            std::copy(_hits.begin(), _hits.end(), out);
+            return _hits.size();
+        }
+};
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "utils/Entity.h"
+#include "utils/EntityInstance.h"
+#include "utils/SingleInstanceComponentManager.h"
+#include "filament/Box.h"
+#include "filament/Frustum.h"
+#include "filament/TransformManager.h"
+#include "components/AabbTree.hpp"
+
+namespace thermion
+{
+
+//
+// A spatial index over the world-space bounding boxes of renderables, for region, visibility and proximity queries.
+//
+// Elements: the (local) bounding box, the proxy in the tree, the world transform the proxy was last refit with and the
+// world-space bounding box for that transform.
+//
+// The index is refit lazily (before each query) by comparing world transforms, and proxies are only reinserted
+// into the tree when an entity moves outside its fattened box.
+//
+class SpatialIndexComponentManager : public utils::SingleInstanceComponentManager<filament::Aabb, int32_t, filament::math::mat4f, filament::Aabb> {
+
+    const filament::TransformManager& _transformManager;
+    AabbTree _tree;
+    // scratch space for k-nearest queries
+    std::vector<std::pair<float, int32_t>> _nearest;
+
+    public:
+        SpatialIndexComponentManager(const filament::TransformManager& transformManager) : _transformManager(transformManager) {}
+
+        Instance addComponent(utils::Entity entity, const filament::Aabb& boundingBox) {
+            if(hasComponent(entity)) {
+                removeComponent(entity);
+            }
+            auto instance = SingleInstanceComponentManager::addComponent(entity);
+            auto worldTransform = _transformManager.getWorldTransform(_transformManager.getInstance(entity));
+            auto worldBox = boundingBox.transform(worldTransform);
+            elementAt<0>(instance) = boundingBox;
+            elementAt<1>(instance) = _tree.createProxy(worldBox, entity);
+            elementAt<2>(instance) = worldTransform;
+            elementAt<3>(instance) = worldBox;
+            return instance;
+        }
+
+        void removeComponent(utils::Entity entity) {
+            auto instance = getInstance(entity);
+            if(!instance) {
+                return;
+            }
+            _tree.destroyProxy(elementAt<1>(instance));
+            SingleInstanceComponentManager::removeComponent(entity);
+        }
+
+        ///
+        /// Moves the proxy of every entity whose world transform has changed since the last refit.
+        ///
+        void refit() {
+            for(auto it = begin(); it < end(); it++) {
+                auto worldTransform = _transformManager.getWorldTransform(_transformManager.getInstance(getEntity(it)));
+                auto& lastTransform = elementAt<2>(it);
+                if(memcmp(&worldTransform, &lastTransform, sizeof(worldTransform)) == 0) {
+                    continue;
+                }
+                lastTransform = worldTransform;
+                elementAt<3>(it) = elementAt<0>(it).transform(worldTransform);
+                _tree.moveProxy(elementAt<1>(it), elementAt<3>(it));
+            }
+        }
+
+        const filament::Aabb& getWorldBoundingBox(utils::Entity entity) const {
+            return elementAt<3>(getInstance(entity));
+        }
+
+        ///
+        /// Invokes [callback] with every entity whose world-space bounding box overlaps [box].
+        ///
+        template<typename Callback>
+        void queryBox(const filament::Aabb& box, Callback&& callback) {
+            refit();
+            _tree.query(box, [&](int32_t proxy) {
+                auto entity = _tree.getEntity(proxy);
+                if(AabbTree::overlaps(elementAt<3>(getInstance(entity)), box)) {
+                    callback(entity);
+                }
+                return true;
+            });
+        }
+
+        ///
+        /// Invokes [callback] with every entity whose world-space bounding box intersects the sphere at [center] with [radius].
+        ///
+        template<typename Callback>
+        void querySphere(const filament::math::float3& center, float radius, Callback&& callback) {
+            refit();
+            const float radiusSquared = radius * radius;
+            _tree.queryIf([&](const filament::Aabb& box) {
+                return AabbTree::distanceSquared(box, center) <= radiusSquared;
+            }, [&](int32_t proxy) {
+                auto entity = _tree.getEntity(proxy);
+                if(AabbTree::distanceSquared(elementAt<3>(getInstance(entity)), center) <= radiusSquared) {
+                    callback(entity);
+                }
+                return true;
+            });
+        }
+
+        ///
+        /// Invokes [callback] with every entity whose world-space bounding box intersects [frustum]. As with culling,
+        /// this is conservative; a box near a corner of the frustum may be reported even if it is just outside.
+        ///
+        template<typename Callback>
+        void queryFrustum(const filament::Frustum& frustum, Callback&& callback) {
+            refit();
+            _tree.queryIf([&](const filament::Aabb& box) {
+                return frustum.intersects(filament::Box().set(box.min, box.max));
+            }, [&](int32_t proxy) {
+                auto entity = _tree.getEntity(proxy);
+                const auto& box = elementAt<3>(getInstance(entity));
+                if(frustum.intersects(filament::Box().set(box.min, box.max))) {
+                    callback(entity);
+                }
+                return true;
+            });
+        }
+
+        ///
+        /// Invokes [callback] with (at most) the [k] entities whose world-space bounding boxes are closest to [point]
+        /// and for which [filter] returns true, in order of increasing distance. Entities whose boxes contain [point]
+        /// are at distance zero.
+        ///
+        template<typename Filter, typename Callback>
+        void queryNearest(const filament::math::float3& point, size_t k, Filter&& filter, Callback&& callback) {
+            refit();
+            _tree.nearest(point, k, [&](int32_t proxy) {
+                auto entity = _tree.getEntity(proxy);
+                if(!filter(entity)) {
+                    return std::numeric_limits<float>::infinity();
+                }
+                return AabbTree::distanceSquared(elementAt<3>(getInstance(entity)), point);
+            }, _nearest);
+            for(const auto& [distanceSquared, proxy] : _nearest) {
+                callback(_tree.getEntity(proxy), std::sqrt(distanceSquared));
+            }
+        }
+};
+
+}
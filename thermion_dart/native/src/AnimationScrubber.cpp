@@ -0,0 +1,437 @@
+#include "AnimationScrubber.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <filament/RenderableManager.h>
+#include <filament/TransformManager.h>
+#include <math/mat4.h>
+
+#include "cgltf.h"
+#include "Log.hpp"
+
+namespace thermion
+{
+
+    using namespace utils;
+
+    // keyframes closer together than this are assumed to be duplicates
+    static constexpr float kMinKeyframeInterval = 1e-4f;
+
+    std::vector<float> AnimationScrubber::computeFrameRates(const cgltf_data *data)
+    {
+        std::vector<float> frameRates;
+        if (!data)
+        {
+            return frameRates;
+        }
+        for (cgltf_size a = 0; a < data->animations_count; a++)
+        {
+            const auto &animation = data->animations[a];
+            float minInterval = 0.0f;
+            for (cgltf_size s = 0; s < animation.samplers_count; s++)
+            {
+                const cgltf_accessor *input = animation.samplers[s].input;
+                if (!input)
+                {
+                    continue;
+                }
+                float previous = 0.0f;
+                for (cgltf_size k = 0; k < input->count; k++)
+                {
+                    float time = 0.0f;
+                    if (!cgltf_accessor_read_float(input, k, &time, 1))
+                    {
+                        break;
+                    }
+                    const float interval = time - previous;
+                    if (k > 0 && interval > kMinKeyframeInterval && (minInterval == 0.0f || interval < minInterval))
+                    {
+                        minInterval = interval;
+                    }
+                    previous = time;
+                }
+            }
+            if (minInterval == 0.0f)
+            {
+                frameRates.push_back(kDefaultFrameRate);
+                continue;
+            }
+            // keyframe times are rounded when exported, so snap to the nearest whole frame rate if it's close enough
+            const float frameRate = 1.0f / minInterval;
+            const float rounded = std::round(frameRate);
+            frameRates.push_back(std::abs(frameRate - rounded) < frameRate * 0.01f ? rounded : frameRate);
+        }
+        return frameRates;
+    }
+
+    AnimationScrubber *AnimationScrubber::create(Engine *engine, const FilamentAsset *asset, FilamentInstance *instance)
+    {
+        // getSourceAsset is only a getter, but isn't declared const
+        const auto *data = static_cast<const cgltf_data *>(const_cast<FilamentAsset *>(asset)->getSourceAsset());
+        if (!data)
+        {
+            return nullptr;
+        }
+
+        auto *scrubber = new AnimationScrubber(engine, data);
+        scrubber->_nodes.resize(data->nodes_count);
+        scrubber->_clips.resize(data->animations_count);
+
+        // joints are matched exactly via the skins of the instance, any other nodes are matched by name
+        for (cgltf_size s = 0; s < data->skins_count && s < instance->getSkinCount(); s++)
+        {
+            const auto &skin = data->skins[s];
+            const Entity *joints = instance->getJointsAt(s);
+            const size_t jointCount = std::min(skin.joints_count, instance->getJointCountAt(s));
+            for (size_t j = 0; j < jointCount; j++)
+            {
+                scrubber->_nodes[skin.joints[j] - data->nodes].entity = joints[j];
+            }
+        }
+
+        const Entity *entities = instance->getEntities();
+        const size_t numEntities = instance->getEntityCount();
+
+        for (cgltf_size n = 0; n < data->nodes_count; n++)
+        {
+            const cgltf_node &node = data->nodes[n];
+            auto &target = scrubber->_nodes[n];
+            if (!target.entity && node.name)
+            {
+                for (size_t i = 0; i < numEntities; i++)
+                {
+                    const char *name = asset->getName(entities[i]);
+                    if (name && strcmp(name, node.name) == 0)
+                    {
+                        target.entity = entities[i];
+                        break;
+                    }
+                }
+            }
+            if (target.entity)
+            {
+                const auto match = std::find(entities, entities + numEntities, target.entity);
+                target.poseIndex = match == entities + numEntities ? -1 : int(match - entities);
+            }
+
+            // the rest pose, used for any paths that an animation doesn't target
+            if (node.has_matrix)
+            {
+                math::mat4f matrix;
+                std::memcpy(&matrix[0][0], node.matrix, sizeof(node.matrix));
+                target.translation = matrix[3].xyz;
+                target.scale = math::float3(std::sqrt(dot(matrix[0].xyz, matrix[0].xyz)),
+                                            std::sqrt(dot(matrix[1].xyz, matrix[1].xyz)),
+                                            std::sqrt(dot(matrix[2].xyz, matrix[2].xyz)));
+                target.rotation = math::mat3f(matrix[0].xyz / target.scale.x,
+                                              matrix[1].xyz / target.scale.y,
+                                              matrix[2].xyz / target.scale.z)
+                                      .toQuaternion();
+            }
+            else
+            {
+                if (node.has_translation)
+                {
+                    target.translation = math::float3(node.translation[0], node.translation[1], node.translation[2]);
+                }
+                if (node.has_rotation)
+                {
+                    target.rotation = math::quatf(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
+                }
+                if (node.has_scale)
+                {
+                    target.scale = math::float3(node.scale[0], node.scale[1], node.scale[2]);
+                }
+            }
+        }
+        return scrubber;
+    }
+
+    AnimationScrubber::Clip *AnimationScrubber::getClip(int animationIndex)
+    {
+        if (animationIndex < 0 || size_t(animationIndex) >= _clips.size())
+        {
+            return nullptr;
+        }
+        auto &clip = _clips[animationIndex];
+        if (clip)
+        {
+            return clip.get();
+        }
+
+        clip = std::make_unique<Clip>();
+        const auto &animation = _data->animations[animationIndex];
+        for (cgltf_size c = 0; c < animation.channels_count; c++)
+        {
+            const auto &source = animation.channels[c];
+            if (!source.target_node || !source.sampler || !source.sampler->input || !source.sampler->output)
+            {
+                continue;
+            }
+            const int node = int(source.target_node - _data->nodes);
+            if (!_nodes[node].entity)
+            {
+                continue;
+            }
+
+            Channel channel;
+            channel.node = node;
+            switch (source.target_path)
+            {
+            case cgltf_animation_path_type_translation:
+                channel.path = Path::TRANSLATION;
+                channel.components = 3;
+                break;
+            case cgltf_animation_path_type_rotation:
+                channel.path = Path::ROTATION;
+                channel.components = 4;
+                break;
+            case cgltf_animation_path_type_scale:
+                channel.path = Path::SCALE;
+                channel.components = 3;
+                break;
+            case cgltf_animation_path_type_weights:
+                channel.path = Path::WEIGHTS;
+                break;
+            default:
+                continue;
+            }
+            switch (source.sampler->interpolation)
+            {
+            case cgltf_interpolation_type_step:
+                channel.interpolation = Interpolation::STEP;
+                break;
+            case cgltf_interpolation_type_cubic_spline:
+                channel.interpolation = Interpolation::CUBIC_SPLINE;
+                break;
+            default:
+                channel.interpolation = Interpolation::LINEAR;
+                break;
+            }
+
+            const cgltf_accessor *input = source.sampler->input;
+            const cgltf_accessor *output = source.sampler->output;
+            const size_t valuesPerKeyframe = channel.interpolation == Interpolation::CUBIC_SPLINE ? 3 : 1;
+            if (input->count == 0)
+            {
+                continue;
+            }
+            if (channel.path == Path::WEIGHTS)
+            {
+                // the output of a weights sampler is a flat list of scalars
+                channel.components = uint32_t(output->count / (input->count * valuesPerKeyframe));
+            }
+            if (channel.components == 0 || output->count * cgltf_num_components(output->type) < input->count * valuesPerKeyframe * channel.components)
+            {
+                Log("Warning: skipping malformed channel %zu in animation %d", c, animationIndex);
+                continue;
+            }
+
+            channel.times.resize(input->count);
+            cgltf_accessor_unpack_floats(input, channel.times.data(), channel.times.size());
+            channel.values.resize(input->count * valuesPerKeyframe * channel.components);
+            cgltf_accessor_unpack_floats(output, channel.values.data(), channel.values.size());
+
+            clip->duration = std::max(clip->duration, channel.times.back());
+            auto &nodes = channel.path == Path::WEIGHTS ? clip->morphNodes : clip->nodes;
+            if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+            {
+                nodes.push_back(node);
+            }
+            clip->channels.push_back(std::move(channel));
+        }
+        return clip.get();
+    }
+
+    size_t AnimationScrubber::findKeyframe(Channel &channel, float timeInSecs) const
+    {
+        const auto &times = channel.times;
+        const size_t last = times.size() - 1;
+        size_t keyframe = std::min(channel.cursor, last);
+
+        if (times[keyframe] <= timeInSecs)
+        {
+            // playing forwards (or paused): step over the next few keyframes before resorting to a binary search
+            size_t steps = 0;
+            while (keyframe < last && times[keyframe + 1] <= timeInSecs && steps < kMaxLinearSteps)
+            {
+                keyframe++;
+                steps++;
+            }
+            if (keyframe == last || times[keyframe + 1] > timeInSecs)
+            {
+                channel.cursor = keyframe;
+                return keyframe;
+            }
+        }
+        else if (keyframe > 0 && times[keyframe - 1] <= timeInSecs)
+        {
+            // playing backwards
+            channel.cursor = keyframe - 1;
+            return keyframe - 1;
+        }
+
+        const auto upper = std::upper_bound(times.begin(), times.end(), timeInSecs);
+        keyframe = upper == times.begin() ? 0 : size_t(upper - times.begin()) - 1;
+        channel.cursor = keyframe;
+        return keyframe;
+    }
+
+    void AnimationScrubber::evaluate(const Channel &channel, size_t keyframe, float timeInSecs, float *out) const
+    {
+        const uint32_t n = channel.components;
+        const bool cubic = channel.interpolation == Interpolation::CUBIC_SPLINE;
+        const size_t stride = cubic ? 3 * n : n;
+        // for cubic splines, skip the in-tangent
+        const float *v0 = channel.values.data() + keyframe * stride + (cubic ? n : 0);
+
+        const bool last = keyframe + 1 >= channel.times.size();
+        if (last || channel.interpolation == Interpolation::STEP || timeInSecs <= channel.times[keyframe])
+        {
+            std::copy(v0, v0 + n, out);
+            return;
+        }
+
+        const float *v1 = v0 + stride;
+        const float dt = channel.times[keyframe + 1] - channel.times[keyframe];
+        const float t = std::clamp((timeInSecs - channel.times[keyframe]) / dt, 0.0f, 1.0f);
+
+        if (cubic)
+        {
+            const float *outTangent0 = v0 + n;
+            const float *inTangent1 = v1 - n;
+            const float t2 = t * t;
+            const float t3 = t2 * t;
+            for (uint32_t i = 0; i < n; i++)
+            {
+                out[i] = (2 * t3 - 3 * t2 + 1) * v0[i] + (t3 - 2 * t2 + t) * dt * outTangent0[i] +
+                         (-2 * t3 + 3 * t2) * v1[i] + (t3 - t2) * dt * inTangent1[i];
+            }
+            if (channel.path == Path::ROTATION)
+            {
+                const auto q = normalize(math::quatf(out[3], out[0], out[1], out[2]));
+                out[0] = q.x;
+                out[1] = q.y;
+                out[2] = q.z;
+                out[3] = q.w;
+            }
+        }
+        else if (channel.path == Path::ROTATION)
+        {
+            const auto q = slerp(math::quatf(v0[3], v0[0], v0[1], v0[2]), math::quatf(v1[3], v1[0], v1[1], v1[2]), t);
+            out[0] = q.x;
+            out[1] = q.y;
+            out[2] = q.z;
+            out[3] = q.w;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < n; i++)
+            {
+                out[i] = v0[i] + (v1[i] - v0[i]) * t;
+            }
+        }
+    }
+
+    bool AnimationScrubber::seek(int animationIndex, float timeInSecs)
+    {
+        auto *clip = getClip(animationIndex);
+        if (!clip)
+        {
+            Log("ERROR: glTF animation index %d is out of range", animationIndex);
+            return false;
+        }
+
+        timeInSecs = std::clamp(timeInSecs, 0.0f, clip->duration);
+
+        float value[4];
+        for (auto &channel : clip->channels)
+        {
+            const size_t keyframe = findKeyframe(channel, timeInSecs);
+            auto &node = _nodes[channel.node];
+            switch (channel.path)
+            {
+            case Path::TRANSLATION:
+                evaluate(channel, keyframe, timeInSecs, value);
+                node.translation = math::float3(value[0], value[1], value[2]);
+                break;
+            case Path::ROTATION:
+                evaluate(channel, keyframe, timeInSecs, value);
+                node.rotation = math::quatf(value[3], value[0], value[1], value[2]);
+                break;
+            case Path::SCALE:
+                evaluate(channel, keyframe, timeInSecs, value);
+                node.scale = math::float3(value[0], value[1], value[2]);
+                break;
+            case Path::WEIGHTS:
+                node.weights.resize(channel.components);
+                evaluate(channel, keyframe, timeInSecs, node.weights.data());
+                break;
+            }
+        }
+
+        auto &tm = _engine->getTransformManager();
+        tm.openLocalTransformTransaction();
+        for (int index : clip->nodes)
+        {
+            const auto &node = _nodes[index];
+            tm.setTransform(tm.getInstance(node.entity),
+                            math::mat4f::translation(node.translation) * math::mat4f(node.rotation) * math::mat4f::scaling(node.scale));
+        }
+        tm.commitLocalTransformTransaction();
+
+        auto &rm = _engine->getRenderableManager();
+        for (int index : clip->morphNodes)
+        {
+            const auto &node = _nodes[index];
+            auto renderable = rm.getInstance(node.entity);
+            if (!renderable.isValid())
+            {
+                continue;
+            }
+            const size_t count = std::min(node.weights.size(), rm.getMorphTargetCount(renderable));
+            rm.setMorphWeights(renderable, node.weights.data(), count);
+        }
+        return true;
+    }
+
+    bool AnimationScrubber::sample(int animationIndex, float timeInSecs, LocalPose &pose)
+    {
+        auto *clip = getClip(animationIndex);
+        if (!clip)
+        {
+            Log("ERROR: glTF animation index %d is out of range", animationIndex);
+            return false;
+        }
+
+        timeInSecs = std::clamp(timeInSecs, 0.0f, clip->duration);
+
+        float value[4];
+        for (auto &channel : clip->channels)
+        {
+            const int index = _nodes[channel.node].poseIndex;
+            if (channel.path == Path::WEIGHTS || index < 0 || size_t(index) >= pose.numNodes)
+            {
+                continue;
+            }
+            evaluate(channel, findKeyframe(channel, timeInSecs), timeInSecs, value);
+            switch (channel.path)
+            {
+            case Path::TRANSLATION:
+                pose.setTranslation(index, math::float3(value[0], value[1], value[2]));
+                break;
+            case Path::ROTATION:
+                pose.setRotation(index, math::quatf(value[3], value[0], value[1], value[2]));
+                break;
+            case Path::SCALE:
+                pose.setScale(index, math::float3(value[0], value[1], value[2]));
+                break;
+            default:
+                break;
+            }
+        }
+        return true;
+    }
+}
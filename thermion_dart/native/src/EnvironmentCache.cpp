@@ -0,0 +1,280 @@
+#include "EnvironmentCache.hpp"
+
+#include <algorithm>
+
+#include <ktxreader/Ktx1Reader.h>
+
+#include "Log.hpp"
+
+namespace thermion
+{
+
+    // the maximum number of environments that will be fetched/parsed concurrently
+    static constexpr int kMaxConcurrentLoads = 2;
+
+    EnvironmentCache::EnvironmentCache(Engine *engine, const ResourceLoaderWrapperImpl *const resourceLoaderWrapper, ThreadPool *pool, size_t budgetInBytes)
+        : _engine(engine), _resourceLoaderWrapper(resourceLoaderWrapper), _budgetInBytes(budgetInBytes), _loads(pool)
+    {
+    }
+
+    EnvironmentCache::~EnvironmentCache()
+    {
+        _stopped = true;
+
+        // wait for any running loads to complete
+        _loads.wait();
+
+        std::lock_guard lock(_mutex);
+        for (auto it = _entries.begin(); it != _entries.end(); it++)
+        {
+            destroyEntry(it.value());
+        }
+        _entries.clear();
+    }
+
+    void EnvironmentCache::destroyEntry(Entry &entry)
+    {
+        if (entry.bundle)
+        {
+            delete entry.bundle;
+            entry.bundle = nullptr;
+        }
+        if (entry.environment.texture)
+        {
+            _engine->destroy(entry.environment.texture);
+            entry.environment.texture = nullptr;
+            _residentBytes -= entry.sizeInBytes;
+        }
+    }
+
+    void EnvironmentCache::prefetch(const char *uri, int priority)
+    {
+        if (!uri)
+        {
+            return;
+        }
+        std::lock_guard lock(_mutex);
+        auto it = _entries.find(uri);
+        if (it != _entries.end())
+        {
+            it.value().priority = std::max(it->second.priority, priority);
+            return;
+        }
+        Entry entry;
+        entry.priority = priority;
+        entry.lastUsed = ++_clock;
+        _entries.emplace(std::string(uri), entry);
+    }
+
+    void EnvironmentCache::setBudget(size_t budgetInBytes)
+    {
+        std::lock_guard lock(_mutex);
+        _budgetInBytes = budgetInBytes;
+        evict(0);
+    }
+
+    bool EnvironmentCache::acquire(const char *uri, Environment &out)
+    {
+        if (!uri)
+        {
+            return false;
+        }
+        std::lock_guard lock(_mutex);
+        auto it = _entries.find(uri);
+        if (it == _entries.end() || it->second.state != State::RESIDENT)
+        {
+            return false;
+        }
+        auto &entry = it.value();
+        entry.useCount++;
+        entry.lastUsed = ++_clock;
+        out = entry.environment;
+        return true;
+    }
+
+    bool EnvironmentCache::contains(const char *uri)
+    {
+        if (!uri)
+        {
+            return false;
+        }
+        std::lock_guard lock(_mutex);
+        return _entries.find(uri) != _entries.end();
+    }
+
+    bool EnvironmentCache::isResident(const char *uri)
+    {
+        if (!uri)
+        {
+            return false;
+        }
+        std::lock_guard lock(_mutex);
+        auto it = _entries.find(uri);
+        return it != _entries.end() && it->second.state == State::RESIDENT;
+    }
+
+    bool EnvironmentCache::release(Texture *texture)
+    {
+        if (!texture)
+        {
+            return false;
+        }
+        std::lock_guard lock(_mutex);
+        for (auto it = _entries.begin(); it != _entries.end(); it++)
+        {
+            if (it->second.environment.texture == texture)
+            {
+                auto &entry = it.value();
+                entry.useCount = std::max(0, entry.useCount - 1);
+                entry.lastUsed = ++_clock;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void EnvironmentCache::evict(size_t requiredBytes)
+    {
+        while (_residentBytes + requiredBytes > _budgetInBytes)
+        {
+            auto lru = _entries.end();
+            for (auto it = _entries.begin(); it != _entries.end(); it++)
+            {
+                if (it->second.state == State::RESIDENT && it->second.useCount == 0 &&
+                    (lru == _entries.end() || it->second.lastUsed < lru->second.lastUsed))
+                {
+                    lru = it;
+                }
+            }
+            if (lru == _entries.end())
+            {
+                return;
+            }
+            Log("Evicting environment %s from cache", lru->first.c_str());
+            destroyEntry(lru.value());
+            _entries.erase(lru);
+        }
+    }
+
+    void EnvironmentCache::load(std::string uri)
+    {
+        if (_stopped)
+        {
+            return;
+        }
+
+        ResourceBuffer rb = _resourceLoaderWrapper->load(uri.c_str());
+
+        image::Ktx1Bundle *bundle = nullptr;
+        Environment environment;
+        size_t sizeInBytes = rb.size > 0 ? size_t(rb.size) : 0;
+
+        if (sizeInBytes > 0)
+        {
+            // Ktx1Bundle takes a copy of the data, so the resource can be released immediately
+            bundle = new image::Ktx1Bundle(static_cast<const uint8_t *>(rb.data), static_cast<uint32_t>(rb.size));
+            environment.hasHarmonics = bundle->getSphericalHarmonics(environment.harmonics);
+            _resourceLoaderWrapper->free(rb);
+        }
+
+        std::lock_guard lock(_mutex);
+        _loading--;
+        auto it = _entries.find(uri);
+        if (!bundle)
+        {
+            Log("Failed to prefetch environment %s", uri.c_str());
+            if (it != _entries.end())
+            {
+                _entries.erase(it);
+            }
+            return;
+        }
+        auto &entry = it.value();
+        entry.bundle = bundle;
+        entry.environment = environment;
+        entry.sizeInBytes = sizeInBytes;
+        entry.state = State::LOADED;
+    }
+
+    bool EnvironmentCache::hasPendingLoads()
+    {
+        std::lock_guard lock(_mutex);
+        for (auto it = _entries.begin(); it != _entries.end(); it++)
+        {
+            if (it->second.state != State::RESIDENT)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void EnvironmentCache::update()
+    {
+        std::unique_lock lock(_mutex);
+
+        // upload at most one environment per frame
+        std::string toUpload;
+        for (auto it = _entries.begin(); it != _entries.end(); it++)
+        {
+            if (it->second.state == State::LOADED)
+            {
+                toUpload = it->first;
+                break;
+            }
+        }
+
+        if (!toUpload.empty())
+        {
+            auto it = _entries.find(toUpload);
+            const size_t sizeInBytes = it->second.sizeInBytes;
+            evict(sizeInBytes);
+
+            it = _entries.find(toUpload);
+            auto &entry = it.value();
+            if (_residentBytes + sizeInBytes > _budgetInBytes)
+            {
+                Log("Environment %s (%zu bytes) does not fit within the cache budget, discarding", toUpload.c_str(), sizeInBytes);
+                destroyEntry(entry);
+                _entries.erase(it);
+            }
+            else
+            {
+                // this overload destroys the bundle once the upload is complete
+                entry.environment.texture = ktxreader::Ktx1Reader::createTexture(_engine, entry.bundle, false);
+                entry.bundle = nullptr;
+                entry.state = State::RESIDENT;
+                _residentBytes += sizeInBytes;
+            }
+        }
+
+        // dispatch the highest priority queued requests
+        std::vector<std::string> toLoad;
+        while (_loading < kMaxConcurrentLoads)
+        {
+            auto next = _entries.end();
+            for (auto it = _entries.begin(); it != _entries.end(); it++)
+            {
+                if (it->second.state == State::QUEUED &&
+                    (next == _entries.end() || it->second.priority > next->second.priority))
+                {
+                    next = it;
+                }
+            }
+            if (next == _entries.end())
+            {
+                break;
+            }
+            next.value().state = State::LOADING;
+            _loading++;
+            toLoad.push_back(next->first);
+        }
+        lock.unlock();
+
+        for (const auto &uri : toLoad)
+        {
+            _loads.add([=]
+                       { load(uri); });
+        }
+    }
+}
@@ -89,6 +89,7 @@
 #include <filesystem>
 #include <mutex>
 #include <iomanip>
+#include <limits>
 #include <unordered_set>
 
 #include "Log.hpp"
@@ -98,6 +99,7 @@
 #include "material/image.h"
 #include "TimeIt.hpp"
 #include "UnprojectTexture.hpp"
+#include "IblGenerator.hpp"
 
 namespace filament
 {
@@ -180,6 +182,10 @@ namespace thermion
         _scene,
         uberArchivePath,
         _mainCamera);
+
+    _environmentCache = new EnvironmentCache(_engine, _resourceLoaderWrapper, _sceneManager->getThreadPool());
+
+    _imageDecodes = new TaskGroup(_sceneManager->getThreadPool());
   }
 
   void FilamentViewer::setFrameInterval(float frameInterval)
@@ -297,85 +303,123 @@ namespace thermion
     return path.compare(path.length() - ending.length(), ending.length(), ending) == 0;
   }
 
-  void FilamentViewer::loadKtx2Texture(string path, ResourceBuffer rb)
+  void FilamentViewer::decodeImage(string path, DecodedImage &out)
   {
+    std::string ktxExt(".ktx");
+    string ktx2Ext(".ktx2");
+    string pngExt(".png");
 
-    // TODO - check all this
-
-    // ktxreader::Ktx2Reader reader(*_engine);
-
-    // reader.requestFormat(Texture::InternalFormat::DXT3_SRGBA);
-    // reader.requestFormat(Texture::InternalFormat::DXT3_RGBA);
-
-    // // Uncompressed formats are lower priority, so they get added last.
-    // reader.requestFormat(Texture::InternalFormat::SRGB8_A8);
-    // reader.requestFormat(Texture::InternalFormat::RGBA8);
-
-    // // std::ifstream inputStream("/data/data/app.polyvox.filament_example/foo.ktx", ios::binary);
+    if (path.length() < 5)
+    {
+      Log("Invalid resource path : %s", path.c_str());
+      return;
+    }
 
-    // // auto contents = vector<uint8_t>((istreambuf_iterator<char>(inputStream)), {});
+    if (!endsWith(path, ktxExt) && !endsWith(path, ktx2Ext) && !endsWith(path, pngExt))
+    {
+      Log("Unsupported image format : %s", path.c_str());
+      return;
+    }
 
-    // _imageTexture = reader.load(contents.data(), contents.size(),
-    //           ktxreader::Ktx2Reader::TransferFunction::LINEAR);
-  }
+    ResourceBuffer rb = _resourceLoaderWrapper->load(path.c_str());
 
-  void FilamentViewer::loadKtxTexture(string path, ResourceBuffer rb)
-  {
-    ktxreader::Ktx1Bundle *bundle =
-        new ktxreader::Ktx1Bundle(static_cast<const uint8_t *>(rb.data),
-                                  static_cast<uint32_t>(rb.size));
+    if (rb.size <= 0)
+    {
+      Log("Could not load image resource : %s", path.c_str());
+      return;
+    }
 
-    // the ResourceBuffer will go out of scope before the texture callback is invoked
-    // make a copy to the heap
-    ResourceBuffer *rbCopy = new ResourceBuffer(rb);
+    // the bundle, the KTX2 data and the LinearImage are all copies, so the ResourceBuffer can be freed immediately
+    if (endsWith(path, ktx2Ext))
+    {
+      const uint8_t *data = static_cast<const uint8_t *>(rb.data);
+      out.ktx2 = new std::vector<uint8_t>(data, data + rb.size);
+    }
+    else if (endsWith(path, ktxExt))
+    {
+      out.bundle = new ktxreader::Ktx1Bundle(static_cast<const uint8_t *>(rb.data),
+                                             static_cast<uint32_t>(rb.size));
+    }
+    else
+    {
+      thermion::StreamBufferAdapter sb((char *)rb.data, (char *)rb.data + rb.size);
 
-    std::vector<void *> *callbackData = new std::vector<void *>{(void *)_resourceLoaderWrapper, rbCopy};
+      std::istream inputStream(&sb);
 
-    _imageTexture =
-        ktxreader::Ktx1Reader::createTexture(
-            _engine, *bundle, false, [](void *userdata)
-            {
-          std::vector<void*>* vec = (std::vector<void*>*)userdata;
-          ResourceLoaderWrapperImpl* loader = (ResourceLoaderWrapperImpl*)vec->at(0);
-          ResourceBuffer* rb = (ResourceBuffer*) vec->at(1);
-          loader->free(*rb);
-          delete rb;
-          delete vec; },
-            callbackData);
+      LinearImage *image = new LinearImage(ImageDecoder::decode(
+          inputStream, path.c_str(), ImageDecoder::ColorSpace::SRGB));
 
-    auto info = bundle->getInfo();
-    _imageWidth = info.pixelWidth;
-    _imageHeight = info.pixelHeight;
+      if (!image->isValid())
+      {
+        Log("Invalid image : %s", path.c_str());
+        delete image;
+      }
+      else
+      {
+        out.image = image;
+      }
+    }
+    _resourceLoaderWrapper->free(rb);
   }
 
-  void FilamentViewer::loadPngTexture(string path, ResourceBuffer rb)
+  Texture *FilamentViewer::uploadImage(DecodedImage &decoded, uint32_t &width, uint32_t &height)
   {
+    if (decoded.bundle)
+    {
+      auto info = decoded.bundle->getInfo();
+      width = info.pixelWidth;
+      height = info.pixelHeight;
+      // this overload destroys the bundle once the upload is complete
+      auto texture = ktxreader::Ktx1Reader::createTexture(_engine, decoded.bundle, false);
+      decoded.bundle = nullptr;
+      return texture;
+    }
 
-    thermion::StreamBufferAdapter sb((char *)rb.data, (char *)rb.data + rb.size);
-
-    std::istream inputStream(&sb);
-
-    LinearImage *image = new LinearImage(ImageDecoder::decode(
-        inputStream, path.c_str(), ImageDecoder::ColorSpace::SRGB));
+    if (decoded.ktx2)
+    {
+      std::unique_ptr<std::vector<uint8_t>> data(decoded.ktx2);
+      decoded.ktx2 = nullptr;
+
+      ktxreader::Ktx2Reader reader(*_engine);
+      reader.requestFormat(Texture::InternalFormat::SRGB8_A8);
+      reader.requestFormat(Texture::InternalFormat::RGBA8);
+      // transcoding happens here (on the render thread), since the texture must be created first
+      auto texture = reader.load(data->data(), data->size(), ktxreader::Ktx2Reader::TransferFunction::sRGB);
+      if (!texture)
+      {
+        // the transfer function must match the file's metadata
+        texture = reader.load(data->data(), data->size(), ktxreader::Ktx2Reader::TransferFunction::LINEAR);
+      }
+      if (!texture)
+      {
+        Log("Failed to transcode KTX2 image");
+        return nullptr;
+      }
+      width = texture->getWidth();
+      height = texture->getHeight();
+      return texture;
+    }
 
-    if (!image->isValid())
+    if (!decoded.image)
     {
-      Log("Invalid image : %s", path.c_str());
-      return;
+      return nullptr;
     }
 
+    LinearImage *image = decoded.image;
+    decoded.image = nullptr;
+
     uint32_t channels = image->getChannels();
-    _imageWidth = image->getWidth();
-    _imageHeight = image->getHeight();
-
-    _imageTexture = Texture::Builder()
-                        .width(_imageWidth)
-                        .height(_imageHeight)
-                        .levels(0x01)
-                        .format(channels == 3 ? Texture::InternalFormat::RGB16F
-                                              : Texture::InternalFormat::RGBA16F)
-                        .sampler(Texture::Sampler::SAMPLER_2D)
-                        .build(*_engine);
+    width = image->getWidth();
+    height = image->getHeight();
+
+    auto texture = Texture::Builder()
+                       .width(width)
+                       .height(height)
+                       .levels(0x01)
+                       .format(channels == 3 ? Texture::InternalFormat::RGB16F
+                                             : Texture::InternalFormat::RGBA16F)
+                       .sampler(Texture::Sampler::SAMPLER_2D)
+                       .build(*_engine);
 
     Texture::PixelBufferDescriptor::Callback freeCallback = [](void *buf, size_t,
                                                                void *data)
@@ -384,43 +428,12 @@ namespace thermion
     };
 
     auto pbd = Texture::PixelBufferDescriptor(
-        image->getPixelRef(), size_t(_imageWidth * _imageHeight * channels * sizeof(float)),
+        image->getPixelRef(), size_t(width * height * channels * sizeof(float)),
         channels == 3 ? Texture::Format::RGB : Texture::Format::RGBA,
         Texture::Type::FLOAT, nullptr, freeCallback, image);
 
-    _imageTexture->setImage(*_engine, 0, std::move(pbd));
-
-    // don't need to free the ResourceBuffer in the texture callback
-    // LinearImage takes a copy
-    _resourceLoaderWrapper->free(rb);
-  }
-
-  void FilamentViewer::loadTextureFromPath(string path)
-  {
-    std::string ktxExt(".ktx");
-    string ktx2Ext(".ktx2");
-    string pngExt(".png");
-
-    if (path.length() < 5)
-    {
-      Log("Invalid resource path : %s", path.c_str());
-      return;
-    }
-
-    ResourceBuffer rb = _resourceLoaderWrapper->load(path.c_str());
-
-    if (endsWith(path, ktxExt))
-    {
-      loadKtxTexture(path, rb);
-    }
-    else if (endsWith(path, ktx2Ext))
-    {
-      loadKtx2Texture(path, rb);
-    }
-    else if (endsWith(path, pngExt))
-    {
-      loadPngTexture(path, rb);
-    }
+    texture->setImage(*_engine, 0, std::move(pbd));
+    return texture;
   }
 
   void FilamentViewer::setBackgroundColor(const float r, const float g, const float b, const float a)
@@ -498,6 +511,9 @@ namespace thermion
 
   void FilamentViewer::clearBackgroundImage()
   {
+    // discard any in-flight asynchronous image
+    _backgroundImageGeneration++;
+
     std::lock_guard lock(_imageMutex);
 
     if (_imageEntity.isNull())
@@ -515,7 +531,44 @@ namespace thermion
 
   void FilamentViewer::setBackgroundImage(const char *resourcePath, bool fillHeight, uint32_t width, uint32_t height)
   {
+    // any in-flight asynchronous image is now stale
+    _backgroundImageGeneration++;
+
+    DecodedImage decoded;
+    decodeImage(string(resourcePath), decoded);
+
+    uint32_t imageWidth = 0, imageHeight = 0;
+    Texture *texture = uploadImage(decoded, imageWidth, imageHeight);
+    if (!texture)
+    {
+      Log("Failed to set background image %s", resourcePath);
+      return;
+    }
+    applyBackgroundImage(texture, imageWidth, imageHeight, fillHeight, width, height);
+  }
+
+  void FilamentViewer::setBackgroundImageAsync(const char *resourcePath, bool fillHeight, uint32_t width, uint32_t height, void (*onComplete)())
+  {
+    DecodedImage decoded;
+    decoded.fillHeight = fillHeight;
+    decoded.width = width;
+    decoded.height = height;
+    decoded.generation = ++_backgroundImageGeneration;
+    decoded.onComplete = onComplete;
+
+    string path(resourcePath);
+
+    _imageDecodesInFlight++;
+    _imageDecodes->add([=]() mutable
+                       {
+      decodeImage(path, decoded);
+      std::lock_guard lock(_decodedImagesMutex);
+      _decodedImages.push_back(decoded);
+      _imageDecodesInFlight--; });
+  }
 
+  void FilamentViewer::applyBackgroundImage(Texture *texture, uint32_t imageWidth, uint32_t imageHeight, bool fillHeight, uint32_t width, uint32_t height)
+  {
     std::lock_guard lock(_imageMutex);
 
     if (_imageEntity.isNull())
@@ -523,9 +576,14 @@ namespace thermion
       createBackgroundImage();
     }
 
-    string resourcePathString(resourcePath);
-
-    loadTextureFromPath(resourcePathString);
+    _imageMaterial->setDefaultParameter("image", texture, _imageSampler);
+    if (_imageTexture)
+    {
+      _engine->destroy(_imageTexture);
+    }
+    _imageTexture = texture;
+    _imageWidth = imageWidth;
+    _imageHeight = imageHeight;
 
     // This currently just anchors the image at the bottom left of the viewport at its original size
     // TODO - implement stretch/etc
@@ -544,7 +602,6 @@ namespace thermion
     _imageScale = mat4f{xScale, 0.0f, 0.0f, 0.0f, 0.0f, yScale, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
 
     _imageMaterial->setDefaultParameter("transform", _imageScale);
-    _imageMaterial->setDefaultParameter("image", _imageTexture, _imageSampler);
     _imageMaterial->setDefaultParameter("showImage", 1);
   }
 
@@ -653,6 +710,18 @@ namespace thermion
 
     _swapChains.clear();
 
+    // waits for any in-flight decodes to complete
+    delete _imageDecodes;
+    _imageDecodes = nullptr;
+    for (auto &decoded : _decodedImages)
+    {
+      delete decoded.image;
+      delete decoded.bundle;
+      delete decoded.ktx2;
+    }
+    _decodedImages.clear();
+    _pendingEnvironments.clear();
+
     if (!_imageEntity.isNull())
     {
       _engine->destroy(_imageEntity);
@@ -661,6 +730,13 @@ namespace thermion
       _engine->destroy(_imageIb);
       _engine->destroy(_imageMaterial);
     }
+    removeSkybox();
+    removeIbl();
+    if (_panoramaMaterial)
+    {
+      _engine->destroy(_panoramaMaterial);
+    }
+    delete _environmentCache;
     delete _sceneManager;
     _engine->destroyCameraComponent(_mainCamera->getEntity());
     _mainCamera = nullptr;
@@ -842,6 +918,20 @@ namespace thermion
       Log("No skybox path provided, removed skybox.");
     }
 
+    EnvironmentCache::Environment environment;
+    if (_environmentCache->acquire(skyboxPath, environment))
+    {
+      Log("Using cached skybox for path %s", skyboxPath);
+      _skyboxTexture = environment.texture;
+      _skybox =
+          filament::Skybox::Builder()
+              .environment(_skyboxTexture)
+              .build(*_engine);
+      _skybox->setLayerMask(0xFF, 1u << SceneManager::LAYERS::BACKGROUND);
+      _scene->setSkybox(_skybox);
+      return;
+    }
+
     Log("Loading skybox from path %s", skyboxPath);
     ResourceBuffer skyboxBuffer = _resourceLoaderWrapper->load(skyboxPath);
 
@@ -883,8 +973,281 @@ namespace thermion
     _scene->setSkybox(_skybox);
   }
 
+  void FilamentViewer::loadSkyboxAsync(const char *const skyboxPath, void (*onComplete)())
+  {
+    if (!skyboxPath)
+    {
+      loadSkybox(skyboxPath);
+      if (onComplete)
+      {
+        onComplete();
+      }
+      return;
+    }
+    PendingEnvironment pending;
+    pending.uri = skyboxPath;
+    pending.onComplete = onComplete;
+    queueEnvironment(pending);
+  }
+
+  void FilamentViewer::loadIblAsync(const char *const iblPath, float intensity, float crossfadeInSecs, void (*onComplete)())
+  {
+    if (!iblPath)
+    {
+      removeIbl();
+      if (onComplete)
+      {
+        onComplete();
+      }
+      return;
+    }
+    PendingEnvironment pending;
+    pending.uri = iblPath;
+    pending.ibl = true;
+    pending.intensity = intensity;
+    pending.crossfadeInSecs = crossfadeInSecs;
+    pending.onComplete = onComplete;
+    queueEnvironment(pending);
+  }
+
+  void FilamentViewer::queueEnvironment(PendingEnvironment pending)
+  {
+    // a newer request supersedes any pending request of the same type
+    for (auto it = _pendingEnvironments.begin(); it != _pendingEnvironments.end();)
+    {
+      if (it->ibl == pending.ibl)
+      {
+        if (it->onComplete)
+        {
+          it->onComplete();
+        }
+        it = _pendingEnvironments.erase(it);
+      }
+      else
+      {
+        it++;
+      }
+    }
+    // load ahead of any speculative prefetches
+    _environmentCache->prefetch(pending.uri.c_str(), std::numeric_limits<int>::max());
+    _pendingEnvironments.push_back(pending);
+  }
+
+  bool FilamentViewer::updatePendingEnvironment(PendingEnvironment &pending)
+  {
+    const auto swap = [&]()
+    {
+      if (pending.ibl)
+      {
+        loadIbl(pending.uri.c_str(), pending.intensity);
+      }
+      else
+      {
+        loadSkybox(pending.uri.c_str());
+      }
+    };
+
+    const auto fadeProgress = [&]()
+    {
+      if (pending.fadeDuration <= 0.0f)
+      {
+        return 1.0f;
+      }
+      std::chrono::duration<float> elapsed = std::chrono::high_resolution_clock::now() - pending.fadeStart;
+      return std::min(elapsed.count() / pending.fadeDuration, 1.0f);
+    };
+
+    switch (pending.stage)
+    {
+    case PendingEnvironmentStage::LOADING:
+    {
+      if (!_environmentCache->isResident(pending.uri.c_str()))
+      {
+        if (_environmentCache->contains(pending.uri.c_str()))
+        {
+          return false;
+        }
+        // the cache discarded it (failed to load or over budget), so fall back to a synchronous load
+        Log("Environment %s could not be loaded asynchronously, loading synchronously", pending.uri.c_str());
+        swap();
+        return true;
+      }
+      const bool fade = pending.ibl && pending.crossfadeInSecs > 0.0f;
+      if (fade && _indirectLight)
+      {
+        pending.stage = PendingEnvironmentStage::FADING_OUT;
+        pending.fromIntensity = _indirectLight->getIntensity();
+        pending.fadeDuration = pending.crossfadeInSecs / 2.0f;
+        pending.fadeStart = std::chrono::high_resolution_clock::now();
+        return false;
+      }
+      swap();
+      if (fade && _indirectLight)
+      {
+        _indirectLight->setIntensity(0.0f);
+        pending.stage = PendingEnvironmentStage::FADING_IN;
+        pending.fadeDuration = pending.crossfadeInSecs;
+        pending.fadeStart = std::chrono::high_resolution_clock::now();
+        return false;
+      }
+      return true;
+    }
+    case PendingEnvironmentStage::FADING_OUT:
+    {
+      const float t = fadeProgress();
+      if (t < 1.0f)
+      {
+        if (_indirectLight)
+        {
+          _indirectLight->setIntensity(pending.fromIntensity * (1.0f - t));
+        }
+        return false;
+      }
+      swap();
+      if (!_indirectLight)
+      {
+        return true;
+      }
+      _indirectLight->setIntensity(0.0f);
+      pending.stage = PendingEnvironmentStage::FADING_IN;
+      pending.fadeStart = std::chrono::high_resolution_clock::now();
+      return false;
+    }
+    case PendingEnvironmentStage::FADING_IN:
+    {
+      const float t = fadeProgress();
+      if (_indirectLight)
+      {
+        _indirectLight->setIntensity(pending.intensity * t);
+      }
+      return t >= 1.0f || !_indirectLight;
+    }
+    }
+    return true;
+  }
+
+  bool FilamentViewer::hasPendingAsyncLoads()
+  {
+    if (!_pendingEnvironments.empty() || _imageDecodesInFlight > 0 || _environmentCache->hasPendingLoads())
+    {
+      return true;
+    }
+    std::lock_guard lock(_decodedImagesMutex);
+    return !_decodedImages.empty();
+  }
+
+  void FilamentViewer::processAsyncLoads()
+  {
+    _environmentCache->update();
+
+    for (size_t i = 0; i < _pendingEnvironments.size();)
+    {
+      if (updatePendingEnvironment(_pendingEnvironments[i]))
+      {
+        auto onComplete = _pendingEnvironments[i].onComplete;
+        _pendingEnvironments.erase(_pendingEnvironments.begin() + i);
+        if (onComplete)
+        {
+          onComplete();
+        }
+      }
+      else
+      {
+        i++;
+      }
+    }
+
+    // upload at most one background image per call
+    DecodedImage decoded;
+    {
+      std::lock_guard lock(_decodedImagesMutex);
+      if (_decodedImages.empty())
+      {
+        return;
+      }
+      decoded = _decodedImages.front();
+      _decodedImages.erase(_decodedImages.begin());
+    }
+
+    if (decoded.generation != _backgroundImageGeneration)
+    {
+      delete decoded.image;
+      delete decoded.bundle;
+      delete decoded.ktx2;
+    }
+    else
+    {
+      uint32_t imageWidth = 0, imageHeight = 0;
+      Texture *texture = uploadImage(decoded, imageWidth, imageHeight);
+      if (texture)
+      {
+        applyBackgroundImage(texture, imageWidth, imageHeight, decoded.fillHeight, decoded.width, decoded.height);
+      }
+      else
+      {
+        Log("Failed to set background image");
+      }
+    }
+    if (decoded.onComplete)
+    {
+      decoded.onComplete();
+    }
+  }
+
+  bool FilamentViewer::loadPanoramaMaterial(const char *const uri)
+  {
+    ResourceBuffer rb = _resourceLoaderWrapper->load(uri);
+    if (rb.size <= 0)
+    {
+      Log("ERROR: failed to load panorama material %s", uri);
+      return false;
+    }
+    auto *material = Material::Builder()
+                         .package(rb.data, rb.size)
+                         .build(*_engine);
+    _resourceLoaderWrapper->free(rb);
+    if (!material)
+    {
+      Log("ERROR: failed to build panorama material %s", uri);
+      return false;
+    }
+    if (_panoramaMaterial)
+    {
+      Log("Panorama material has already been loaded");
+      _engine->destroy(material);
+      return true;
+    }
+    _panoramaMaterial = material;
+    return true;
+  }
+
+  void FilamentViewer::loadTiledPanorama(const char *const uriTemplate, uint32_t tileSize, uint32_t numLevels, uint32_t cacheFaceSize)
+  {
+    removeSkybox();
+
+    if (!uriTemplate)
+    {
+      Log("No panorama URI template provided, removed skybox.");
+      return;
+    }
+
+    if (!_panoramaMaterial)
+    {
+      Log("ERROR: the panorama material has not been loaded (see loadPanoramaMaterial)");
+      return;
+    }
+
+    Log("Loading tiled panorama from %s", uriTemplate);
+    _panoramaStreamer = new PanoramaStreamer(_engine, _scene, _panoramaMaterial, _sceneManager->getThreadPool(), _resourceLoaderWrapper, uriTemplate, tileSize, numLevels, cacheFaceSize);
+  }
+
   void FilamentViewer::removeSkybox()
   {
+    if (_panoramaStreamer)
+    {
+      delete _panoramaStreamer;
+      _panoramaStreamer = nullptr;
+    }
     _scene->setSkybox(nullptr);
     if (_skybox)
     {
@@ -893,17 +1256,34 @@ namespace thermion
     }
     if (_skyboxTexture)
     {
-      _engine->destroy(_skyboxTexture);
+      // cached textures are retained by the cache
+      if (!_environmentCache->release(_skyboxTexture))
+      {
+        _engine->destroy(_skyboxTexture);
+      }
       _skyboxTexture = nullptr;
     }
   }
 
+  void FilamentViewer::prefetchEnvironment(const char *const uri, int priority)
+  {
+    _environmentCache->prefetch(uri, priority);
+  }
+
+  void FilamentViewer::setEnvironmentCacheBudget(size_t budgetInBytes)
+  {
+    _environmentCache->setBudget(budgetInBytes);
+  }
+
   void FilamentViewer::removeIbl()
   {
     if (_indirectLight)
     {
       _engine->destroy(_indirectLight);
-      _engine->destroy(_iblTexture);
+      if (!_environmentCache->release(_iblTexture))
+      {
+        _engine->destroy(_iblTexture);
+      }
       _indirectLight = nullptr;
       _iblTexture = nullptr;
     }
@@ -975,9 +1355,78 @@ namespace thermion
     _scene->setIndirectLight(_indirectLight);
   }
 
+  void FilamentViewer::createIblFromImage(const char *const path, float intensity, bool createSkybox, const char *const cacheDir)
+  {
+#ifdef __EMSCRIPTEN__
+    // the web build doesn't link filament-iblprefilter
+    Log("createIblFromImage is not supported on web");
+#else
+    if (!path)
+    {
+      Log("No image path provided");
+      return;
+    }
+
+    ResourceBuffer rb = _resourceLoaderWrapper->load(path);
+    if (rb.size <= 0)
+    {
+      Log("Error creating IBL, resource %s could not be loaded.", path);
+      return;
+    }
+
+    IblGenerator generator(_engine, _renderer);
+    IblGenerator::Ibl ibl;
+    bool success = generator.generate(path, static_cast<const uint8_t *>(rb.data), rb.size, cacheDir, createSkybox, ibl);
+    _resourceLoaderWrapper->free(rb);
+
+    if (!success)
+    {
+      return;
+    }
+
+    removeIbl();
+
+    _iblTexture = ibl.reflections;
+    _indirectLight = IndirectLight::Builder()
+                         .reflections(_iblTexture)
+                         .irradiance(3, ibl.harmonics)
+                         .intensity(intensity)
+                         .build(*_engine);
+    _scene->setIndirectLight(_indirectLight);
+
+    if (ibl.skybox)
+    {
+      removeSkybox();
+      _skyboxTexture = ibl.skybox;
+      _skybox =
+          filament::Skybox::Builder()
+              .environment(_skyboxTexture)
+              .build(*_engine);
+      _skybox->setLayerMask(0xFF, 1u << SceneManager::LAYERS::BACKGROUND);
+      _scene->setSkybox(_skybox);
+    }
+#endif
+  }
+
   void FilamentViewer::loadIbl(const char *const iblPath, float intensity)
   {
     removeIbl();
+    EnvironmentCache::Environment environment;
+    if (_environmentCache->acquire(iblPath, environment))
+    {
+      Log("Using cached IBL for path %s", iblPath);
+      _iblTexture = environment.texture;
+      IndirectLight::Builder builder;
+      builder.reflections(_iblTexture).intensity(intensity);
+      if (environment.hasHarmonics)
+      {
+        builder.irradiance(3, environment.harmonics);
+      }
+      _indirectLight = builder.build(*_engine);
+      _scene->setIndirectLight(_indirectLight);
+      return;
+    }
+
     if (iblPath)
     {
       // Load IBL.
@@ -1046,8 +1495,38 @@ namespace thermion
       uint64_t frameTimeInNanos)
   {
 
+    // animation LOD, panorama tiles and texture mip residency are all driven by the views that will be rendered this frame
+    std::vector<View *> renderableViews;
+    for (auto swapChain : _swapChains)
+    {
+      auto &views = _renderable[swapChain];
+      renderableViews.insert(renderableViews.end(), views.begin(), views.end());
+    }
+
     _sceneManager->updateTransforms();
-    _sceneManager->updateAnimations();
+    _sceneManager->updateAnimations(renderableViews);
+    _sceneManager->updateCollisions();
+    processAsyncLoads();
+
+    if (_panoramaStreamer)
+    {
+      // tiles are selected for the first view that will actually be rendered
+      View *panoramaView = nullptr;
+      for (auto swapChain : _swapChains)
+      {
+        auto &views = _renderable[swapChain];
+        if (views.size() > 0)
+        {
+          panoramaView = views[0];
+          break;
+        }
+      }
+      _panoramaStreamer->update(panoramaView);
+    }
+
+    _sceneManager->getTextureStreamer()->update(renderableViews);
+
+    issueHoverPicks(renderableViews);
 
     for(auto swapChain : _swapChains) {
       auto views = _renderable[swapChain];
@@ -1193,7 +1672,7 @@ namespace thermion
 
   bool FilamentViewer::isNonPickableEntity(EntityId entityId) {
     auto renderable = Entity::import(entityId);
-    return _sceneManager->isGizmoEntity(renderable) || renderable == _imageEntity || renderable == _sceneManager->_gridOverlay->sphere() || _sceneManager->_gridOverlay->grid();
+    return _sceneManager->isGizmoEntity(renderable) || renderable == _imageEntity || (_panoramaStreamer && renderable == _panoramaStreamer->getEntity()) || renderable == _sceneManager->_gridOverlay->sphere() || _sceneManager->_gridOverlay->grid();
   }
 
   void FilamentViewer::pick(View *view, uint32_t x, uint32_t y, PickCallback callback)
@@ -1203,6 +1682,54 @@ namespace thermion
     });
   }
 
+  void FilamentViewer::hoverPick(View *view, uint32_t x, uint32_t y, PickCallback callback)
+  {
+    std::lock_guard lock(_hoverPickMutex);
+    auto it = std::find_if(_hoverPicks.begin(), _hoverPicks.end(), [=](const HoverPick &hoverPick)
+                           { return hoverPick.view == view; });
+    if (it == _hoverPicks.end())
+    {
+      _hoverPicks.push_back({view});
+      it = _hoverPicks.end() - 1;
+    }
+    it->callback = callback;
+    it->x = x;
+    it->y = y;
+    it->pending = true;
+  }
+
+  void FilamentViewer::issueHoverPicks(const std::vector<View *> &views)
+  {
+    std::lock_guard lock(_hoverPickMutex);
+    for (auto &hoverPick : _hoverPicks)
+    {
+      // a pick is resolved when its view is rendered, so only views that are about to be rendered are picked
+      if (!hoverPick.pending || hoverPick.inFlight || std::find(views.begin(), views.end(), hoverPick.view) == views.end())
+      {
+        continue;
+      }
+      hoverPick.pending = false;
+      hoverPick.inFlight = true;
+      const auto x = hoverPick.x;
+      const auto y = hoverPick.y;
+      const auto callback = hoverPick.callback;
+      View *view = hoverPick.view;
+      view->pick(x, y, [=](filament::View::PickingQueryResult const &result)
+                 {
+        {
+          std::lock_guard lock(_hoverPickMutex);
+          for (auto &hoverPick : _hoverPicks)
+          {
+            if (hoverPick.view == view)
+            {
+              hoverPick.inFlight = false;
+            }
+          }
+        }
+        callback(Entity::smuggle(result.renderable), x, y, view, result.depth, result.fragCoords.x, result.fragCoords.y, result.fragCoords.z); });
+    }
+  }
+
   void FilamentViewer::unprojectTexture(EntityId entityId, uint8_t *input, uint32_t inputWidth, uint32_t inputHeight, uint8_t *out, uint32_t outWidth, uint32_t outHeight)
   {
     const auto *geometry = _sceneManager->getGeometry(entityId);
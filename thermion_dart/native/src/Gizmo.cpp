@@ -6,6 +6,11 @@
 #include <filament/RenderableManager.h>
 #include <filament/TransformManager.h>
 #include <gltfio/math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "SceneManager.hpp"
 #include "material/gizmo.h"
 #include "Log.hpp"
@@ -34,7 +39,7 @@ Gizmo::Gizmo(Engine *engine, View *view, Scene* scene) : _engine(engine), _view(
     _materialInstances[3]->setParameter("color", math::float4{0.0f, 0.0f, 0.0f, 1.0f}); // Black color
 
     // Create center cube vertices
-    float centerCubeSize = 0.01f;
+    float centerCubeSize = kCenterCubeSize;
     float *centerCubeVertices = new float[8 * 3]{
         -centerCubeSize, -centerCubeSize, -centerCubeSize,
         centerCubeSize, -centerCubeSize, -centerCubeSize,
@@ -84,10 +89,10 @@ Gizmo::Gizmo(Engine *engine, View *view, Scene* scene) : _engine(engine), _view(
     transformManager.setTransform(cubeTransformInstance, cubeTransform);
 
     // Line and arrow vertices
-    float lineLength = 0.6f;
-    float lineWidth = 0.004f;
-    float arrowLength = 0.06f;
-    float arrowWidth = 0.02f;
+    float lineLength = kLineLength;
+    float lineWidth = kLineWidth;
+    float arrowLength = kArrowLength;
+    float arrowWidth = kArrowWidth;
     float *vertices = new float[13 * 3]{
         // Line vertices (8 vertices)
         -lineWidth, -lineWidth, 0.0f,
@@ -182,18 +187,16 @@ Gizmo::Gizmo(Engine *engine, View *view, Scene* scene) : _engine(engine), _view(
         transformManager.setParent(instance, cubeTransformInstance);
 
     }
-
-    createTransparentRectangles();
 }
 
 Gizmo::~Gizmo() {
-    _scene->removeEntities(_entities, 7);
+    _scene->removeEntities(_entities, 4);
     
-    for(int i = 0; i < 7; i++) {
+    for(int i = 0; i < 4; i++) {
         _engine->destroy(_entities[i]);    
     }
     
-    for(int i = 0; i < 7; i++) {
+    for(int i = 0; i < 4; i++) {
         _engine->destroy(_materialInstances[i]);    
     }
     
@@ -201,95 +204,6 @@ Gizmo::~Gizmo() {
     
 }
 
-void Gizmo::createTransparentRectangles()
-{
-    auto &entityManager = EntityManager::get();
-    auto &transformManager = _engine->getTransformManager();
-
-    float volumeWidth = 0.2f;
-    float volumeLength = 1.2f;
-    float volumeDepth = 0.2f;
-
-    float *volumeVertices = new float[8 * 3]{
-        -volumeWidth / 2, -volumeDepth / 2, 0,
-        volumeWidth / 2, -volumeDepth / 2, 0,
-        volumeWidth / 2, -volumeDepth / 2, volumeLength,
-        -volumeWidth / 2, -volumeDepth / 2, volumeLength,
-        -volumeWidth / 2, volumeDepth / 2, 0,
-        volumeWidth / 2, volumeDepth / 2, 0,
-        volumeWidth / 2, volumeDepth / 2, volumeLength,
-        -volumeWidth / 2, volumeDepth / 2, volumeLength
-    };
-
-    uint16_t *volumeIndices = new uint16_t[36]{
-        0, 1, 2, 2, 3, 0,  // Bottom face
-        4, 5, 6, 6, 7, 4,  // Top face
-        0, 4, 7, 7, 3, 0,  // Left face
-        1, 5, 6, 6, 2, 1,  // Right face
-        0, 1, 5, 5, 4, 0,  // Front face
-        3, 2, 6, 6, 7, 3   // Back face
-    };
-
-    auto volumeVb = VertexBuffer::Builder()
-        .vertexCount(8)
-        .bufferCount(1)
-        .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
-        .build(*_engine);
-
-    volumeVb->setBufferAt(*_engine, 0, VertexBuffer::BufferDescriptor(
-        volumeVertices, 8 * sizeof(filament::math::float3),
-        [](void *buffer, size_t size, void *) { delete[] static_cast<float *>(buffer); }
-    ));
-
-    auto volumeIb = IndexBuffer::Builder()
-        .indexCount(36)
-        .bufferType(IndexBuffer::IndexType::USHORT)
-        .build(*_engine);
-
-    volumeIb->setBuffer(*_engine, IndexBuffer::BufferDescriptor(
-        volumeIndices, 36 * sizeof(uint16_t),
-        [](void *buffer, size_t size, void *) { delete[] static_cast<uint16_t *>(buffer); }
-    ));
-
-    for (int i = 4; i < 7; i++)
-    {
-        _entities[i] = entityManager.create();
-        _materialInstances[i] = _material->createInstance();
-
-        _materialInstances[i]->setParameter("color", math::float4{0.0f, 0.0f, 0.0f, 0.0f});  
-
-        math::mat4f transform;
-        switch (i-4)
-        {
-        case Axis::X:
-            transform = math::mat4f::rotation(math::F_PI_2, math::float3{0, 1, 0});
-            break;
-        case Axis::Y:
-            transform = math::mat4f::rotation(-math::F_PI_2, math::float3{1, 0, 0});
-            break;
-        case Axis::Z:
-            break;
-        }
-
-        RenderableManager::Builder(1)
-            .boundingBox({{-volumeWidth / 2, -volumeDepth / 2, 0}, {volumeWidth / 2, volumeDepth / 2, volumeLength}})
-            .material(0, _materialInstances[i])
-            .geometry(0, RenderableManager::PrimitiveType::TRIANGLES, volumeVb, volumeIb, 0, 36)
-            .priority(7)
-            .layerMask(0xFF, 1u << SceneManager::LAYERS::OVERLAY)
-            .culling(false)
-            .receiveShadows(false)
-            .castShadows(false)
-            .build(*_engine, _entities[i]);
-
-        auto instance = transformManager.getInstance(_entities[i]);
-        transformManager.setTransform(instance, transform);
-
-        // Parent the picking volume to the center cube
-        transformManager.setParent(instance, transformManager.getInstance(_entities[3]));
-    }
-}
-
 void Gizmo::highlight(Entity entity) {
     auto &rm = _engine->getRenderableManager();
     auto renderableInstance = rm.getInstance(entity);
@@ -320,18 +234,165 @@ void Gizmo::unhighlight() {
         math::float4 baseColor = inactiveColors[i];
         materialInstance->setParameter("color", baseColor);
     }
+
+    auto centerInstance = rm.getInstance(center());
+    rm.getMaterialInstanceAt(centerInstance, 0)->setParameter("color", math::float4{0.0f, 0.0f, 0.0f, 1.0f});
+}
+
+// the distance along the ray to the entry point of the box centered at the origin with the given half-extent, or infinity if the ray misses it
+static float intersectBox(const math::float3 &origin, const math::float3 &direction, float halfExtent)
+{
+    const math::float3 inverseDirection = 1.0f / direction;
+    const auto t0 = (math::float3(-halfExtent) - origin) * inverseDirection;
+    const auto t1 = (math::float3(halfExtent) - origin) * inverseDirection;
+    const auto tmin = min(t0, t1);
+    const auto tmax = max(t0, t1);
+    const float enter = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+    const float exit = std::min(std::min(tmax.x, tmax.y), tmax.z);
+    return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+// the first distance (>= 0) along the ray at which it is inside both [lo, hi] and the slab [slabLo, slabHi], or infinity if there is none
+static float firstInside(float lo, float hi, float slabLo, float slabHi)
+{
+    const float enter = std::max(std::max(lo, slabLo), 0.0f);
+    const float exit = std::min(hi, slabHi);
+    return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+// the distance along the ray to the entry point of the solid cone (or, when [baseRadius] == [apexRadius], cylinder) around the z-axis
+// whose radius varies linearly from [baseRadius] at z = [base] to [apexRadius] at z = [apex], or infinity if the ray misses it
+static float intersectCone(const math::float3 &origin, const math::float3 &direction, float base, float apex, float baseRadius, float apexRadius)
+{
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+
+    // the ray parameters at which it crosses the planes bounding the cone
+    float slabLo, slabHi;
+    if (std::abs(direction.z) < 1e-12f)
+    {
+        if (origin.z < base || origin.z > apex)
+        {
+            return infinity;
+        }
+        slabLo = -infinity;
+        slabHi = infinity;
+    }
+    else
+    {
+        slabLo = (base - origin.z) / direction.z;
+        slabHi = (apex - origin.z) / direction.z;
+        if (slabLo > slabHi)
+        {
+            std::swap(slabLo, slabHi);
+        }
+    }
+
+    // the ray is inside the (infinite) cone where x^2 + y^2 <= (r0 + k(z - base))^2, i.e. where a t^2 + b t + c <= 0
+    const float slope = (apexRadius - baseRadius) / (apex - base);
+    const float radius = baseRadius + slope * (origin.z - base);
+    const float radiusRate = slope * direction.z;
+    const float a = direction.x * direction.x + direction.y * direction.y - radiusRate * radiusRate;
+    const float b = 2.0f * (origin.x * direction.x + origin.y * direction.y - radius * radiusRate);
+    const float c = origin.x * origin.x + origin.y * origin.y - radius * radius;
+
+    if (std::abs(a) < 1e-12f)
+    {
+        if (std::abs(b) < 1e-12f)
+        {
+            return c <= 0.0f ? firstInside(-infinity, infinity, slabLo, slabHi) : infinity;
+        }
+        const float t = -c / b;
+        return b > 0.0f ? firstInside(-infinity, t, slabLo, slabHi) : firstInside(t, infinity, slabLo, slabHi);
+    }
+
+    const float discriminant = b * b - 4.0f * a * c;
+    if (discriminant < 0.0f)
+    {
+        // the quadratic never changes sign, so the ray is either always inside (a < 0) or always outside (a > 0)
+        return a < 0.0f ? firstInside(-infinity, infinity, slabLo, slabHi) : infinity;
+    }
+    const float root = std::sqrt(discriminant);
+    const float t0 = std::min((-b - root) / (2.0f * a), (-b + root) / (2.0f * a));
+    const float t1 = std::max((-b - root) / (2.0f * a), (-b + root) / (2.0f * a));
+    if (a > 0.0f)
+    {
+        return firstInside(t0, t1, slabLo, slabHi);
+    }
+    // the ray passes through both nappes of the double cone; the slab discards the one that isn't part of this cone
+    return std::min(firstInside(-infinity, t0, slabLo, slabHi), firstInside(t1, infinity, slabLo, slabHi));
+}
+
+Entity Gizmo::hitTest(uint32_t x, uint32_t y)
+{
+    const auto &viewport = _view->getViewport();
+    if (viewport.width == 0 || viewport.height == 0 || !_scene->hasEntity(center()))
+    {
+        return Entity();
+    }
+    const auto &camera = _view->getCamera();
+    auto &transformManager = _engine->getTransformManager();
+
+    // cast a ray from the near plane through the center of the pixel (viewport coordinates have their origin at the bottom-left)
+    const math::mat4 worldFromClip = inverse(camera.getProjectionMatrix() * camera.getViewMatrix());
+    const double ndcX = 2.0 * (x + 0.5) / viewport.width - 1.0;
+    const double ndcY = 2.0 * (y + 0.5) / viewport.height - 1.0;
+    const math::double4 nearPoint = worldFromClip * math::double4(ndcX, ndcY, -1.0, 1.0);
+    const math::double4 farPoint = worldFromClip * math::double4(ndcX, ndcY, 0.0, 1.0);
+    const math::double3 worldOrigin = nearPoint.xyz / nearPoint.w;
+    const math::double3 worldDirection = farPoint.xyz / farPoint.w - worldOrigin;
+
+    // the gizmo material scales the model by (distance from the camera / 4) so its size is constant in screen-space; the distance to
+    // the center of the gizmo is used for the whole gizmo, which is indistinguishable at the distances the gizmo is drawn at
+    const math::mat4 worldFromGizmo = transformManager.getWorldTransformAccurate(transformManager.getInstance(center()));
+    const double scale = length(camera.getPosition() - worldFromGizmo[3].xyz) / 4.0;
+    if (!(scale > 0.0))
+    {
+        return Entity();
+    }
+    const math::mat4 gizmoFromWorld = inverse(worldFromGizmo);
+    const math::float3 origin = math::float3((gizmoFromWorld * math::double4(worldOrigin, 1.0)).xyz / scale);
+    const math::float3 direction = math::float3((gizmoFromWorld * math::double4(worldDirection, 0.0)).xyz / scale);
+
+    Entity closest;
+    float closestDistance = intersectBox(origin, direction, kCenterCubeSize + kPickTolerance);
+    if (closestDistance != std::numeric_limits<float>::infinity())
+    {
+        closest = center();
+    }
+
+    const float shaftRadius = kLineWidth + kPickTolerance;
+    // the arrow is a square pyramid, so its base is bounded by a circle of radius sqrt(2) * width
+    const float arrowRadius = kArrowWidth * math::F_SQRT2 + kPickTolerance;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        // swizzle the ray so the axis is along z (the handles are symmetric around their axis, so the handedness doesn't matter)
+        const math::float3 axisOrigin = {origin[(axis + 1) % 3], origin[(axis + 2) % 3], origin[axis]};
+        const math::float3 axisDirection = {direction[(axis + 1) % 3], direction[(axis + 2) % 3], direction[axis]};
+        const float distance = std::min(
+            intersectCone(axisOrigin, axisDirection, 0.0f, kLineLength, shaftRadius, shaftRadius),
+            intersectCone(axisOrigin, axisDirection, kLineLength, kLineLength + kArrowLength + kPickTolerance, arrowRadius, 0.0f));
+        if (distance < closestDistance)
+        {
+            closestDistance = distance;
+            closest = _entities[axis];
+        }
+    }
+    return closest;
 }
 
 void Gizmo::pick(uint32_t x, uint32_t y, PickCallback callback)
-  {
-    auto handler = new Gizmo::PickCallbackHandler(this, callback);
-    _view->pick(x, y,  [=](filament::View::PickingQueryResult const &result) { 
-        handler->handle(result);
-    });
-  }
+{
+    auto entity = hitTest(x, y);
+    unhighlight();
+    if (!entity.isNull())
+    {
+        highlight(entity);
+    }
+    callback(Entity::smuggle(entity), x, y, _view);
+}
 
 bool Gizmo::isGizmoEntity(Entity e) {
-    for(int i = 0; i < 7; i++) {
+    for(int i = 0; i < 4; i++) {
         if(e == _entities[i]) {
             return true;
         }
@@ -341,9 +402,9 @@ bool Gizmo::isGizmoEntity(Entity e) {
 
 void Gizmo::setVisibility(bool visible) {
     if(visible) {
-        _scene->addEntities(_entities, 7);
+        _scene->addEntities(_entities, 4);
     } else { 
-        _scene->removeEntities(_entities, 7);
+        _scene->removeEntities(_entities, 4);
     }
 }
 }
@@ -0,0 +1,354 @@
+#include "IblGenerator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <vector>
+
+#include <filament/RenderTarget.h>
+#include <filament/SwapChain.h>
+#include <filament-iblprefilter/IBLPrefilterContext.h>
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapSH.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <imageio/ImageDecoder.h>
+#include <image/LinearImage.h>
+
+#include <math/half.h>
+
+#include "Log.hpp"
+#include "StreamBufferAdapter.hpp"
+
+namespace thermion
+{
+
+    using namespace filament::math;
+    using namespace image;
+
+    static constexpr char kCacheMagic[4] = {'T', 'I', 'B', 'L'};
+    static constexpr uint32_t kCacheVersion = 1;
+
+    // the number of times to retry beginFrame (which returns false when Filament skips a frame) before giving up on the cache
+    static constexpr int kMaxCacheFrameAttempts = 4;
+
+    // the maximum width of the (downsampled) equirect used to compute spherical harmonics
+    static constexpr size_t kHarmonicsSourceWidth = 512;
+
+    // the face size of the cubemap used to compute spherical harmonics
+    static constexpr size_t kHarmonicsCubemapSize = 64;
+
+    static uint64_t fnv1a(const uint8_t *data, size_t length)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= data[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    ///
+    /// Copies the RGB channels of [image] to a tightly packed float buffer (greyscale is expanded to RGB).
+    ///
+    static float *toRGB(const LinearImage &image)
+    {
+        const size_t numPixels = size_t(image.getWidth()) * image.getHeight();
+        const uint32_t channels = image.getChannels();
+        const float *src = image.getPixelRef();
+        float *rgb = new float[numPixels * 3];
+        for (size_t i = 0; i < numPixels; i++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                rgb[i * 3 + c] = src[i * channels + (channels >= 3 ? c : 0)];
+            }
+        }
+        return rgb;
+    }
+
+    static void computeHarmonics(Engine *engine, const float *rgb, size_t width, size_t height, float3 *out)
+    {
+        // SH are extremely low frequency, so box-filter the image down before projecting
+        const size_t factor = std::max<size_t>(1, width / kHarmonicsSourceWidth);
+        const size_t dstWidth = std::max<size_t>(1, width / factor);
+        const size_t dstHeight = std::max<size_t>(1, height / factor);
+
+        ibl::Image equirect(dstWidth, dstHeight);
+        for (size_t y = 0; y < dstHeight; y++)
+        {
+            for (size_t x = 0; x < dstWidth; x++)
+            {
+                float3 sum{0.0f};
+                for (size_t sy = y * factor; sy < (y + 1) * factor; sy++)
+                {
+                    for (size_t sx = x * factor; sx < (x + 1) * factor; sx++)
+                    {
+                        const float *p = rgb + (sy * width + sx) * 3;
+                        sum += float3{p[0], p[1], p[2]};
+                    }
+                }
+                *static_cast<float3 *>(equirect.getPixelRef(x, y)) = sum / float(factor * factor);
+            }
+        }
+
+        auto &js = engine->getJobSystem();
+        ibl::Image faces;
+        ibl::Cubemap cubemap = ibl::CubemapUtils::create(faces, kHarmonicsCubemapSize);
+        ibl::CubemapUtils::equirectangularToCubemap(js, cubemap, equirect);
+
+        auto sh = ibl::CubemapSH::computeSH(js, cubemap, 3, true);
+        ibl::CubemapSH::preprocessSHForShader(sh);
+        std::copy(sh.get(), sh.get() + 9, out);
+    }
+
+    bool IblGenerator::generate(
+        const char *name,
+        const uint8_t *data,
+        size_t length,
+        const char *cacheDir,
+        bool createSkybox,
+        Ibl &out)
+    {
+        std::string cachePath;
+#ifndef __EMSCRIPTEN__
+        if (cacheDir && strlen(cacheDir) > 0)
+        {
+            char filename[32];
+            snprintf(filename, sizeof(filename), "%016llx.ibl", (unsigned long long)fnv1a(data, length));
+            cachePath = std::string(cacheDir) + "/" + filename;
+        }
+#endif
+
+        const bool cached = !cachePath.empty() && readFromCache(cachePath, out);
+        if (cached)
+        {
+            Log("Loaded IBL for %s from cache %s", name, cachePath.c_str());
+            if (!createSkybox)
+            {
+                return true;
+            }
+        }
+
+        thermion::StreamBufferAdapter sb((char *)data, (char *)data + length);
+        std::istream inputStream(&sb);
+        LinearImage image = ImageDecoder::decode(inputStream, name, ImageDecoder::ColorSpace::SRGB);
+
+        if (!image.isValid())
+        {
+            Log("Failed to decode image %s", name);
+            // a cached IBL is still usable, we just can't create the skybox
+            return cached;
+        }
+
+        const uint32_t width = image.getWidth();
+        const uint32_t height = image.getHeight();
+        float *rgb = toRGB(image);
+
+        if (!cached)
+        {
+            computeHarmonics(_engine, rgb, width, height, out.harmonics);
+        }
+
+        Texture *equirect = Texture::Builder()
+                                .width(width)
+                                .height(height)
+                                .levels(0xff)
+                                .format(Texture::InternalFormat::R11F_G11F_B10F)
+                                .sampler(Texture::Sampler::SAMPLER_2D)
+                                .build(*_engine);
+
+        Texture::PixelBufferDescriptor::Callback freeCallback = [](void *buf, size_t, void *)
+        {
+            delete[] reinterpret_cast<float *>(buf);
+        };
+
+        equirect->setImage(*_engine, 0,
+                           Texture::PixelBufferDescriptor(
+                               rgb, size_t(width) * height * 3 * sizeof(float),
+                               Texture::Format::RGB, Texture::Type::FLOAT, freeCallback));
+        equirect->generateMipmaps(*_engine);
+
+        IBLPrefilterContext context(*_engine);
+        IBLPrefilterContext::EquirectangularToCubemap equirectangularToCubemap(context);
+        Texture *environment = equirectangularToCubemap(equirect);
+        _engine->destroy(equirect);
+
+        if (!cached)
+        {
+            IBLPrefilterContext::SpecularFilter specularFilter(context);
+            out.reflections = specularFilter(environment);
+            if (!cachePath.empty())
+            {
+                writeToCache(cachePath, out);
+            }
+        }
+
+        if (createSkybox)
+        {
+            out.skybox = environment;
+        }
+        else
+        {
+            _engine->destroy(environment);
+        }
+        return true;
+    }
+
+    bool IblGenerator::readFromCache(const std::string &path, Ibl &out)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.good())
+        {
+            return false;
+        }
+
+        char magic[4];
+        uint32_t version = 0, faceSize = 0, levels = 0;
+        in.read(magic, 4);
+        in.read(reinterpret_cast<char *>(&version), sizeof(version));
+        in.read(reinterpret_cast<char *>(&faceSize), sizeof(faceSize));
+        in.read(reinterpret_cast<char *>(&levels), sizeof(levels));
+        in.read(reinterpret_cast<char *>(out.harmonics), sizeof(float3) * 9);
+
+        if (!in.good() || memcmp(magic, kCacheMagic, 4) != 0 || version != kCacheVersion || faceSize == 0 || levels == 0)
+        {
+            Log("Ignoring invalid IBL cache file %s", path.c_str());
+            return false;
+        }
+
+        // read everything before creating the texture so a truncated file doesn't leave a half-populated IBL
+        std::vector<half *> faces;
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            const size_t dim = std::max(1u, faceSize >> level);
+            for (uint32_t face = 0; face < 6; face++)
+            {
+                half *pixels = new half[dim * dim * 3];
+                in.read(reinterpret_cast<char *>(pixels), dim * dim * 3 * sizeof(half));
+                faces.push_back(pixels);
+            }
+        }
+
+        if (!in.good())
+        {
+            Log("IBL cache file %s is truncated", path.c_str());
+            for (auto pixels : faces)
+            {
+                delete[] pixels;
+            }
+            return false;
+        }
+
+        out.reflections = Texture::Builder()
+                              .width(faceSize)
+                              .height(faceSize)
+                              .levels(levels)
+                              .format(Texture::InternalFormat::R11F_G11F_B10F)
+                              .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+                              .build(*_engine);
+
+        Texture::PixelBufferDescriptor::Callback freeCallback = [](void *buf, size_t, void *)
+        {
+            delete[] reinterpret_cast<half *>(buf);
+        };
+
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            const uint32_t dim = std::max(1u, faceSize >> level);
+            for (uint32_t face = 0; face < 6; face++)
+            {
+                out.reflections->setImage(*_engine, level, 0, 0, face, dim, dim, 1,
+                                          Texture::PixelBufferDescriptor(
+                                              faces[level * 6 + face], size_t(dim) * dim * 3 * sizeof(half),
+                                              Texture::Format::RGB, Texture::Type::HALF, freeCallback));
+            }
+        }
+        return true;
+    }
+
+    bool IblGenerator::writeToCache(const std::string &path, const Ibl &ibl)
+    {
+        const uint32_t faceSize = ibl.reflections->getWidth(0);
+        const uint32_t levels = ibl.reflections->getLevels();
+
+        std::vector<std::vector<float>> buffers(levels * 6);
+        std::vector<RenderTarget *> renderTargets;
+
+        // readPixels must be called within a frame; this uses a headless swap chain so that frame is never presented
+        SwapChain *swapChain = _engine->createSwapChain(1, 1, 0);
+        bool frameStarted = _renderer->beginFrame(swapChain, 0);
+        for (int attempt = 1; !frameStarted && attempt < kMaxCacheFrameAttempts; attempt++)
+        {
+            // the frame was skipped (the GPU is still busy with earlier frames), so wait for it to catch up
+            _engine->flushAndWait();
+            frameStarted = _renderer->beginFrame(swapChain, 0);
+        }
+        if (!frameStarted)
+        {
+            Log("Failed to write IBL cache file %s (the renderer skipped every frame)", path.c_str());
+            _engine->destroy(swapChain);
+            return false;
+        }
+
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            const uint32_t dim = std::max(1u, faceSize >> level);
+            for (uint32_t face = 0; face < 6; face++)
+            {
+                auto &buffer = buffers[level * 6 + face];
+                buffer.resize(size_t(dim) * dim * 4);
+                auto renderTarget = RenderTarget::Builder()
+                                        .texture(RenderTarget::AttachmentPoint::COLOR, ibl.reflections)
+                                        .mipLevel(RenderTarget::AttachmentPoint::COLOR, level)
+                                        .face(RenderTarget::AttachmentPoint::COLOR, Texture::CubemapFace(face))
+                                        .build(*_engine);
+                _renderer->readPixels(renderTarget, 0, 0, dim, dim,
+                                      Texture::PixelBufferDescriptor(
+                                          buffer.data(), buffer.size() * sizeof(float),
+                                          Texture::Format::RGBA, Texture::Type::FLOAT));
+                renderTargets.push_back(renderTarget);
+            }
+        }
+        _renderer->endFrame();
+        _engine->flushAndWait();
+
+        for (auto renderTarget : renderTargets)
+        {
+            _engine->destroy(renderTarget);
+        }
+        _engine->destroy(swapChain);
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out.good())
+        {
+            Log("Failed to open IBL cache file %s for writing", path.c_str());
+            return false;
+        }
+        out.write(kCacheMagic, 4);
+        out.write(reinterpret_cast<const char *>(&kCacheVersion), sizeof(kCacheVersion));
+        out.write(reinterpret_cast<const char *>(&faceSize), sizeof(faceSize));
+        out.write(reinterpret_cast<const char *>(&levels), sizeof(levels));
+        out.write(reinterpret_cast<const char *>(ibl.harmonics), sizeof(float3) * 9);
+
+        std::vector<half> rgb;
+        for (const auto &buffer : buffers)
+        {
+            const size_t numPixels = buffer.size() / 4;
+            rgb.resize(numPixels * 3);
+            for (size_t i = 0; i < numPixels; i++)
+            {
+                rgb[i * 3] = half(buffer[i * 4]);
+                rgb[i * 3 + 1] = half(buffer[i * 4 + 1]);
+                rgb[i * 3 + 2] = half(buffer[i * 4 + 2]);
+            }
+            out.write(reinterpret_cast<const char *>(rgb.data()), rgb.size() * sizeof(half));
+        }
+        Log("Wrote IBL cache file %s", path.c_str());
+        return true;
+    }
+}
@@ -0,0 +1,297 @@
+#include "MeshBvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace thermion
+{
+
+    // the number of bins used to evaluate split candidates along each axis
+    static constexpr int kBinCount = 12;
+
+    static Aabb merge(const Aabb &a, const Aabb &b)
+    {
+        return {min(a.min, b.min), max(a.max, b.max)};
+    }
+
+    static float surfaceArea(const Aabb &box)
+    {
+        if (box.isEmpty())
+        {
+            return 0.0f;
+        }
+        const auto d = box.max - box.min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    // the distance along the ray to the entry point of [box], or infinity if the ray misses it (or enters it beyond [maxDistance])
+    static float intersect(const Aabb &box, const math::float3 &origin, const math::float3 &inverseDirection, float maxDistance)
+    {
+        const auto t0 = (box.min - origin) * inverseDirection;
+        const auto t1 = (box.max - origin) * inverseDirection;
+        const auto tmin = min(t0, t1);
+        const auto tmax = max(t0, t1);
+        const float enter = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+        const float exit = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, maxDistance));
+        return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+    }
+
+    std::shared_ptr<const MeshBvh> MeshBvh::build(std::vector<math::float3> &&positions, std::vector<math::float2> &&uvs, std::vector<uint32_t> &&indices)
+    {
+        // drop any triangles that refer to missing vertices
+        size_t validIndices = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            if (indices[i] < positions.size() && indices[i + 1] < positions.size() && indices[i + 2] < positions.size())
+            {
+                std::copy(indices.begin() + i, indices.begin() + i + 3, indices.begin() + validIndices);
+                validIndices += 3;
+            }
+        }
+        indices.resize(validIndices);
+
+        const uint32_t triangleCount = uint32_t(indices.size() / 3);
+        if (triangleCount == 0)
+        {
+            return nullptr;
+        }
+
+        auto bvh = std::make_shared<MeshBvh>();
+        bvh->_positions = std::move(positions);
+        bvh->_uvs = uvs.size() == bvh->_positions.size() ? std::move(uvs) : std::vector<math::float2>();
+        bvh->_indices = std::move(indices);
+
+        std::vector<Aabb> triangleBoxes(triangleCount);
+        std::vector<math::float3> centroids(triangleCount);
+        bvh->_triangles.resize(triangleCount);
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            Aabb box;
+            for (int v = 0; v < 3; v++)
+            {
+                const auto &p = bvh->_positions[bvh->_indices[t * 3 + v]];
+                box.min = min(box.min, p);
+                box.max = max(box.max, p);
+            }
+            triangleBoxes[t] = box;
+            centroids[t] = box.center();
+            bvh->_triangles[t] = t;
+        }
+
+        bvh->_nodes.reserve(size_t(triangleCount) * 2);
+        bvh->buildRecursive(0, triangleCount, triangleBoxes, centroids);
+        return bvh;
+    }
+
+    uint32_t MeshBvh::buildRecursive(uint32_t first, uint32_t count, const std::vector<Aabb> &triangleBoxes, const std::vector<math::float3> &centroids)
+    {
+        const uint32_t nodeIndex = uint32_t(_nodes.size());
+        _nodes.emplace_back();
+
+        Aabb box;
+        Aabb centroidBox;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            box = merge(box, triangleBoxes[_triangles[i]]);
+            const auto &c = centroids[_triangles[i]];
+            centroidBox.min = min(centroidBox.min, c);
+            centroidBox.max = max(centroidBox.max, c);
+        }
+        _nodes[nodeIndex].box = box;
+
+        auto makeLeaf = [&]()
+        {
+            _nodes[nodeIndex].offset = first;
+            _nodes[nodeIndex].count = count;
+            return nodeIndex;
+        };
+
+        if (count <= kMaxLeafSize)
+        {
+            return makeLeaf();
+        }
+
+        // find the cheapest split (by surface area heuristic) across kBinCount bins along each axis
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = surfaceArea(box) * float(count);
+        const auto extent = centroidBox.max - centroidBox.min;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (extent[axis] <= 0.0f)
+            {
+                continue;
+            }
+            Aabb bins[kBinCount];
+            uint32_t binCounts[kBinCount] = {};
+            const float scale = float(kBinCount) / extent[axis];
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                const uint32_t t = _triangles[i];
+                const int bin = std::min(kBinCount - 1, int((centroids[t][axis] - centroidBox.min[axis]) * scale));
+                bins[bin] = merge(bins[bin], triangleBoxes[t]);
+                binCounts[bin]++;
+            }
+
+            // sweep from the right to accumulate the cost of every right-hand partition
+            float rightAreas[kBinCount];
+            uint32_t rightCounts[kBinCount];
+            Aabb right;
+            uint32_t rightCount = 0;
+            for (int b = kBinCount - 1; b > 0; b--)
+            {
+                right = merge(right, bins[b]);
+                rightCount += binCounts[b];
+                rightAreas[b] = surfaceArea(right);
+                rightCounts[b] = rightCount;
+            }
+
+            Aabb left;
+            uint32_t leftCount = 0;
+            for (int b = 0; b < kBinCount - 1; b++)
+            {
+                left = merge(left, bins[b]);
+                leftCount += binCounts[b];
+                if (leftCount == 0 || rightCounts[b + 1] == 0)
+                {
+                    continue;
+                }
+                const float cost = surfaceArea(left) * float(leftCount) + rightAreas[b + 1] * float(rightCounts[b + 1]);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        uint32_t middle;
+        if (bestAxis >= 0)
+        {
+            const float scale = float(kBinCount) / extent[bestAxis];
+            const float splitMin = centroidBox.min[bestAxis];
+            auto *begin = _triangles.data() + first;
+            auto *end = begin + count;
+            middle = first + uint32_t(std::partition(begin, end, [&](uint32_t t)
+                                                     { return std::min(kBinCount - 1, int((centroids[t][bestAxis] - splitMin) * scale)) <= bestSplit; }) -
+                                      begin);
+        }
+        else if (count > kMaxLeafSize * 4)
+        {
+            // no split is cheaper than a leaf (e.g. every centroid is identical), but the leaf would be too large to traverse efficiently
+            middle = first + count / 2;
+        }
+        else
+        {
+            return makeLeaf();
+        }
+
+        buildRecursive(first, middle - first, triangleBoxes, centroids);
+        const uint32_t rightChild = buildRecursive(middle, first + count - middle, triangleBoxes, centroids);
+        _nodes[nodeIndex].offset = rightChild;
+        _nodes[nodeIndex].count = 0;
+        return nodeIndex;
+    }
+
+    bool MeshBvh::raycast(const math::float3 &origin, const math::float3 &direction, float maxDistance, Hit &hit) const
+    {
+        const math::float3 inverseDirection = 1.0f / direction;
+        bool found = false;
+        float closest = maxDistance;
+
+        uint32_t stack[64];
+        int stackSize = 0;
+        if (intersect(_nodes[0].box, origin, inverseDirection, closest) == std::numeric_limits<float>::infinity())
+        {
+            return false;
+        }
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const Node &node = _nodes[stack[--stackSize]];
+
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                {
+                    // Moller-Trumbore
+                    const uint32_t t = _triangles[i];
+                    const auto &p0 = _positions[_indices[t * 3]];
+                    const auto &p1 = _positions[_indices[t * 3 + 1]];
+                    const auto &p2 = _positions[_indices[t * 3 + 2]];
+                    const auto e1 = p1 - p0;
+                    const auto e2 = p2 - p0;
+                    const auto p = cross(direction, e2);
+                    const float det = dot(e1, p);
+                    if (std::abs(det) < 1e-12f)
+                    {
+                        continue;
+                    }
+                    const float inverseDet = 1.0f / det;
+                    const auto s = origin - p0;
+                    const float u = dot(s, p) * inverseDet;
+                    if (u < 0.0f || u > 1.0f)
+                    {
+                        continue;
+                    }
+                    const auto q = cross(s, e1);
+                    const float v = dot(direction, q) * inverseDet;
+                    if (v < 0.0f || u + v > 1.0f)
+                    {
+                        continue;
+                    }
+                    const float distance = dot(e2, q) * inverseDet;
+                    if (distance < 0.0f || distance > closest)
+                    {
+                        continue;
+                    }
+                    closest = distance;
+                    found = true;
+                    hit.distance = distance;
+                    hit.barycentrics = {1.0f - u - v, u, v};
+                    hit.triangle = t;
+                }
+                continue;
+            }
+
+            // visit the nearer child first so the farther one can (hopefully) be culled by the closest hit
+            const uint32_t left = uint32_t(&node - _nodes.data()) + 1;
+            const uint32_t right = node.offset;
+            float leftDistance = intersect(_nodes[left].box, origin, inverseDirection, closest);
+            float rightDistance = intersect(_nodes[right].box, origin, inverseDirection, closest);
+            uint32_t nearChild = left, farChild = right;
+            if (rightDistance < leftDistance)
+            {
+                std::swap(nearChild, farChild);
+                std::swap(leftDistance, rightDistance);
+            }
+            // the stack can only overflow for degenerate trees deeper than 64 levels, in which case the far child is dropped
+            if (rightDistance != std::numeric_limits<float>::infinity() && stackSize < 64)
+            {
+                stack[stackSize++] = farChild;
+            }
+            if (leftDistance != std::numeric_limits<float>::infinity() && stackSize < 64)
+            {
+                stack[stackSize++] = nearChild;
+            }
+        }
+
+        if (found)
+        {
+            if (!_uvs.empty())
+            {
+                const uint32_t *triangle = &_indices[hit.triangle * 3];
+                hit.uv = _uvs[triangle[0]] * hit.barycentrics.x + _uvs[triangle[1]] * hit.barycentrics.y + _uvs[triangle[2]] * hit.barycentrics.z;
+            }
+            else
+            {
+                hit.uv = math::float2(0.0f);
+            }
+        }
+        return found;
+    }
+}
@@ -0,0 +1,156 @@
+#include "OrientedBox.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace thermion
+{
+
+    // the maximum number of Jacobi sweeps; a 3x3 symmetric matrix converges in a handful
+    static constexpr int kMaxSweeps = 16;
+
+    // diagonalizes the symmetric matrix [a] with Jacobi rotations, writing its eigenvectors to the columns of [vectors]
+    static void eigenvectors(double a[3][3], double vectors[3][3])
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                vectors[i][j] = i == j ? 1.0 : 0.0;
+            }
+        }
+
+        for (int sweep = 0; sweep < kMaxSweeps; sweep++)
+        {
+            const double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+            const double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+            if (offDiagonal <= 1e-24 * diagonal)
+            {
+                return;
+            }
+            for (int p = 0; p < 2; p++)
+            {
+                for (int q = p + 1; q < 3; q++)
+                {
+                    if (a[p][q] == 0.0)
+                    {
+                        continue;
+                    }
+                    // the rotation (c, s) that zeroes a[p][q]
+                    const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                    const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                    const double c = 1.0 / std::sqrt(t * t + 1.0);
+                    const double s = t * c;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        const double akp = a[k][p];
+                        const double akq = a[k][q];
+                        a[k][p] = c * akp - s * akq;
+                        a[k][q] = s * akp + c * akq;
+                    }
+                    for (int k = 0; k < 3; k++)
+                    {
+                        const double apk = a[p][k];
+                        const double aqk = a[q][k];
+                        a[p][k] = c * apk - s * aqk;
+                        a[q][k] = s * apk + c * aqk;
+                    }
+                    for (int k = 0; k < 3; k++)
+                    {
+                        const double vkp = vectors[k][p];
+                        const double vkq = vectors[k][q];
+                        vectors[k][p] = c * vkp - s * vkq;
+                        vectors[k][q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+    }
+
+    // the box with the given (orthonormal) axes that bounds [points]
+    static OrientedBox bound(const math::float3 *points, size_t count, const math::float3 axes[3])
+    {
+        math::float3 lower(FLT_MAX);
+        math::float3 upper(-FLT_MAX);
+        for (size_t i = 0; i < count; i++)
+        {
+            const math::float3 projected = {dot(points[i], axes[0]), dot(points[i], axes[1]), dot(points[i], axes[2])};
+            lower = min(lower, projected);
+            upper = max(upper, projected);
+        }
+        OrientedBox result;
+        const math::float3 middle = (lower + upper) * 0.5f;
+        result.center = axes[0] * middle.x + axes[1] * middle.y + axes[2] * middle.z;
+        result.halfExtents = (upper - lower) * 0.5f;
+        for (int i = 0; i < 3; i++)
+        {
+            result.axes[i] = axes[i];
+        }
+        return result;
+    }
+
+    OrientedBox OrientedBox::fit(const math::float3 *points, size_t count)
+    {
+        if (count == 0)
+        {
+            OrientedBox empty;
+            empty.center = math::float3(0.0f);
+            empty.halfExtents = math::float3(0.0f);
+            return empty;
+        }
+
+        const math::float3 identity[3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+        const OrientedBox aligned = bound(points, count, identity);
+
+        // the covariance is accumulated relative to the center of the axis-aligned box, in double precision, to avoid cancellation
+        double mean[3] = {0.0, 0.0, 0.0};
+        for (size_t i = 0; i < count; i++)
+        {
+            const math::float3 p = points[i] - aligned.center;
+            for (int j = 0; j < 3; j++)
+            {
+                mean[j] += p[j];
+            }
+        }
+        for (int j = 0; j < 3; j++)
+        {
+            mean[j] /= double(count);
+        }
+        double covariance[3][3] = {};
+        for (size_t i = 0; i < count; i++)
+        {
+            const math::float3 p = points[i] - aligned.center;
+            const double d[3] = {p.x - mean[0], p.y - mean[1], p.z - mean[2]};
+            for (int j = 0; j < 3; j++)
+            {
+                for (int k = j; k < 3; k++)
+                {
+                    covariance[j][k] += d[j] * d[k];
+                }
+            }
+        }
+        for (int j = 0; j < 3; j++)
+        {
+            for (int k = 0; k < j; k++)
+            {
+                covariance[j][k] = covariance[k][j];
+            }
+        }
+
+        double vectors[3][3];
+        eigenvectors(covariance, vectors);
+
+        math::float3 axes[3];
+        for (int i = 0; i < 2; i++)
+        {
+            axes[i] = normalize(math::float3{float(vectors[0][i]), float(vectors[1][i]), float(vectors[2][i])});
+        }
+        // rebuild the last axis so the basis is exactly orthonormal (and right-handed)
+        axes[1] = normalize(axes[1] - dot(axes[1], axes[0]) * axes[0]);
+        axes[2] = cross(axes[0], axes[1]);
+
+        const OrientedBox principal = bound(points, count, axes);
+        return principal.getVolume() < aligned.getVolume() ? principal : aligned;
+    }
+}
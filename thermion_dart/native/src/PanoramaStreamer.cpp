@@ -0,0 +1,575 @@
+#include "PanoramaStreamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+
+#include <filament/Camera.h>
+#include <filament/RenderableManager.h>
+#include <filament/Viewport.h>
+#include <utils/EntityManager.h>
+
+#include <imageio/ImageDecoder.h>
+#include <image/LinearImage.h>
+
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include "Log.hpp"
+#include "SceneManager.hpp"
+#include "StreamBufferAdapter.hpp"
+
+namespace thermion
+{
+
+    using namespace filament::math;
+    using namespace image;
+
+    static constexpr const char *kFaceNames[6] = {"px", "nx", "py", "ny", "pz", "nz"};
+
+    // the maximum number of tiles that can be fetched/decoded at any one time
+    static constexpr uint32_t kMaxTilesInFlight = 8;
+
+    // the maximum number of tiles that will be uploaded in a single frame
+    static constexpr uint32_t kMaxTileUploadsPerFrame = 4;
+
+    // the maximum width/height of the tile atlas
+    static constexpr uint32_t kMaxAtlasSize = 4096;
+
+    // the indirection texture holds 6 x 2^(levels - 1) texels per row, which must not exceed kMaxAtlasSize
+    static constexpr uint32_t kMaxLevels = 10;
+
+    static constexpr float4 kFullScreenTriangleVertices[3] = {
+        {-1.0f, -1.0f, 1.0f, 1.0f},
+        {3.0f, -1.0f, 1.0f, 1.0f},
+        {-1.0f, 3.0f, 1.0f, 1.0f}};
+
+    static const uint16_t kFullScreenTriangleIndices[3] = {0, 1, 2};
+
+    ///
+    /// Returns the (unnormalized) direction for the texel at [u],[v] on the given cubemap face,
+    /// where [u],[v] are in the range [0,1] and v = 0 is the top of the face.
+    ///
+    static float3 faceDirection(uint32_t face, float u, float v)
+    {
+        const float s = 2.0f * u - 1.0f;
+        const float t = 2.0f * v - 1.0f;
+        switch (face)
+        {
+        case 0:
+            return {1.0f, -t, -s};
+        case 1:
+            return {-1.0f, -t, s};
+        case 2:
+            return {s, 1.0f, t};
+        case 3:
+            return {s, -1.0f, -t};
+        case 4:
+            return {s, -t, 1.0f};
+        default:
+            return {-s, -t, -1.0f};
+        }
+    }
+
+    ///
+    /// Copies the RGB(A) or greyscale [image] ([tileSize] x [tileSize]) into a [slotSize] x [slotSize] RGB8 buffer
+    /// centered in the slot, duplicating the edge texels into the border so bilinear filtering never bleeds
+    /// between neighbouring slots.
+    /// The caller takes ownership of the returned buffer (delete[]).
+    ///
+    static uint8_t *copyToSlot(const LinearImage &image, uint32_t tileSize, uint32_t slotSize)
+    {
+        const uint32_t channels = image.getChannels();
+        const float *src = image.getPixelRef();
+
+        uint8_t *out = new uint8_t[size_t(slotSize) * slotSize * 3];
+
+        for (uint32_t y = 0; y < slotSize; y++)
+        {
+            const uint32_t sy = std::clamp(int(y) - 1, 0, int(tileSize) - 1);
+            for (uint32_t x = 0; x < slotSize; x++)
+            {
+                const uint32_t sx = std::clamp(int(x) - 1, 0, int(tileSize) - 1);
+                const float *p = src + (sy * tileSize + sx) * channels;
+                uint8_t *dst = out + (y * slotSize + x) * 3;
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    // greyscale images are expanded to RGB
+                    const uint32_t ci = channels >= 3 ? c : 0;
+                    dst[c] = uint8_t(std::clamp(p[ci], 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+        return out;
+    }
+
+    PanoramaStreamer::PanoramaStreamer(
+        Engine *engine,
+        Scene *scene,
+        Material *material,
+        ThreadPool *pool,
+        const ResourceLoaderWrapperImpl *const resourceLoaderWrapper,
+        const char *uriTemplate,
+        uint32_t tileSize,
+        uint32_t numLevels,
+        uint32_t cacheFaceSize) : _engine(engine),
+                                  _scene(scene),
+                                  _resourceLoaderWrapper(resourceLoaderWrapper),
+                                  _uriTemplate(uriTemplate),
+                                  _tileSize(std::max(1u, tileSize)),
+                                  _numLevels(std::clamp(numLevels, 1u, kMaxLevels)),
+                                  _decodes(pool)
+    {
+        if (numLevels > kMaxLevels)
+        {
+            Log("Panorama has %d levels but the indirection texture can only address %d, finer levels will not be streamed", numLevels, kMaxLevels);
+        }
+        _finestTilesPerSide = 1u << (_numLevels - 1);
+        _slotSize = _tileSize + 2;
+
+        // enough slots for a cubemap with faces of cacheFaceSize, but always enough for level 0 and all of level 1
+        const uint32_t cacheTilesPerSide = std::max(1u, cacheFaceSize / _tileSize);
+        const uint32_t requestedSlots = std::max(6 * cacheTilesPerSide * cacheTilesPerSide, 30u);
+        const uint32_t maxSlotsPerSide = std::min(kMaxAtlasSize / _slotSize, 255u);
+        _slotsPerSide = std::min(uint32_t(std::ceil(std::sqrt(float(requestedSlots)))), maxSlotsPerSide);
+        _numSlots = _slotsPerSide * _slotsPerSide;
+        _atlasSize = _slotsPerSide * _slotSize;
+
+        if (_numSlots < 6)
+        {
+            Log("ERROR: panorama tiles of size %d are too large for the tile atlas (maximum size %d)", _tileSize, kMaxAtlasSize);
+        }
+
+        _slotKeys.resize(_numSlots);
+        // slots are allocated from the back
+        for (int32_t slot = int32_t(_numSlots) - 1; slot >= 0; slot--)
+        {
+            _freeSlots.push_back(slot);
+        }
+        _indirection.resize(size_t(6 * _finestTilesPerSide) * _finestTilesPerSide * 4, 0);
+
+        _atlasTexture = Texture::Builder()
+                            .width(std::max(1u, _atlasSize))
+                            .height(std::max(1u, _atlasSize))
+                            .levels(1)
+                            .format(Texture::InternalFormat::SRGB8)
+                            .sampler(Texture::Sampler::SAMPLER_2D)
+                            .build(*_engine);
+
+        _indirectionTexture = Texture::Builder()
+                                  .width(6 * _finestTilesPerSide)
+                                  .height(_finestTilesPerSide)
+                                  .levels(1)
+                                  .format(Texture::InternalFormat::RGBA8)
+                                  .sampler(Texture::Sampler::SAMPLER_2D)
+                                  .build(*_engine);
+
+        TextureSampler atlasSampler(TextureSampler::MinFilter::LINEAR, TextureSampler::MagFilter::LINEAR);
+        TextureSampler indirectionSampler(TextureSampler::MinFilter::NEAREST, TextureSampler::MagFilter::NEAREST);
+
+        _materialInstance = material->createInstance();
+        _materialInstance->setParameter("atlas", _atlasTexture, atlasSampler);
+        _materialInstance->setParameter("indirection", _indirectionTexture, indirectionSampler);
+        _materialInstance->setParameter("finestTilesPerSide", int32_t(_finestTilesPerSide));
+        _materialInstance->setParameter("tileSize", float(_tileSize));
+        _materialInstance->setParameter("slotSize", float(_slotSize));
+        _materialInstance->setParameter("atlasSize", float(_atlasSize));
+
+        _vertexBuffer = VertexBuffer::Builder()
+                            .vertexCount(3)
+                            .bufferCount(1)
+                            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT4, 0)
+                            .build(*_engine);
+        _vertexBuffer->setBufferAt(*_engine, 0, {kFullScreenTriangleVertices, sizeof(kFullScreenTriangleVertices)});
+
+        _indexBuffer = IndexBuffer::Builder()
+                           .indexCount(3)
+                           .bufferType(IndexBuffer::IndexType::USHORT)
+                           .build(*_engine);
+        _indexBuffer->setBuffer(*_engine, {kFullScreenTriangleIndices, sizeof(kFullScreenTriangleIndices)});
+
+        // the entity is only added to the scene once every level 0 tile has been uploaded
+        _entity = utils::EntityManager::get().create();
+        RenderableManager::Builder(1)
+            .boundingBox({{}, {1.0f, 1.0f, 1.0f}})
+            .material(0, _materialInstance)
+            .geometry(0, RenderableManager::PrimitiveType::TRIANGLES, _vertexBuffer, _indexBuffer, 0, 3)
+            .layerMask(0xFF, 1u << SceneManager::LAYERS::BACKGROUND)
+            .priority(0)
+            .culling(false)
+            .castShadows(false)
+            .receiveShadows(false)
+            .build(*_engine, _entity);
+
+        Log("Created panorama tile atlas with %d slots of size %d (%d levels)", _numSlots, _slotSize, _numLevels);
+    }
+
+    PanoramaStreamer::~PanoramaStreamer()
+    {
+        _stopped = true;
+
+        // wait for any running decodes to complete
+        _decodes.wait();
+
+        for (auto &tile : _decoded)
+        {
+            delete[] tile.pixels;
+        }
+        _decoded.clear();
+
+        _scene->remove(_entity);
+        _engine->destroy(_entity);
+        utils::EntityManager::get().destroy(_entity);
+        _engine->destroy(_materialInstance);
+        _engine->destroy(_vertexBuffer);
+        _engine->destroy(_indexBuffer);
+        _engine->destroy(_atlasTexture);
+        _engine->destroy(_indirectionTexture);
+    }
+
+    std::string PanoramaStreamer::getTileUri(uint32_t level, uint32_t face, uint32_t x, uint32_t y) const
+    {
+        std::string uri = _uriTemplate;
+        const std::pair<std::string, std::string> replacements[4] = {
+            {"{level}", std::to_string(level)},
+            {"{face}", kFaceNames[face]},
+            {"{x}", std::to_string(x)},
+            {"{y}", std::to_string(y)}};
+
+        for (const auto &[token, value] : replacements)
+        {
+            size_t pos = 0;
+            while ((pos = uri.find(token, pos)) != std::string::npos)
+            {
+                uri.replace(pos, token.length(), value);
+                pos += value.length();
+            }
+        }
+        return uri;
+    }
+
+    void PanoramaStreamer::decodeTile(uint32_t level, uint32_t face, uint32_t x, uint32_t y)
+    {
+        if (_stopped)
+        {
+            return;
+        }
+
+        DecodedTile tile{makeKey(level, face, x, y), level, face, x, y};
+
+        const std::string uri = getTileUri(level, face, x, y);
+        ResourceBuffer rb = _resourceLoaderWrapper->load(uri.c_str());
+
+        if (rb.size <= 0)
+        {
+            Log("Failed to load panorama tile %s", uri.c_str());
+            std::lock_guard lock(_decodedMutex);
+            _decoded.push_back(tile);
+            return;
+        }
+
+        thermion::StreamBufferAdapter sb((char *)rb.data, (char *)rb.data + rb.size);
+        std::istream inputStream(&sb);
+
+        // tiles are uploaded to an sRGB texture, so skip the linear conversion
+        LinearImage image = ImageDecoder::decode(inputStream, uri, ImageDecoder::ColorSpace::LINEAR);
+        _resourceLoaderWrapper->free(rb);
+
+        if (!image.isValid() || _stopped)
+        {
+            if (!_stopped)
+            {
+                Log("Failed to decode panorama tile %s", uri.c_str());
+            }
+            std::lock_guard lock(_decodedMutex);
+            _decoded.push_back(tile);
+            return;
+        }
+
+        if (image.getWidth() != _tileSize || image.getHeight() != _tileSize)
+        {
+            Log("Panorama tile %s is %dx%d, expected %dx%d", uri.c_str(), image.getWidth(), image.getHeight(), _tileSize, _tileSize);
+            std::lock_guard lock(_decodedMutex);
+            _decoded.push_back(tile);
+            return;
+        }
+
+        tile.pixels = copyToSlot(image, _tileSize, _slotSize);
+
+        std::lock_guard lock(_decodedMutex);
+        _decoded.push_back(tile);
+    }
+
+    void PanoramaStreamer::setIndirection(const Tile &region, const Tile &target)
+    {
+        // every entry covered by [region] that is not already pointing to a finer tile
+        const uint32_t span = _finestTilesPerSide >> region.level;
+        const uint32_t rowLength = 6 * _finestTilesPerSide;
+        const uint8_t entry[4] = {
+            uint8_t(target.slot % _slotsPerSide),
+            uint8_t(target.slot / _slotsPerSide),
+            uint8_t(target.level),
+            255};
+
+        for (uint32_t y = region.y * span; y < (region.y + 1) * span; y++)
+        {
+            for (uint32_t x = region.x * span; x < (region.x + 1) * span; x++)
+            {
+                uint8_t *texel = _indirection.data() + (size_t(y) * rowLength + region.face * _finestTilesPerSide + x) * 4;
+                if (texel[3] == 0 || texel[2] <= region.level)
+                {
+                    std::copy(entry, entry + 4, texel);
+                }
+            }
+        }
+        _indirectionDirty = true;
+    }
+
+    void PanoramaStreamer::evict(int32_t slot)
+    {
+        const uint64_t key = _slotKeys[slot];
+        const Tile evicted = _tiles[key];
+        _tiles.erase(key);
+
+        // point the evicted region back to the nearest resident ancestor (level 0 tiles are never evicted)
+        for (uint32_t level = evicted.level; level-- > 0;)
+        {
+            const uint32_t shift = evicted.level - level;
+            auto it = _tiles.find(makeKey(level, evicted.face, evicted.x >> shift, evicted.y >> shift));
+            if (it != _tiles.end() && it->second.state == TileState::UPLOADED)
+            {
+                setIndirection(evicted, it->second);
+                break;
+            }
+        }
+        _uploadedTileCount--;
+    }
+
+    int32_t PanoramaStreamer::allocateSlot()
+    {
+        if (!_freeSlots.empty())
+        {
+            const int32_t slot = _freeSlots.back();
+            _freeSlots.pop_back();
+            return slot;
+        }
+
+        // evict the least recently visible tile (finest first), but never one that was visible in the last
+        // update (uploads happen before the visible tiles are collected for the current frame)
+        const Tile *lru = nullptr;
+        for (const auto &[key, tile] : _tiles)
+        {
+            if (tile.state != TileState::UPLOADED || tile.level == 0 || tile.lastVisible + 1 >= _frame)
+            {
+                continue;
+            }
+            if (!lru || tile.lastVisible < lru->lastVisible || (tile.lastVisible == lru->lastVisible && tile.level > lru->level))
+            {
+                lru = &tile;
+            }
+        }
+        if (!lru)
+        {
+            return -1;
+        }
+        const int32_t slot = lru->slot;
+        evict(slot);
+        return slot;
+    }
+
+    void PanoramaStreamer::uploadTile(DecodedTile &decoded)
+    {
+        const int32_t slot = allocateSlot();
+        if (slot < 0)
+        {
+            // every slot holds a visible tile, so drop this one (it will be requested again once there is room)
+            delete[] decoded.pixels;
+            _tiles.erase(decoded.key);
+            return;
+        }
+
+        Texture::PixelBufferDescriptor::Callback freeCallback = [](void *buf, size_t, void *)
+        {
+            delete[] reinterpret_cast<uint8_t *>(buf);
+        };
+
+        auto pbd = Texture::PixelBufferDescriptor(
+            decoded.pixels,
+            size_t(_slotSize) * _slotSize * 3,
+            Texture::Format::RGB,
+            Texture::Type::UBYTE,
+            freeCallback);
+
+        _atlasTexture->setImage(*_engine, 0, (slot % _slotsPerSide) * _slotSize, (slot / _slotsPerSide) * _slotSize, _slotSize, _slotSize, std::move(pbd));
+
+        Tile &tile = _tiles[decoded.key];
+        tile.state = TileState::UPLOADED;
+        tile.level = decoded.level;
+        tile.face = decoded.face;
+        tile.x = decoded.x;
+        tile.y = decoded.y;
+        tile.slot = slot;
+        tile.lastVisible = _frame;
+        _slotKeys[slot] = decoded.key;
+        _uploadedTileCount++;
+
+        setIndirection(tile, tile);
+
+        if (tile.level == 0)
+        {
+            _rootsUploaded++;
+            if (_rootsUploaded == 6)
+            {
+                // every direction is now covered
+                _scene->addEntity(_entity);
+            }
+        }
+    }
+
+    void PanoramaStreamer::collectRequests(
+        const filament::Frustum &frustum,
+        const float3 &cameraPosition,
+        const float3 &cameraForward,
+        float sphereScale,
+        uint32_t requiredLevel,
+        uint32_t level,
+        uint32_t face,
+        uint32_t x,
+        uint32_t y,
+        std::vector<TileRequest> &requests)
+    {
+        const float tilesPerSide = float(1u << level);
+        const float3 center = faceDirection(face, (x + 0.5f) / tilesPerSide, (y + 0.5f) / tilesPerSide);
+
+        // level 0 tiles are always required so the entire panorama is covered
+        if (level > 0)
+        {
+            // each tile is a patch on a cube (centered on the camera) with half-extent sphereScale
+            const float radius = 1.41421356f / tilesPerSide;
+            const float4 sphere(cameraPosition + center * sphereScale, radius * sphereScale);
+            if (!frustum.intersects(sphere))
+            {
+                return;
+            }
+        }
+
+        auto it = _tiles.find(makeKey(level, face, x, y));
+        if (it == _tiles.end())
+        {
+            requests.push_back({level, face, x, y, 1.0f - dot(normalize(center), cameraForward)});
+            return;
+        }
+
+        if (it->second.state != TileState::UPLOADED)
+        {
+            return;
+        }
+        it.value().lastVisible = _frame;
+
+        if (level >= requiredLevel)
+        {
+            return;
+        }
+
+        for (uint32_t cy = 0; cy < 2; cy++)
+        {
+            for (uint32_t cx = 0; cx < 2; cx++)
+            {
+                collectRequests(frustum, cameraPosition, cameraForward, sphereScale, requiredLevel, level + 1, face, x * 2 + cx, y * 2 + cy, requests);
+            }
+        }
+    }
+
+    void PanoramaStreamer::update(View *view)
+    {
+        _frame++;
+
+        std::vector<DecodedTile> ready;
+        {
+            std::lock_guard lock(_decodedMutex);
+            while (!_decoded.empty() && ready.size() < kMaxTileUploadsPerFrame)
+            {
+                ready.push_back(_decoded.front());
+                _decoded.pop_front();
+            }
+        }
+
+        for (auto &tile : ready)
+        {
+            _inFlight--;
+            if (!tile.pixels)
+            {
+                _tiles[tile.key].state = TileState::FAILED;
+                continue;
+            }
+            uploadTile(tile);
+        }
+
+        if (_indirectionDirty)
+        {
+            const size_t size = _indirection.size();
+            uint8_t *texels = new uint8_t[size];
+            std::copy(_indirection.begin(), _indirection.end(), texels);
+            _indirectionTexture->setImage(*_engine, 0, Texture::PixelBufferDescriptor(texels, size, Texture::Format::RGBA, Texture::Type::UBYTE, [](void *buf, size_t, void *)
+                                                                                       { delete[] reinterpret_cast<uint8_t *>(buf); }));
+            _indirectionDirty = false;
+        }
+
+        if (!view || _inFlight >= kMaxTilesInFlight)
+        {
+            return;
+        }
+
+        const Camera &camera = view->getCamera();
+        const auto &viewport = view->getViewport();
+
+        // pick the coarsest level whose texel density matches the viewport (each face spans 90 degrees)
+        const float fov = camera.getFieldOfViewInDegrees(Camera::Fov::VERTICAL);
+        const float requiredFacePixels = float(viewport.height) * 90.0f / std::max(fov, 1.0f);
+        uint32_t requiredLevel = 0;
+        while (requiredLevel + 1 < _numLevels && float(_tileSize << requiredLevel) < requiredFacePixels)
+        {
+            requiredLevel++;
+        }
+
+        // the panorama is at infinity, so test tiles on a cube that lies safely within the near/far planes
+        const float sphereScale = float(std::min(camera.getNear() * 10.0, camera.getCullingFar() * 0.5));
+        const float3 cameraPosition = float3(camera.getPosition());
+        const float3 cameraForward = normalize(float3(camera.getForwardVector()));
+        const filament::Frustum frustum = camera.getFrustum();
+
+        std::vector<TileRequest> requests;
+        for (uint32_t face = 0; face < 6; face++)
+        {
+            collectRequests(frustum, cameraPosition, cameraForward, sphereScale, requiredLevel, 0, face, 0, 0, requests);
+        }
+
+        // only request as many tiles as there are slots to hold them, so visible tiles never evict each other
+        int32_t available = int32_t(_freeSlots.size()) - int32_t(_inFlight);
+        for (const auto &[key, tile] : _tiles)
+        {
+            if (tile.state == TileState::UPLOADED && tile.level > 0 && tile.lastVisible + 1 < _frame)
+            {
+                available++;
+            }
+        }
+
+        // coarse levels first, then closest to the center of the view
+        std::sort(requests.begin(), requests.end(), [](const TileRequest &a, const TileRequest &b)
+                  { return a.level != b.level ? a.level < b.level : a.angle < b.angle; });
+
+        for (const auto &request : requests)
+        {
+            if (_inFlight >= kMaxTilesInFlight || (request.level > 0 && available <= 0))
+            {
+                break;
+            }
+            Tile &tile = _tiles[makeKey(request.level, request.face, request.x, request.y)];
+            tile.state = TileState::REQUESTED;
+            _inFlight++;
+            available--;
+            _decodes.add([=]
+                         { decodeTile(request.level, request.face, request.x, request.y); });
+        }
+    }
+}
@@ -32,6 +32,8 @@
 #include "SceneManager.hpp"
 #include "CustomGeometry.hpp"
 #include "UnprojectTexture.hpp"
+#include "ScreenSpaceBounds.hpp"
+#include "cgltf.h"
 
 extern "C"
 {
@@ -95,8 +97,21 @@ namespace thermion
 
         auto &tm = _engine->getTransformManager();
 
+#ifndef __EMSCRIPTEN__
+        const int numWorkerThreads = std::min(int(std::thread::hardware_concurrency()) - 1, kMaxWorkerThreads);
+        if (numWorkerThreads > 0)
+        {
+            _threadPool = new ThreadPool(numWorkerThreads);
+        }
+#endif
+
         _collisionComponentManager = new CollisionComponentManager(tm);
-        _animationComponentManager = new AnimationComponentManager(tm, _engine->getRenderableManager());
+        _raycastComponentManager = new RaycastComponentManager(tm, _engine->getRenderableManager(), _threadPool);
+        _spatialIndexComponentManager = new SpatialIndexComponentManager(tm);
+        _animationComponentManager = new AnimationComponentManager(tm, _engine->getRenderableManager(), _threadPool);
+
+        _textureStreamer = new TextureStreamer(_engine, _threadPool);
+        _vertexAnimationEpoch = _animationComponentManager->getTime();
 
         _gridOverlay = new GridOverlay(*_engine);
 
@@ -120,8 +135,18 @@ namespace thermion
         _gltfResourceLoader->asyncCancelLoad();
         _ubershaderProvider->destroyMaterials();
 
+        if (_vertexAnimationMaterial)
+        {
+            _engine->destroy(_vertexAnimationMaterial);
+        }
+
         delete _animationComponentManager;
         delete _collisionComponentManager;
+        delete _raycastComponentManager;
+        delete _spatialIndexComponentManager;
+        // after the component managers, since the tasks still queued may hold futures they created
+        delete _threadPool;
+        delete _textureStreamer;
         delete _ncm;
 
         delete _gltfResourceLoader;
@@ -225,8 +250,15 @@ namespace thermion
         FilamentInstance *inst = asset->getInstance();
         inst->getAnimator()->updateBoneMatrices();
         inst->recomputeBoundingBoxes();
+        addToSpatialIndex(asset->getEntities(), asset->getEntityCount());
 
-        if (!keepData)
+        _animationFrameRates[asset] = AnimationScrubber::computeFrameRates(static_cast<const cgltf_data *>(asset->getSourceAsset()));
+
+        if (keepData)
+        {
+            addRaycastComponents(asset, inst);
+        }
+        else
         {
             asset->releaseSourceData();
         }
@@ -331,8 +363,18 @@ namespace thermion
             auto instanceEntityId = Entity::smuggle(instanceEntity);
             _instances.emplace(instanceEntityId, inst);
         }
+        addToSpatialIndex(asset->getEntities(), asset->getEntityCount());
 
-        if (!keepData)
+        _animationFrameRates[asset] = AnimationScrubber::computeFrameRates(static_cast<const cgltf_data *>(asset->getSourceAsset()));
+
+        if (keepData)
+        {
+            for (int i = 0; i < asset->getAssetInstanceCount(); i++)
+            {
+                addRaycastComponents(asset, asset->getAssetInstances()[i]);
+            }
+        }
+        else
         {
             asset->releaseSourceData();
         }
@@ -410,6 +452,8 @@ namespace thermion
         }
         auto root = instance->getRoot();
         _scene->addEntities(instance->getEntities(), instance->getEntityCount());
+        addToSpatialIndex(instance->getEntities(), instance->getEntityCount());
+        addRaycastComponents(asset, instance);
 
         return Entity::smuggle(root);
     }
@@ -530,6 +574,14 @@ namespace thermion
                     {
                         _animationComponentManager->removeComponent(childEntity);
                     }
+                    if (_raycastComponentManager->hasComponent(childEntity))
+                    {
+                        _raycastComponentManager->removeComponent(childEntity);
+                    }
+                    if (_spatialIndexComponentManager->hasComponent(childEntity))
+                    {
+                        _spatialIndexComponentManager->removeComponent(childEntity);
+                    }
                 }
             }
 
@@ -542,6 +594,8 @@ namespace thermion
         for(auto *texture : _textures) {
             _engine->destroy(texture);
         }
+        _textureStreamer->clear();
+        destroyVertexAnimations();
 
         for(auto *materialInstance : _materialInstances) {
             _engine->destroy(materialInstance);
@@ -550,6 +604,9 @@ namespace thermion
         // TODO - free geometry?
         _textures.clear();
         _assets.clear();
+        _animationScrubbers.clear();
+        _animationFrameRates.clear();
+        _meshBvhs.clear();
         _materialInstances.clear();
     }
 
@@ -672,6 +729,16 @@ namespace thermion
             _collisionComponentManager->removeComponent(entity);
         }
 
+        if (_raycastComponentManager->hasComponent(entity))
+        {
+            _raycastComponentManager->removeComponent(entity);
+        }
+
+        if (_spatialIndexComponentManager->hasComponent(entity))
+        {
+            _spatialIndexComponentManager->removeComponent(entity);
+        }
+
         _scene->remove(entity);
 
         if(isGeometryEntity(entityId)) {
@@ -683,6 +750,7 @@ namespace thermion
         if (instance)
         {
             _instances.erase(entityId);
+            _animationScrubbers.erase(instance);
             _scene->removeEntities(instance->getEntities(), instance->getEntityCount());
             for (int i = 0; i < instance->getEntityCount(); i++)
             {
@@ -695,6 +763,14 @@ namespace thermion
                 {
                     _animationComponentManager->removeComponent(childEntity);
                 }
+                if (_raycastComponentManager->hasComponent(childEntity))
+                {
+                    _raycastComponentManager->removeComponent(childEntity);
+                }
+                if (_spatialIndexComponentManager->hasComponent(childEntity))
+                {
+                    _spatialIndexComponentManager->removeComponent(childEntity);
+                }
             }
         }
         else
@@ -706,6 +782,12 @@ namespace thermion
                 return;
             }
             _assets.erase(entityId);
+            _animationFrameRates.erase(asset);
+            _meshBvhs.erase(asset);
+            for (size_t i = 0; i < asset->getAssetInstanceCount(); i++)
+            {
+                _animationScrubbers.erase(asset->getAssetInstances()[i]);
+            }
 
             _scene->removeEntities(asset->getEntities(), asset->getEntityCount());
 
@@ -722,6 +804,14 @@ namespace thermion
                 {
                     _animationComponentManager->removeComponent(childEntity);
                 }
+                if (_raycastComponentManager->hasComponent(childEntity))
+                {
+                    _raycastComponentManager->removeComponent(childEntity);
+                }
+                if (_spatialIndexComponentManager->hasComponent(childEntity))
+                {
+                    _spatialIndexComponentManager->removeComponent(childEntity);
+                }
             }
 
             auto lightCount = asset->getLightEntityCount();
@@ -837,11 +927,8 @@ namespace thermion
         MorphAnimation morphAnimation;
 
         morphAnimation.meshTarget = entity;
-        morphAnimation.frameData.clear();
-        morphAnimation.frameData.insert(
-            morphAnimation.frameData.begin(),
-            morphData,
-            morphData + (numFrames * numMorphTargets));
+        morphAnimation.frameData = MorphTrack::compress(morphData, numFrames, numMorphTargets);
+        _animationComponentManager->addClipStats(size_t(numFrames) * numMorphTargets * sizeof(float), morphAnimation.frameData.getSizeInBytes());
         morphAnimation.frameLengthInMs = frameLengthInMs;
         morphAnimation.morphIndices.resize(numMorphTargets);
         for (int i = 0; i < numMorphTargets; i++)
@@ -850,7 +937,7 @@ namespace thermion
         }
         morphAnimation.durationInSecs = (frameLengthInMs * numFrames) / 1000.0f;
 
-        morphAnimation.start = high_resolution_clock::now();
+        morphAnimation.start = _animationComponentManager->getTime();
         morphAnimation.lengthInFrames = static_cast<int>(
             morphAnimation.durationInSecs * 1000.0f /
             frameLengthInMs);
@@ -1188,9 +1275,8 @@ namespace thermion
 
         BoneAnimation animation;
         animation.boneIndex = boneIndex;
-        animation.frameData.clear();
-
-        const auto &inverseBindMatrix = instance->getInverseBindMatricesAt(skinIndex)[boneIndex];
+        std::vector<math::mat4f> frames;
+        frames.reserve(numFrames);
 
         for (int i = 0; i < numFrames; i++)
         {
@@ -1212,11 +1298,15 @@ namespace thermion
                 frameData[(i * 16) + 14],
                 frameData[(i * 16) + 15]);
 
-            animation.frameData.push_back(frame);
+            frames.push_back(frame);
         }
 
+        // decomposed/compressed once here rather than every frame when the animation is sampled
+        animation.frameData = TransformTrack::compress(frames, _animationComponentManager->getCompressionSettings());
+        _animationComponentManager->addClipStats(frames.size() * sizeof(math::mat4f), animation.frameData.getSizeInBytes());
+
         animation.frameLengthInMs = frameLengthInMs;
-        animation.start = std::chrono::high_resolution_clock::now();
+        animation.start = _animationComponentManager->getTime();
         animation.reverse = false;
         animation.durationInSecs = (frameLengthInMs * numFrames) / 1000.0f;
         animation.lengthInFrames = numFrames;
@@ -1235,7 +1325,7 @@ namespace thermion
         auto &animationComponent = _animationComponentManager->elementAt<0>(animationComponentInstance);
         auto &boneAnimations = animationComponent.boneAnimations;
 
-        boneAnimations.emplace_back(animation);
+        boneAnimations.emplace_back(std::move(animation));
 
         return true;
     }
@@ -1281,7 +1371,7 @@ namespace thermion
                 auto &last = animationComponent.gltfAnimations.back();
                 animationComponent.fadeGltfAnimationIndex = last.index;
                 animationComponent.fadeDuration = crossfade;
-                auto now = high_resolution_clock::now();
+                auto now = _animationComponentManager->getTime();
                 auto elapsedInSecs = float(std::chrono::duration_cast<std::chrono::milliseconds>(now - last.start).count()) / 1000.0f;
                 animationComponent.fadeOutAnimationStart = elapsedInSecs;
                 animationComponent.gltfAnimations.clear();
@@ -1306,7 +1396,7 @@ namespace thermion
         GltfAnimation animation;
         animation.startOffset = startOffset;
         animation.index = index;
-        animation.start = std::chrono::high_resolution_clock::now();
+        animation.start = _animationComponentManager->getTime();
         animation.loop = loop;
         animation.reverse = reverse;
         animation.durationInSecs = instance->getAnimator()->getAnimationDuration(index);
@@ -1358,260 +1448,602 @@ namespace thermion
                                                 animationComponent.gltfAnimations.end());
     }
 
-    Texture *SceneManager::createTexture(const uint8_t *data, size_t length, const char *name)
+    int SceneManager::addAnimationLayer(EntityId entityId, int animationIndex, float weight, int mode, bool loop, const EntityId *maskEntities, int maskCount)
     {
-        using namespace filament;
-
-        // Create an input stream from the data
-        std::istringstream stream(std::string(reinterpret_cast<const char *>(data), length));
-
-        // Decode the image
-        image::LinearImage linearImage = image::ImageDecoder::decode(stream, name, image::ImageDecoder::ColorSpace::SRGB);
-
-        if (!linearImage.isValid())
-        {
-            Log("Failed to decode image.");
-            return nullptr;
-        }
-
-        uint32_t w = linearImage.getWidth();
-        uint32_t h = linearImage.getHeight();
-        uint32_t channels = linearImage.getChannels();
-
-        Texture::InternalFormat textureFormat = channels == 3 ? Texture::InternalFormat::RGB16F
-                                                              : Texture::InternalFormat::RGBA16F;
-        Texture::Format bufferFormat = channels == 3 ? Texture::Format::RGB
-                                                     : Texture::Format::RGBA;
-
-        Texture *texture = Texture::Builder()
-                               .width(w)
-                               .height(h)
-                               .levels(1)
-                               .format(textureFormat)
-                               .sampler(Texture::Sampler::SAMPLER_2D)
-                               .build(*_engine);
+        std::lock_guard lock(_mutex);
 
-        if (!texture)
+        auto *instance = getInstanceByEntityId(entityId);
+        if (!instance)
         {
-            Log("Failed to create texture: ");
-            return nullptr;
+            auto *asset = getAssetByEntityId(entityId);
+            if (!asset)
+            {
+                Log("Failed to find instance for entity");
+                return -1;
+            }
+            instance = asset->getInstance();
         }
 
-        Texture::PixelBufferDescriptor buffer(
-            linearImage.getPixelRef(),
-            size_t(w * h * channels * sizeof(float)),
-            bufferFormat,
-            Texture::Type::FLOAT);
-
-        texture->setImage(*_engine, 0, std::move(buffer));
-
-        Log("Created texture: %s (%d x %d, %d channels)", name, w, h, channels);
-
-        _textures.insert(texture);
-
-        return texture;
-    }
-
-    bool SceneManager::applyTexture(EntityId entityId, Texture *texture, const char* parameterName, int materialIndex)
-    {
-        auto entity = Entity::import(entityId);
-
-        if (entity.isNull())
+        if (animationIndex < 0 || size_t(animationIndex) >= instance->getAnimator()->getAnimationCount())
         {
-            Log("Entity %d is null?", entityId);
-            return false;
+            Log("ERROR: glTF animation index %d is out of range", animationIndex);
+            return -1;
         }
 
-        RenderableManager &rm = _engine->getRenderableManager();
-
-        auto renderable = rm.getInstance(entity);
-
-        if (!renderable.isValid())
+        std::vector<Entity> maskRoots;
+        for (int i = 0; i < maskCount; i++)
         {
-            Log("Renderable not valid, was the entity id correct (%d)?", entityId);
-            return false;
+            maskRoots.push_back(Entity::import(maskEntities[i]));
         }
 
-        MaterialInstance *mi = rm.getMaterialInstanceAt(renderable, materialIndex);
-
-        if (!mi)
+        auto layerId = _animationComponentManager->addLayer(instance, animationIndex, weight, (AnimationBlendMode)mode, loop, maskRoots, getAnimationScrubber(instance));
+        if (layerId < 0)
         {
-            Log("ERROR: material index must be less than number of material instances");
-            return false;
+            Log("ERROR: entity %d has no animation component", entityId);
         }
-
-        auto sampler = TextureSampler();
-        mi->setParameter(parameterName, texture, sampler);
-        Log("Applied texture to entity %d", entityId);
-        return true;
-    }
-
-    void SceneManager::destroyTexture(Texture* texture) {
-        if(_textures.find(texture) == _textures.end()) {
-            Log("Warning: couldn't find texture");
-        } 
-        _textures.erase(texture);
-        _engine->destroy(texture);
-    }
-
-    void SceneManager::setAnimationFrame(EntityId entityId, int animationIndex, int animationFrame)
-    {
-        auto *instance = getInstanceByEntityId(entityId);
-        auto offset = 60 * animationFrame * 1000; // TODO - don't hardcore 60fps framerate
-        instance->getAnimator()->applyAnimation(animationIndex, offset);
-        instance->getAnimator()->updateBoneMatrices();
+        return layerId;
     }
 
-    float SceneManager::getAnimationDuration(EntityId entity, int animationIndex)
+    bool SceneManager::setAnimationLayerWeight(EntityId entityId, int layerId, float weight)
     {
-        auto *instance = getInstanceByEntityId(entity);
+        std::lock_guard lock(_mutex);
 
+        auto *instance = getInstanceByEntityId(entityId);
         if (!instance)
         {
-            auto *asset = getAssetByEntityId(entity);
+            auto *asset = getAssetByEntityId(entityId);
             if (!asset)
             {
-                return -1.0f;
+                Log("Failed to find instance for entity");
+                return false;
             }
             instance = asset->getInstance();
         }
-        return instance->getAnimator()->getAnimationDuration(animationIndex);
+        return _animationComponentManager->setLayerWeight(instance, layerId, weight);
     }
 
-    unique_ptr<std::vector<std::string>> SceneManager::getAnimationNames(EntityId entity)
+    bool SceneManager::removeAnimationLayer(EntityId entityId, int layerId)
     {
+        std::lock_guard lock(_mutex);
 
-        const auto &pos = _instances.find(entity);
-
-        unique_ptr<std::vector<std::string>> names = std::make_unique<std::vector<std::string>>();
-
-        FilamentInstance *instance;
-
-        if (pos != _instances.end())
-        {
-            instance = pos->second;
-        }
-        else
+        auto *instance = getInstanceByEntityId(entityId);
+        if (!instance)
         {
-            const auto &assetPos = _assets.find(entity);
-            if (assetPos != _assets.end())
-            {
-                instance = assetPos->second->getInstance();
-            }
-            else
+            auto *asset = getAssetByEntityId(entityId);
+            if (!asset)
             {
-                Log("Could not resolve entity ID %d to FilamentInstance or FilamentAsset");
-                return names;
+                Log("Failed to find instance for entity");
+                return false;
             }
+            instance = asset->getInstance();
         }
+        return _animationComponentManager->removeLayer(instance, layerId);
+    }
 
-        size_t count = instance->getAnimator()->getAnimationCount();
-
-        for (size_t i = 0; i < count; i++)
+    int SceneManager::createAnimationStateMachine(const uint8_t *data, size_t length)
+    {
+        std::lock_guard lock(_mutex);
+        auto stateMachine = AnimationStateMachine::parse(data, length);
+        if (!stateMachine)
         {
-            names->push_back(instance->getAnimator()->getAnimationName(i));
+            return -1;
         }
-
-        return names;
+        const int id = _nextAnimationStateMachineId++;
+        _animationStateMachines.emplace(id, stateMachine);
+        return id;
     }
 
-    unique_ptr<std::vector<std::string>> SceneManager::getMorphTargetNames(EntityId assetEntityId, EntityId child)
+    void SceneManager::destroyAnimationStateMachine(int stateMachine)
     {
-        unique_ptr<std::vector<std::string>> names = std::make_unique<std::vector<std::string>>();
+        std::lock_guard lock(_mutex);
+        // entities that are still using the state machine keep a reference to it
+        _animationStateMachines.erase(stateMachine);
+    }
 
-        const auto *instance = getInstanceByEntityId(assetEntityId);
+    bool SceneManager::setAnimationStateMachine(EntityId entityId, int stateMachine)
+    {
+        std::lock_guard lock(_mutex);
 
+        auto *instance = getInstanceByEntityId(entityId);
         if (!instance)
         {
-            auto asset = getAssetByEntityId(assetEntityId);
+            auto *asset = getAssetByEntityId(entityId);
             if (!asset)
             {
-                Log("Warning - failed to find specified asset. This is unexpected and probably indicates you are passing the wrong entity");
-                return names;
+                Log("Failed to find instance for entity");
+                return false;
             }
             instance = asset->getInstance();
-            if (!instance)
+        }
+
+        std::shared_ptr<const AnimationStateMachine> definition;
+        if (stateMachine >= 0)
+        {
+            auto it = _animationStateMachines.find(stateMachine);
+            if (it == _animationStateMachines.end())
             {
-                Log("Warning - failed to find instance for specified asset. This is unexpected and probably indicates you are passing the wrong entity");
-                return names;
+                Log("ERROR: animation state machine %d not found", stateMachine);
+                return false;
             }
+            definition = it->second;
         }
+        return _animationComponentManager->setStateMachine(instance, definition);
+    }
 
-        const auto *asset = instance->getAsset();
-
-        const utils::Entity *entities = asset->getEntities();
-
-        const utils::Entity target = Entity::import(child);
+    bool SceneManager::setAnimationStateMachineParameter(EntityId entityId, int parameter, float value)
+    {
+        std::lock_guard lock(_mutex);
 
-        for (int i = 0; i < asset->getEntityCount(); i++)
+        auto *instance = getInstanceByEntityId(entityId);
+        if (!instance)
         {
-
-            utils::Entity e = entities[i];
-            if (e == target)
+            auto *asset = getAssetByEntityId(entityId);
+            if (!asset)
             {
-                size_t count = asset->getMorphTargetCountAt(e);
-                for (int j = 0; j < count; j++)
-                {
-                    const char *morphName = asset->getMorphTargetNameAt(e, j);
-                    names->push_back(morphName);
-                }
-                break;
+                Log("Failed to find instance for entity");
+                return false;
             }
+            instance = asset->getInstance();
         }
-        return names;
+        return _animationComponentManager->setStateMachineParameter(instance, parameter, value);
     }
 
-    unique_ptr<vector<string>> SceneManager::getBoneNames(EntityId assetEntityId, int skinIndex)
+    int SceneManager::getAnimationStateMachineState(EntityId entityId)
     {
+        std::lock_guard lock(_mutex);
 
-        unique_ptr<std::vector<std::string>> names = std::make_unique<std::vector<std::string>>();
-
-        auto *instance = getInstanceByEntityId(assetEntityId);
-
+        auto *instance = getInstanceByEntityId(entityId);
         if (!instance)
         {
-            auto *asset = getAssetByEntityId(assetEntityId);
-            if (asset)
-            {
-                instance = asset->getInstance();
-            }
-            else
+            auto *asset = getAssetByEntityId(entityId);
+            if (!asset)
             {
-                Log("ERROR: failed to find instance for entity %d", assetEntityId);
-                return names;
+                Log("Failed to find instance for entity");
+                return -1;
             }
+            instance = asset->getInstance();
         }
+        return _animationComponentManager->getStateMachineState(instance);
+    }
 
-        size_t skinCount = instance->getSkinCount();
+    bool SceneManager::loadVertexAnimationMaterial(const char *uri)
+    {
+        std::lock_guard lock(_mutex);
 
-        if (skinCount > 1)
+        ResourceBuffer rb = _resourceLoaderWrapper->load(uri);
+        if (rb.size <= 0)
         {
-            Log("WARNING - skin count > 1 not currently implemented. This will probably not work");
+            Log("ERROR: failed to load vertex animation material %s", uri);
+            return false;
         }
-
-        size_t numJoints = instance->getJointCountAt(skinIndex);
-        auto joints = instance->getJointsAt(skinIndex);
-        for (int i = 0; i < numJoints; i++)
+        auto *material = Material::Builder()
+                             .package(rb.data, rb.size)
+                             .build(*_engine);
+        _resourceLoaderWrapper->free(rb);
+        if (!material)
         {
-            const char *jointName = _ncm->getName(_ncm->getInstance(joints[i]));
-            names->push_back(jointName);
+            Log("ERROR: failed to build vertex animation material %s", uri);
+            return false;
         }
-        return names;
+        if (_vertexAnimationMaterial)
+        {
+            Log("Vertex animation material has already been loaded");
+            _engine->destroy(material);
+            return true;
+        }
+        _vertexAnimationMaterial = material;
+        return true;
     }
 
-    void SceneManager::transformToUnitCube(EntityId entityId)
+    int SceneManager::bakeVertexAnimation(EntityId entityId, int animationIndex, float frameRate)
     {
-        const auto *instance = getInstanceByEntityId(entityId);
+        std::lock_guard lock(_mutex);
+
+        auto *instance = getInstanceByEntityId(entityId);
         if (!instance)
         {
-            auto asset = getAssetByEntityId(entityId);
-            if (asset)
+            auto *asset = getAssetByEntityId(entityId);
+            if (!asset)
             {
-                instance = asset->getInstance();
+                Log("Failed to find instance for entity");
+                return -1;
             }
-            else
-            {
-                return;
+            instance = asset->getInstance();
+        }
+
+        auto *vertexAnimation = VertexAnimationTexture::bake(_engine, instance->getAsset(), instance, animationIndex, frameRate);
+        if (!vertexAnimation)
+        {
+            return -1;
+        }
+        const int id = _nextVertexAnimationId++;
+        _vertexAnimations.emplace(id, unique_ptr<VertexAnimationTexture>(vertexAnimation));
+        return id;
+    }
+
+    EntityId SceneManager::createVertexAnimationInstances(int vertexAnimation, const float *transforms, const float *timeOffsets, int count)
+    {
+        std::lock_guard lock(_mutex);
+
+        if (!_vertexAnimationMaterial)
+        {
+            Log("ERROR: the vertex animation material has not been loaded");
+            return 0;
+        }
+        auto it = _vertexAnimations.find(vertexAnimation);
+        if (it == _vertexAnimations.end())
+        {
+            Log("ERROR: vertex animation %d not found", vertexAnimation);
+            return 0;
+        }
+        auto entity = it->second->createInstances(_vertexAnimationMaterial, reinterpret_cast<const math::mat4f *>(transforms), timeOffsets, count);
+        if (entity.isNull())
+        {
+            return 0;
+        }
+        _scene->addEntity(entity);
+        return Entity::smuggle(entity);
+    }
+
+    bool SceneManager::setVertexAnimationInstances(EntityId entityId, const float *transforms, const float *timeOffsets, int count)
+    {
+        std::lock_guard lock(_mutex);
+        auto entity = Entity::import(entityId);
+        for (auto &[id, vertexAnimation] : _vertexAnimations)
+        {
+            if (vertexAnimation->hasInstances(entity))
+            {
+                return vertexAnimation->setInstances(entity, reinterpret_cast<const math::mat4f *>(transforms), timeOffsets, count);
+            }
+        }
+        Log("ERROR: entity %d was not created by createVertexAnimationInstances", entityId);
+        return false;
+    }
+
+    bool SceneManager::destroyVertexAnimationInstances(EntityId entityId)
+    {
+        std::lock_guard lock(_mutex);
+        auto entity = Entity::import(entityId);
+        for (auto &[id, vertexAnimation] : _vertexAnimations)
+        {
+            if (vertexAnimation->hasInstances(entity))
+            {
+                _scene->remove(entity);
+                return vertexAnimation->destroyInstances(entity);
+            }
+        }
+        return false;
+    }
+
+    void SceneManager::destroyVertexAnimation(int vertexAnimation)
+    {
+        std::lock_guard lock(_mutex);
+        auto it = _vertexAnimations.find(vertexAnimation);
+        if (it == _vertexAnimations.end())
+        {
+            Log("ERROR: vertex animation %d not found", vertexAnimation);
+            return;
+        }
+        for (auto entity : it->second->getInstanceEntities())
+        {
+            _scene->remove(entity);
+        }
+        _vertexAnimations.erase(it);
+    }
+
+    void SceneManager::destroyVertexAnimations()
+    {
+        for (auto &[id, vertexAnimation] : _vertexAnimations)
+        {
+            for (auto entity : vertexAnimation->getInstanceEntities())
+            {
+                _scene->remove(entity);
+            }
+        }
+        _vertexAnimations.clear();
+    }
+
+    Texture *SceneManager::createTexture(const uint8_t *data, size_t length, const char *name)
+    {
+        return _textureStreamer->create(data, length, name);
+    }
+
+    bool SceneManager::applyTexture(EntityId entityId, Texture *texture, const char* parameterName, int materialIndex)
+    {
+        auto entity = Entity::import(entityId);
+
+        if (entity.isNull())
+        {
+            Log("Entity %d is null?", entityId);
+            return false;
+        }
+
+        RenderableManager &rm = _engine->getRenderableManager();
+
+        auto renderable = rm.getInstance(entity);
+
+        if (!renderable.isValid())
+        {
+            Log("Renderable not valid, was the entity id correct (%d)?", entityId);
+            return false;
+        }
+
+        if (_textureStreamer->isStreamed(texture))
+        {
+            if (!_textureStreamer->bind(texture, entity, materialIndex, parameterName))
+            {
+                return false;
+            }
+            Log("Applied streamed texture to entity %d", entityId);
+            return true;
+        }
+
+        MaterialInstance *mi = rm.getMaterialInstanceAt(renderable, materialIndex);
+
+        if (!mi)
+        {
+            Log("ERROR: material index must be less than number of material instances");
+            return false;
+        }
+
+        auto sampler = TextureSampler();
+        mi->setParameter(parameterName, texture, sampler);
+        Log("Applied texture to entity %d", entityId);
+        return true;
+    }
+
+    void SceneManager::destroyTexture(Texture* texture) {
+        if(_textureStreamer->destroy(texture)) {
+            return;
+        }
+        if(_textures.find(texture) == _textures.end()) {
+            Log("Warning: couldn't find texture");
+        } 
+        _textures.erase(texture);
+        _engine->destroy(texture);
+    }
+
+    void SceneManager::setAnimationFrame(EntityId entityId, int animationIndex, int animationFrame)
+    {
+        const float frameRate = getAnimationFrameRate(entityId, animationIndex);
+        if (frameRate <= 0.0f)
+        {
+            return;
+        }
+        seekAnimation(entityId, animationIndex, float(animationFrame) / frameRate);
+    }
+
+    bool SceneManager::seekAnimation(EntityId entityId, int animationIndex, float timeInSecs)
+    {
+        std::lock_guard lock(_mutex);
+
+        auto *instance = getInstanceByEntityId(entityId);
+        if (!instance)
+        {
+            auto *asset = getAssetByEntityId(entityId);
+            if (!asset)
+            {
+                Log("Failed to find instance for entity %d", entityId);
+                return false;
+            }
+            instance = asset->getInstance();
+        }
+
+        auto *animator = instance->getAnimator();
+        if (animationIndex < 0 || size_t(animationIndex) >= animator->getAnimationCount())
+        {
+            Log("ERROR: glTF animation index %d is out of range", animationIndex);
+            return false;
+        }
+
+        auto *scrubber = getAnimationScrubber(instance);
+        if (scrubber)
+        {
+            scrubber->seek(animationIndex, timeInSecs);
+        }
+        else
+        {
+            // the source data has been released, so fall back to the Animator (which searches every channel from scratch)
+            animator->applyAnimation(animationIndex, std::clamp(timeInSecs, 0.0f, animator->getAnimationDuration(animationIndex)));
+        }
+        animator->updateBoneMatrices();
+        return true;
+    }
+
+    float SceneManager::getAnimationFrameRate(EntityId entityId, int animationIndex)
+    {
+        auto *instance = getInstanceByEntityId(entityId);
+        if (!instance)
+        {
+            auto *asset = getAssetByEntityId(entityId);
+            if (!asset)
+            {
+                Log("Failed to find instance for entity %d", entityId);
+                return -1.0f;
+            }
+            instance = asset->getInstance();
+        }
+
+        const auto it = _animationFrameRates.find(instance->getAsset());
+        if (animationIndex < 0 || size_t(animationIndex) >= instance->getAnimator()->getAnimationCount())
+        {
+            Log("ERROR: glTF animation index %d is out of range", animationIndex);
+            return -1.0f;
+        }
+        if (it == _animationFrameRates.end() || size_t(animationIndex) >= it->second.size())
+        {
+            return AnimationScrubber::kDefaultFrameRate;
+        }
+        return it->second[animationIndex];
+    }
+
+    AnimationScrubber *SceneManager::getAnimationScrubber(FilamentInstance *instance)
+    {
+        const auto it = _animationScrubbers.find(instance);
+        if (it != _animationScrubbers.end())
+        {
+            return it->second.get();
+        }
+        // the keyframes are read from the source data, which is only retained for assets loaded with keepData
+        auto *scrubber = AnimationScrubber::create(_engine, instance->getAsset(), instance);
+        if (!scrubber)
+        {
+            return nullptr;
+        }
+        _animationScrubbers.emplace(instance, unique_ptr<AnimationScrubber>(scrubber));
+        return scrubber;
+    }
+
+    float SceneManager::getAnimationDuration(EntityId entity, int animationIndex)
+    {
+        auto *instance = getInstanceByEntityId(entity);
+
+        if (!instance)
+        {
+            auto *asset = getAssetByEntityId(entity);
+            if (!asset)
+            {
+                return -1.0f;
+            }
+            instance = asset->getInstance();
+        }
+        return instance->getAnimator()->getAnimationDuration(animationIndex);
+    }
+
+    unique_ptr<std::vector<std::string>> SceneManager::getAnimationNames(EntityId entity)
+    {
+
+        const auto &pos = _instances.find(entity);
+
+        unique_ptr<std::vector<std::string>> names = std::make_unique<std::vector<std::string>>();
+
+        FilamentInstance *instance;
+
+        if (pos != _instances.end())
+        {
+            instance = pos->second;
+        }
+        else
+        {
+            const auto &assetPos = _assets.find(entity);
+            if (assetPos != _assets.end())
+            {
+                instance = assetPos->second->getInstance();
+            }
+            else
+            {
+                Log("Could not resolve entity ID %d to FilamentInstance or FilamentAsset");
+                return names;
+            }
+        }
+
+        size_t count = instance->getAnimator()->getAnimationCount();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            names->push_back(instance->getAnimator()->getAnimationName(i));
+        }
+
+        return names;
+    }
+
+    unique_ptr<std::vector<std::string>> SceneManager::getMorphTargetNames(EntityId assetEntityId, EntityId child)
+    {
+        unique_ptr<std::vector<std::string>> names = std::make_unique<std::vector<std::string>>();
+
+        const auto *instance = getInstanceByEntityId(assetEntityId);
+
+        if (!instance)
+        {
+            auto asset = getAssetByEntityId(assetEntityId);
+            if (!asset)
+            {
+                Log("Warning - failed to find specified asset. This is unexpected and probably indicates you are passing the wrong entity");
+                return names;
+            }
+            instance = asset->getInstance();
+            if (!instance)
+            {
+                Log("Warning - failed to find instance for specified asset. This is unexpected and probably indicates you are passing the wrong entity");
+                return names;
+            }
+        }
+
+        const auto *asset = instance->getAsset();
+
+        const utils::Entity *entities = asset->getEntities();
+
+        const utils::Entity target = Entity::import(child);
+
+        for (int i = 0; i < asset->getEntityCount(); i++)
+        {
+
+            utils::Entity e = entities[i];
+            if (e == target)
+            {
+                size_t count = asset->getMorphTargetCountAt(e);
+                for (int j = 0; j < count; j++)
+                {
+                    const char *morphName = asset->getMorphTargetNameAt(e, j);
+                    names->push_back(morphName);
+                }
+                break;
+            }
+        }
+        return names;
+    }
+
+    unique_ptr<vector<string>> SceneManager::getBoneNames(EntityId assetEntityId, int skinIndex)
+    {
+
+        unique_ptr<std::vector<std::string>> names = std::make_unique<std::vector<std::string>>();
+
+        auto *instance = getInstanceByEntityId(assetEntityId);
+
+        if (!instance)
+        {
+            auto *asset = getAssetByEntityId(assetEntityId);
+            if (asset)
+            {
+                instance = asset->getInstance();
+            }
+            else
+            {
+                Log("ERROR: failed to find instance for entity %d", assetEntityId);
+                return names;
+            }
+        }
+
+        size_t skinCount = instance->getSkinCount();
+
+        if (skinCount > 1)
+        {
+            Log("WARNING - skin count > 1 not currently implemented. This will probably not work");
+        }
+
+        size_t numJoints = instance->getJointCountAt(skinIndex);
+        auto joints = instance->getJointsAt(skinIndex);
+        for (int i = 0; i < numJoints; i++)
+        {
+            const char *jointName = _ncm->getName(_ncm->getInstance(joints[i]));
+            names->push_back(jointName);
+        }
+        return names;
+    }
+
+    void SceneManager::transformToUnitCube(EntityId entityId)
+    {
+        const auto *instance = getInstanceByEntityId(entityId);
+        if (!instance)
+        {
+            auto asset = getAssetByEntityId(entityId);
+            if (asset)
+            {
+                instance = asset->getInstance();
+            }
+            else
+            {
+                return;
             }
         }
         auto &tm = _engine->getTransformManager();
@@ -1703,7 +2135,7 @@ namespace thermion
         tm.setParent(childInstance, parentInstance);
     }
 
-    void SceneManager::addCollisionComponent(EntityId entityId, void (*onCollisionCallback)(const EntityId entityId1, const EntityId entityId2), bool affectsTransform)
+    void SceneManager::addCollisionComponent(EntityId entityId, void (*onCollisionCallback)(const EntityId entityId1, const EntityId entityId2), bool affectsTransform, CollisionShapeType shapeType)
     {
         std::lock_guard lock(_mutex);
         const auto *instance = getInstanceByEntityId(entityId);
@@ -1719,10 +2151,57 @@ namespace thermion
                 instance = asset->getInstance();
             }
         }
-        auto collisionInstance = _collisionComponentManager->addComponent(instance->getRoot());
-        _collisionComponentManager->elementAt<0>(collisionInstance) = instance->getBoundingBox();
-        _collisionComponentManager->elementAt<1>(collisionInstance) = onCollisionCallback;
-        _collisionComponentManager->elementAt<2>(collisionInstance) = affectsTransform;
+
+        const auto boundingBox = instance->getBoundingBox();
+        std::shared_future<OrientedBox> fitted;
+        if (shapeType == CollisionShapeType::OBB)
+        {
+            // the vertices of each mesh are those the mesh's BVH was built from (so this requires keepData), transformed into
+            // the space of the root entity
+            const auto &tm = _engine->getTransformManager();
+            const auto rootFromWorld = inverse(tm.getWorldTransform(tm.getInstance(instance->getRoot())));
+            std::vector<std::pair<MeshBvhFuture, math::mat4f>> meshes;
+            for (size_t i = 0; i < instance->getEntityCount(); i++)
+            {
+                const auto entity = instance->getEntities()[i];
+                auto bvh = _raycastComponentManager->getBvh(entity);
+                if (bvh.valid())
+                {
+                    meshes.emplace_back(std::move(bvh), rootFromWorld * tm.getWorldTransform(tm.getInstance(entity)));
+                }
+            }
+            if (!meshes.empty())
+            {
+                const auto fallback = OrientedBox::fromAabb(boundingBox);
+                std::packaged_task<OrientedBox()> task([meshes = std::move(meshes), fallback]()
+                                                       {
+                    std::vector<math::float3> points;
+                    for (const auto &[future, transform] : meshes)
+                    {
+                        const auto &bvh = future.get();
+                        if (!bvh)
+                        {
+                            continue;
+                        }
+                        for (const auto &position : bvh->getPositions())
+                        {
+                            points.push_back((transform * math::float4(position, 1.0f)).xyz);
+                        }
+                    }
+                    const auto box = OrientedBox::fit(points.data(), points.size());
+                    return !points.empty() && box.getVolume() < fallback.getVolume() ? box : fallback; });
+                if (_threadPool)
+                {
+                    fitted = _threadPool->add_task(task).share();
+                }
+                else
+                {
+                    fitted = task.get_future().share();
+                    task();
+                }
+            }
+        }
+        _collisionComponentManager->addComponent(instance->getRoot(), boundingBox, onCollisionCallback, affectsTransform, shapeType, std::move(fitted));
     }
 
     void SceneManager::removeCollisionComponent(EntityId entityId)
@@ -1766,19 +2245,452 @@ namespace thermion
         auto worldTransform = tm.getWorldTransform(transformInstance);
         auto aabb = instance->getBoundingBox();
         aabb = aabb.transform(worldTransform);
-        _collisionComponentManager->collides(instance->getRoot(), aabb);
+        _collisionComponentManager->refit();
+        OrientedBox shape;
+        const bool hasShape = _collisionComponentManager->getShape(instance->getRoot(), worldTransform, shape);
+        if (hasShape)
+        {
+            aabb = shape.getBounds();
+        }
+        _collisionComponentManager->collides(instance->getRoot(), aabb, hasShape ? &shape : nullptr);
+    }
+
+    void SceneManager::updateCollisions()
+    {
+        std::lock_guard lock(_mutex);
+        _collisionComponentManager->update();
+    }
+
+    void SceneManager::setStopAtFirstContact(bool enabled)
+    {
+        std::lock_guard lock(_mutex);
+        _stopAtFirstContact = enabled;
+    }
+
+    float SceneManager::timeOfImpact(EntityId entityId, float dx, float dy, float dz, EntityId *hitEntity)
+    {
+        std::lock_guard lock(_mutex);
+        const auto *instance = getInstanceByEntityId(entityId);
+        if (!instance)
+        {
+            auto asset = getAssetByEntityId(entityId);
+            if (!asset)
+            {
+                Log("Failed to find instance for entity %d", entityId);
+                return -1.0f;
+            }
+            instance = asset->getInstance();
+        }
+
+        const auto &tm = _engine->getTransformManager();
+        const auto entity = instance->getRoot();
+        auto worldTransform = tm.getWorldTransform(tm.getInstance(entity));
+        auto startBox = instance->getBoundingBox().transform(worldTransform);
+        OrientedBox shape;
+        if (_collisionComponentManager->getShape(entity, worldTransform, shape))
+        {
+            startBox = shape.getBounds();
+        }
+        const math::float3 displacement = {dx, dy, dz};
+        const Aabb endBox = {startBox.min + displacement, startBox.max + displacement};
+
+        _collisionComponentManager->refit();
+        Entity hit;
+        const float fraction = _collisionComponentManager->timeOfImpact(entity, startBox, endBox, hit);
+        if (hitEntity)
+        {
+            *hitEntity = Entity::smuggle(hit);
+        }
+        return fraction;
+    }
+
+    void SceneManager::setCollisionEventsEnabled(bool enabled)
+    {
+        std::lock_guard lock(_mutex);
+        _collisionComponentManager->setEventsEnabled(enabled);
+    }
+
+    int SceneManager::getCollisionEvents(TCollisionEvent *out, int capacity)
+    {
+        std::lock_guard lock(_mutex);
+        static_assert(sizeof(TCollisionEvent) == sizeof(CollisionEvent), "TCollisionEvent must match CollisionEvent");
+        return int(_collisionComponentManager->drainEvents(reinterpret_cast<CollisionEvent *>(out), size_t(std::max(capacity, 0))));
+    }
+
+    void SceneManager::addRaycastComponents(FilamentAsset *asset, FilamentInstance *instance)
+    {
+        const auto *data = static_cast<const cgltf_data *>(asset->getSourceAsset());
+        if (!data)
+        {
+            // the source data has been released (the asset wasn't loaded with keepData)
+            return;
+        }
+
+        // the triangles are read here (rather than on a worker thread) because the source data is released with the asset
+        auto &meshBvhs = _meshBvhs[asset];
+        if (meshBvhs.empty())
+        {
+            meshBvhs.resize(data->meshes_count);
+            for (cgltf_size m = 0; m < data->meshes_count; m++)
+            {
+                std::vector<math::float3> positions;
+                std::vector<math::float2> uvs;
+                std::vector<uint32_t> indices;
+                bool hasUvs = true;
+                for (cgltf_size p = 0; p < data->meshes[m].primitives_count; p++)
+                {
+                    const cgltf_primitive &primitive = data->meshes[m].primitives[p];
+                    if (primitive.type != cgltf_primitive_type_triangles)
+                    {
+                        continue;
+                    }
+                    const cgltf_accessor *position = nullptr;
+                    const cgltf_accessor *uv = nullptr;
+                    for (cgltf_size a = 0; a < primitive.attributes_count; a++)
+                    {
+                        const auto &attribute = primitive.attributes[a];
+                        if (attribute.type == cgltf_attribute_type_position)
+                        {
+                            position = attribute.data;
+                        }
+                        else if (attribute.type == cgltf_attribute_type_texcoord && attribute.index == 0)
+                        {
+                            uv = attribute.data;
+                        }
+                    }
+                    if (!position)
+                    {
+                        continue;
+                    }
+                    hasUvs = hasUvs && uv && uv->count == position->count;
+
+                    const uint32_t baseVertex = uint32_t(positions.size());
+                    positions.resize(baseVertex + position->count);
+                    uvs.resize(positions.size());
+                    for (cgltf_size v = 0; v < position->count; v++)
+                    {
+                        cgltf_accessor_read_float(position, v, &positions[baseVertex + v].x, 3);
+                        if (hasUvs)
+                        {
+                            cgltf_accessor_read_float(uv, v, &uvs[baseVertex + v].x, 2);
+                        }
+                    }
+                    if (primitive.indices)
+                    {
+                        for (cgltf_size i = 0; i < primitive.indices->count; i++)
+                        {
+                            indices.push_back(baseVertex + uint32_t(cgltf_accessor_read_index(primitive.indices, i)));
+                        }
+                    }
+                    else
+                    {
+                        for (cgltf_size v = 0; v < position->count; v++)
+                        {
+                            indices.push_back(baseVertex + uint32_t(v));
+                        }
+                    }
+                }
+                if (!hasUvs)
+                {
+                    uvs.clear();
+                }
+                if (!indices.empty())
+                {
+                    meshBvhs[m] = _raycastComponentManager->buildBvh(std::move(positions), std::move(uvs), std::move(indices));
+                }
+            }
+        }
+
+        // gltfio doesn't expose the node for each entity, so renderables are matched to nodes by name (as with AnimationScrubber)
+        auto &rm = _engine->getRenderableManager();
+        const Entity *entities = instance->getEntities();
+        const size_t numEntities = instance->getEntityCount();
+        for (cgltf_size n = 0; n < data->nodes_count; n++)
+        {
+            const cgltf_node &node = data->nodes[n];
+            if (!node.mesh || !node.name)
+            {
+                continue;
+            }
+            const auto &bvh = meshBvhs[node.mesh - data->meshes];
+            if (!bvh.valid())
+            {
+                continue;
+            }
+            for (size_t i = 0; i < numEntities; i++)
+            {
+                const char *name = asset->getName(entities[i]);
+                if (!name || strcmp(name, node.name) != 0)
+                {
+                    continue;
+                }
+                auto renderableInstance = rm.getInstance(entities[i]);
+                if (renderableInstance.isValid())
+                {
+                    // skinned meshes are raycast in their bind pose
+                    const auto &box = rm.getAxisAlignedBoundingBox(renderableInstance);
+                    _raycastComponentManager->addComponent(entities[i], bvh, {box.getMin(), box.getMax()});
+                }
+                break;
+            }
+        }
+    }
+
+    int SceneManager::raycast(const math::float3 &origin, const math::float3 &direction, float maxDistance, uint8_t layerMask, TRaycastHit *out, int maxHits)
+    {
+        std::lock_guard lock(_mutex);
+        if (maxHits <= 0)
+        {
+            return 0;
+        }
+        std::vector<RaycastHit> hits(maxHits);
+        _raycastComponentManager->refit();
+        const size_t numHits = _raycastComponentManager->raycast(origin, direction, maxDistance, layerMask, hits.data(), size_t(maxHits));
+        for (size_t i = 0; i < numHits; i++)
+        {
+            const auto &hit = hits[i];
+            out[i].entity = Entity::smuggle(hit.entity);
+            out[i].distance = hit.hit.distance;
+            out[i].barycentrics[0] = hit.hit.barycentrics.x;
+            out[i].barycentrics[1] = hit.hit.barycentrics.y;
+            out[i].barycentrics[2] = hit.hit.barycentrics.z;
+            out[i].uv[0] = hit.hit.uv.x;
+            out[i].uv[1] = hit.hit.uv.y;
+            out[i].triangle = int32_t(hit.hit.triangle);
+        }
+        return int(numHits);
     }
 
-    void SceneManager::updateAnimations()
+    void SceneManager::addToSpatialIndex(const Entity *entities, size_t count)
+    {
+        auto &rm = _engine->getRenderableManager();
+        for (size_t i = 0; i < count; i++)
+        {
+            auto renderableInstance = rm.getInstance(entities[i]);
+            if (renderableInstance.isValid())
+            {
+                const auto &box = rm.getAxisAlignedBoundingBox(renderableInstance);
+                _spatialIndexComponentManager->addComponent(entities[i], {box.getMin(), box.getMax()});
+            }
+        }
+    }
+
+    int SceneManager::queryBox(const Aabb &box, EntityId *out, int capacity)
+    {
+        std::lock_guard lock(_mutex);
+        int count = 0;
+        _spatialIndexComponentManager->queryBox(box, [&](Entity entity)
+                                                {
+            // hidden entities (which have been removed from the scene) remain in the index
+            if (!_scene->hasEntity(entity))
+            {
+                return;
+            }
+            if (count < capacity)
+            {
+                out[count] = Entity::smuggle(entity);
+            }
+            count++; });
+        return count;
+    }
+
+    int SceneManager::querySphere(const math::float3 &center, float radius, EntityId *out, int capacity)
+    {
+        std::lock_guard lock(_mutex);
+        int count = 0;
+        _spatialIndexComponentManager->querySphere(center, radius, [&](Entity entity)
+                                                   {
+            if (!_scene->hasEntity(entity))
+            {
+                return;
+            }
+            if (count < capacity)
+            {
+                out[count] = Entity::smuggle(entity);
+            }
+            count++; });
+        return count;
+    }
+
+    int SceneManager::queryFrustum(View *view, EntityId *out, int capacity)
+    {
+        std::lock_guard lock(_mutex);
+        int count = 0;
+        _spatialIndexComponentManager->queryFrustum(view->getCamera().getFrustum(), [&](Entity entity)
+                                                    {
+            if (!_scene->hasEntity(entity))
+            {
+                return;
+            }
+            if (count < capacity)
+            {
+                out[count] = Entity::smuggle(entity);
+            }
+            count++; });
+        return count;
+    }
+
+    int SceneManager::queryNearest(const math::float3 &point, int k, EntityId *out, float *distances)
+    {
+        std::lock_guard lock(_mutex);
+        int count = 0;
+        _spatialIndexComponentManager->queryNearest(
+            point, size_t(std::max(k, 0)), [&](Entity entity)
+            { return _scene->hasEntity(entity); },
+            [&](Entity entity, float distance)
+            {
+                out[count] = Entity::smuggle(entity);
+                if (distances)
+                {
+                    distances[count] = distance;
+                }
+                count++;
+            });
+        return count;
+    }
+
+    int SceneManager::pickRegion(View *view, const float *points, int numPoints, int step, EntityId *outEntities, int32_t *outPixelCounts, int capacity)
+    {
+        std::lock_guard lock(_mutex);
+
+        if (numPoints < 3)
+        {
+            Log("Error: a region must have at least three points");
+            return 0;
+        }
+
+        const auto &viewport = view->getViewport();
+        const auto &camera = view->getCamera();
+        const math::mat4 worldFromClip = inverse(camera.getProjectionMatrix() * camera.getViewMatrix());
+        const uint8_t layerMask = view->getVisibleLayers();
+        const Scene *scene = view->getScene();
+
+        // the bounds of the region, clipped to the viewport
+        float minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max();
+        float maxX = std::numeric_limits<float>::lowest(), maxY = std::numeric_limits<float>::lowest();
+        for (int i = 0; i < numPoints; i++)
+        {
+            minX = std::min(minX, points[i * 2]);
+            maxX = std::max(maxX, points[i * 2]);
+            minY = std::min(minY, points[i * 2 + 1]);
+            maxY = std::max(maxY, points[i * 2 + 1]);
+        }
+        minX = std::max(minX, 0.0f);
+        minY = std::max(minY, 0.0f);
+        maxX = std::min(maxX, float(viewport.width));
+        maxY = std::min(maxY, float(viewport.height));
+        if (minX >= maxX || minY >= maxY)
+        {
+            return 0;
+        }
+
+        // coarsen the sampling grid for very large regions
+        step = std::max(step, 1);
+        while (((maxX - minX) / step) * ((maxY - minY) / step) > kMaxRegionSamples)
+        {
+            step *= 2;
+        }
+
+        _raycastComponentManager->refit();
+
+        tsl::robin_map<EntityId, int32_t> pixelCounts;
+        std::vector<float> crossings;
+        RaycastHit hit;
+
+        // samples are taken at the center of every [step]th pixel (aligned to the viewport origin, so overlapping regions
+        // sample the same pixels), in spans between the points where each row of samples crosses the polygon (even-odd rule)
+        const int firstRow = int(std::floor(minY / step));
+        const int lastRow = int(std::ceil(maxY / step));
+        for (int row = firstRow; row <= lastRow; row++)
+        {
+            const float y = row * step + 0.5f;
+            if (y < minY || y >= maxY)
+            {
+                continue;
+            }
+            crossings.clear();
+            for (int i = 0, j = numPoints - 1; i < numPoints; j = i++)
+            {
+                const float x0 = points[j * 2], y0 = points[j * 2 + 1];
+                const float x1 = points[i * 2], y1 = points[i * 2 + 1];
+                if ((y0 <= y) != (y1 <= y))
+                {
+                    crossings.push_back(x0 + (y - y0) / (y1 - y0) * (x1 - x0));
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            for (size_t c = 0; c + 1 < crossings.size(); c += 2)
+            {
+                const float spanStart = std::max(crossings[c], minX);
+                const float spanEnd = std::min(crossings[c + 1], maxX);
+                for (int column = int(std::ceil((spanStart - 0.5f) / step)); column * step + 0.5f < spanEnd; column++)
+                {
+                    const float x = column * step + 0.5f;
+
+                    // cast a ray from the near plane through the sample
+                    const double ndcX = 2.0 * x / viewport.width - 1.0;
+                    const double ndcY = 1.0 - 2.0 * y / viewport.height;
+                    const math::double4 nearPoint = worldFromClip * math::double4(ndcX, ndcY, -1.0, 1.0);
+                    const math::double4 farPoint = worldFromClip * math::double4(ndcX, ndcY, 0.0, 1.0);
+                    const math::double3 origin = nearPoint.xyz / nearPoint.w;
+                    const math::double3 direction = farPoint.xyz / farPoint.w - origin;
+
+                    if (_raycastComponentManager->raycast(math::float3(origin), math::float3(direction), std::numeric_limits<float>::infinity(), layerMask, &hit, 1,
+                                                          [&](Entity entity)
+                                                          { return !scene || scene->hasEntity(entity); }) > 0)
+                    {
+                        pixelCounts[Entity::smuggle(hit.entity)] += step * step;
+                    }
+                }
+            }
+        }
+
+        // entities are reported in order of decreasing coverage
+        std::vector<std::pair<int32_t, EntityId>> sorted;
+        sorted.reserve(pixelCounts.size());
+        for (const auto &[entity, count] : pixelCounts)
+        {
+            sorted.emplace_back(count, entity);
+        }
+        std::sort(sorted.begin(), sorted.end(), std::greater<>());
+
+        const int count = int(sorted.size());
+        for (int i = 0; i < std::min(count, capacity); i++)
+        {
+            outEntities[i] = sorted[i].second;
+            if (outPixelCounts)
+            {
+                outPixelCounts[i] = sorted[i].first;
+            }
+        }
+        return count;
+    }
+
+    void SceneManager::updateAnimations(const std::vector<View *> &views)
     {
         std::lock_guard lock(_mutex);
-        _animationComponentManager->update();
+        _animationComponentManager->update(views);
+
+        if (!_vertexAnimations.empty())
+        {
+            const float timeInSecs = std::chrono::duration<float>(_animationComponentManager->getTime() - _vertexAnimationEpoch).count();
+            for (auto &[id, vertexAnimation] : _vertexAnimations)
+            {
+                vertexAnimation->setTime(timeInSecs);
+            }
+        }
     }
 
     void SceneManager::updateTransforms()
     {
         std::lock_guard lock(_mutex);
 
+        if (!_transformUpdates.empty())
+        {
+            _collisionComponentManager->refit();
+        }
+
         auto &tm = _engine->getTransformManager();
         tm.openLocalTransformTransaction();
 
@@ -1789,7 +2701,6 @@ namespace thermion
             bool isCollidable = true;
             Entity entity;
             filament::TransformManager::Instance transformInstance;
-            filament::math::mat4f transform;
             Aabb boundingBox;
             if (pos == _instances.end())
             {
@@ -1804,30 +2715,34 @@ namespace thermion
             }
 
             transformInstance = tm.getInstance(entity);
-            transform = tm.getTransform(transformInstance);
+            math::mat4 transform = transformUpdate;
 
             if (isCollidable)
             {
-                auto transformedBB = boundingBox.transform(transform);
-
-                auto collisionAxes = _collisionComponentManager->collides(entity, transformedBB);
-
-                if (collisionAxes.size() == 1)
+                // sweep the entity from its current pose to the new one, so a fast movement can't skip over a collider
+                const auto parent = tm.getParent(transformInstance);
+                const math::mat4 parentWorldTransform = parent.isNull() ? math::mat4() : tm.getWorldTransformAccurate(tm.getInstance(parent));
+                const math::mat4 startWorldTransform = tm.getWorldTransformAccurate(transformInstance);
+                math::mat4 endWorldTransform = parentWorldTransform * transformUpdate;
+                auto worldBox = [&](const math::mat4 &worldTransform)
                 {
-                    // auto globalAxis = collisionAxes[0];
-                    // globalAxis *= norm(relativeTranslation);
-                    // auto newRelativeTranslation = relativeTranslation + globalAxis;
-                    // translation -= relativeTranslation;
-                    // translation += newRelativeTranslation;
-                    // transform = composeMatrix(translation, rotation, scale);
-                }
-                else if (collisionAxes.size() > 1)
+                    OrientedBox shape;
+                    if (_collisionComponentManager->getShape(entity, math::mat4f(worldTransform), shape))
+                    {
+                        return shape.getBounds();
+                    }
+                    return boundingBox.transform(math::mat4f(worldTransform));
+                };
+
+                const float fraction = _collisionComponentManager->moveAndCollide(entity, worldBox(startWorldTransform), worldBox(endWorldTransform), _stopAtFirstContact);
+                if (fraction < 1.0f)
                 {
-                    // translation -= relativeTranslation;
-                    // transform = composeMatrix(translation, rotation, scale);
+                    // the new orientation/scale is kept, but the translation stops at the contact
+                    endWorldTransform[3].xyz = startWorldTransform[3].xyz + (endWorldTransform[3].xyz - startWorldTransform[3].xyz) * double(fraction);
+                    transform = inverse(parentWorldTransform) * endWorldTransform;
                 }
             }
-            tm.setTransform(transformInstance, transformUpdate);
+            tm.setTransform(transformInstance, transform);
         }
         tm.commitLocalTransformTransaction();
         _transformUpdates.clear();
@@ -1940,8 +2855,10 @@ namespace thermion
         auto entityPlaneInCameraSpace = entityPlaneInClipSpace / entityPlaneInClipSpace.w;
         auto entityPlaneInWorldSpace = camera.getModelMatrix() * entityPlaneInCameraSpace;
 
-        // Queue the position update (as a relative movement)
-        
+        // Queue the position update (like the projection above, this treats the local transform as the world transform)
+        math::mat4 transform(currentTransform);
+        transform[3] = math::double4(entityPlaneInWorldSpace.xyz, 1.0);
+        queueTransformUpdates(&entityId, &transform, 1);
     }
     
     void SceneManager::queueTransformUpdates(EntityId* entities, math::mat4* transforms, int numEntities)
@@ -1950,13 +2867,8 @@ namespace thermion
 
         for(int i= 0; i < numEntities; i++) {
             auto entity = entities[i];
-            const auto &pos = _transformUpdates.find(entity);
-            if (pos == _transformUpdates.end())
-            {
-                _transformUpdates.emplace(entity, transforms[i]);
-            }
-            auto curr = _transformUpdates[entity];
-            _transformUpdates[entity] = curr;
+            // only the latest update for each entity is applied; the movement to it is swept in updateTransforms
+            _transformUpdates[entity] = transforms[i];
         }
     }
 
@@ -2181,6 +3093,13 @@ namespace thermion
     }
 
     Aabb2 SceneManager::getBoundingBox(View *view, EntityId entityId)
+    {
+        Aabb2 result;
+        getBoundingBoxes(view, &entityId, 1, &result, nullptr);
+        return result;
+    }
+
+    void SceneManager::getBoundingBoxes(View *view, const EntityId *entityIds, int count, Aabb2 *out, int32_t *inFront)
     {
         const auto &camera = view->getCamera();
         const auto &viewport = view->getViewport();
@@ -2188,68 +3107,33 @@ namespace thermion
         auto &tcm = _engine->getTransformManager();
         auto &rcm = _engine->getRenderableManager();
 
-        // Get the projection and view matrices
-        math::mat4 projMatrix = camera.getProjectionMatrix();
-        math::mat4 viewMatrix = camera.getViewMatrix();
-        math::mat4 vpMatrix = projMatrix * viewMatrix;
-
-        auto entity = Entity::import(entityId);
-
-        auto renderable = rcm.getInstance(entity);
-        auto worldTransform = tcm.getWorldTransform(tcm.getInstance(entity));
-
-        // Get the axis-aligned bounding box in model space
-        Box aabb = rcm.getAxisAlignedBoundingBox(renderable);
-
-        auto min = aabb.getMin();
-        auto max = aabb.getMax();
-
-        // Transform the 8 corners of the AABB to clip space
-        std::array<math::float4, 8> corners = {
-            worldTransform * math::float4(min.x, min.y, min.z, 1.0f),
-            worldTransform * math::float4(max.x, min.y, min.z, 1.0f),
-            worldTransform * math::float4(min.x, max.y, min.z, 1.0f),
-            worldTransform * math::float4(max.x, max.y, min.z, 1.0f),
-            worldTransform * math::float4(min.x, min.y, max.z, 1.0f),
-            worldTransform * math::float4(max.x, min.y, max.z, 1.0f),
-            worldTransform * math::float4(min.x, max.y, max.z, 1.0f),
-            worldTransform * math::float4(max.x, max.y, max.z, 1.0f)};
+        // the view-projection matrix is computed (in double precision) once and shared by every entity
+        const math::mat4f vpMatrix(camera.getProjectionMatrix() * camera.getViewMatrix());
 
-        // Project corners to clip space and convert to viewport space
-        float minX = std::numeric_limits<float>::max();
-        float minY = std::numeric_limits<float>::max();
-        float maxX = std::numeric_limits<float>::lowest();
-        float maxY = std::numeric_limits<float>::lowest();
-
-        for (const auto &corner : corners)
+        for (int i = 0; i < count; i++)
         {
-
-            math::float4 clipSpace = vpMatrix * corner;
-
-            // Check if the point is behind the camera
-            if (clipSpace.w <= 0)
+            auto entity = Entity::import(entityIds[i]);
+            auto renderable = rcm.getInstance(entity);
+            if (!renderable.isValid())
             {
-                continue; // Skip this point
+                out[i] = Aabb2{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+                if (inFront)
+                {
+                    inFront[i] = 0;
+                }
+                continue;
             }
+            auto worldTransform = tcm.getWorldTransform(tcm.getInstance(entity));
 
-            // Perform perspective division
-            math::float3 ndcSpace = clipSpace.xyz / clipSpace.w;
-
-            // Clamp NDC coordinates to [-1, 1] range
-            ndcSpace.x = std::max(-1.0f, std::min(1.0f, ndcSpace.x));
-            ndcSpace.y = std::max(-1.0f, std::min(1.0f, ndcSpace.y));
-
-            // Convert NDC to viewport space
-            float viewportX = (ndcSpace.x * 0.5f + 0.5f) * viewport.width;
-            float viewportY = (1.0f - (ndcSpace.y * 0.5f + 0.5f)) * viewport.height; // Flip Y-axis
+            // Get the axis-aligned bounding box in model space
+            const Box &aabb = rcm.getAxisAlignedBoundingBox(renderable);
 
-            minX = std::min(minX, viewportX);
-            minY = std::min(minY, viewportY);
-            maxX = std::max(maxX, viewportX);
-            maxY = std::max(maxY, viewportY);
+            const bool visible = projectBox(vpMatrix * worldTransform, {aabb.getMin(), aabb.getMax()}, float(viewport.width), float(viewport.height), out[i]);
+            if (inFront)
+            {
+                inFront[i] = visible ? 1 : 0;
+            }
         }
-
-        return Aabb2{minX, minY, maxX, maxY};
     }
 
     void SceneManager::removeStencilHighlight(EntityId entityId)
@@ -2376,9 +3260,25 @@ EntityId SceneManager::createGeometry(
     builder.build(*_engine, entity);
 
     _scene->addEntity(entity);
+    addToSpatialIndex(&entity, 1);
 
     auto entityId = Entity::smuggle(entity);
 
+    if (primitiveType == RenderableManager::PrimitiveType::TRIANGLES)
+    {
+        std::vector<math::float3> positions(reinterpret_cast<const math::float3 *>(vertices), reinterpret_cast<const math::float3 *>(vertices) + numVertices / 3);
+        std::vector<math::float2> triangleUvs;
+        if (uvs && numUvs / 2 == positions.size())
+        {
+            triangleUvs.assign(reinterpret_cast<const math::float2 *>(uvs), reinterpret_cast<const math::float2 *>(uvs) + numUvs / 2);
+        }
+        std::vector<uint32_t> triangleIndices(indices, indices + numIndices);
+        const auto box = geometry->getBoundingBox();
+        _raycastComponentManager->addComponent(entity,
+                                               _raycastComponentManager->buildBvh(std::move(positions), std::move(triangleUvs), std::move(triangleIndices)),
+                                               {box.getMin(), box.getMax()});
+    }
+
     _geometry.emplace(entityId, std::move(geometry));
 
     return entityId;
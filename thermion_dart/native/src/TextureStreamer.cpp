@@ -0,0 +1,549 @@
+#include "TextureStreamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <limits>
+
+#include <filament/Box.h>
+#include <filament/Camera.h>
+#include <filament/Frustum.h>
+#include <filament/RenderableManager.h>
+#include <filament/TransformManager.h>
+#include <filament/Viewport.h>
+
+#include <image/ImageSampler.h>
+#include <imageio/ImageDecoder.h>
+#include <utils/EntityManager.h>
+
+#include <math/mat4.h>
+#include <math/vec4.h>
+
+#include "Log.hpp"
+#include "StreamBufferAdapter.hpp"
+
+namespace thermion
+{
+
+    using namespace image;
+
+    // the largest dimension of the (always resident) base texture
+    static constexpr uint32_t kBaseSize = 64;
+
+    // the maximum number of textures that will be uploaded/swapped in per frame
+    static constexpr int kMaxUploadsPerFrame = 2;
+
+    // the maximum number of textures that will be decoded concurrently
+    static constexpr int kMaxDecodesInFlight = 4;
+
+    TextureStreamer::TextureStreamer(Engine *engine, ThreadPool *pool, size_t budgetInBytes)
+        : _engine(engine), _budgetInBytes(budgetInBytes),
+          _sampler(TextureSampler::MinFilter::LINEAR_MIPMAP_LINEAR, TextureSampler::MagFilter::LINEAR),
+          _decodes(pool)
+    {
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        // wait for any running decodes to complete
+        _decodes.wait();
+        clear();
+    }
+
+    std::vector<LinearImage> TextureStreamer::createLevels(const LinearImage &image, uint32_t level)
+    {
+        std::vector<LinearImage> levels;
+        if (level == 0)
+        {
+            levels.push_back(image);
+        }
+        else
+        {
+            const uint32_t width = std::max(1u, image.getWidth() >> level);
+            const uint32_t height = std::max(1u, image.getHeight() >> level);
+            levels.push_back(resampleImage(image, width, height, Filter::BOX));
+        }
+
+        const uint32_t mipCount = getMipmapCount(levels[0]);
+        if (mipCount > 0)
+        {
+            std::vector<LinearImage> mips(mipCount);
+            generateMipmaps(levels[0], Filter::BOX, mips.data(), mipCount);
+            levels.insert(levels.end(), mips.begin(), mips.end());
+        }
+        return levels;
+    }
+
+    std::vector<LinearImage> TextureStreamer::decodeLevels(const std::vector<uint8_t> &source, const std::string &name, uint32_t level)
+    {
+        thermion::StreamBufferAdapter sb((char *)source.data(), (char *)source.data() + source.size());
+        std::istream inputStream(&sb);
+        LinearImage image = ImageDecoder::decode(inputStream, name, ImageDecoder::ColorSpace::SRGB);
+        if (!image.isValid())
+        {
+            Log("Failed to decode streamed texture %s", name.c_str());
+            return {};
+        }
+        return createLevels(image, level);
+    }
+
+    size_t TextureStreamer::getSizeInBytes(const StreamedTexture &texture, uint32_t level) const
+    {
+        // RGB16F/RGBA16F
+        const size_t bytesPerPixel = texture.channels * 2;
+        size_t size = 0;
+        for (uint32_t i = level; i < texture.numLevels; i++)
+        {
+            size += size_t(std::max(1u, texture.width >> i)) * std::max(1u, texture.height >> i) * bytesPerPixel;
+        }
+        return size;
+    }
+
+    Texture *TextureStreamer::upload(const StreamedTexture &texture, std::vector<LinearImage> &mips)
+    {
+        const bool rgb = texture.channels == 3;
+        Texture *result = Texture::Builder()
+                              .width(mips[0].getWidth())
+                              .height(mips[0].getHeight())
+                              .levels(mips.size())
+                              .format(rgb ? Texture::InternalFormat::RGB16F : Texture::InternalFormat::RGBA16F)
+                              .sampler(Texture::Sampler::SAMPLER_2D)
+                              .build(*_engine);
+
+        Texture::PixelBufferDescriptor::Callback freeCallback = [](void *, size_t, void *data)
+        {
+            delete reinterpret_cast<LinearImage *>(data);
+        };
+
+        for (size_t i = 0; i < mips.size(); i++)
+        {
+            // LinearImage copies are shallow, so this just keeps the pixels alive until the upload completes
+            LinearImage *image = new LinearImage(mips[i]);
+            result->setImage(*_engine, i,
+                             Texture::PixelBufferDescriptor(
+                                 image->getPixelRef(),
+                                 size_t(image->getWidth()) * image->getHeight() * texture.channels * sizeof(float),
+                                 rgb ? Texture::Format::RGB : Texture::Format::RGBA,
+                                 Texture::Type::FLOAT, nullptr, freeCallback, image));
+        }
+        return result;
+    }
+
+    Texture *TextureStreamer::create(const uint8_t *data, size_t length, const char *name)
+    {
+        std::string textureName(name ? name : "");
+        auto source = std::make_shared<std::vector<uint8_t>>(data, data + length);
+
+        thermion::StreamBufferAdapter sb((char *)source->data(), (char *)source->data() + source->size());
+        std::istream inputStream(&sb);
+        LinearImage image = ImageDecoder::decode(inputStream, textureName, ImageDecoder::ColorSpace::SRGB);
+
+        if (!image.isValid())
+        {
+            Log("Failed to decode image.");
+            return nullptr;
+        }
+
+        const uint32_t channels = image.getChannels();
+        if (channels != 3 && channels != 4)
+        {
+            Log("Unsupported channel count %d for texture %s", channels, textureName.c_str());
+            return nullptr;
+        }
+
+        StreamedTexture texture;
+        texture.id = ++_nextId;
+        texture.name = textureName;
+        texture.source = source;
+        texture.width = image.getWidth();
+        texture.height = image.getHeight();
+        texture.channels = channels;
+        texture.numLevels = getMipmapCount(image) + 1;
+
+        while (texture.baseLevel + 1 < texture.numLevels &&
+               (std::max(texture.width, texture.height) >> texture.baseLevel) > kBaseSize)
+        {
+            texture.baseLevel++;
+        }
+        texture.residentLevel = texture.baseLevel;
+        texture.requiredLevel = texture.baseLevel;
+
+        auto levels = createLevels(image, texture.baseLevel);
+        texture.base = upload(texture, levels);
+        _residentBytes += getSizeInBytes(texture, texture.baseLevel);
+
+        Log("Created streamed texture %s (%d x %d, %d channels, %d levels, base level %d)", textureName.c_str(), texture.width, texture.height, channels, texture.numLevels, texture.baseLevel);
+
+        Texture *handle = texture.base;
+        _textures.emplace(handle, std::move(texture));
+        return handle;
+    }
+
+    bool TextureStreamer::isStreamed(Texture *handle) const
+    {
+        return _textures.find(handle) != _textures.end();
+    }
+
+    bool TextureStreamer::bind(Texture *handle, utils::Entity entity, int materialIndex, const char *parameterName)
+    {
+        auto it = _textures.find(handle);
+        if (it == _textures.end())
+        {
+            return false;
+        }
+
+        auto &rm = _engine->getRenderableManager();
+        auto renderable = rm.getInstance(entity);
+        if (!renderable.isValid() || materialIndex < 0 || size_t(materialIndex) >= rm.getPrimitiveCount(renderable))
+        {
+            Log("Cannot bind streamed texture, invalid renderable or material index %d", materialIndex);
+            return false;
+        }
+
+        auto &texture = it.value();
+        Binding binding;
+        binding.entity = entity;
+        binding.materialIndex = materialIndex;
+        binding.materialInstance = rm.getMaterialInstanceAt(renderable, materialIndex);
+        binding.parameterName = parameterName;
+
+        // replace any existing binding for the same parameter
+        texture.bindings.erase(
+            std::remove_if(texture.bindings.begin(), texture.bindings.end(), [&](const Binding &b)
+                           { return b.materialInstance == binding.materialInstance && b.parameterName == binding.parameterName; }),
+            texture.bindings.end());
+
+        binding.materialInstance->setParameter(parameterName, texture.resident ? texture.resident : texture.base, _sampler);
+        texture.bindings.push_back(binding);
+        return true;
+    }
+
+    void TextureStreamer::destroyTexture(StreamedTexture &texture)
+    {
+        if (texture.resident)
+        {
+            _engine->destroy(texture.resident);
+            _residentBytes -= getSizeInBytes(texture, texture.residentLevel);
+            texture.resident = nullptr;
+        }
+        _engine->destroy(texture.base);
+        _residentBytes -= getSizeInBytes(texture, texture.baseLevel);
+        texture.base = nullptr;
+    }
+
+    bool TextureStreamer::destroy(Texture *handle)
+    {
+        auto it = _textures.find(handle);
+        if (it == _textures.end())
+        {
+            return false;
+        }
+        destroyTexture(it.value());
+        _textures.erase(it);
+        return true;
+    }
+
+    void TextureStreamer::clear()
+    {
+        for (auto it = _textures.begin(); it != _textures.end(); it++)
+        {
+            destroyTexture(it.value());
+        }
+        _textures.clear();
+        std::lock_guard lock(_decodedMutex);
+        _decoded.clear();
+    }
+
+    void TextureStreamer::setBudget(size_t budgetInBytes)
+    {
+        _budgetInBytes = budgetInBytes;
+        makeRoom(0, nullptr);
+    }
+
+    void TextureStreamer::swap(StreamedTexture &texture, Texture *resident, uint32_t level)
+    {
+        Texture *bound = resident ? resident : texture.base;
+        for (auto &binding : texture.bindings)
+        {
+            binding.materialInstance->setParameter(binding.parameterName.c_str(), bound, _sampler);
+        }
+        if (texture.resident)
+        {
+            _engine->destroy(texture.resident);
+            _residentBytes -= getSizeInBytes(texture, texture.residentLevel);
+        }
+        texture.resident = resident;
+        texture.residentLevel = resident ? level : texture.baseLevel;
+        if (resident)
+        {
+            _residentBytes += getSizeInBytes(texture, level);
+        }
+    }
+
+    bool TextureStreamer::makeRoom(size_t requiredBytes, Texture *exclude)
+    {
+        while (_residentBytes + requiredBytes > _budgetInBytes)
+        {
+            // evict the least recently visible texture that is resident at a finer level than it needs
+            StreamedTexture *lru = nullptr;
+            for (auto it = _textures.begin(); it != _textures.end(); it++)
+            {
+                auto &texture = it.value();
+                if (it->first != exclude && texture.resident && texture.residentLevel < texture.requiredLevel &&
+                    (!lru || texture.lastVisibleFrame < lru->lastVisibleFrame))
+                {
+                    lru = &texture;
+                }
+            }
+            if (!lru)
+            {
+                return false;
+            }
+            swap(*lru, nullptr, lru->baseLevel);
+        }
+        return true;
+    }
+
+    uint32_t TextureStreamer::computeRequiredLevel(StreamedTexture &texture, const std::vector<View *> &views)
+    {
+        auto &rm = _engine->getRenderableManager();
+        auto &tm = _engine->getTransformManager();
+        auto &em = utils::EntityManager::get();
+
+        uint32_t required = texture.baseLevel;
+        const float maxDimension = float(std::max(texture.width, texture.height));
+
+        for (auto it = texture.bindings.begin(); it != texture.bindings.end();)
+        {
+            // drop bindings for entities/material instances that have since been destroyed or replaced
+            auto renderable = em.isAlive(it->entity) ? rm.getInstance(it->entity) : RenderableManager::Instance();
+            if (!renderable.isValid() || size_t(it->materialIndex) >= rm.getPrimitiveCount(renderable) ||
+                rm.getMaterialInstanceAt(renderable, it->materialIndex) != it->materialInstance)
+            {
+                it = texture.bindings.erase(it);
+                continue;
+            }
+
+            const auto aabb = rm.getAxisAlignedBoundingBox(renderable);
+            const math::mat4f worldTransform = tm.getWorldTransform(tm.getInstance(it->entity));
+            const math::float3 min = aabb.getMin();
+            const math::float3 max = aabb.getMax();
+            const math::float4 corners[8] = {
+                worldTransform * math::float4(min.x, min.y, min.z, 1.0f),
+                worldTransform * math::float4(max.x, min.y, min.z, 1.0f),
+                worldTransform * math::float4(min.x, max.y, min.z, 1.0f),
+                worldTransform * math::float4(max.x, max.y, min.z, 1.0f),
+                worldTransform * math::float4(min.x, min.y, max.z, 1.0f),
+                worldTransform * math::float4(max.x, min.y, max.z, 1.0f),
+                worldTransform * math::float4(min.x, max.y, max.z, 1.0f),
+                worldTransform * math::float4(max.x, max.y, max.z, 1.0f)};
+
+            math::float3 worldMin(std::numeric_limits<float>::max());
+            math::float3 worldMax(std::numeric_limits<float>::lowest());
+            for (const auto &corner : corners)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    worldMin[i] = std::min(worldMin[i], corner[i]);
+                    worldMax[i] = std::max(worldMax[i], corner[i]);
+                }
+            }
+            Box worldBox;
+            worldBox.set(worldMin, worldMax);
+
+            for (auto view : views)
+            {
+                const auto &viewport = view->getViewport();
+                const auto &camera = view->getCamera();
+                if (viewport.width == 0 || viewport.height == 0 || !camera.getFrustum().intersects(worldBox))
+                {
+                    continue;
+                }
+
+                const math::mat4 vp = camera.getProjectionMatrix() * camera.getViewMatrix();
+                float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+                bool straddlesCamera = false;
+                for (const auto &corner : corners)
+                {
+                    const math::float4 clip = math::float4(vp * math::double4(corner));
+                    if (clip.w <= 0.0f)
+                    {
+                        straddlesCamera = true;
+                        break;
+                    }
+                    const float x = std::clamp(clip.x / clip.w, -1.0f, 1.0f);
+                    const float y = std::clamp(clip.y / clip.w, -1.0f, 1.0f);
+                    minX = std::min(minX, x);
+                    minY = std::min(minY, y);
+                    maxX = std::max(maxX, x);
+                    maxY = std::max(maxY, y);
+                }
+
+                // if the camera is inside/very close to the bounds, assume the renderable fills the viewport
+                const float areaInPixels = straddlesCamera
+                                               ? float(viewport.width) * float(viewport.height)
+                                               : (maxX - minX) * 0.5f * viewport.width * (maxY - minY) * 0.5f * viewport.height;
+
+                texture.lastVisibleFrame = _frame;
+
+                // assume the texture is mapped once across the projected bounds, so (roughly) one texel per pixel
+                // is needed along sqrt(area) pixels
+                const float texelsNeeded = std::sqrt(std::max(areaInPixels, 1.0f));
+                const uint32_t level = texelsNeeded >= maxDimension
+                                           ? 0
+                                           : uint32_t(std::floor(std::log2(maxDimension / texelsNeeded)));
+                required = std::min(required, level);
+            }
+            it++;
+        }
+        return required;
+    }
+
+    void TextureStreamer::update(const std::vector<View *> &views)
+    {
+        _frame++;
+
+        for (auto it = _textures.begin(); it != _textures.end(); it++)
+        {
+            auto &texture = it.value();
+            texture.requiredLevel = computeRequiredLevel(texture, views);
+        }
+
+        // upload decoded levels
+        std::vector<DecodedLevels> decoded;
+        {
+            std::lock_guard lock(_decodedMutex);
+            const size_t count = std::min(_decoded.size(), size_t(kMaxUploadsPerFrame));
+            decoded.insert(decoded.end(), std::make_move_iterator(_decoded.begin()), std::make_move_iterator(_decoded.begin() + count));
+            _decoded.erase(_decoded.begin(), _decoded.begin() + count);
+        }
+
+        for (auto &levels : decoded)
+        {
+            auto it = _textures.find(levels.handle);
+            if (it == _textures.end() || it->second.id != levels.id)
+            {
+                // destroyed while decoding
+                continue;
+            }
+            auto &texture = it.value();
+            texture.pending = false;
+
+            // no longer an improvement (e.g. the decode failed)
+            if (levels.mips.empty() || levels.level >= texture.residentLevel)
+            {
+                continue;
+            }
+
+            const size_t currentBytes = texture.resident ? getSizeInBytes(texture, texture.residentLevel) : 0;
+            const size_t extraBytes = getSizeInBytes(texture, levels.level) - currentBytes;
+            if (!makeRoom(extraBytes, levels.handle))
+            {
+                Log("Not enough texture streaming budget to swap in level %d of %s", levels.level, texture.name.c_str());
+                continue;
+            }
+            swap(texture, upload(texture, levels.mips), levels.level);
+        }
+
+        // dispatch decodes for the textures that need finer levels, largest deficit first
+        int inFlight = 0;
+        size_t evictableBytes = 0;
+        std::vector<StreamedTexture *> candidates;
+        for (auto it = _textures.begin(); it != _textures.end(); it++)
+        {
+            auto &texture = it.value();
+            if (texture.pending)
+            {
+                inFlight++;
+            }
+            else if (texture.requiredLevel < texture.residentLevel)
+            {
+                candidates.push_back(&texture);
+            }
+            if (texture.resident && texture.residentLevel < texture.requiredLevel)
+            {
+                evictableBytes += getSizeInBytes(texture, texture.residentLevel);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture *a, const StreamedTexture *b)
+                  {
+            const uint32_t deficitA = a->residentLevel - a->requiredLevel;
+            const uint32_t deficitB = b->residentLevel - b->requiredLevel;
+            if (deficitA != deficitB)
+            {
+                return deficitA > deficitB;
+            }
+            return a->lastVisibleFrame > b->lastVisibleFrame; });
+
+        size_t availableBytes = _budgetInBytes > _residentBytes ? _budgetInBytes - _residentBytes + evictableBytes : evictableBytes;
+
+        for (auto texture : candidates)
+        {
+            if (inFlight >= kMaxDecodesInFlight)
+            {
+                break;
+            }
+
+            // clamp to the finest level that fits within the budget
+            const size_t currentBytes = texture->resident ? getSizeInBytes(*texture, texture->residentLevel) : 0;
+            uint32_t level = texture->requiredLevel;
+            while (level < texture->residentLevel && getSizeInBytes(*texture, level) - currentBytes > availableBytes)
+            {
+                level++;
+            }
+            if (level >= texture->residentLevel)
+            {
+                continue;
+            }
+            availableBytes -= getSizeInBytes(*texture, level) - currentBytes;
+
+            texture->pending = true;
+            texture->pendingLevel = level;
+            inFlight++;
+
+            DecodedLevels request;
+            request.handle = texture->base;
+            request.id = texture->id;
+            request.level = level;
+
+            auto source = texture->source;
+            auto name = texture->name;
+            auto decode = [=]() mutable
+            {
+                request.mips = decodeLevels(*source, name, request.level);
+                std::lock_guard lock(_decodedMutex);
+                _decoded.push_back(std::move(request));
+            };
+
+            _decodes.add(decode);
+        }
+    }
+
+    TextureStreamer::Stats TextureStreamer::getStats() const
+    {
+        Stats stats;
+        stats.budgetBytes = _budgetInBytes;
+        stats.residentBytes = _residentBytes;
+        for (auto it = _textures.begin(); it != _textures.end(); it++)
+        {
+            const auto &texture = it->second;
+            stats.textureCount++;
+            if (texture.residentLevel <= texture.requiredLevel)
+            {
+                stats.satisfiedCount++;
+            }
+            if (texture.pending)
+            {
+                stats.pendingCount++;
+            }
+            // the base texture is always resident
+            stats.requiredBytes += getSizeInBytes(texture, texture.baseLevel);
+            if (texture.requiredLevel < texture.baseLevel)
+            {
+                stats.requiredBytes += getSizeInBytes(texture, texture.requiredLevel);
+            }
+        }
+        return stats;
+    }
+}
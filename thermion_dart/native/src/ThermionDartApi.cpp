@@ -56,6 +56,13 @@ extern "C"
         ((FilamentViewer *)viewer)->pick(view, static_cast<uint32_t>(x), static_cast<uint32_t>(y), reinterpret_cast<FilamentViewer::PickCallback>(callback));
     }
 
+    EMSCRIPTEN_KEEPALIVE void Viewer_hoverPick(TViewer *tViewer, TView* tView, int x, int y, void (*callback)(EntityId entityId, int x, int y, TView *tView, float depth, float fragX, float fragY, float fragZ))
+    {
+        auto *viewer = reinterpret_cast<FilamentViewer*>(tViewer);
+        auto *view = reinterpret_cast<View*>(tView);
+        viewer->hoverPick(view, static_cast<uint32_t>(x), static_cast<uint32_t>(y), reinterpret_cast<FilamentViewer::PickCallback>(callback));
+    }
+
     EMSCRIPTEN_KEEPALIVE bool Viewer_isNonPickableEntity(TViewer *tViewer, EntityId entityId) {
         auto *viewer = reinterpret_cast<FilamentViewer*>(tViewer);
         return viewer->isNonPickableEntity(entityId);
@@ -81,6 +88,11 @@ extern "C"
         ((FilamentViewer *)viewer)->setBackgroundImage(path, fillHeight, 100, 100);
     }
 
+    EMSCRIPTEN_KEEPALIVE void Viewer_setBackgroundImageAsync(TViewer *viewer, const char *path, bool fillHeight, void (*onComplete)())
+    {
+        ((FilamentViewer *)viewer)->setBackgroundImageAsync(path, fillHeight, 100, 100, onComplete);
+    }
+
     EMSCRIPTEN_KEEPALIVE void set_background_image_position(TViewer *viewer, float x, float y, bool clamp)
     {
         ((FilamentViewer *)viewer)->setBackgroundImagePosition(x, y, clamp, 100, 100);
@@ -92,16 +104,51 @@ extern "C"
         ((FilamentViewer *)viewer)->loadSkybox(skyboxPath);
     }
 
+    EMSCRIPTEN_KEEPALIVE void Viewer_loadSkyboxAsync(TViewer *viewer, const char *skyboxPath, void (*onComplete)())
+    {
+        ((FilamentViewer *)viewer)->loadSkyboxAsync(skyboxPath, onComplete);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool Viewer_loadPanoramaMaterial(TViewer *viewer, const char *path)
+    {
+        return ((FilamentViewer *)viewer)->loadPanoramaMaterial(path);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void Viewer_loadTiledPanorama(TViewer *viewer, const char *uriTemplate, uint32_t tileSize, uint32_t numLevels, uint32_t cacheFaceSize)
+    {
+        ((FilamentViewer *)viewer)->loadTiledPanorama(uriTemplate, tileSize, numLevels, cacheFaceSize);
+    }
+
     EMSCRIPTEN_KEEPALIVE void create_ibl(TViewer *viewer, float r, float g, float b, float intensity)
     {
         ((FilamentViewer *)viewer)->createIbl(r, g, b, intensity);
     }
 
+    EMSCRIPTEN_KEEPALIVE void Viewer_createIblFromImage(TViewer *viewer, const char *imagePath, float intensity, bool createSkybox, const char *cacheDir)
+    {
+        ((FilamentViewer *)viewer)->createIblFromImage(imagePath, intensity, createSkybox, cacheDir);
+    }
+
     EMSCRIPTEN_KEEPALIVE void Viewer_loadIbl(TViewer *viewer, const char *iblPath, float intensity)
     {
         ((FilamentViewer *)viewer)->loadIbl(iblPath, intensity);
     }
 
+    EMSCRIPTEN_KEEPALIVE void Viewer_loadIblAsync(TViewer *viewer, const char *iblPath, float intensity, float crossfadeInSecs, void (*onComplete)())
+    {
+        ((FilamentViewer *)viewer)->loadIblAsync(iblPath, intensity, crossfadeInSecs, onComplete);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void Viewer_prefetchEnvironment(TViewer *viewer, const char *uri, int priority)
+    {
+        ((FilamentViewer *)viewer)->prefetchEnvironment(uri, priority);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void Viewer_setEnvironmentCacheBudget(TViewer *viewer, size_t budgetInBytes)
+    {
+        ((FilamentViewer *)viewer)->setEnvironmentCacheBudget(budgetInBytes);
+    }
+
     EMSCRIPTEN_KEEPALIVE void rotate_ibl(TViewer *viewer, float *rotationMatrix)
     {
         math::mat3f matrix(rotationMatrix[0], rotationMatrix[1],
@@ -634,7 +681,21 @@ extern "C"
         int animationIndex,
         int animationFrame)
     {
-        // ((SceneManager*)sceneManager)->setAnimationFrame(asset, animationIndex, animationFrame);
+        ((SceneManager *)sceneManager)->setAnimationFrame(asset, animationIndex, animationFrame);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool seek_animation(
+        TSceneManager *sceneManager,
+        EntityId asset,
+        int animationIndex,
+        float timeInSecs)
+    {
+        return ((SceneManager *)sceneManager)->seekAnimation(asset, animationIndex, timeInSecs);
+    }
+
+    EMSCRIPTEN_KEEPALIVE float get_animation_frame_rate(TSceneManager *sceneManager, EntityId asset, int animationIndex)
+    {
+        return ((SceneManager *)sceneManager)->getAnimationFrameRate(asset, animationIndex);
     }
 
     float get_animation_duration(TSceneManager *sceneManager, EntityId asset, int animationIndex)
@@ -839,6 +900,11 @@ extern "C"
         ((SceneManager *)sceneManager)->addCollisionComponent(entityId, onCollisionCallback, affectsCollidingTransform);
     }
 
+    EMSCRIPTEN_KEEPALIVE void SceneManager_addCollisionComponent(TSceneManager *sceneManager, EntityId entityId, void (*onCollisionCallback)(const EntityId entityId1, const EntityId entityId2), bool affectsCollidingTransform, int shapeType)
+    {
+        ((SceneManager *)sceneManager)->addCollisionComponent(entityId, onCollisionCallback, affectsCollidingTransform, static_cast<CollisionShapeType>(shapeType));
+    }
+
     EMSCRIPTEN_KEEPALIVE void remove_collision_component(TSceneManager *sceneManager, EntityId entityId)
     {
         ((SceneManager *)sceneManager)->removeCollisionComponent(entityId);
@@ -897,6 +963,58 @@ extern "C"
         ((SceneManager *)sceneManager)->testCollisions(entity);
     }
 
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setCollisionEventsEnabled(TSceneManager *sceneManager, bool enabled)
+    {
+        ((SceneManager *)sceneManager)->setCollisionEventsEnabled(enabled);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setStopAtFirstContact(TSceneManager *sceneManager, bool enabled)
+    {
+        ((SceneManager *)sceneManager)->setStopAtFirstContact(enabled);
+    }
+
+    EMSCRIPTEN_KEEPALIVE float SceneManager_timeOfImpact(TSceneManager *sceneManager, EntityId entity, float dx, float dy, float dz, EntityId *hitEntity)
+    {
+        return ((SceneManager *)sceneManager)->timeOfImpact(entity, dx, dy, dz, hitEntity);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_getCollisionEvents(TSceneManager *sceneManager, TCollisionEvent *out, int capacity)
+    {
+        return ((SceneManager *)sceneManager)->getCollisionEvents(out, capacity);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_raycast(TSceneManager *sceneManager, float originX, float originY, float originZ, float directionX, float directionY, float directionZ, float maxDistance, int layerMask, TRaycastHit *out, int maxHits)
+    {
+        return ((SceneManager *)sceneManager)->raycast({originX, originY, originZ}, {directionX, directionY, directionZ}, maxDistance, uint8_t(layerMask), out, maxHits);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_queryBox(TSceneManager *sceneManager, float minX, float minY, float minZ, float maxX, float maxY, float maxZ, EntityId *out, int capacity)
+    {
+        return ((SceneManager *)sceneManager)->queryBox({{minX, minY, minZ}, {maxX, maxY, maxZ}}, out, capacity);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_querySphere(TSceneManager *sceneManager, float x, float y, float z, float radius, EntityId *out, int capacity)
+    {
+        return ((SceneManager *)sceneManager)->querySphere({x, y, z}, radius, out, capacity);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_queryFrustum(TSceneManager *sceneManager, TView *tView, EntityId *out, int capacity)
+    {
+        auto view = reinterpret_cast<View *>(tView);
+        return ((SceneManager *)sceneManager)->queryFrustum(view, out, capacity);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_queryNearest(TSceneManager *sceneManager, float x, float y, float z, int k, EntityId *out, float *distances)
+    {
+        return ((SceneManager *)sceneManager)->queryNearest({x, y, z}, k, out, distances);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_pickRegion(TSceneManager *sceneManager, TView *tView, const float *points, int numPoints, int step, EntityId *outEntities, int32_t *outPixelCounts, int capacity)
+    {
+        auto view = reinterpret_cast<View *>(tView);
+        return ((SceneManager *)sceneManager)->pickRegion(view, points, numPoints, step, outEntities, outPixelCounts, capacity);
+    }
+
     EMSCRIPTEN_KEEPALIVE void set_priority(TSceneManager *sceneManager, EntityId entity, int priority)
     {
         ((SceneManager *)sceneManager)->setPriority(entity, priority);
@@ -919,6 +1037,12 @@ extern "C"
         *maxY = box.maxY;
     }
 
+    EMSCRIPTEN_KEEPALIVE void get_bounding_boxes(TSceneManager *sceneManager, TView *tView, const EntityId *entities, int count, Aabb2 *out, int32_t *inFront)
+    {
+        auto view = reinterpret_cast<View*>(tView);
+        ((SceneManager *)sceneManager)->getBoundingBoxes(view, entities, count, out, inFront);
+    }
+
     EMSCRIPTEN_KEEPALIVE void SceneManager_setVisibilityLayer(TSceneManager *tSceneManager, EntityId entity, int layer)
     {
         auto *sceneManager = reinterpret_cast<SceneManager*>(tSceneManager);
@@ -986,6 +1110,136 @@ extern "C"
         ((SceneManager *)sceneManager)->destroyTexture(reinterpret_cast<Texture *>(texture));
     }
 
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setTextureStreamingBudget(TSceneManager *sceneManager, size_t budgetInBytes)
+    {
+        ((SceneManager *)sceneManager)->getTextureStreamer()->setBudget(budgetInBytes);
+    }
+
+    EMSCRIPTEN_KEEPALIVE TTextureStreamingStats SceneManager_getTextureStreamingStats(TSceneManager *sceneManager)
+    {
+        auto stats = ((SceneManager *)sceneManager)->getTextureStreamer()->getStats();
+        return TTextureStreamingStats{
+            stats.textureCount,
+            stats.satisfiedCount,
+            stats.pendingCount,
+            stats.residentBytes,
+            stats.requiredBytes,
+            stats.budgetBytes};
+    }
+
+    EMSCRIPTEN_KEEPALIVE TAnimationStats SceneManager_getAnimationStats(TSceneManager *sceneManager)
+    {
+        auto stats = ((SceneManager *)sceneManager)->getAnimationComponentManager()->getStats();
+        return TAnimationStats{
+            stats.boneMatrixUpdates,
+            stats.jointTransformWrites,
+            stats.morphWeightUploads,
+            stats.evaluatedComponents,
+            stats.skippedEvaluations,
+            stats.skippedSkinningUpdates,
+            stats.uncompressedClipBytes,
+            stats.compressedClipBytes};
+    }
+
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationClock(TSceneManager *sceneManager, int mode, float timestepInSecs)
+    {
+        ((SceneManager *)sceneManager)->getAnimationComponentManager()->setClock((AnimationComponentManager::ClockMode)mode, timestepInSecs);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void SceneManager_stepAnimations(TSceneManager *sceneManager, float deltaInSecs)
+    {
+        ((SceneManager *)sceneManager)->getAnimationComponentManager()->step(deltaInSecs);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationLod(TSceneManager *sceneManager, bool enabled, float distantScreenSize, int distantInterval, int culledInterval)
+    {
+        AnimationComponentManager::LodSettings settings;
+        settings.enabled = enabled;
+        settings.distantScreenSize = distantScreenSize;
+        settings.distantInterval = distantInterval;
+        settings.culledInterval = culledInterval;
+        ((SceneManager *)sceneManager)->getAnimationComponentManager()->setLodSettings(settings);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationCompression(TSceneManager *sceneManager, float translationTolerance, float rotationTolerance, float scaleTolerance)
+    {
+        TrackCompressionSettings settings;
+        settings.translationTolerance = translationTolerance;
+        settings.rotationTolerance = rotationTolerance;
+        settings.scaleTolerance = scaleTolerance;
+        ((SceneManager *)sceneManager)->getAnimationComponentManager()->setCompressionSettings(settings);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_addAnimationLayer(TSceneManager *sceneManager, EntityId entity, int animationIndex, float weight, int mode, bool loop, const EntityId *maskEntities, int maskCount)
+    {
+        return ((SceneManager *)sceneManager)->addAnimationLayer(entity, animationIndex, weight, mode, loop, maskEntities, maskCount);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool SceneManager_setAnimationLayerWeight(TSceneManager *sceneManager, EntityId entity, int layerId, float weight)
+    {
+        return ((SceneManager *)sceneManager)->setAnimationLayerWeight(entity, layerId, weight);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool SceneManager_removeAnimationLayer(TSceneManager *sceneManager, EntityId entity, int layerId)
+    {
+        return ((SceneManager *)sceneManager)->removeAnimationLayer(entity, layerId);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_createAnimationStateMachine(TSceneManager *sceneManager, const uint8_t *data, size_t length)
+    {
+        return ((SceneManager *)sceneManager)->createAnimationStateMachine(data, length);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void SceneManager_destroyAnimationStateMachine(TSceneManager *sceneManager, int stateMachine)
+    {
+        ((SceneManager *)sceneManager)->destroyAnimationStateMachine(stateMachine);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool SceneManager_setAnimationStateMachine(TSceneManager *sceneManager, EntityId entity, int stateMachine)
+    {
+        return ((SceneManager *)sceneManager)->setAnimationStateMachine(entity, stateMachine);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool SceneManager_setAnimationStateMachineParameter(TSceneManager *sceneManager, EntityId entity, int parameter, float value)
+    {
+        return ((SceneManager *)sceneManager)->setAnimationStateMachineParameter(entity, parameter, value);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_getAnimationStateMachineState(TSceneManager *sceneManager, EntityId entity)
+    {
+        return ((SceneManager *)sceneManager)->getAnimationStateMachineState(entity);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool SceneManager_loadVertexAnimationMaterial(TSceneManager *sceneManager, const char *path)
+    {
+        return ((SceneManager *)sceneManager)->loadVertexAnimationMaterial(path);
+    }
+
+    EMSCRIPTEN_KEEPALIVE int SceneManager_bakeVertexAnimation(TSceneManager *sceneManager, EntityId entity, int animationIndex, float frameRate)
+    {
+        return ((SceneManager *)sceneManager)->bakeVertexAnimation(entity, animationIndex, frameRate);
+    }
+
+    EMSCRIPTEN_KEEPALIVE EntityId SceneManager_createVertexAnimationInstances(TSceneManager *sceneManager, int vertexAnimation, const float *transforms, const float *timeOffsets, int count)
+    {
+        return ((SceneManager *)sceneManager)->createVertexAnimationInstances(vertexAnimation, transforms, timeOffsets, count);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool SceneManager_setVertexAnimationInstances(TSceneManager *sceneManager, EntityId entity, const float *transforms, const float *timeOffsets, int count)
+    {
+        return ((SceneManager *)sceneManager)->setVertexAnimationInstances(entity, transforms, timeOffsets, count);
+    }
+
+    EMSCRIPTEN_KEEPALIVE bool SceneManager_destroyVertexAnimationInstances(TSceneManager *sceneManager, EntityId entity)
+    {
+        return ((SceneManager *)sceneManager)->destroyVertexAnimationInstances(entity);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void SceneManager_destroyVertexAnimation(TSceneManager *sceneManager, int vertexAnimation)
+    {
+        ((SceneManager *)sceneManager)->destroyVertexAnimation(vertexAnimation);
+    }
+
     EMSCRIPTEN_KEEPALIVE TMaterialInstance *create_material_instance(TSceneManager *sceneManager, TMaterialKey materialConfig)
     {
 
@@ -96,6 +96,15 @@ public:
       taskLock.lock();
     }
 
+    // frames are only rendered on request, so make sure background loads still complete when idle
+    // (only while there are any, so an idle render thread does no work)
+    if (_viewer && ((FilamentViewer *)_viewer)->hasPendingAsyncLoads())
+    {
+      taskLock.unlock();
+      ((FilamentViewer *)_viewer)->processAsyncLoads();
+      taskLock.lock();
+    }
+
     _cv.wait_for(taskLock, std::chrono::microseconds(2000), [this]
     { return !_tasks.empty() || _stop; });
 
@@ -253,11 +262,52 @@ extern "C"
     }
   }
 
-  EMSCRIPTEN_KEEPALIVE void Viewer_loadIblRenderThread(TViewer *viewer, const char *iblPath, float intensity, void(*onComplete)()) { 
+  EMSCRIPTEN_KEEPALIVE void Viewer_loadIblRenderThread(TViewer *viewer, const char *iblPath, float intensity, float crossfadeInSecs, void(*onComplete)()) { 
+      // onComplete is invoked once the IBL has been loaded in the background and swapped in
+      std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          Viewer_loadIblAsync(viewer, iblPath, intensity, crossfadeInSecs, onComplete);
+        });
+      auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void Viewer_createIblFromImageRenderThread(TViewer *viewer, const char *imagePath, float intensity, bool createSkybox, const char *cacheDir, void(*onComplete)()) { 
       std::packaged_task<void()> lambda(
         [=]() mutable
         {
-          Viewer_loadIbl(viewer, iblPath, intensity);
+          Viewer_createIblFromImage(viewer, imagePath, intensity, createSkybox, cacheDir);
+          onComplete();
+        });
+      auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void Viewer_setEnvironmentCacheBudgetRenderThread(TViewer *viewer, size_t budgetInBytes, void(*onComplete)()) { 
+      std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          Viewer_setEnvironmentCacheBudget(viewer, budgetInBytes);
+          onComplete();
+        });
+      auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void Viewer_loadPanoramaMaterialRenderThread(TViewer *viewer, const char *path, void (*callback)(bool)) {
+    std::packaged_task<bool()> lambda(
+        [=]
+        {
+          auto success = Viewer_loadPanoramaMaterial(viewer, path);
+          callback(success);
+          return success;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void Viewer_loadTiledPanoramaRenderThread(TViewer *viewer, const char *uriTemplate, uint32_t tileSize, uint32_t numLevels, uint32_t cacheFaceSize, void(*onComplete)()) { 
+      std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          Viewer_loadTiledPanorama(viewer, uriTemplate, tileSize, numLevels, cacheFaceSize);
           onComplete();
         });
       auto fut = _rl->add_task(lambda);
@@ -371,6 +421,255 @@ extern "C"
     auto fut = _rl->add_task(lambda);
   }
 
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setTextureStreamingBudgetRenderThread(TSceneManager *sceneManager, size_t budgetInBytes, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setTextureStreamingBudget(sceneManager, budgetInBytes);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_getTextureStreamingStatsRenderThread(TSceneManager *sceneManager, TTextureStreamingStats *out, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          *out = SceneManager_getTextureStreamingStats(sceneManager);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_getAnimationStatsRenderThread(TSceneManager *sceneManager, TAnimationStats *out, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          *out = SceneManager_getAnimationStats(sceneManager);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setCollisionEventsEnabledRenderThread(TSceneManager *sceneManager, bool enabled, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setCollisionEventsEnabled(sceneManager, enabled);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_getCollisionEventsRenderThread(TSceneManager *sceneManager, TCollisionEvent *out, int capacity, void (*callback)(int)) {
+    std::packaged_task<int()> lambda(
+        [=]
+        {
+          auto count = SceneManager_getCollisionEvents(sceneManager, out, capacity);
+          callback(count);
+          return count;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_pickRegionRenderThread(TSceneManager *sceneManager, TView *view, const float *points, int numPoints, int step, EntityId *outEntities, int32_t *outPixelCounts, int capacity, void (*callback)(int)) {
+    std::packaged_task<int()> lambda(
+        [=]
+        {
+          auto count = SceneManager_pickRegion(sceneManager, view, points, numPoints, step, outEntities, outPixelCounts, capacity);
+          callback(count);
+          return count;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationClockRenderThread(TSceneManager *sceneManager, int mode, float timestepInSecs, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setAnimationClock(sceneManager, mode, timestepInSecs);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_stepAnimationsRenderThread(TSceneManager *sceneManager, float deltaInSecs, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_stepAnimations(sceneManager, deltaInSecs);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationLodRenderThread(TSceneManager *sceneManager, bool enabled, float distantScreenSize, int distantInterval, int culledInterval, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setAnimationLod(sceneManager, enabled, distantScreenSize, distantInterval, culledInterval);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationCompressionRenderThread(TSceneManager *sceneManager, float translationTolerance, float rotationTolerance, float scaleTolerance, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setAnimationCompression(sceneManager, translationTolerance, rotationTolerance, scaleTolerance);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_addAnimationLayerRenderThread(TSceneManager *sceneManager, EntityId entity, int animationIndex, float weight, int mode, bool loop, const EntityId *maskEntities, int maskCount, void (*callback)(int)) {
+    std::packaged_task<int()> lambda(
+        [=]
+        {
+          auto layerId = SceneManager_addAnimationLayer(sceneManager, entity, animationIndex, weight, mode, loop, maskEntities, maskCount);
+          callback(layerId);
+          return layerId;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationLayerWeightRenderThread(TSceneManager *sceneManager, EntityId entity, int layerId, float weight, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setAnimationLayerWeight(sceneManager, entity, layerId, weight);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_removeAnimationLayerRenderThread(TSceneManager *sceneManager, EntityId entity, int layerId, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_removeAnimationLayer(sceneManager, entity, layerId);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_createAnimationStateMachineRenderThread(TSceneManager *sceneManager, const uint8_t *data, size_t length, void (*callback)(int)) {
+    std::packaged_task<int()> lambda(
+        [=]
+        {
+          auto stateMachine = SceneManager_createAnimationStateMachine(sceneManager, data, length);
+          callback(stateMachine);
+          return stateMachine;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_destroyAnimationStateMachineRenderThread(TSceneManager *sceneManager, int stateMachine, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_destroyAnimationStateMachine(sceneManager, stateMachine);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationStateMachineRenderThread(TSceneManager *sceneManager, EntityId entity, int stateMachine, void (*callback)(bool)) {
+    std::packaged_task<bool()> lambda(
+        [=]
+        {
+          auto success = SceneManager_setAnimationStateMachine(sceneManager, entity, stateMachine);
+          callback(success);
+          return success;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setAnimationStateMachineParameterRenderThread(TSceneManager *sceneManager, EntityId entity, int parameter, float value, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setAnimationStateMachineParameter(sceneManager, entity, parameter, value);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_getAnimationStateMachineStateRenderThread(TSceneManager *sceneManager, EntityId entity, void (*callback)(int)) {
+    std::packaged_task<int()> lambda(
+        [=]
+        {
+          auto state = SceneManager_getAnimationStateMachineState(sceneManager, entity);
+          callback(state);
+          return state;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_loadVertexAnimationMaterialRenderThread(TSceneManager *sceneManager, const char *path, void (*callback)(bool)) {
+    std::packaged_task<bool()> lambda(
+        [=]
+        {
+          auto success = SceneManager_loadVertexAnimationMaterial(sceneManager, path);
+          callback(success);
+          return success;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_bakeVertexAnimationRenderThread(TSceneManager *sceneManager, EntityId entity, int animationIndex, float frameRate, void (*callback)(int)) {
+    std::packaged_task<int()> lambda(
+        [=]
+        {
+          auto vertexAnimation = SceneManager_bakeVertexAnimation(sceneManager, entity, animationIndex, frameRate);
+          callback(vertexAnimation);
+          return vertexAnimation;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_createVertexAnimationInstancesRenderThread(TSceneManager *sceneManager, int vertexAnimation, const float *transforms, const float *timeOffsets, int count, void (*callback)(EntityId)) {
+    std::packaged_task<EntityId()> lambda(
+        [=]
+        {
+          auto entity = SceneManager_createVertexAnimationInstances(sceneManager, vertexAnimation, transforms, timeOffsets, count);
+          callback(entity);
+          return entity;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_setVertexAnimationInstancesRenderThread(TSceneManager *sceneManager, EntityId entity, const float *transforms, const float *timeOffsets, int count, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_setVertexAnimationInstances(sceneManager, entity, transforms, timeOffsets, count);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_destroyVertexAnimationInstancesRenderThread(TSceneManager *sceneManager, EntityId entity, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_destroyVertexAnimationInstances(sceneManager, entity);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
+  EMSCRIPTEN_KEEPALIVE void SceneManager_destroyVertexAnimationRenderThread(TSceneManager *sceneManager, int vertexAnimation, void (*onComplete)()) {
+    std::packaged_task<void()> lambda(
+        [=]() mutable
+        {
+          SceneManager_destroyVertexAnimation(sceneManager, vertexAnimation);
+          onComplete();
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
   EMSCRIPTEN_KEEPALIVE void SceneManager_loadGlbFromBufferRenderThread(TSceneManager *sceneManager,
                                                                const uint8_t *const data,
                                                                size_t length,
@@ -402,11 +701,11 @@ extern "C"
                                                                const char *path,
                                                                bool fillHeight, void (*callback)())
   {
+    // callback is invoked once the image has been decoded in the background and uploaded
     std::packaged_task<void()> lambda(
         [=]
         {
-          set_background_image(viewer, path, fillHeight);
-          callback();
+          Viewer_setBackgroundImageAsync(viewer, path, fillHeight, callback);
         });
     auto fut = _rl->add_task(lambda);
   }
@@ -425,11 +724,9 @@ extern "C"
                                                       const char *skyboxPath,
                                                       void (*onComplete)())
   {
+    // onComplete is invoked once the skybox has been loaded in the background and swapped in
     std::packaged_task<void()> lambda([=]
-                                      {
-                                        load_skybox(viewer, skyboxPath);
-                                        onComplete();
-                                      });
+                                      { Viewer_loadSkyboxAsync(viewer, skyboxPath, onComplete); });
     auto fut = _rl->add_task(lambda);
   }
   
@@ -503,6 +800,22 @@ extern "C"
     auto fut = _rl->add_task(lambda);
   }
 
+  EMSCRIPTEN_KEEPALIVE void seek_animation_render_thread(TSceneManager *sceneManager,
+                                                         EntityId asset,
+                                                         int animationIndex,
+                                                         float timeInSecs,
+                                                         void (*callback)(bool))
+  {
+    std::packaged_task<bool()> lambda(
+        [=]
+        {
+          auto result = seek_animation(sceneManager, asset, animationIndex, timeInSecs);
+          callback(result);
+          return result;
+        });
+    auto fut = _rl->add_task(lambda);
+  }
+
   EMSCRIPTEN_KEEPALIVE void stop_animation_render_thread(TSceneManager *sceneManager,
                                                          EntityId asset, int index)
   {
@@ -0,0 +1,623 @@
+#include "VertexAnimationTexture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include <filament/RenderableManager.h>
+#include <filament/TransformManager.h>
+#include <gltfio/Animator.h>
+#include <math/half.h>
+#include <utils/EntityManager.h>
+
+#include "cgltf.h"
+#include "Log.hpp"
+
+namespace thermion
+{
+
+    using namespace utils;
+
+    // most mobile GPUs support textures of at least this size
+    static constexpr uint32_t kMaxTextureHeight = 8192;
+
+    template <typename T>
+    static VertexBuffer::BufferDescriptor toBufferDescriptor(std::vector<T> &&values)
+    {
+        auto *data = new std::vector<T>(std::move(values));
+        return VertexBuffer::BufferDescriptor(
+            data->data(), data->size() * sizeof(T),
+            [](void *, size_t, void *user)
+            { delete static_cast<std::vector<T> *>(user); },
+            data);
+    }
+
+    template <typename T>
+    static Texture::PixelBufferDescriptor toPixelBufferDescriptor(std::vector<T> &&texels, Texture::Type type)
+    {
+        auto *data = new std::vector<T>(std::move(texels));
+        return Texture::PixelBufferDescriptor(
+            data->data(), data->size() * sizeof(T), Texture::Format::RGBA, type,
+            [](void *, size_t, void *user)
+            { delete static_cast<std::vector<T> *>(user); },
+            data);
+    }
+
+    static uint32_t getTextureHeight(size_t numTexels)
+    {
+        return uint32_t(std::max<size_t>(1, (numTexels + VertexAnimationTexture::kTextureWidth - 1) / VertexAnimationTexture::kTextureWidth));
+    }
+
+    ///
+    /// Maps each glTF node (by index) to its entity in [instance].
+    /// gltfio creates one entity per node by walking the hierarchy of each scene (or every root node, if there are no
+    /// scenes) depth first, which is also the order of FilamentInstance::getEntities, but it doesn't expose that table.
+    /// The walk is repeated here and checked against the parent of every entity (and its name, where both have one), so
+    /// this returns false rather than guessing if the two ever disagree.
+    ///
+    static bool mapNodesToEntities(const cgltf_data *data, FilamentInstance *instance, TransformManager &tm, std::vector<Entity> &nodeEntities)
+    {
+        nodeEntities.assign(data->nodes_count, Entity());
+
+        const Entity *entities = instance->getEntities();
+        const size_t numEntities = instance->getEntityCount();
+        size_t next = 0;
+        bool matched = true;
+
+        std::function<void(const cgltf_node *, Entity)> visit = [&](const cgltf_node *node, Entity parent)
+        {
+            const size_t index = size_t(node - data->nodes);
+            if (!matched || nodeEntities[index])
+            {
+                // a node that belongs to more than one scene only has a single entity
+                return;
+            }
+            if (next >= numEntities)
+            {
+                matched = false;
+                return;
+            }
+            const Entity entity = entities[next++];
+            const char *name = instance->getAsset()->getName(entity);
+            if (tm.getParent(tm.getInstance(entity)) != parent || (name && node->name && strcmp(name, node->name) != 0))
+            {
+                matched = false;
+                return;
+            }
+            nodeEntities[index] = entity;
+            for (cgltf_size c = 0; c < node->children_count; c++)
+            {
+                visit(node->children[c], entity);
+            }
+        };
+
+        const Entity root = instance->getRoot();
+        if (data->scenes_count > 0)
+        {
+            for (cgltf_size s = 0; s < data->scenes_count; s++)
+            {
+                for (cgltf_size n = 0; n < data->scenes[s].nodes_count; n++)
+                {
+                    visit(data->scenes[s].nodes[n], root);
+                }
+            }
+        }
+        else
+        {
+            for (cgltf_size n = 0; n < data->nodes_count; n++)
+            {
+                if (!data->nodes[n].parent)
+                {
+                    visit(&data->nodes[n], root);
+                }
+            }
+        }
+        return matched && next == numEntities;
+    }
+
+    static math::mat4f readMatrix(const cgltf_accessor *accessor, size_t index)
+    {
+        math::mat4f matrix;
+        if (accessor)
+        {
+            cgltf_accessor_read_float(accessor, index, &matrix[0][0], 16);
+        }
+        return matrix;
+    }
+
+    VertexAnimationTexture *VertexAnimationTexture::bake(Engine *engine, const FilamentAsset *asset, FilamentInstance *instance, int animationIndex, float frameRate)
+    {
+        // getSourceAsset is only a getter, but isn't declared const
+        const auto *data = static_cast<const cgltf_data *>(const_cast<FilamentAsset *>(asset)->getSourceAsset());
+        if (!data)
+        {
+            Log("ERROR: the source data for this asset has been released (load the asset with keepData to bake vertex animations)");
+            return nullptr;
+        }
+
+        auto *animator = instance->getAnimator();
+        if (animationIndex < 0 || size_t(animationIndex) >= animator->getAnimationCount())
+        {
+            Log("ERROR: glTF animation index %d is out of range", animationIndex);
+            return nullptr;
+        }
+        if (frameRate <= 0.0f)
+        {
+            Log("ERROR: invalid frame rate %f", frameRate);
+            return nullptr;
+        }
+
+        auto &tm = engine->getTransformManager();
+
+        // (non-skinned) meshes are baked with the animated transform of their node's entity
+        std::vector<Entity> nodeEntities;
+        if (!mapNodesToEntities(data, instance, tm, nodeEntities))
+        {
+            Log("ERROR: could not match the glTF nodes to the entities of this instance");
+            return nullptr;
+        }
+
+        struct Primitive
+        {
+            Entity entity;
+            int skin = -1;
+            uint32_t firstVertex = 0;
+            uint32_t vertexCount = 0;
+        };
+
+        std::vector<Primitive> primitives;
+        std::vector<math::float3> positions;
+        std::vector<math::float3> normals;
+        std::vector<math::float4> colors;
+        std::vector<math::uint4> joints;
+        std::vector<math::float4> weights;
+        std::vector<uint32_t> indices;
+
+        for (cgltf_size n = 0; n < data->nodes_count; n++)
+        {
+            const cgltf_node &node = data->nodes[n];
+            if (!node.mesh)
+            {
+                continue;
+            }
+
+            const Entity nodeEntity = nodeEntities[n];
+            if (!node.skin && !nodeEntity)
+            {
+                // the node isn't part of any scene, so it has no entity (and wouldn't be rendered)
+                continue;
+            }
+
+            for (cgltf_size p = 0; p < node.mesh->primitives_count; p++)
+            {
+                const cgltf_primitive &prim = node.mesh->primitives[p];
+                if (prim.type != cgltf_primitive_type_triangles)
+                {
+                    continue;
+                }
+
+                const cgltf_accessor *positionAccessor = nullptr;
+                const cgltf_accessor *normalAccessor = nullptr;
+                const cgltf_accessor *colorAccessor = nullptr;
+                const cgltf_accessor *jointsAccessor = nullptr;
+                const cgltf_accessor *weightsAccessor = nullptr;
+                for (cgltf_size a = 0; a < prim.attributes_count; a++)
+                {
+                    const auto &attribute = prim.attributes[a];
+                    switch (attribute.type)
+                    {
+                    case cgltf_attribute_type_position:
+                        positionAccessor = attribute.data;
+                        break;
+                    case cgltf_attribute_type_normal:
+                        normalAccessor = attribute.data;
+                        break;
+                    case cgltf_attribute_type_color:
+                        colorAccessor = attribute.index == 0 ? attribute.data : colorAccessor;
+                        break;
+                    case cgltf_attribute_type_joints:
+                        jointsAccessor = attribute.index == 0 ? attribute.data : jointsAccessor;
+                        break;
+                    case cgltf_attribute_type_weights:
+                        weightsAccessor = attribute.index == 0 ? attribute.data : weightsAccessor;
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                if (!positionAccessor)
+                {
+                    continue;
+                }
+
+                math::float4 baseColor(1.0f);
+                if (prim.material && prim.material->has_pbr_metallic_roughness)
+                {
+                    const auto *factor = prim.material->pbr_metallic_roughness.base_color_factor;
+                    baseColor = math::float4(factor[0], factor[1], factor[2], factor[3]);
+                }
+
+                Primitive primitive;
+                primitive.entity = nodeEntity;
+                primitive.skin = node.skin && jointsAccessor && weightsAccessor ? int(node.skin - data->skins) : -1;
+                primitive.firstVertex = uint32_t(positions.size());
+                primitive.vertexCount = uint32_t(positionAccessor->count);
+
+                for (cgltf_size v = 0; v < positionAccessor->count; v++)
+                {
+                    math::float3 position(0.0f);
+                    cgltf_accessor_read_float(positionAccessor, v, &position[0], 3);
+                    positions.push_back(position);
+
+                    math::float3 normal(0.0f, 0.0f, 1.0f);
+                    if (normalAccessor)
+                    {
+                        cgltf_accessor_read_float(normalAccessor, v, &normal[0], 3);
+                    }
+                    normals.push_back(normal);
+
+                    math::float4 color(1.0f);
+                    if (colorAccessor)
+                    {
+                        cgltf_accessor_read_float(colorAccessor, v, &color[0], 4);
+                    }
+                    colors.push_back(color * baseColor);
+
+                    math::uint4 joint(0);
+                    math::float4 weight(0.0f);
+                    if (primitive.skin >= 0)
+                    {
+                        cgltf_accessor_read_uint(jointsAccessor, v, &joint[0], 4);
+                        cgltf_accessor_read_float(weightsAccessor, v, &weight[0], 4);
+                    }
+                    joints.push_back(joint);
+                    weights.push_back(weight);
+                }
+
+                if (prim.indices)
+                {
+                    for (cgltf_size i = 0; i < prim.indices->count; i++)
+                    {
+                        indices.push_back(primitive.firstVertex + uint32_t(cgltf_accessor_read_index(prim.indices, i)));
+                    }
+                }
+                else
+                {
+                    for (uint32_t i = 0; i < primitive.vertexCount; i++)
+                    {
+                        indices.push_back(primitive.firstVertex + i);
+                    }
+                }
+                primitives.push_back(primitive);
+            }
+        }
+
+        const uint32_t vertexCount = uint32_t(positions.size());
+        if (vertexCount == 0)
+        {
+            Log("ERROR: asset has no triangle geometry to bake");
+            return nullptr;
+        }
+
+        const float duration = animator->getAnimationDuration(animationIndex);
+        const uint32_t frameCount = std::max(1u, uint32_t(std::ceil(duration * frameRate)));
+        const size_t numTexels = size_t(vertexCount) * frameCount;
+        if (getTextureHeight(numTexels) > kMaxTextureHeight)
+        {
+            Log("ERROR: %u vertices x %u frames exceeds the maximum vertex animation texture size; reduce the frame rate", vertexCount, frameCount);
+            return nullptr;
+        }
+
+        // the inverse bind matrices for each skin
+        std::vector<std::vector<math::mat4f>> inverseBindMatrices(data->skins_count);
+        for (cgltf_size s = 0; s < data->skins_count && s < instance->getSkinCount(); s++)
+        {
+            const auto &skin = data->skins[s];
+            for (cgltf_size j = 0; j < skin.joints_count; j++)
+            {
+                inverseBindMatrices[s].push_back(readMatrix(skin.inverse_bind_matrices, j));
+            }
+        }
+
+        // applying the animation overwrites the local transforms, so these are restored once baking is complete
+        const Entity *entities = instance->getEntities();
+        const size_t numEntities = instance->getEntityCount();
+        std::vector<math::mat4f> restPose(numEntities);
+        for (size_t i = 0; i < numEntities; i++)
+        {
+            restPose[i] = tm.getTransform(tm.getInstance(entities[i]));
+        }
+
+        std::vector<math::float4> positionTexels(size_t(getTextureHeight(numTexels)) * kTextureWidth);
+        std::vector<math::half> normalTexels(positionTexels.size() * 4);
+        std::vector<std::vector<math::mat4f>> jointMatrices(inverseBindMatrices.size());
+        Box bounds;
+        bool first = true;
+
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            animator->applyAnimation(animationIndex, std::min(float(frame) / frameRate, duration));
+
+            // bake relative to the root of the instance
+            const math::mat4f rootInverse = inverse(tm.getWorldTransform(tm.getInstance(instance->getRoot())));
+
+            for (size_t s = 0; s < jointMatrices.size(); s++)
+            {
+                const Entity *skinJoints = instance->getJointsAt(s);
+                const size_t jointCount = std::min(instance->getJointCountAt(s), inverseBindMatrices[s].size());
+                jointMatrices[s].resize(jointCount);
+                for (size_t j = 0; j < jointCount; j++)
+                {
+                    jointMatrices[s][j] = rootInverse * tm.getWorldTransform(tm.getInstance(skinJoints[j])) * inverseBindMatrices[s][j];
+                }
+            }
+
+            for (const auto &primitive : primitives)
+            {
+                math::mat4f nodeTransform;
+                if (primitive.skin < 0)
+                {
+                    nodeTransform = rootInverse * tm.getWorldTransform(tm.getInstance(primitive.entity));
+                }
+
+                for (uint32_t v = primitive.firstVertex; v < primitive.firstVertex + primitive.vertexCount; v++)
+                {
+                    math::mat4f transform = nodeTransform;
+                    if (primitive.skin >= 0)
+                    {
+                        const auto &matrices = jointMatrices[primitive.skin];
+                        transform = math::mat4f(0.0f);
+                        for (int k = 0; k < 4; k++)
+                        {
+                            if (weights[v][k] > 0.0f && joints[v][k] < matrices.size())
+                            {
+                                transform += matrices[joints[v][k]] * weights[v][k];
+                            }
+                        }
+                    }
+
+                    const math::float3 position = (transform * math::float4(positions[v], 1.0f)).xyz;
+                    math::float3 normal = (transform * math::float4(normals[v], 0.0f)).xyz;
+                    const float length = std::sqrt(dot(normal, normal));
+                    normal = length > 0.0f ? normal / length : math::float3(0.0f, 0.0f, 1.0f);
+
+                    const size_t texel = size_t(frame) * vertexCount + v;
+                    positionTexels[texel] = math::float4(position, 1.0f);
+                    for (int c = 0; c < 3; c++)
+                    {
+                        normalTexels[texel * 4 + c] = math::half(normal[c]);
+                    }
+
+                    if (first)
+                    {
+                        bounds = Box().set(position, position);
+                        first = false;
+                    }
+                    else
+                    {
+                        bounds = bounds.unionSelf(Box().set(position, position));
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < numEntities; i++)
+        {
+            tm.setTransform(tm.getInstance(entities[i]), restPose[i]);
+        }
+
+        auto *vat = new VertexAnimationTexture(engine);
+        vat->_vertexCount = vertexCount;
+        vat->_indexCount = uint32_t(indices.size());
+        vat->_frameCount = frameCount;
+        vat->_frameRate = frameRate;
+        vat->_bounds = bounds;
+
+        const uint32_t height = getTextureHeight(numTexels);
+        vat->_positions = Texture::Builder()
+                              .width(kTextureWidth)
+                              .height(height)
+                              .levels(1)
+                              .format(Texture::InternalFormat::RGBA32F)
+                              .sampler(Texture::Sampler::SAMPLER_2D)
+                              .build(*engine);
+        vat->_positions->setImage(*engine, 0, toPixelBufferDescriptor(std::move(positionTexels), Texture::Type::FLOAT));
+
+        vat->_normals = Texture::Builder()
+                            .width(kTextureWidth)
+                            .height(height)
+                            .levels(1)
+                            .format(Texture::InternalFormat::RGBA16F)
+                            .sampler(Texture::Sampler::SAMPLER_2D)
+                            .build(*engine);
+        vat->_normals->setImage(*engine, 0, toPixelBufferDescriptor(std::move(normalTexels), Texture::Type::HALF));
+
+        // the vertex index is used to look up the baked position/normal
+        std::vector<float> vertexIds(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            vertexIds[v] = float(v);
+        }
+
+        vat->_vertexBuffer = VertexBuffer::Builder()
+                                 .vertexCount(vertexCount)
+                                 .bufferCount(3)
+                                 .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+                                 .attribute(VertexAttribute::COLOR, 1, VertexBuffer::AttributeType::FLOAT4)
+                                 .attribute(VertexAttribute::CUSTOM0, 2, VertexBuffer::AttributeType::FLOAT)
+                                 .build(*engine);
+        vat->_vertexBuffer->setBufferAt(*engine, 0, toBufferDescriptor(std::move(positions)));
+        vat->_vertexBuffer->setBufferAt(*engine, 1, toBufferDescriptor(std::move(colors)));
+        vat->_vertexBuffer->setBufferAt(*engine, 2, toBufferDescriptor(std::move(vertexIds)));
+
+        vat->_indexBuffer = IndexBuffer::Builder()
+                                .indexCount(vat->_indexCount)
+                                .bufferType(IndexBuffer::IndexType::UINT)
+                                .build(*engine);
+        vat->_indexBuffer->setBuffer(*engine, toBufferDescriptor(std::move(indices)));
+
+        Log("Baked %u vertices x %u frames into vertex animation texture (%zu bytes)", vertexCount, frameCount, vat->getSizeInBytes());
+        return vat;
+    }
+
+    VertexAnimationTexture::~VertexAnimationTexture()
+    {
+        while (!_instances.empty())
+        {
+            destroyInstances(_instances.back().entity);
+        }
+        _engine->destroy(_vertexBuffer);
+        _engine->destroy(_indexBuffer);
+        _engine->destroy(_positions);
+        _engine->destroy(_normals);
+    }
+
+    size_t VertexAnimationTexture::getSizeInBytes() const
+    {
+        // RGBA32F positions + RGBA16F normals
+        const size_t texels = size_t(getTextureHeight(size_t(_vertexCount) * _frameCount)) * kTextureWidth;
+        return texels * (sizeof(math::float4) + 4 * sizeof(math::half));
+    }
+
+    Texture *VertexAnimationTexture::createInstanceData(const math::mat4f *transforms, const float *timeOffsets, int count) const
+    {
+        // four texels per instance (kTextureWidth is a multiple of four, so an instance never straddles two rows)
+        std::vector<math::float4> texels(size_t(getTextureHeight(size_t(count) * 4)) * kTextureWidth);
+        for (int i = 0; i < count; i++)
+        {
+            const math::mat4f &transform = transforms[i];
+            for (int row = 0; row < 3; row++)
+            {
+                texels[i * 4 + row] = math::float4(transform[0][row], transform[1][row], transform[2][row], transform[3][row]);
+            }
+            texels[i * 4 + 3] = math::float4(timeOffsets ? timeOffsets[i] : 0.0f, 0.0f, 0.0f, 0.0f);
+        }
+
+        auto *texture = Texture::Builder()
+                            .width(kTextureWidth)
+                            .height(getTextureHeight(size_t(count) * 4))
+                            .levels(1)
+                            .format(Texture::InternalFormat::RGBA32F)
+                            .sampler(Texture::Sampler::SAMPLER_2D)
+                            .build(*_engine);
+        texture->setImage(*_engine, 0, toPixelBufferDescriptor(std::move(texels), Texture::Type::FLOAT));
+        return texture;
+    }
+
+    Box VertexAnimationTexture::computeBounds(const math::mat4f *transforms, int count) const
+    {
+        // every instance is culled with the same bounding box, so this must enclose every instance
+        Box bounds;
+        for (int i = 0; i < count; i++)
+        {
+            const Box transformed = rigidTransform(_bounds, transforms[i]);
+            bounds = i == 0 ? transformed : bounds.unionSelf(transformed);
+        }
+        return bounds;
+    }
+
+    Entity VertexAnimationTexture::createInstances(Material *material, const math::mat4f *transforms, const float *timeOffsets, int count)
+    {
+        if (count <= 0 || count > kMaxInstances)
+        {
+            Log("ERROR: instance count must be between 1 and %d", kMaxInstances);
+            return Entity();
+        }
+
+        Instances instances;
+        instances.count = count;
+        instances.data = createInstanceData(transforms, timeOffsets, count);
+
+        TextureSampler sampler(TextureSampler::MinFilter::NEAREST, TextureSampler::MagFilter::NEAREST);
+        instances.materialInstance = material->createInstance();
+        instances.materialInstance->setParameter("positions", _positions, sampler);
+        instances.materialInstance->setParameter("normals", _normals, sampler);
+        instances.materialInstance->setParameter("instances", instances.data, sampler);
+        instances.materialInstance->setParameter("frameRate", _frameRate);
+        instances.materialInstance->setParameter("frameCount", int32_t(_frameCount));
+        instances.materialInstance->setParameter("vertexCount", int32_t(_vertexCount));
+        instances.materialInstance->setParameter("lightDirection", math::float3(0.0f, -1.0f, -0.5f));
+        instances.materialInstance->setParameter("time", 0.0f);
+
+        instances.entity = EntityManager::get().create();
+        RenderableManager::Builder(1)
+            .boundingBox(computeBounds(transforms, count))
+            .material(0, instances.materialInstance)
+            .geometry(0, RenderableManager::PrimitiveType::TRIANGLES, _vertexBuffer, _indexBuffer, 0, _indexCount)
+            .instances(count)
+            .culling(true)
+            .castShadows(false)
+            .receiveShadows(false)
+            .build(*_engine, instances.entity);
+
+        _instances.push_back(instances);
+        return instances.entity;
+    }
+
+    bool VertexAnimationTexture::setInstances(Entity entity, const math::mat4f *transforms, const float *timeOffsets, int count)
+    {
+        auto it = std::find_if(_instances.begin(), _instances.end(), [=](const Instances &instances)
+                               { return instances.entity == entity; });
+        if (it == _instances.end())
+        {
+            return false;
+        }
+        if (count != it->count)
+        {
+            Log("ERROR: expected %d instances, got %d", it->count, count);
+            return false;
+        }
+
+        // replace the instance data texture (with the same dimensions, since the count is unchanged)
+        _engine->destroy(it->data);
+        it->data = createInstanceData(transforms, timeOffsets, count);
+        it->materialInstance->setParameter("instances", it->data,
+                                           TextureSampler(TextureSampler::MinFilter::NEAREST, TextureSampler::MagFilter::NEAREST));
+
+        auto &rm = _engine->getRenderableManager();
+        rm.setAxisAlignedBoundingBox(rm.getInstance(entity), computeBounds(transforms, count));
+        return true;
+    }
+
+    bool VertexAnimationTexture::hasInstances(Entity entity) const
+    {
+        return std::any_of(_instances.begin(), _instances.end(), [=](const Instances &instances)
+                           { return instances.entity == entity; });
+    }
+
+    std::vector<Entity> VertexAnimationTexture::getInstanceEntities() const
+    {
+        std::vector<Entity> entities;
+        for (const auto &instances : _instances)
+        {
+            entities.push_back(instances.entity);
+        }
+        return entities;
+    }
+
+    bool VertexAnimationTexture::destroyInstances(Entity entity)
+    {
+        auto it = std::find_if(_instances.begin(), _instances.end(), [=](const Instances &instances)
+                               { return instances.entity == entity; });
+        if (it == _instances.end())
+        {
+            return false;
+        }
+        _engine->destroy(it->entity);
+        _engine->destroy(it->materialInstance);
+        _engine->destroy(it->data);
+        EntityManager::get().destroy(it->entity);
+        _instances.erase(it);
+        return true;
+    }
+
+    void VertexAnimationTexture::setTime(float timeInSecs)
+    {
+        for (auto &instances : _instances)
+        {
+            instances.materialInstance->setParameter("time", timeInSecs);
+        }
+    }
+}
@@ -1,32 +1,504 @@
 import 'dart:async';
+import 'dart:math';
 import 'dart:typed_data';
 import 'package:animation_tools_dart/animation_tools_dart.dart';
 import 'package:test/test.dart';
+import 'package:thermion_dart/thermion_dart.dart';
 import 'package:vector_math/vector_math_64.dart';
 import 'helpers.dart';
 
 void main() async {
   final testHelper = TestHelper("animation");
 
+  // the morph animation tests all animate the single morph target of this cube
+  Future<ThermionEntity> loadMorphCube(ThermionViewer viewer,
+          {bool keepData = false}) =>
+      viewer.loadGlb(
+          "${testHelper.testDir}/assets/cube_with_morph_targets.glb",
+          keepData: keepData);
+
+  final morphData = MorphAnimationData(
+      Float32List.fromList(List<double>.generate(60, (i) => i / 60)),
+      ["Key 1"]);
+
+  // a skinned asset whose three glTF animations (Survey, Walk and Run) all animate the same joints
+  Future<ThermionEntity> loadFox(ThermionViewer viewer,
+          {bool keepData = false}) =>
+      viewer.loadGlb("${testHelper.testDir}/assets/Fox.glb",
+          keepData: keepData);
+
   group('morph animation tests', () {
     test('set morph animation', () async {
       var viewer = await testHelper.createViewer(
           bg: kRed, cameraPosition: Vector3(0, 0, 5));
 
-      final cube = await viewer
-          .loadGlb("${testHelper.testDir}/assets/cube_with_morph_targets.glb");
-      var morphData = MorphAnimationData(
-          Float32List.fromList(List<double>.generate(60, (i) => i / 60)),
-          ["Key 1"]);
-      
-        await viewer.setMorphAnimationData(cube, morphData);
+      final cube = await loadMorphCube(viewer);
+      await viewer.setMorphAnimationData(cube, morphData);
       for (int i = 0; i < 60; i++) {
         await viewer.requestFrame();
-        await Future.delayed(Duration(milliseconds: 17));  
+        await Future.delayed(Duration(milliseconds: 17));
       }
-    
+
       await testHelper.capture(viewer, "morph_animation");
       await viewer.dispose();
     });
+
+    test('morph weights are uploaded once per frame', () async {
+      var viewer = await testHelper.createViewer(
+          bg: kRed, cameraPosition: Vector3(0, 0, 5));
+
+      final cube = await loadMorphCube(viewer);
+      await viewer.setMorphAnimationData(cube, morphData);
+
+      final numFrames = 60;
+      final before = await viewer.getAnimationStats();
+      final stopwatch = Stopwatch()..start();
+      for (int i = 0; i < numFrames; i++) {
+        await viewer.render();
+      }
+      stopwatch.stop();
+      final after = await viewer.getAnimationStats();
+      final uploads = after.morphWeightUploads - before.morphWeightUploads;
+      print(
+          "$uploads morph weight uploads / ${after.boneMatrixUpdates - before.boneMatrixUpdates} bone matrix updates in $numFrames frames (${stopwatch.elapsedMicroseconds / numFrames}us/frame)");
+      expect(uploads, greaterThan(0));
+      expect(uploads, lessThanOrEqualTo(numFrames));
+      await viewer.dispose();
+    });
+
+    test('manual animation clock', () async {
+      var viewer = await testHelper.createViewer(
+          bg: kRed, cameraPosition: Vector3(0, 0, 5));
+      await viewer.setAnimationClock(AnimationClockMode.MANUAL);
+
+      final cube = await loadMorphCube(viewer);
+      await viewer.setMorphAnimationData(cube, morphData);
+
+      await viewer.stepAnimations(0.5);
+      final first =
+          await testHelper.capture(viewer, "morph_animation_manual_clock");
+
+      // the animation shouldn't advance with the wall clock
+      await Future.delayed(Duration(milliseconds: 250));
+      final second =
+          await testHelper.capture(viewer, "morph_animation_manual_clock");
+      expect(second, first);
+
+      await viewer.setAnimationClock(AnimationClockMode.WALL_CLOCK);
+      await viewer.dispose();
+    });
+
+    test('culled entities are not animated when LOD is enabled', () async {
+      var viewer = await testHelper.createViewer(
+          bg: kRed, cameraPosition: Vector3(0, 0, 5));
+      await viewer.setAnimationLod(culledInterval: 0);
+
+      final cube = await loadMorphCube(viewer);
+      await viewer.setMorphAnimationData(cube, morphData);
+
+      // the camera looks down -Z, so the cube is now behind it
+      await viewer.setCameraPosition(0, 0, -5);
+      final before = await viewer.getAnimationStats();
+      for (int i = 0; i < 10; i++) {
+        await viewer.render();
+      }
+      final after = await viewer.getAnimationStats();
+      expect(after.skippedEvaluations, greaterThan(before.skippedEvaluations));
+      expect(after.morphWeightUploads, before.morphWeightUploads);
+
+      await viewer.setAnimationLod(enabled: false);
+      await viewer.dispose();
+    });
+
+    test('morph animation clips are compressed', () async {
+      var viewer = await testHelper.createViewer(
+          bg: kRed, cameraPosition: Vector3(0, 0, 5));
+
+      final cube = await loadMorphCube(viewer);
+      final before = await viewer.getAnimationStats();
+      await viewer.setMorphAnimationData(cube, morphData);
+      final after = await viewer.getAnimationStats();
+
+      final uncompressed =
+          after.uncompressedClipBytes - before.uncompressedClipBytes;
+      final compressed = after.compressedClipBytes - before.compressedClipBytes;
+      print(
+          "Compressed morph animation from $uncompressed to $compressed bytes (${(uncompressed / compressed).toStringAsFixed(1)}x)");
+      expect(compressed, lessThan(uncompressed));
+      await viewer.dispose();
+    });
+
+    test('adding an animation layer with an invalid index throws', () async {
+      var viewer = await testHelper.createViewer();
+      final cube = await loadMorphCube(viewer);
+      // the test asset has no glTF animations
+      await expectLater(viewer.addAnimationLayer(cube, 0), throwsException);
+      await viewer.dispose();
+    });
+
+    test('baking a vertex animation for an asset without animations throws',
+        () async {
+      var viewer = await testHelper.createViewer();
+      final cube = await loadMorphCube(viewer, keepData: true);
+      await expectLater(viewer.bakeVertexAnimation(cube, 0), throwsException);
+      await viewer.dispose();
+    });
+
+    test('seeking an invalid animation throws', () async {
+      var viewer = await testHelper.createViewer();
+      final cube = await loadMorphCube(viewer, keepData: true);
+      // the test asset has no glTF animations
+      await expectLater(viewer.seekAnimation(cube, 0, 0.5), throwsException);
+      await expectLater(viewer.getAnimationFrameRate(cube, 0), throwsException);
+      await viewer.dispose();
+    });
+
+    test('create animation state machine', () async {
+      var viewer = await testHelper.createViewer();
+      final stateMachine = AnimationStateMachine()
+        ..addParameter("speed", AnimationStateMachineParameterType.FLOAT)
+        ..addParameter("jump", AnimationStateMachineParameterType.TRIGGER)
+        ..addState("idle", 0)
+        ..addState("walk", 1)
+        ..addState("jump", 2, loop: false)
+        ..addTransition("idle", "walk",
+            conditions: [AnimationCondition.greaterThan("speed", 0.1)])
+        ..addTransition("walk", "idle",
+            conditions: [AnimationCondition.lessThan("speed", 0.1)])
+        ..addTransition(null, "jump",
+            blendDuration: 0.1, conditions: [AnimationCondition.isSet("jump")])
+        ..addTransition("jump", "idle", exitTime: 1.0);
+      final id = await viewer.createAnimationStateMachine(stateMachine);
+
+      final cube = await loadMorphCube(viewer);
+      // the test asset has no glTF animations for the states to play
+      await expectLater(
+          viewer.setAnimationStateMachine(cube, id), throwsException);
+      await viewer.destroyAnimationStateMachine(id);
+      await viewer.dispose();
+    });
   });
+
+  group('skinned animation tests', () {
+    test('bone animation clips are compressed within tolerance', () async {
+      var viewer = await testHelper.createViewer();
+      await viewer.setAnimationClock(AnimationClockMode.MANUAL);
+
+      // one period of a smooth sway of the hips, sampled every 50ms
+      final numFrames = 40;
+      final animation = BoneAnimationData(
+          ["b_Hip_01"],
+          List<List<BoneAnimationFrame>>.generate(numFrames, (i) {
+            final phase = sin(i / numFrames * 2 * pi);
+            return [
+              (
+                rotation:
+                    Quaternion.axisAngle(Vector3(0, 1, 0), phase * pi / 4),
+                translation: Vector3(0, 5 * phase, 0)
+              )
+            ];
+          }),
+          space: Space.Bone,
+          frameLengthInMs: 50);
+
+      Future<int> addClip(ThermionEntity fox, double tolerance) async {
+        await viewer.addAnimationComponent(fox);
+        await viewer.setAnimationCompression(
+            translationTolerance: tolerance,
+            rotationTolerance: tolerance,
+            scaleTolerance: tolerance);
+        final before = await viewer.getAnimationStats();
+        await viewer.addBoneAnimation(fox, animation);
+        final after = await viewer.getAnimationStats();
+        return after.compressedClipBytes - before.compressedClipBytes;
+      }
+
+      // every keyframe is kept (and quantized) when the tolerance is zero, and
+      // the compressed size of a channel is proportional to its number of
+      // keyframes, so a smaller clip means keyframes were removed
+      final tolerance = 1e-3;
+      final lossless = await addClip(await loadFox(viewer), 0);
+      final fox = await loadFox(viewer);
+      final hip = await viewer.getBone(
+          fox, (await viewer.getBoneNames(fox)).indexOf("b_Hip_01"));
+      final rest = await viewer.getLocalTransform(hip);
+      final compressed = await addClip(fox, tolerance);
+      print("Compressed bone animation to $compressed bytes "
+          "($lossless bytes with every keyframe)");
+      expect(compressed, lessThan(lossless));
+
+      // sample the clip at every source frame (the last frame ends the animation)
+      var maxTranslationError = 0.0;
+      var maxRotationError = 0.0;
+      for (int i = 1; i < numFrames; i++) {
+        await viewer.stepAnimations(animation.frameLengthInMs / 1000);
+        await viewer.render();
+        final frame = animation.frameData[i][0];
+        final expected = rest.multiplied(
+            Matrix4.compose(frame.translation, frame.rotation, Vector3.all(1)));
+        final actual = await viewer.getLocalTransform(hip);
+        maxTranslationError = max(maxTranslationError,
+            actual.getTranslation().distanceTo(expected.getTranslation()));
+        maxRotationError = max(maxRotationError,
+            angleBetween(rotationOf(actual), rotationOf(expected)));
+      }
+      print("Max error $maxTranslationError (translation) / "
+          "$maxRotationError rad (rotation)");
+      // allow for the float precision of composing/decomposing each transform
+      expect(maxTranslationError, lessThanOrEqualTo(tolerance + 1e-4));
+      expect(maxRotationError, lessThanOrEqualTo(tolerance + 1e-4));
+
+      await viewer.setAnimationCompression();
+      await viewer.setAnimationClock(AnimationClockMode.WALL_CLOCK);
+      await viewer.dispose();
+    });
+
+    test('animation layers are blended by weight', () async {
+      var viewer = await testHelper.createViewer();
+      await viewer.setAnimationClock(AnimationClockMode.MANUAL);
+
+      // the poses of each animation are sampled from a second instance
+      final reference = await loadFox(viewer);
+      final fox = await loadFox(viewer, keepData: true);
+      await viewer.addAnimationComponent(fox);
+
+      final time = 0.5;
+      await viewer.seekAnimation(reference, 0, time);
+      final survey = await getJointPose(viewer, reference);
+      await viewer.seekAnimation(reference, 1, time);
+      final walk = await getJointPose(viewer, reference);
+      expect(maxRotationDifference(survey, walk), greaterThan(0.1));
+
+      await viewer.addAnimationLayer(fox, 0);
+      final walkLayer = await viewer.addAnimationLayer(fox, 1, weight: 0.5);
+      await viewer.stepAnimations(time);
+      await viewer.render();
+      expectPose(await getJointPose(viewer, fox), blendPose(survey, walk, 0.5));
+
+      // at full weight, the walk layer replaces the survey layer
+      await viewer.setAnimationLayerWeight(fox, walkLayer, 1.0);
+      await viewer.render();
+      expectPose(await getJointPose(viewer, fox), walk);
+
+      await viewer.removeAnimationLayer(fox, walkLayer);
+      await viewer.render();
+      expectPose(await getJointPose(viewer, fox), survey);
+
+      await viewer.setAnimationClock(AnimationClockMode.WALL_CLOCK);
+      await viewer.dispose();
+    });
+
+    test('vertex animation instances are animated by the clock', () async {
+      var viewer = await testHelper.createViewer(
+          bg: kRed, cameraPosition: Vector3(0, 40, 250));
+      await viewer.setAnimationClock(AnimationClockMode.MANUAL);
+      // compiled by `make materials`
+      await viewer.loadVertexAnimationMaterial(
+          "file://${testHelper.testDir}/../../materials/vat.filamat");
+
+      // the source asset isn't animated, so only the instances move
+      final fox = await loadFox(viewer, keepData: true);
+      await viewer.setPosition(fox, -40, 0, 0);
+      final walk = await viewer.bakeVertexAnimation(fox, 1);
+      final instances = await viewer.createVertexAnimationInstances(
+          walk, [Matrix4.translation(Vector3(40, 0, 0))]);
+
+      final first = await testHelper.capture(viewer, "vat_walk_0");
+      final unchanged = await testHelper.capture(viewer, "vat_walk_0");
+      expect(unchanged, first);
+
+      // a quarter of the walk cycle
+      await viewer.stepAnimations(0.18);
+      final second = await testHelper.capture(viewer, "vat_walk_1");
+      expect(second, isNot(equals(first)));
+
+      await viewer.destroyVertexAnimationInstances(instances);
+      await viewer.destroyVertexAnimation(walk);
+      await viewer.setAnimationClock(AnimationClockMode.WALL_CLOCK);
+      await viewer.dispose();
+    });
+
+    test('animation state machine transitions cross-fade', () async {
+      var viewer = await testHelper.createViewer();
+      await viewer.setAnimationClock(AnimationClockMode.MANUAL);
+
+      final stateMachine = AnimationStateMachine()
+        ..addParameter("speed", AnimationStateMachineParameterType.FLOAT)
+        ..addState("idle", 0)
+        ..addState("walk", 1)
+        ..addTransition("idle", "walk",
+            blendDuration: 0.5,
+            conditions: [AnimationCondition.greaterThan("speed", 0.1)]);
+      final id = await viewer.createAnimationStateMachine(stateMachine);
+
+      // the poses of each animation are sampled from a second instance
+      final reference = await loadFox(viewer);
+      final fox = await loadFox(viewer);
+      await viewer.addAnimationComponent(fox);
+      await viewer.setAnimationStateMachine(fox, id);
+      expect(
+          stateMachine
+              .getStateName(await viewer.getAnimationStateMachineState(fox)),
+          "idle");
+
+      await viewer.stepAnimations(1.0);
+      await viewer.render();
+      await viewer.seekAnimation(reference, 0, 1.0);
+      expectPose(await getJointPose(viewer, fox),
+          await getJointPose(viewer, reference));
+
+      // the transition is taken on the next frame, then the survey animation
+      // (which keeps playing) is faded out over the blend duration
+      await viewer.setAnimationStateMachineParameter(
+          fox, stateMachine.getParameterIndex("speed"), 1.0);
+      await viewer.render();
+      expect(
+          stateMachine
+              .getStateName(await viewer.getAnimationStateMachineState(fox)),
+          "walk");
+
+      await viewer.stepAnimations(0.25);
+      await viewer.render();
+      await viewer.seekAnimation(reference, 0, 1.25);
+      final survey = await getJointPose(viewer, reference);
+      await viewer.seekAnimation(reference, 1, 0.25);
+      final walk = await getJointPose(viewer, reference);
+      expect(maxRotationDifference(survey, walk), greaterThan(0.1));
+      expectPose(await getJointPose(viewer, fox), blendPose(survey, walk, 0.5));
+
+      // once the blend has finished, only the walk animation is applied
+      await viewer.stepAnimations(0.3);
+      await viewer.render();
+      await viewer.seekAnimation(reference, 1, 0.55);
+      expectPose(await getJointPose(viewer, fox),
+          await getJointPose(viewer, reference));
+
+      await viewer.destroyAnimationStateMachine(id);
+      await viewer.setAnimationClock(AnimationClockMode.WALL_CLOCK);
+      await viewer.dispose();
+    });
+
+    test('seeking an animation applies the pose at that time', () async {
+      var viewer = await testHelper.createViewer();
+
+      // with keepData, seeking samples the cached keyframes; without it, the
+      // reference falls back to applying the animation with gltfio's Animator
+      final fox = await loadFox(viewer, keepData: true);
+      final reference = await loadFox(viewer);
+      final rest = await getJointPose(viewer, fox);
+
+      final frameRate = await viewer.getAnimationFrameRate(fox, 0);
+      expect(frameRate, closeTo(24, 0.01));
+
+      await viewer.setAnimationFrame(fox, 0, 30);
+      final frame = await getJointPose(viewer, fox);
+      expect(maxRotationDifference(rest, frame), greaterThan(0.1));
+      await viewer.seekAnimation(reference, 0, 30 / frameRate);
+      expectPose(frame, await getJointPose(viewer, reference));
+
+      // between keyframes
+      await viewer.seekAnimation(fox, 0, 1.27);
+      await viewer.seekAnimation(reference, 0, 1.27);
+      expectPose(await getJointPose(viewer, fox),
+          await getJointPose(viewer, reference));
+
+      // scrubbing forwards and backwards returns to the same pose
+      await viewer.seekAnimation(fox, 0, 3.0);
+      await viewer.seekAnimation(fox, 0, 0.4);
+      await viewer.seekAnimation(fox, 0, 30 / frameRate);
+      expectPose(await getJointPose(viewer, fox), frame);
+
+      await viewer.dispose();
+    });
+  });
+}
+
+///
+/// The local transform of every joint in the first skin of [entity].
+///
+Future<List<Matrix4>> getJointPose(
+    ThermionViewer viewer, ThermionEntity entity) async {
+  final numJoints = (await viewer.getBoneNames(entity)).length;
+  return [
+    for (int i = 0; i < numJoints; i++)
+      await viewer.getLocalTransform(await viewer.getBone(entity, i))
+  ];
+}
+
+///
+/// Expects every joint transform in [actual] to match [expected] within
+/// [translationTolerance] (in the units of the asset) and [rotationTolerance]
+/// (in radians).
+///
+void expectPose(List<Matrix4> actual, List<Matrix4> expected,
+    {double translationTolerance = 1e-2, double rotationTolerance = 1e-3}) {
+  expect(actual.length, expected.length);
+  for (int i = 0; i < actual.length; i++) {
+    expect(actual[i].getTranslation().distanceTo(expected[i].getTranslation()),
+        lessThanOrEqualTo(translationTolerance),
+        reason: "translation of joint $i");
+    expect(angleBetween(rotationOf(actual[i]), rotationOf(expected[i])),
+        lessThanOrEqualTo(rotationTolerance),
+        reason: "rotation of joint $i");
+  }
+}
+
+///
+/// The largest angle between the rotations of corresponding joints in [a] and [b].
+///
+double maxRotationDifference(List<Matrix4> a, List<Matrix4> b) {
+  var difference = 0.0;
+  for (int i = 0; i < a.length; i++) {
+    difference =
+        max(difference, angleBetween(rotationOf(a[i]), rotationOf(b[i])));
+  }
+  return difference;
+}
+
+///
+/// Blends each joint transform in [from] towards [to] by [weight], the same way
+/// an animation layer or cross-fade does (translation/scale are interpolated
+/// linearly, rotations are nlerped).
+///
+List<Matrix4> blendPose(List<Matrix4> from, List<Matrix4> to, double weight) {
+  final blended = <Matrix4>[];
+  for (int i = 0; i < from.length; i++) {
+    final t0 = Vector3.zero(), t1 = Vector3.zero();
+    final s0 = Vector3.zero(), s1 = Vector3.zero();
+    final r0 = Quaternion.identity(), r1 = Quaternion.identity();
+    from[i].decompose(t0, r0, s0);
+    to[i].decompose(t1, r1, s1);
+    // interpolate towards whichever of r1/-r1 is in the same hemisphere as r0
+    final sign =
+        r0.x * r1.x + r0.y * r1.y + r0.z * r1.z + r0.w * r1.w < 0 ? -1.0 : 1.0;
+    final rotation = Quaternion(
+        r0.x + (sign * r1.x - r0.x) * weight,
+        r0.y + (sign * r1.y - r0.y) * weight,
+        r0.z + (sign * r1.z - r0.z) * weight,
+        r0.w + (sign * r1.w - r0.w) * weight)
+      ..normalize();
+    blended.add(Matrix4.compose(
+        t0 + (t1 - t0) * weight, rotation, s0 + (s1 - s0) * weight));
+  }
+  return blended;
+}
+
+///
+/// The rotation of [transform] (with any scale removed).
+///
+Quaternion rotationOf(Matrix4 transform) {
+  final rotation = Quaternion.identity();
+  transform.decompose(Vector3.zero(), rotation, Vector3.zero());
+  return rotation;
+}
+
+///
+/// The angle (in radians) between [a] and [b] (measured via the relative
+/// rotation, since acos of the dot product can't resolve small angles).
+///
+double angleBetween(Quaternion a, Quaternion b) {
+  final relative = a * b.conjugated();
+  return 2 *
+      atan2(Vector3(relative.x, relative.y, relative.z).length,
+          relative.w.abs());
 }
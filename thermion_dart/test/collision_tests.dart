@@ -0,0 +1,175 @@
+// ignore_for_file: unused_local_variable
+
+import 'dart:math';
+
+import 'package:thermion_dart/thermion_dart.dart';
+import 'package:test/test.dart';
+import 'package:vector_math/vector_math_64.dart';
+
+import 'helpers.dart';
+
+void main() async {
+  final testHelper = TestHelper("collision");
+  group("collision", () {
+    test('collision queries with 10k colliders', () async {
+      var viewer = await testHelper.createViewer();
+
+      const numColliders = 10000;
+      const gridSize = 100;
+      const spacing = 4.0;
+      final asset = await viewer.loadGlb("${testHelper.testDir}/assets/cube.glb",
+          numInstances: numColliders);
+      final instances = await viewer.getInstances(asset);
+
+      final collisions = <(int, int)>[];
+      for (int i = 0; i < instances.length; i++) {
+        await viewer.setPosition(instances[i], (i % gridSize) * spacing, 0,
+            (i ~/ gridSize) * spacing);
+        await viewer.addCollisionComponent(instances[i],
+            callback: i == 1 ? (e1, e2) => collisions.add((e1, e2)) : null);
+      }
+
+      // move the first instance on top of the second
+      await viewer.setPosition(instances[0], spacing, 0, 0);
+
+      const numQueries = 1000;
+      final stopwatch = Stopwatch()..start();
+      for (int i = 0; i < numQueries; i++) {
+        await viewer.testCollisions(instances[0]);
+      }
+      stopwatch.stop();
+      print(
+          "${stopwatch.elapsedMicroseconds / numQueries}us per collision query against ${instances.length} colliders");
+
+      await Future.delayed(Duration(milliseconds: 100));
+      expect(collisions, isNotEmpty);
+      expect(collisions.first, (instances[1], instances[0]));
+      await viewer.dispose();
+    });
+
+    test('collision events', () async {
+      var viewer = await testHelper.createViewer();
+      final asset = await viewer.loadGlb("${testHelper.testDir}/assets/cube.glb",
+          numInstances: 3);
+      final instances = await viewer.getInstances(asset);
+      await viewer.setPosition(instances[0], 0, 0, 0);
+      await viewer.setPosition(instances[1], 0.5, 0, 0);
+      await viewer.setPosition(instances[2], 100, 0, 0);
+      for (final instance in instances) {
+        await viewer.addCollisionComponent(instance);
+      }
+      await viewer.setCollisionEventsEnabled(true);
+
+      final pair = {instances[0], instances[1]};
+
+      await viewer.render();
+      var events = await viewer.getCollisionEvents();
+      expect(events.length, 1);
+      expect(events.first.type, CollisionEventType.BEGIN);
+      expect({events.first.entity1, events.first.entity2}, pair);
+
+      await viewer.render();
+      events = await viewer.getCollisionEvents();
+      expect(events.map((e) => e.type), [CollisionEventType.PERSIST]);
+
+      await viewer.setPosition(instances[1], -100, 0, 0);
+      await viewer.render();
+      events = await viewer.getCollisionEvents();
+      expect(events.map((e) => e.type), [CollisionEventType.END]);
+      expect({events.first.entity1, events.first.entity2}, pair);
+
+      await viewer.setCollisionEventsEnabled(false);
+      await viewer.dispose();
+    });
+
+    test('collision shape false positives', () async {
+      var viewer = await testHelper.createViewer();
+
+      const numColliders = 500;
+      final asset = await viewer.loadGlb("${testHelper.testDir}/assets/cube.glb",
+          numInstances: numColliders);
+      final instances = await viewer.getInstances(asset);
+      final random = Random(42);
+      for (final instance in instances) {
+        await viewer.setPosition(instance, random.nextDouble() * 40,
+            random.nextDouble() * 40, random.nextDouble() * 40);
+        await viewer.setRotation(instance, random.nextDouble() * 2 * pi,
+            random.nextDouble() - 0.5, random.nextDouble() - 0.5, random.nextDouble() - 0.5);
+      }
+
+      // the cube is its own OBB, so the pairs found with OBBs are exactly the pairs that collide
+      final overlaps = <CollisionShapeType, int>{};
+      for (final shape in CollisionShapeType.values) {
+        for (final instance in instances) {
+          await viewer.addCollisionComponent(instance, shape: shape);
+        }
+        await viewer.setCollisionEventsEnabled(true);
+        final stopwatch = Stopwatch()..start();
+        await viewer.render();
+        stopwatch.stop();
+        final events = await viewer.getCollisionEvents();
+        overlaps[shape] =
+            events.where((e) => e.type == CollisionEventType.BEGIN).length;
+        print(
+            "${shape.name}: ${overlaps[shape]} overlapping pairs in ${stopwatch.elapsedMicroseconds}us (including the frame)");
+        await viewer.setCollisionEventsEnabled(false);
+        for (final instance in instances) {
+          await viewer.removeCollisionComponent(instance);
+        }
+      }
+
+      final aabbOverlaps = overlaps[CollisionShapeType.AABB]!;
+      final obbOverlaps = overlaps[CollisionShapeType.OBB]!;
+      print(
+          "AABB false positive rate: ${aabbOverlaps == 0 ? 0 : (100 * (aabbOverlaps - obbOverlaps) / aabbOverlaps).toStringAsFixed(1)}%");
+      expect(aabbOverlaps, greaterThan(obbOverlaps));
+      await viewer.dispose();
+    });
+
+    test('swept transform updates', () async {
+      var viewer = await testHelper.createViewer();
+
+      final asset = await viewer.loadGlb("${testHelper.testDir}/assets/cube.glb",
+          numInstances: 2);
+      final instances = await viewer.getInstances(asset);
+      final moving = instances[0];
+      final wall = instances[1];
+      await viewer.setPosition(moving, 0, 0, 0);
+      await viewer.setPosition(wall, 10, 0, 0);
+      await viewer.setScale(wall, 0.01);
+
+      // the callback of the collider that is touched is called with the moving entity
+      final collisions = <int>[];
+      await viewer.addCollisionComponent(moving);
+      await viewer.addCollisionComponent(wall,
+          callback: (e1, e2) => collisions.add(e2), affectsTransform: true);
+
+      // a single step far past the (thin) wall still hits it part of the way
+      final hit = await viewer.timeOfImpact(moving, Vector3(20, 0, 0));
+      expect(hit, isNotNull);
+      expect(hit!.entity, wall);
+      expect(hit.fraction, greaterThan(0));
+      expect(hit.fraction, lessThan(1));
+      expect(await viewer.timeOfImpact(moving, Vector3(0, 20, 0)), isNull);
+
+      // without stopping, the entity tunnels through but the contact is still reported
+      await viewer.queueTransformUpdates(
+          [moving], [Matrix4.translation(Vector3(20, 0, 0))]);
+      await viewer.render();
+      await Future.delayed(Duration(milliseconds: 100));
+      expect(collisions, contains(moving));
+      expect((await viewer.getWorldTransform(moving)).getTranslation().x, 20);
+
+      // with stopping, it comes to rest against the wall
+      await viewer.setPosition(moving, 0, 0, 0);
+      await viewer.setStopAtFirstContact(true);
+      await viewer.queueTransformUpdates(
+          [moving], [Matrix4.translation(Vector3(20, 0, 0))]);
+      await viewer.render();
+      final x = (await viewer.getWorldTransform(moving)).getTranslation().x;
+      expect(x, greaterThan(0));
+      expect(x, lessThan(10));
+      await viewer.dispose();
+    });
+  });
+}
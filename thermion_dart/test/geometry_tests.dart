@@ -102,6 +102,46 @@ void main() async {
       await viewer.destroyTexture(texture);
     });
 
+    test('stream texture mip levels', () async {
+      var viewer = await testHelper.createViewer();
+      await viewer.setCameraPosition(0, 0, 3);
+      var materialInstance = await viewer.createUbershaderMaterialInstance();
+      final cube = await viewer.createGeometry(
+          GeometryHelper.cube(uvs: true, normals: true),
+          materialInstance: materialInstance);
+      var textureData =
+          File("${testHelper.testDir}/assets/cube_texture_512x512.png")
+              .readAsBytesSync();
+      var texture = await viewer.createTexture(textureData);
+      await viewer.applyTexture(texture as ThermionFFITexture, cube);
+
+      var stats = await viewer.getTextureStreamingStats();
+      expect(stats.textureCount, 1);
+      final baseBytes = stats.residentBytes;
+
+      // finer levels are decoded in the background and swapped in on subsequent frames
+      for (int i = 0; i < 10; i++) {
+        await viewer.render();
+        await Future.delayed(Duration(milliseconds: 50));
+      }
+      stats = await viewer.getTextureStreamingStats();
+      expect(stats.satisfiedCount, 1);
+      expect(stats.residentBytes, greaterThan(baseBytes));
+      await testHelper.capture(viewer, "texture_streaming");
+
+      // once the finer levels are no longer needed, shrinking the budget evicts them
+      await viewer.setCameraPosition(0, 0, 1000);
+      await viewer.render();
+      await viewer.setTextureStreamingBudget(baseBytes);
+      stats = await viewer.getTextureStreamingStats();
+      expect(stats.residentBytes, baseBytes);
+
+      await viewer.removeEntity(cube);
+      await viewer.destroyMaterialInstance(materialInstance);
+      await viewer.destroyTexture(texture);
+      await viewer.dispose();
+    });
+
     test('unlit material with color only', () async {
       var viewer = await testHelper.createViewer();
       await viewer.setCameraPosition(0, 0, 6);
@@ -179,5 +219,123 @@ void main() async {
           .createGeometry(GeometryHelper.sphere(normals: false, uvs: false));
       await testHelper.capture(viewer, "geometry_sphere_no_normals");
     });
+
+    test('raycast against cube', () async {
+      var viewer = await testHelper.createViewer();
+      final cube = await viewer
+          .createGeometry(GeometryHelper.cube(normals: false, uvs: true));
+      await viewer.setPosition(cube, 0, 0, -1);
+
+      // the BVH is built in the background, so wait until it's ready
+      var hits = <RaycastHit>[];
+      for (int i = 0; i < 50 && hits.isEmpty; i++) {
+        hits = await viewer.raycast(Vector3(0, 0, 5), Vector3(0, 0, -1));
+        if (hits.isEmpty) {
+          await Future.delayed(Duration(milliseconds: 10));
+        }
+      }
+      expect(hits.length, 1);
+      expect(hits.first.entity, cube);
+      expect(hits.first.distance, closeTo(5, 0.001));
+
+      expect(
+          await viewer.raycast(Vector3(0, 0, 5), Vector3(0, 0, -1),
+              maxDistance: 4),
+          isEmpty);
+      expect(await viewer.raycast(Vector3(0, 5, 5), Vector3(0, 0, -1)),
+          isEmpty);
+
+      await viewer.removeEntity(cube);
+      expect(await viewer.raycast(Vector3(0, 0, 5), Vector3(0, 0, -1)),
+          isEmpty);
+      await viewer.dispose();
+    });
+
+    test('spatial queries', () async {
+      var viewer = await testHelper.createViewer();
+      await viewer.setCameraPosition(0, 0, 6);
+      final near = await viewer
+          .createGeometry(GeometryHelper.cube(normals: false, uvs: false));
+      final far = await viewer
+          .createGeometry(GeometryHelper.cube(normals: false, uvs: false));
+      await viewer.setPosition(far, 10, 0, 0);
+
+      expect(
+          await viewer
+              .queryBox(Aabb3.minMax(Vector3.all(-0.5), Vector3.all(0.5))),
+          [near]);
+      expect(await viewer.querySphere(Vector3(12, 0, 0), 1.5), [far]);
+      expect(await viewer.querySphere(Vector3(5, 0, 0), 1), isEmpty);
+      expect(await viewer.queryNearest(Vector3(8, 0, 0), 2), [far, near]);
+      expect(await viewer.queryFrustum(), contains(near));
+
+      await viewer.removeEntity(far);
+      expect(await viewer.queryNearest(Vector3(8, 0, 0), 2), [near]);
+      await viewer.dispose();
+    });
+
+    test('viewport bounding boxes', () async {
+      var viewer = await testHelper.createViewer();
+      await viewer.setCameraPosition(0, 0, 6);
+      final inFront = await viewer
+          .createGeometry(GeometryHelper.cube(normals: false, uvs: false));
+      final behind = await viewer
+          .createGeometry(GeometryHelper.cube(normals: false, uvs: false));
+      await viewer.setPosition(behind, 0, 0, 10);
+
+      final boxes =
+          await viewer.getViewportBoundingBoxes([inFront, behind]);
+      expect(boxes.length, 2);
+      expect(boxes[1], isNull);
+
+      final single = await viewer.getViewportBoundingBox(inFront);
+      expect(boxes[0]!.min.x, closeTo(single.min.x, 0.01));
+      expect(boxes[0]!.min.y, closeTo(single.min.y, 0.01));
+      expect(boxes[0]!.max.x, closeTo(single.max.x, 0.01));
+      expect(boxes[0]!.max.y, closeTo(single.max.y, 0.01));
+      expect(boxes[0]!.max.x, greaterThan(boxes[0]!.min.x));
+      await viewer.dispose();
+    });
+
+    test('pick region', () async {
+      var viewer = await testHelper.createViewer();
+      await viewer.setCameraPosition(0, 0, 6);
+      final left = await viewer
+          .createGeometry(GeometryHelper.cube(normals: false, uvs: false));
+      final right = await viewer
+          .createGeometry(GeometryHelper.cube(normals: false, uvs: false));
+      await viewer.setPosition(left, -2, 0, 0);
+      await viewer.setPosition(right, 2, 0, 0);
+
+      // wait until both BVHs are ready
+      for (int i = 0; i < 50; i++) {
+        final hits = [
+          ...await viewer.raycast(Vector3(-2, 0, 5), Vector3(0, 0, -1)),
+          ...await viewer.raycast(Vector3(2, 0, 5), Vector3(0, 0, -1))
+        ];
+        if (hits.length == 2) {
+          break;
+        }
+        await Future.delayed(Duration(milliseconds: 10));
+      }
+
+      final viewport = await (await viewer.getViewAt(0)).getViewport();
+      final width = viewport.width.toDouble();
+      final height = viewport.height.toDouble();
+
+      final all = await viewer.pickRect(Vector2.zero(), Vector2(width, height),
+          step: 4);
+      expect(all.map((r) => r.entity).toSet(), {left, right});
+      expect(all.every((r) => r.pixelCount > 0), isTrue);
+
+      final leftHalf = await viewer.pickRegion([
+        Vector2(0, 0),
+        Vector2(width / 2, 0),
+        Vector2(width / 2, height),
+        Vector2(0, height)
+      ], step: 2);
+      expect(leftHalf.map((r) => r.entity), [left]);
+      await viewer.dispose();
+    });
   });
 }
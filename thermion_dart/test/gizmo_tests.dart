@@ -1,6 +1,10 @@
 // ignore_for_file: unused_local_variable
 
+import 'dart:async';
+
 import 'package:test/test.dart';
+import 'package:thermion_dart/src/utils/src/gizmo.dart';
+import 'package:thermion_dart/thermion_dart.dart';
 
 import 'helpers.dart';
 
@@ -15,5 +19,20 @@ void main() async {
       await testHelper.capture(viewer, "gizmo_add_to_scene");
       await viewer.dispose();
     });
+
+    test('pick gizmo without rendering', () async {
+      var viewer = await testHelper.createViewer();
+      var view = await viewer.getViewAt(0);
+      var gizmo = await viewer.createGizmo(view) as BaseGizmo;
+      await gizmo.setVisibility(true);
+      await viewer.setRendering(false);
+
+      final result = Completer<PickResult>();
+      gizmo.onPick((r) => result.complete(r));
+      await gizmo.pick(0, 0);
+      // the gizmo is at the origin, so the corner of the viewport can't hit it
+      expect((await result.future.timeout(Duration(seconds: 1))).entity, 0);
+      await viewer.dispose();
+    });
   });
 }
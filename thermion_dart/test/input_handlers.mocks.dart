@@ -459,12 +459,16 @@ class MockThermionViewer extends _i1.Mock implements _i5.ThermionViewer {
   _i6.Future<dynamic> loadIbl(
     String? lightingPath, {
     double? intensity = 30000.0,
+    double? crossfade = 0.0,
   }) =>
       (super.noSuchMethod(
         Invocation.method(
           #loadIbl,
           [lightingPath],
-          {#intensity: intensity},
+          {
+            #intensity: intensity,
+            #crossfade: crossfade,
+          },
         ),
         returnValue: _i6.Future<dynamic>.value(),
       ) as _i6.Future<dynamic>);
@@ -1,3 +1,5 @@
+import 'dart:io';
+
 import 'package:test/test.dart';
 
 import 'helpers.dart';
@@ -15,5 +17,79 @@ void main() async {
       await testHelper.capture(viewer, "remove_skybox");
       await viewer.dispose();
     });
+
+    test('prefetch skybox', () async {
+      var viewer = await testHelper.createViewer();
+      var skyboxPath =
+          "file://${testHelper.testDir}/assets/default_env_skybox.ktx";
+      await viewer.prefetchEnvironment(skyboxPath, priority: 1);
+      // the environment is uploaded on the render thread, so allow a few frames to elapse
+      for (int i = 0; i < 5; i++) {
+        await viewer.render();
+        await Future.delayed(Duration(milliseconds: 50));
+      }
+      await viewer.loadSkybox(skyboxPath);
+      await testHelper.capture(viewer, "prefetch_skybox");
+      await viewer.removeSkybox();
+      // the cached texture should still be resident after removing the skybox
+      await viewer.loadSkybox(skyboxPath);
+      await testHelper.capture(viewer, "prefetch_skybox_reload");
+      await viewer.dispose();
+    });
+
+    test('swap IBL and background image asynchronously', () async {
+      var viewer = await testHelper.createViewer();
+      var iblPath = "file://${testHelper.testDir}/assets/default_env_ibl.ktx";
+      await viewer.loadIbl(iblPath);
+      // the futures complete once the new environment/image has been swapped in
+      // without any frames being requested in the meantime
+      await viewer.loadIbl(iblPath, intensity: 50000, crossfade: 0.5);
+      await viewer.setBackgroundImage(
+          "file://${testHelper.testDir}/assets/cube_texture_512x512.png");
+      await testHelper.capture(viewer, "async_ibl_background");
+      await viewer.dispose();
+    });
+
+    test('create IBL and skybox from equirect image', () async {
+      var viewer = await testHelper.createViewer();
+      var cacheDir = Directory("${testHelper.outDir.path}/ibl_cache");
+      if (cacheDir.existsSync()) {
+        cacheDir.deleteSync(recursive: true);
+      }
+      cacheDir.createSync(recursive: true);
+      var imagePath =
+          "file://${testHelper.testDir}/assets/cube_texture_512x512.png";
+      await viewer.createIblFromImage(imagePath,
+          createSkybox: true, cacheDirectory: cacheDir.path);
+      await testHelper.capture(viewer, "ibl_from_image");
+      expect(cacheDir.listSync().length, 1);
+
+      // the second call should be loaded from the cache
+      await viewer.createIblFromImage(imagePath,
+          cacheDirectory: cacheDir.path);
+      await testHelper.capture(viewer, "ibl_from_image_cached");
+      await viewer.dispose();
+    });
+
+    test('load tiled panorama', () async {
+      var viewer = await testHelper.createViewer();
+      // compiled by `make materials`
+      await viewer.loadPanoramaMaterial(
+          "file://${testHelper.testDir}/../../materials/panorama.filamat");
+      // every tile resolves to the same image, so this only exercises the
+      // tile request/decode/upload path (not the tile layout)
+      await viewer.loadTiledPanorama(
+          "file://${testHelper.testDir}/assets/cube_texture_256x256.png",
+          numLevels: 2,
+          tileSize: 256);
+      for (int i = 0; i < 5; i++) {
+        await viewer.render();
+        await Future.delayed(Duration(milliseconds: 50));
+      }
+      await testHelper.capture(viewer, "load_tiled_panorama");
+      await viewer.removeSkybox();
+      await testHelper.capture(viewer, "remove_tiled_panorama");
+      await viewer.dispose();
+    });
   });
 }